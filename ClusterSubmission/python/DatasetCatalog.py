@@ -0,0 +1,236 @@
+#! /usr/bin/env python
+from ClusterSubmission.Utils import ReadListFromFile, WriteList, CreateDirectory, IsROOTFile
+import os, argparse, sqlite3, zlib, heapq, math
+
+#######################################################################
+#   Local catalog of the input files of the batch jobs. For each file #
+#   the size, the number of events, the GUID and the adler32 checksum #
+#   are stored in a SQLite database together with the datasets the   #
+#   file belongs to. The catalog is filled incrementally:             #
+#     - from the rucio metadata by the RucioListBuilder               #
+#     - by opening the files which are not yet known                  #
+#   Once the files of a dataset are in the catalog, the SubmitToBatch #
+#   resolves the dataset and splits it into jobs balanced in events   #
+#   and size without opening any file or asking any service.         #
+#######################################################################
+
+
+def Adler32(path, chunk_size=64 * 1024 * 1024):
+    checksum = 1
+    with open(path, "rb") as in_file:
+        while True:
+            chunk = in_file.read(chunk_size)
+            if not chunk: break
+            checksum = zlib.adler32(chunk, checksum)
+    return "%08x" % (checksum & 0xffffffff)
+
+
+def LogicalName(ds):
+    ### mc16_13TeV:mc16_13TeV.<Blah>/ and mc16_13TeV.<Blah> are the same dataset
+    ds_name = ds.rstrip("/")
+    if ds_name.find(":") != -1: ds_name = ds_name[ds_name.find(":") + 1:]
+    return ds_name
+
+
+class FileRecord(object):
+    def __init__(self, path, size=-1, mtime=-1., n_events=-1, guid="", checksum=""):
+        self.path = path
+        self.size = size
+        self.mtime = mtime
+        self.n_events = n_events
+        self.guid = guid
+        self.checksum = checksum
+
+
+class ROOTFileInspector(object):
+    """Opens the file with ROOT to read the number of events of the CollectionTree and the POOL GUID.
+       The adler32 checksum is computed for local files if requested as the whole file has to be read"""
+    def __init__(self, tree_name="CollectionTree", compute_checksum=False):
+        self.__tree_name = tree_name
+        self.__compute_checksum = compute_checksum
+
+    def inspect(self, path):
+        import ROOT
+        root_file = ROOT.TFile.Open(path, "READ")
+        if not root_file or not root_file.IsOpen():
+            print("ERROR <ROOTFileInspector>: Could not open %s" % (path))
+            return None
+        record = FileRecord(path, size=root_file.GetSize())
+        tree = root_file.Get(self.__tree_name)
+        record.n_events = tree.GetEntries() if tree else 0
+        record.guid = self.__pool_guid(root_file)
+        if not record.guid: record.guid = root_file.GetUUID().AsString().upper()
+        root_file.Close()
+        if os.path.isfile(path):
+            record.mtime = os.stat(path).st_mtime
+            if self.__compute_checksum: record.checksum = Adler32(path)
+        return record
+
+    def __pool_guid(self, root_file):
+        ### The POOL file id is stored as [NAME=FID][VALUE=<guid>] in the ##Params tree of the xAODs
+        params = root_file.Get("##Params")
+        if not params: return ""
+        for entry in params:
+            db_string = str(entry.db_string)
+            if db_string.startswith("[NAME=FID][VALUE="): return db_string[len("[NAME=FID][VALUE="):-1]
+        return ""
+
+
+class DatasetCatalog(object):
+    def __init__(self, db_path, inspector=None):
+        self.__path = db_path
+        if os.path.dirname(db_path): CreateDirectory(os.path.dirname(db_path), False)
+        self.__db = sqlite3.connect(db_path)
+        self.__inspector = inspector if inspector else ROOTFileInspector()
+        self.__db.execute("CREATE TABLE IF NOT EXISTS files (path TEXT PRIMARY KEY, size INTEGER, mtime REAL, " +
+                          "n_events INTEGER, guid TEXT, checksum TEXT)")
+        self.__db.execute("CREATE TABLE IF NOT EXISTS datasets (name TEXT, path TEXT, PRIMARY KEY (name, path))")
+        self.__db.commit()
+
+    def path(self):
+        return self.__path
+
+    def close(self):
+        self.__db.close()
+
+    def add_record(self, record):
+        self.__db.execute("INSERT OR REPLACE INTO files VALUES (?, ?, ?, ?, ?, ?)",
+                          (record.path, record.size, record.mtime, record.n_events, record.guid, record.checksum))
+
+    def record(self, path):
+        row = self.__db.execute("SELECT path, size, mtime, n_events, guid, checksum FROM files WHERE path = ?", (path, )).fetchone()
+        return FileRecord(*row) if row else None
+
+    def register(self, dataset, files):
+        """Replaces the list of files of the dataset"""
+        name = LogicalName(dataset)
+        self.__db.execute("DELETE FROM datasets WHERE name = ?", (name, ))
+        self.__db.executemany("INSERT OR IGNORE INTO datasets VALUES (?, ?)", [(name, f) for f in files])
+        self.__db.commit()
+
+    def dataset_files(self, dataset):
+        return [row[0] for row in self.__db.execute("SELECT path FROM datasets WHERE name = ? ORDER BY path", (LogicalName(dataset), ))]
+
+    def datasets(self):
+        return [row[0] for row in self.__db.execute("SELECT DISTINCT name FROM datasets ORDER BY name")]
+
+    def is_up_to_date(self, path):
+        record = self.record(path)
+        if not record or record.n_events < 0: return False
+        ### Remote files cannot be checked without asking the storage. They are considered to be immutable
+        if not os.path.isfile(path): return True
+        stat = os.stat(path)
+        return record.size == stat.st_size and record.mtime == stat.st_mtime
+
+    def update(self, files):
+        """Inspects the files which are unknown or changed since their last inspection. Returns False if one could not be read"""
+        to_inspect = [f for f in files if not self.is_up_to_date(f)]
+        if len(to_inspect) > 0: print("INFO <DatasetCatalog>: Inspect %d of %d files" % (len(to_inspect), len(files)))
+        success = True
+        for i, path in enumerate(to_inspect):
+            record = self.__inspector.inspect(path)
+            if not record:
+                success = False
+                continue
+            self.add_record(record)
+            ### Commit from time to time such that an interrupted update does not start from scratch
+            if i % 50 == 49: self.__db.commit()
+        self.__db.commit()
+        return success
+
+    def split(self, files, events_per_job=-1, size_per_job=-1):
+        """Distributes the files over jobs such that no job exceeds the limits and balances the events and the size
+           across them. Starting with the largest file, each file is given to the job with the smallest load so far.
+           If the file does not fit into that job, a new job is opened. A single file exceeding a limit on its own
+           makes up a job of its own. Negative limits are ignored. All files must be in the catalog"""
+        records = [self.record(f) for f in files]
+        if None in records:
+            print("ERROR <DatasetCatalog>: %d files are not in the catalog" % (records.count(None)))
+            return []
+        if len(records) == 0: return []
+        total_events = sum([max(0, r.n_events) for r in records])
+        total_size = sum([max(0, r.size) for r in records])
+        ### Lower bound on the number of jobs
+        n_jobs = 1
+        if events_per_job > 0: n_jobs = max(n_jobs, int(math.ceil(float(total_events) / events_per_job)))
+        if size_per_job > 0: n_jobs = max(n_jobs, int(math.ceil(float(total_size) / size_per_job)))
+        n_jobs = min(n_jobs, len(records))
+
+        ### The load is the larger fraction of the event and the size limit occupied by the job
+        def load(n_events, size):
+            return max(
+                float(n_events) / events_per_job if events_per_job > 0 else 0.,
+                float(size) / size_per_job if size_per_job > 0 else 0.,
+            )
+
+        def fits(job, record):
+            return (events_per_job <= 0 or events[job] + max(0, record.n_events) <= events_per_job) and (
+                size_per_job <= 0 or sizes[job] + max(0, record.size) <= size_per_job)
+
+        jobs = [[] for i in range(n_jobs)]
+        events = [0 for i in range(n_jobs)]
+        sizes = [0 for i in range(n_jobs)]
+        heap = [(0., i) for i in range(n_jobs)]
+        order = sorted(range(len(records)), key=lambda i: (-load(max(0, records[i].n_events), max(0, records[i].size)), records[i].path))
+        for i in order:
+            job_load, job = heapq.heappop(heap)
+            if len(jobs[job]) > 0 and not fits(job, records[i]):
+                heapq.heappush(heap, (job_load, job))
+                job = len(jobs)
+                jobs += [[]]
+                events += [0]
+                sizes += [0]
+            jobs[job] += [i]
+            events[job] += max(0, records[i].n_events)
+            sizes[job] += max(0, records[i].size)
+            heapq.heappush(heap, (load(events[job], sizes[job]), job))
+        ### Keep the order of the input files within each job
+        return [[records[i].path for i in sorted(job)] for job in jobs if len(job) > 0]
+
+    def write_split(self, files, out_dir, events_per_job=-1, size_per_job=-1):
+        """Writes the job lists in the SplitList_<N>.txt format of CreateBatchJobSplit"""
+        jobs = self.split(files, events_per_job, size_per_job)
+        for i, job in enumerate(jobs):
+            WriteList(job, "%s/SplitList_%d.txt" % (out_dir, i + 1))
+        return len(jobs)
+
+
+def setupCatalogParser():
+    parser = argparse.ArgumentParser(
+        prog='DatasetCatalog',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+        description="Fill the local dataset catalog or split its datasets into job lists",
+    )
+    parser.add_argument('--catalog', help='Path to the SQLite catalog', required=True)
+    parser.add_argument('--dataset', '-d', help='Name of the dataset to register or to split', default="")
+    parser.add_argument('--inputFiles', '-i', help='Files of the dataset', default=[], nargs="+")
+    parser.add_argument('--inputLists', '-l', help='Text files with one file per line', default=[], nargs="+")
+    parser.add_argument('--checksum', help='Compute the adler32 checksum of the local files', default=False, action="store_true")
+    parser.add_argument('--splitDir', help='Write the job lists of the dataset to this directory', default="")
+    parser.add_argument('--EventsPerJob', help='Maximum number of events per job', type=int, default=-1)
+    parser.add_argument('--SizePerJob', help='Maximum size per job in MB', type=float, default=-1)
+    parser.add_argument('--list', help='Print the datasets in the catalog', default=False, action="store_true")
+    return parser
+
+
+if __name__ == '__main__':
+    RunOptions = setupCatalogParser().parse_args()
+    catalog = DatasetCatalog(RunOptions.catalog, ROOTFileInspector(compute_checksum=RunOptions.checksum))
+    files = [f for f in RunOptions.inputFiles]
+    for in_list in RunOptions.inputLists:
+        files += [f for f in ReadListFromFile(in_list) if IsROOTFile(f)]
+    if len(files) > 0:
+        if len(RunOptions.dataset) > 0: catalog.register(RunOptions.dataset, files)
+        if not catalog.update(files): exit(1)
+    elif len(RunOptions.dataset) > 0:
+        files = catalog.dataset_files(RunOptions.dataset)
+    if RunOptions.list:
+        for ds in catalog.datasets():
+            records = [catalog.record(f) for f in catalog.dataset_files(ds)]
+            print("%s: %d files, %d events, %.1f MB" % (ds, len(records), sum([r.n_events for r in records if r]),
+                                                         sum([r.size for r in records if r]) / 1024. / 1024.))
+    if len(RunOptions.splitDir) > 0:
+        CreateDirectory(RunOptions.splitDir, True)
+        n_jobs = catalog.write_split(files, RunOptions.splitDir, RunOptions.EventsPerJob, RunOptions.SizePerJob * 1024 * 1024)
+        print("INFO: Split %d files into %d jobs in %s" % (len(files), n_jobs, RunOptions.splitDir))
+    catalog.close()
@@ -0,0 +1,175 @@
+#! /usr/bin/env python
+from ClusterSubmission.Utils import ReadListFromFile, CreateDirectory
+from ClusterSubmission.DatasetCatalog import DatasetCatalog
+import os, sys, json, time, socket, resource, subprocess, hashlib
+
+#######################################################################
+#   Feedback loop between the batch jobs and their submission.        #
+#   The jobs run their command through this script which writes a     #
+#   small JSON report with the peak RSS, the CPU and the wall time    #
+#   and the number of events in the input files:                      #
+#     python -m ClusterSubmission.ResourceReport --report <file>      #
+#           --sample <name> --config <hash> --inputList <list>        #
+#           [--catalog <DatasetCatalog>] -- cmd                       #
+#   The number of events is taken from the DatasetCatalog if it knows #
+#   all input files. Only otherwise the files are opened once more.   #
+#   The ResourceModel reads the reports of earlier jobs with the same #
+#   configuration and predicts the startup time, the time per event   #
+#   and the memory of a sample from the reports of the sample itself  #
+#   or, if there are none, from those of samples in the same          #
+#   category, i.e. the same project and derivation.                   #
+#######################################################################
+
+
+def ConfigHash(*args):
+    ### The resource usage depends on the job options and the options of the algorithm like the systematics
+    return hashlib.md5("|".join([str(a) for a in args]).encode()).hexdigest()[:12]
+
+
+def SampleCategory(sample):
+    ### mc16_13TeV.361106.PowhegPythia8EvtGen_AZNLOCTEQ6L1_Zee.deriv.DAOD_SUSY2.e3601_s3126_r9364_p3652 -> mc16_13TeV.DAOD_SUSY2
+    tokens = sample.split(".")
+    fmt = [t for t in tokens if t.startswith("DAOD") or t.startswith("AOD")]
+    return "%s.%s" % (tokens[0], fmt[0] if len(fmt) > 0 else "")
+
+
+def SecondsToTime(seconds):
+    seconds = int(seconds)
+    return "%02d:%02d:%02d" % (seconds / 3600, (seconds % 3600) / 60, seconds % 60)
+
+
+def CountEvents(in_files, tree_name="CollectionTree"):
+    try:
+        import ROOT
+    except ImportError:
+        return -1
+    n_events = 0
+    for in_file in in_files:
+        root_file = ROOT.TFile.Open(in_file, "READ")
+        if not root_file or not root_file.IsOpen(): return -1
+        tree = root_file.Get(tree_name)
+        if tree: n_events += tree.GetEntries()
+        root_file.Close()
+    return n_events
+
+
+def CatalogEvents(in_files, catalog_path):
+    """Number of events of the files according to the DatasetCatalog. Returns -1 if one of them is unknown or changed"""
+    if len(in_files) == 0 or not os.path.isfile(catalog_path): return -1
+    catalog = DatasetCatalog(catalog_path)
+    n_events = 0
+    for in_file in in_files:
+        if not catalog.is_up_to_date(in_file):
+            n_events = -1
+            break
+        n_events += catalog.record(in_file).n_events
+    catalog.close()
+    return n_events
+
+
+def FitStartupAndSlope(n_events, times):
+    """Least-squares fit of time = startup + slope * n_events. The startup time of the job, i.e. the initialization
+       of the tools and the opening of the files, must not enter the time per event. If the reports do not constrain
+       the startup, i.e. they all have the same number of events, or the fit is unphysical the mean time per event is
+       returned without any startup"""
+    n = float(len(n_events))
+    mean_x = sum(n_events) / n
+    mean_y = sum(times) / n
+    var_x = sum([(x - mean_x)**2 for x in n_events])
+    if var_x > 0:
+        slope = sum([(x - mean_x) * (y - mean_y) for x, y in zip(n_events, times)]) / var_x
+        if slope > 0: return max(0., mean_y - slope * mean_x), slope
+    return 0., sum(times) / float(sum(n_events))
+
+
+class ResourceEstimate(object):
+    def __init__(self, reports):
+        self.n_reports = len(reports)
+        self.n_events = sum([r["n_events"] for r in reports])
+        events = [float(r["n_events"]) for r in reports]
+        self.startup_time, self.time_per_event = FitStartupAndSlope(events, [r["wall_time"] for r in reports])
+        self.cpu_startup, self.cpu_per_event = FitStartupAndSlope(events, [r["cpu_time"] for r in reports])
+        self.peak_rss = max([r["peak_rss"] for r in reports])
+
+    def events_per_job(self, target_seconds, safety=1.):
+        ### Each job pays the startup once
+        return max(1, int((target_seconds - self.startup_time * safety) / (self.time_per_event * safety)))
+
+    def memory(self, safety=1.):
+        return int(self.peak_rss * safety) + 1
+
+    def run_time(self, events_per_job, safety=1.):
+        return int((self.startup_time + events_per_job * self.time_per_event) * safety) + 1
+
+
+class ResourceModel(object):
+    def __init__(self, report_dir, config=""):
+        self.__reports = []
+        if os.path.isdir(report_dir):
+            for report_file in os.listdir(report_dir):
+                if not report_file.endswith(".json"): continue
+                try:
+                    with open("%s/%s" % (report_dir, report_file), "r") as in_file:
+                        report = json.load(in_file)
+                except ValueError:
+                    print "WARNING <ResourceModel>: Cannot read the report %s/%s" % (report_dir, report_file)
+                    continue
+                ### Failed jobs and jobs of other configurations tell nothing about the new ones
+                if report.get("exit_code", 1) != 0 or report.get("n_events", -1) <= 0: continue
+                if len(config) > 0 and report.get("config", "") != config: continue
+                self.__reports += [report]
+        print "INFO <ResourceModel>: Found %d usable resource reports in %s" % (len(self.__reports), report_dir)
+
+    def estimate(self, sample):
+        """Returns None if neither the sample nor any sample of its category has been processed before"""
+        reports = [r for r in self.__reports if r["sample"] == sample]
+        if len(reports) == 0: reports = [r for r in self.__reports if SampleCategory(r["sample"]) == SampleCategory(sample)]
+        if len(reports) == 0: return None
+        return ResourceEstimate(reports)
+
+
+def run_monitored(cmd, report_file, sample, config, in_files, catalog_path=""):
+    start = time.time()
+    exit_code = subprocess.call(cmd)
+    wall_time = time.time() - start
+    ### The usage of all finished child processes. ru_maxrss is in kB on Linux
+    usage = resource.getrusage(resource.RUSAGE_CHILDREN)
+    n_events = -1
+    if exit_code == 0:
+        n_events = CatalogEvents(in_files, catalog_path)
+        if n_events < 0: n_events = CountEvents(in_files)
+    report = {
+        "sample": sample,
+        "config": config,
+        "host": socket.gethostname(),
+        "exit_code": exit_code,
+        "wall_time": wall_time,
+        "cpu_time": usage.ru_utime + usage.ru_stime,
+        "peak_rss": usage.ru_maxrss / 1024.,
+        "n_events": n_events,
+    }
+    if report["n_events"] > 0: report["cpu_per_event"] = report["cpu_time"] / report["n_events"]
+    if os.path.dirname(report_file): CreateDirectory(os.path.dirname(report_file), False)
+    with open(report_file + ".tmp", "w") as out_file:
+        json.dump(report, out_file, indent=2, sort_keys=True)
+    os.rename(report_file + ".tmp", report_file)
+    print "INFO <ResourceReport>: %s" % (json.dumps(report, sort_keys=True))
+    return exit_code
+
+
+if __name__ == '__main__':
+    ### Everything after -- is the command to monitor
+    if "--" not in sys.argv:
+        print "ERROR: Please give the command to run after --"
+        exit(1)
+    import argparse
+    parser = argparse.ArgumentParser(prog='ResourceReport', description="Run a command and report its resource usage")
+    parser.add_argument('--report', help='Location of the JSON report', required=True)
+    parser.add_argument('--sample', help='Name of the processed sample', default="")
+    parser.add_argument('--config', help='Hash of the job configuration', default="")
+    parser.add_argument('--inputList', help='Text file with the input files of the job', default="")
+    parser.add_argument('--catalog', help='DatasetCatalog with the number of events of the input files', default="")
+    RunOptions = parser.parse_args(sys.argv[1:sys.argv.index("--")])
+    in_files = ReadListFromFile(RunOptions.inputList) if os.path.isfile(RunOptions.inputList) else []
+    exit(run_monitored(sys.argv[sys.argv.index("--") + 1:], RunOptions.report, RunOptions.sample, RunOptions.config, in_files,
+                       RunOptions.catalog))
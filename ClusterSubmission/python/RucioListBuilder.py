@@ -1,6 +1,7 @@
 #! /usr/bin/env python
 from ClusterSubmission.ListDisk import *
 from ClusterSubmission.Utils import prettyPrint, WriteList
+from ClusterSubmission.DatasetCatalog import DatasetCatalog, FileRecord
 import errno, subprocess
 
 
@@ -25,6 +26,48 @@ def GetDataSetFiles(dsname, RSE, protocols):
     return DS
 
 
+def ParseFileSize(size):
+    ### rucio prints the sizes either in bytes or in human readable decimal units
+    units = {"B": 1, "kB": 1e3, "KB": 1e3, "MB": 1e6, "GB": 1e9, "TB": 1e12}
+    for unit in sorted(units.iterkeys(), key=lambda u: -len(u)):
+        if size.endswith(unit): return int(float(size[:-len(unit)].strip()) * units[unit])
+    return int(size)
+
+
+def GetDataSetMetaData(dsname):
+    """Returns the GUID, the adler32 checksum, the size and the number of events of each file name in the dataset"""
+    meta_data = {}
+    for line in commands.getoutput("rucio list-files --csv %s" % (dsname)).split("\n"):
+        ### <scope>:<name>,<guid>,<adler32>,<size>,<events>
+        columns = line.strip().split(",")
+        if len(columns) != 5 or columns[0].find(":") == -1: continue
+        try:
+            meta_data[columns[0][columns[0].find(":") + 1:]] = (columns[1], columns[2], ParseFileSize(columns[3]),
+                                                                int(columns[4]) if columns[4].isdigit() else -1)
+        except ValueError:
+            print "WARNING: Cannot interpret the file metadata %s" % (line)
+    return meta_data
+
+
+def FillCatalog(catalog_path, dsname, replicas):
+    """Records the replicas of the dataset together with their rucio metadata in the local dataset catalog"""
+    catalog = DatasetCatalog(catalog_path)
+    meta_data = GetDataSetMetaData(dsname)
+    for replica in replicas:
+        if replica[replica.rfind("/") + 1:] not in meta_data: continue
+        guid, checksum, size, n_events = meta_data[replica[replica.rfind("/") + 1:]]
+        ### Local replicas are stamped with their size and modification time. Otherwise the catalog would consider them
+        ### as changed and open them again. The size printed by rucio may be rounded anyway
+        mtime = -1.
+        if os.path.isfile(replica):
+            stat = os.stat(replica)
+            size, mtime = stat.st_size, stat.st_mtime
+        catalog.add_record(FileRecord(replica, size=size, mtime=mtime, n_events=n_events, guid=guid, checksum=checksum))
+    ### Files without the number of events in rucio are opened by the catalog once they are needed
+    catalog.register(dsname, replicas)
+    catalog.close()
+
+
 def GetScopes():
     print "Reading in the scopes:"
     Scopes = commands.getoutput("rucio list-scopes")
@@ -54,6 +97,7 @@ def createFileList(dsname, options):
         print "Remove the old FileList"
         os.system("rm " + filelistname)
     WriteList(DS, filelistname)
+    if len(getattr(options, "catalog", "")) > 0: FillCatalog(options.catalog, dsname, DS)
 
 
 if __name__ == '__main__':
@@ -71,6 +115,7 @@ if __name__ == '__main__':
     parser.add_argument('-r', '-R', '--RSE', help='specify RSE storage element which should be read', default=RSE)
     parser.add_argument(
         '-p', '-P', '--protocols', help="Specify the protocols you want to use for the file list creation. Default: 'dcap'", default="root")
+    parser.add_argument('--catalog', help='Record the files and their rucio metadata in this local dataset catalog', default='')
     RunOptions = parser.parse_args()
 
     # Do we have one dataset, or a file with a list of them?
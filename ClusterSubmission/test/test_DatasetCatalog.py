@@ -0,0 +1,103 @@
+#! /usr/bin/env python
+from ClusterSubmission.DatasetCatalog import DatasetCatalog, FileRecord
+import os, shutil, tempfile, unittest
+
+
+class FakeInspector(object):
+    """Returns the records of a dictionary instead of opening the files with ROOT and counts the inspections"""
+    def __init__(self, records):
+        self.records = records
+        self.inspected = []
+
+    def inspect(self, path):
+        self.inspected += [path]
+        if path not in self.records: return None
+        record = self.records[path]
+        if os.path.isfile(path):
+            record.size = os.stat(path).st_size
+            record.mtime = os.stat(path).st_mtime
+        return record
+
+
+class DatasetCatalogTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+        self.files = ["root://remote//store/file_%d.root" % (i) for i in range(3)]
+        self.inspector = FakeInspector(dict([(f, FileRecord(f, size=100, n_events=6)) for f in self.files]))
+        self.catalog = DatasetCatalog("%s/catalog.db" % (self.tmp_dir), self.inspector)
+
+    def tearDown(self):
+        self.catalog.close()
+        shutil.rmtree(self.tmp_dir)
+
+    def test_register(self):
+        self.catalog.register("mc16_13TeV:mc16_13TeV.123456.Sample.deriv.DAOD_SUSY2/", self.files)
+        self.assertEqual(self.catalog.datasets(), ["mc16_13TeV.123456.Sample.deriv.DAOD_SUSY2"])
+        self.assertEqual(self.catalog.dataset_files("mc16_13TeV.123456.Sample.deriv.DAOD_SUSY2"), sorted(self.files))
+        ### Registering again replaces the files of the dataset
+        self.catalog.register("mc16_13TeV.123456.Sample.deriv.DAOD_SUSY2", self.files[:1])
+        self.assertEqual(self.catalog.dataset_files("mc16_13TeV:mc16_13TeV.123456.Sample.deriv.DAOD_SUSY2"), self.files[:1])
+
+    def test_update(self):
+        self.assertTrue(self.catalog.update(self.files))
+        self.assertEqual(sorted(self.inspector.inspected), sorted(self.files))
+        self.assertEqual(self.catalog.record(self.files[0]).n_events, 6)
+        ### Known files are not inspected again, not even by another instance of the catalog
+        self.catalog.close()
+        self.catalog = DatasetCatalog("%s/catalog.db" % (self.tmp_dir), self.inspector)
+        self.inspector.inspected = []
+        self.assertTrue(self.catalog.update(self.files))
+        self.assertEqual(self.inspector.inspected, [])
+        ### Unreadable files are reported
+        self.assertFalse(self.catalog.update(["root://remote//store/missing.root"]))
+
+    def test_update_local(self):
+        local = "%s/local.root" % (self.tmp_dir)
+        with open(local, "w") as out_file:
+            out_file.write("events")
+        self.inspector.records[local] = FileRecord(local, n_events=10)
+        self.assertTrue(self.catalog.update([local]))
+        self.assertTrue(self.catalog.is_up_to_date(local))
+        ### A record with the size and the modification time of the file, e.g. from the rucio metadata, is up to date
+        stat = os.stat(local)
+        self.catalog.add_record(FileRecord(local, size=stat.st_size, mtime=stat.st_mtime, n_events=10))
+        self.inspector.inspected = []
+        self.assertTrue(self.catalog.update([local]))
+        self.assertEqual(self.inspector.inspected, [])
+        ### Changed files are inspected again
+        with open(local, "a") as out_file:
+            out_file.write(" and more events")
+        self.assertFalse(self.catalog.is_up_to_date(local))
+        self.assertTrue(self.catalog.update([local]))
+        self.assertEqual(self.inspector.inspected, [local])
+
+    def test_split(self):
+        self.assertTrue(self.catalog.update(self.files))
+        ### 18 events do not fit into two jobs of 10 events each if no file is split
+        jobs = self.catalog.split(self.files, events_per_job=10)
+        self.assertEqual(len(jobs), 3)
+        self.assertEqual(sorted(sum(jobs, [])), sorted(self.files))
+        jobs = self.catalog.split(self.files, events_per_job=12)
+        self.assertEqual(len(jobs), 2)
+        for job in jobs:
+            self.assertTrue(sum([self.catalog.record(f).n_events for f in job]) <= 12)
+        ### The size limit is respected as well
+        self.assertEqual(len(self.catalog.split(self.files, events_per_job=12, size_per_job=150)), 3)
+        self.assertEqual(len(self.catalog.split(self.files)), 1)
+        ### A file larger than the limit is a job of its own
+        self.assertEqual(len(self.catalog.split(self.files, events_per_job=4)), 3)
+        self.assertEqual(self.catalog.split(self.files + ["root://remote//store/unknown.root"]), [])
+
+    def test_write_split(self):
+        self.assertTrue(self.catalog.update(self.files))
+        self.assertEqual(self.catalog.write_split(self.files, self.tmp_dir, events_per_job=12), 2)
+        written = []
+        for i in range(2):
+            with open("%s/SplitList_%d.txt" % (self.tmp_dir, i + 1), "r") as in_file:
+                written += [line.strip() for line in in_file if len(line.strip()) > 0]
+        self.assertEqual(sorted(written), sorted(self.files))
+        self.assertFalse(os.path.exists("%s/SplitList_3.txt" % (self.tmp_dir)))
+
+
+if __name__ == '__main__':
+    unittest.main()
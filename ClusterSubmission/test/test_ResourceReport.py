@@ -0,0 +1,70 @@
+#! /usr/bin/env python
+from ClusterSubmission.DatasetCatalog import DatasetCatalog, FileRecord
+from ClusterSubmission.ResourceReport import ResourceEstimate, CatalogEvents, FitStartupAndSlope
+import os, shutil, tempfile, unittest
+
+
+class FakeInspector(object):
+    def inspect(self, path):
+        return FileRecord(path, size=100, n_events=6)
+
+
+def Report(n_events, wall_time, cpu_time=-1., peak_rss=1000.):
+    return {"n_events": n_events, "wall_time": wall_time, "cpu_time": cpu_time if cpu_time >= 0 else wall_time, "peak_rss": peak_rss}
+
+
+class ResourceEstimateTest(unittest.TestCase):
+    def test_fit(self):
+        ### 120 s to start and 0.5 s per event
+        startup, slope = FitStartupAndSlope([1000., 2000., 4000.], [620., 1120., 2120.])
+        self.assertAlmostEqual(startup, 120.)
+        self.assertAlmostEqual(slope, 0.5)
+        ### The startup is not constrained by jobs of the same size
+        startup, slope = FitStartupAndSlope([1000., 1000.], [600., 640.])
+        self.assertEqual(startup, 0.)
+        self.assertAlmostEqual(slope, 0.62)
+        ### Jobs with more events being faster are no basis for a fit
+        startup, slope = FitStartupAndSlope([1000., 2000.], [800., 700.])
+        self.assertEqual(startup, 0.)
+        self.assertAlmostEqual(slope, 0.5)
+
+    def test_estimate(self):
+        estimate = ResourceEstimate([Report(1000, 620., peak_rss=900.), Report(3000, 1620., peak_rss=1100.)])
+        self.assertEqual(estimate.n_reports, 2)
+        self.assertEqual(estimate.n_events, 4000)
+        self.assertAlmostEqual(estimate.startup_time, 120.)
+        self.assertAlmostEqual(estimate.time_per_event, 0.5)
+        self.assertEqual(estimate.memory(), 1101)
+        ### The startup is paid once per job. 3720 s = 120 s + 7200 * 0.5 s
+        self.assertEqual(estimate.events_per_job(3720.), 7200)
+        self.assertEqual(estimate.run_time(7200), 3721)
+        ### The safety factor scales the startup as well
+        self.assertEqual(estimate.events_per_job(3720., 2.), 3480)
+        self.assertEqual(estimate.events_per_job(100.), 1)
+
+
+class CatalogEventsTest(unittest.TestCase):
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+        self.catalog_path = "%s/catalog.db" % (self.tmp_dir)
+        self.files = ["root://remote//store/file_%d.root" % (i) for i in range(3)]
+        catalog = DatasetCatalog(self.catalog_path, FakeInspector())
+        catalog.update(self.files)
+        catalog.close()
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_dir)
+
+    def test_known_files(self):
+        self.assertEqual(CatalogEvents(self.files, self.catalog_path), 18)
+
+    def test_unknown_files(self):
+        ### A single unknown file requires the files to be opened
+        self.assertEqual(CatalogEvents(self.files + ["root://remote//store/unknown.root"], self.catalog_path), -1)
+        self.assertEqual(CatalogEvents(self.files, "%s/missing.db" % (self.tmp_dir)), -1)
+        self.assertFalse(os.path.exists("%s/missing.db" % (self.tmp_dir)))
+        self.assertEqual(CatalogEvents([], self.catalog_path), -1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -1,26 +1,217 @@
-import os
-import math
-import sys
-import re
-
-datatextdir = '/afs/cern.ch/work/t/tphamleh/private/MirtasCode/MuonTriggers18_addPython/source/MuonValidation/data/data18_hi/'
-datasets1 = 'data18_hi.00365498.express_express.recon.AOD.x586.txt'
-datasets2 = 'data18_hi.00365502.express_express.recon.AOD.x586.txt'
-datadir2 = '/eos/atlas/atlastier0/tzero/prod/data18_hi/express_express/00365502/data18_hi.00365502.express_express.recon.AOD.x586'
-datadir1 = '/eos/atlas/atlastier0/tzero/prod/data18_hi/express_express/00365498/data18_hi.00365498.express_express.recon.AOD.x586'
-
-f = open(datatextdir + datasets2, 'r+')
-
-for sample in f:
-    sample=sample.replace("\n","")
-    sampleout=sample.replace(".1","")
-    command = "athena --filesInput=%s/%s MuonValidation/MuonValidationAlgJobOptions.py "%(datadir2, sample)
-    command2 = "mv output_muons.root /afs/cern.ch/work/t/tphamleh/private/MirtasCode/data18_hi.Output/%s"%(sampleout)
-   
-    print ("executing:\n", command)
-    os.system(command)
-    print ("executing:\n", command2)
-    os.system(command2)
-
-f.close()
+#! /usr/bin/env python
+from ClusterSubmission.ClusterEngine import LocalEngine
+from ClusterSubmission.Utils import CreateDirectory, ReadListFromFile, WriteList
+import os, argparse, json, shutil, zlib
 
+#######################################################################
+#   Runs athena locally over a list of AODs. Each file is processed   #
+#   in its own job with its own working directory by the LocalEngine  #
+#   of ClusterSubmission such that several jobs run concurrently.     #
+#   The processed files are recorded in a manifest keyed by the       #
+#   adler32 checksum of the input. The checksum is computed by the    #
+#   job itself while athena is running. Files already in the manifest #
+#   are skipped when the script is started again. An input is found   #
+#   via its path, size and modification time. Only if these changed,  #
+#   e.g. after the file has been copied to another place, and an      #
+#   entry with the same size exists, the checksum of the input is     #
+#   computed to look it up. Finally, the outputs are merged via the   #
+#   hadd jobs of the ClusterSubmission.                               #
+#######################################################################
+
+
+def setupLocalRunParser():
+    parser = argparse.ArgumentParser(
+        prog='runLocalHeavyIon',
+        formatter_class=argparse.ArgumentDefaultsHelpFormatter,
+        description="Run athena in parallel over local AODs and resume from the files which are already processed",
+    )
+    parser.add_argument('--jobName', '-J', help='Name of the job. Defines the log, tmp and merged output directories', required=True)
+    parser.add_argument('--inputFiles', '-i', help='AODs to process', default=[], nargs="+")
+    parser.add_argument('--inputLists', '-l', help='Text files with one AOD per line', default=[], nargs="+")
+    parser.add_argument('--inputDir', help='Directory of the AODs in the lists which are not given by their absolute path', default="")
+    parser.add_argument(
+        "--jobOptions", help="The athena jobOptions file to be executed", default="MuonAnalysis/MuonAnalysisAlgJobOptions.py")
+    parser.add_argument('--athenaOutFile', help='Output file written by the jobOptions', default='AnalysisOutput.root')
+    parser.add_argument('--outDir', help='Directory of the outputs per input file and of the manifest', required=True)
+    parser.add_argument('--BaseFolder', help='Directory of the logs, the tmp directories and the merged output', default=os.getcwd())
+    parser.add_argument('--nJobs', '-j', help='Number of athena jobs running at the same time', type=int, default=4)
+    parser.add_argument('--mergedOutFile', help='Name of the merged output', default="")
+    parser.add_argument('--filesPerMerge', help='Number of files merged in one hadd job', type=int, default=10)
+    parser.add_argument('--noMerge', help='Do not merge the outputs', default=False, action="store_true")
+    return parser
+
+
+### Commands of the jobs calling the functions of this module
+ChecksumCmd = "python -c \"import sys; from MuonAnalysis.runLocalHeavyIon import Adler32; print(Adler32(sys.argv[1]))\""
+StoreCmd = "python -c \"import sys; from MuonAnalysis.runLocalHeavyIon import StoreOutput; StoreOutput(*sys.argv[1:])\""
+
+
+def Adler32(path, chunk_size=64 * 1024 * 1024):
+    checksum = 1
+    with open(path, "rb") as in_file:
+        while True:
+            chunk = in_file.read(chunk_size)
+            if not chunk: break
+            checksum = zlib.adler32(chunk, checksum)
+    return "%08x" % (checksum & 0xffffffff)
+
+
+class RunManifest(object):
+    """Processed input files keyed by their checksum. The size and the modification time of each input are stored
+       as well such that an unchanged file is recognized via its path without reading it. A file which is not
+       recognized is only read to compare its checksum if an entry with the same size exists. Each job leaves its
+       entry in a <output>.json file next to its output which is moved into the manifest by collect()."""
+    def __init__(self, out_dir):
+        self.__out_dir = out_dir
+        self.__path = "%s/manifest.json" % (out_dir)
+        self.__entries = {}
+        if os.path.exists(self.__path):
+            with open(self.__path, "r") as in_file:
+                self.__entries = json.load(in_file)
+            print("INFO <RunManifest>: Found %d processed files in %s" % (len(self.__entries), self.__path))
+        self.__by_input = dict([(entry["input"], key) for key, entry in self.__entries.iteritems()])
+
+    def collect(self):
+        """Adds the entries of the jobs which finished since the manifest has been written"""
+        job_entries = ["%s/%s" % (self.__out_dir, f) for f in os.listdir(self.__out_dir) if f.endswith(".root.json")]
+        for job_entry in job_entries:
+            with open(job_entry, "r") as in_file:
+                for checksum, entry in json.load(in_file).iteritems():
+                    self.__entries[checksum] = entry
+                    self.__by_input[entry["input"]] = checksum
+        self.write()
+        for job_entry in job_entries:
+            os.remove(job_entry)
+        return len(job_entries)
+
+    def checksum(self, in_file):
+        """Returns the checksum of an input already in the manifest and None otherwise"""
+        stat = os.stat(in_file)
+        key = self.__by_input.get(in_file, None)
+        if key is not None and key in self.__entries:
+            entry = self.__entries[key]
+            if entry["input"] == in_file and entry["size"] == stat.st_size and entry["mtime"] == stat.st_mtime: return key
+        ### The file has been moved or touched. Only read it if its content can be in the manifest
+        if not any(entry["size"] == stat.st_size for entry in self.__entries.itervalues()): return None
+        key = Adler32(in_file)
+        if key not in self.__entries or self.__entries[key]["size"] != stat.st_size: return None
+        print("INFO <RunManifest>: %s has the same checksum as %s" % (in_file, self.__entries[key]["input"]))
+        return key
+
+    def is_done(self, checksum):
+        return checksum in self.__entries and os.path.exists(self.__entries[checksum]["output"])
+
+    def output(self, checksum):
+        return self.__entries[checksum]["output"]
+
+    def write(self):
+        ### Write to a temporary file first that an interrupted write does not destroy the manifest
+        with open(self.__path + ".tmp", "w") as out_file:
+            json.dump(self.__entries, out_file, indent=2, sort_keys=True)
+        os.rename(self.__path + ".tmp", self.__path)
+
+
+def OutputName(out_dir, in_file, checksum):
+    base_name = os.path.basename(in_file)
+    if base_name.endswith(".1"): base_name = base_name[:-2]
+    if base_name.endswith(".root"): base_name = base_name[:-5]
+    return "%s/%s.%s.root" % (out_dir, base_name, checksum)
+
+
+def StoreOutput(in_file, out_dir, athena_out, checksum):
+    """Called by the job once athena succeeded. Moves the output to its final place and records it for the manifest"""
+    out_file = OutputName(out_dir, in_file, checksum)
+    ### The TMPDIR of the job may be on another file system than the out_dir. The output is copied
+    ### next to its final place first such that the last rename cannot leave a truncated file
+    shutil.move(athena_out, out_file + ".part")
+    os.rename(out_file + ".part", out_file)
+    stat = os.stat(in_file)
+    entry = {checksum: {"input": in_file, "output": out_file, "size": stat.st_size, "mtime": stat.st_mtime}}
+    with open(out_file + ".json.tmp", "w") as out_json:
+        json.dump(entry, out_json)
+    os.rename(out_file + ".json.tmp", out_file + ".json")
+
+
+if __name__ == '__main__':
+    RunOptions = setupLocalRunParser().parse_args()
+
+    in_files = [f for f in RunOptions.inputFiles]
+    for in_list in RunOptions.inputLists:
+        for f in ReadListFromFile(in_list):
+            in_files += [f if f.startswith("/") or not RunOptions.inputDir else "%s/%s" % (RunOptions.inputDir, f)]
+    in_files = [os.path.realpath(f) for f in in_files]
+    if len(in_files) == 0:
+        print("ERROR: Please give at least one input file")
+        exit(1)
+    missing = [f for f in in_files if not os.path.exists(f)]
+    if len(missing) > 0:
+        print("ERROR: The input files %s do not exist" % (", ".join(missing)))
+        exit(1)
+
+    out_dir = os.path.realpath(RunOptions.outDir)
+    CreateDirectory(out_dir, False)
+    manifest = RunManifest(out_dir)
+    ### Outputs of an interrupted earlier run
+    n_collected = manifest.collect()
+    if n_collected > 0: print("INFO: Found %d outputs of an earlier run which are not yet in the manifest" % (n_collected))
+
+    outputs = []
+    to_process = []
+    for in_file in in_files:
+        checksum = manifest.checksum(in_file)
+        if checksum is not None and manifest.is_done(checksum):
+            print("INFO: Skip %s which is already processed into %s" % (in_file, manifest.output(checksum)))
+            outputs += [manifest.output(checksum)]
+            continue
+        to_process += [in_file]
+    print("INFO: %d of %d files need to be processed" % (len(to_process), len(in_files)))
+
+    if len(to_process) > 0:
+        engine = LocalEngine(jobName=RunOptions.jobName, baseDir=RunOptions.BaseFolder, maxCurrentJobs=max(1, RunOptions.nJobs))
+        CreateDirectory(engine.log_dir(), False)
+        CreateDirectory(engine.config_dir(), False)
+        ### Each job runs in the TMPDIR of its thread. The checksum of the input is computed next to athena
+        ### and the output is moved to its final place if both succeeded
+        cmds = []
+        for i, in_file in enumerate(to_process):
+            job_script = "%s/athena_%d.sh" % (engine.config_dir(), i + 1)
+            WriteList([
+                "#!/bin/bash",
+                "%s %s > checksum.txt &" % (ChecksumCmd, in_file),
+                "CHECKSUM_PID=$!",
+                "athena --filesInput=%s %s || exit 1" % (in_file, RunOptions.jobOptions),
+                "wait ${CHECKSUM_PID} || exit 1",
+                "%s %s %s %s $(cat checksum.txt)" % (StoreCmd, in_file, out_dir, RunOptions.athenaOutFile),
+            ], job_script)
+            cmds += ["bash %s" % (job_script)]
+        cmd_list = "%s/athena_cmds.txt" % (engine.config_dir())
+        WriteList(cmds, cmd_list)
+        engine.submit_array(script="ClusterSubmission/Run.sh", sub_job="athena", env_vars=[("ListOfCmds", cmd_list)], array_size=len(cmds))
+        engine.finish()
+
+        manifest.collect()
+        failed = []
+        for in_file in to_process:
+            checksum = manifest.checksum(in_file)
+            if checksum is None or not manifest.is_done(checksum):
+                failed += [in_file]
+                continue
+            outputs += [manifest.output(checksum)]
+        if len(failed) > 0:
+            print("ERROR: %d files failed. Check the logs in %s and start the script again to process them" %
+                  (len(failed), engine.log_dir()))
+            for f in failed:
+                print("        %s" % (f))
+            exit(1)
+
+    if RunOptions.noMerge: exit(0)
+    ### The merge runs in a second engine since the first one has already executed its threads
+    merge_engine = LocalEngine(jobName=RunOptions.jobName, baseDir=RunOptions.BaseFolder, maxCurrentJobs=max(1, RunOptions.nJobs))
+    CreateDirectory(merge_engine.log_dir(), False)
+    merged_name = RunOptions.mergedOutFile if len(RunOptions.mergedOutFile) > 0 else RunOptions.jobName
+    merge = merge_engine.create_merge_interface(out_name=merged_name, files_to_merge=outputs, files_per_job=RunOptions.filesPerMerge)
+    if not merge.submit_job():
+        print("ERROR: Could not schedule the merge of the outputs")
+        exit(1)
+    merge_engine.finish()
+    print("INFO: Merged %d files into %s/%s.root" % (len(outputs), merge_engine.out_dir(), merged_name))
@@ -0,0 +1,71 @@
+#include "CentralityLookup.h"
+
+#include <TError.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace XAMPP {
+    CentralityLookup::CentralityLookup() : m_edges(), m_percentiles() {}
+    bool CentralityLookup::load(const std::string& calib_file) {
+        m_edges.clear();
+        m_percentiles.clear();
+        std::ifstream in(calib_file);
+        if (!in.good()) {
+            Error("CentralityLookup::load()", "Could not open the centrality calibration %s", calib_file.c_str());
+            return false;
+        }
+        std::vector<std::pair<float, float>> bins;
+        std::string line;
+        while (std::getline(in, line)) {
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            std::stringstream columns(line);
+            std::pair<float, float> bin;
+            if (!(columns >> bin.first >> bin.second)) {
+                Error("CentralityLookup::load()", "Malformed line '%s' in %s", line.c_str(), calib_file.c_str());
+                return false;
+            }
+            bins.push_back(bin);
+        }
+        if (bins.empty()) {
+            Error("CentralityLookup::load()", "No centrality bins found in %s", calib_file.c_str());
+            return false;
+        }
+        std::sort(bins.begin(), bins.end());
+        for (const auto& bin : bins) {
+            m_edges.push_back(bin.first);
+            m_percentiles.push_back(bin.second);
+        }
+        Info("CentralityLookup::load()", "Read %lu centrality bins from %s", m_edges.size(), calib_file.c_str());
+        return true;
+    }
+    bool CentralityLookup::write(const std::string& calib_file, const std::map<float, float>& lowest_edges) {
+        if (lowest_edges.empty()) {
+            Error("CentralityLookup::write()", "No centrality percentiles to write to %s", calib_file.c_str());
+            return false;
+        }
+        std::ofstream out(calib_file, std::ios::out | std::ios::trunc);
+        out << "# <lower FCal sum ET edge [TeV]>   <centrality percentile>" << std::endl;
+        // Enough digits to read back the same floats
+        out.precision(9);
+        for (const auto& bin : lowest_edges) out << bin.second << "   " << bin.first << std::endl;
+        out.close();
+        if (out.fail()) {
+            Error("CentralityLookup::write()", "Failed to write the centrality calibration %s", calib_file.c_str());
+            return false;
+        }
+        Info("CentralityLookup::write()", "Wrote %lu centrality bins to %s", lowest_edges.size(), calib_file.c_str());
+        return true;
+    }
+    bool CentralityLookup::isLoaded() const { return !m_edges.empty(); }
+    float CentralityLookup::percentile(float fcal_et) const {
+        // First edge above the FCal sum ET. The bin before contains it
+        std::vector<float>::const_iterator next = std::upper_bound(m_edges.begin(), m_edges.end(), fcal_et);
+        if (next == m_edges.begin()) return m_percentiles.front();
+        return m_percentiles[next - m_edges.begin() - 1];
+    }
+    size_t CentralityLookup::nBins() const { return m_edges.size(); }
+}  // namespace XAMPP
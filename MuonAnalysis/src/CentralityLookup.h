@@ -0,0 +1,37 @@
+#ifndef MUONANALYSIS_CENTRALITYLOOKUP_H
+#define MUONANALYSIS_CENTRALITYLOOKUP_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+//###############################################################################
+//  Centrality percentile as function of the FCal sum ET                       #
+//  The calibration is read once from a text file with one bin per line:       #
+//      <lower FCal sum ET edge [TeV]>   <centrality percentile>               #
+//  Empty lines and lines starting with # are skipped. The bins are sorted     #
+//  by their lower edge and the bin containing the FCal sum ET is found by a   #
+//  binary search. Values below the lowest edge belong to the lowest bin.      #
+//  No table is shipped. write() creates one from the lowest FCal sum ET which #
+//  the HICentralityTool assigned to each percentile in a job over the data.   #
+//###############################################################################
+namespace XAMPP {
+    class CentralityLookup {
+    public:
+        CentralityLookup();
+        ~CentralityLookup() = default;
+
+        bool load(const std::string& calib_file);
+        bool isLoaded() const;
+        // Key: centrality percentile, value: lowest FCal sum ET [TeV] of the percentile
+        static bool write(const std::string& calib_file, const std::map<float, float>& lowest_edges);
+
+        float percentile(float fcal_et) const;
+        size_t nBins() const;
+
+    private:
+        std::vector<float> m_edges;
+        std::vector<float> m_percentiles;
+    };
+}  // namespace XAMPP
+#endif
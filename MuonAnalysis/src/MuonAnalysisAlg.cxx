@@ -3,6 +3,8 @@
 
 // System include(s):
 #include <memory>
+#include <cmath>
+#include <algorithm>
 #include <cstdlib>
 #include <string>
 #include <iostream>
@@ -71,6 +73,8 @@
 
 
 #include "TrigDecisionTool/ChainGroup.h"
+#include "TrigDecisionTool/FeatureContainer.h"
+#include "FourMomUtils/xAODP4Helpers.h"
 //#include "METInterface/IMETMaker.h"
 //#include <METInterface/IMETSystematicsTool.h>
 //#include "IsolationSelection/IsolationSelectionTool.h"
@@ -105,10 +109,63 @@
 
 using CxxUtils::make_unique;
 
+namespace {
+  // Shallow copy calibrated for a systematic variation. It is not recorded to the store but owned here
+  template <class Container> struct SystCopy {
+    Container* container = nullptr;
+    xAOD::ShallowAuxContainer* aux = nullptr;
+    ~SystCopy() {
+      delete container;
+      delete aux;
+    }
+  };
+  // MET rebuilt for a systematic variation
+  struct SystMet {
+    std::unique_ptr<xAOD::MissingETContainer> container;
+    std::unique_ptr<xAOD::MissingETAuxContainer> aux;
+    xAOD::MissingETContainer& make() {
+      container = make_unique<xAOD::MissingETContainer>();
+      aux = make_unique<xAOD::MissingETAuxContainer>();
+      container->setStore(aux.get());
+      container->reserve(10);
+      return *container;
+    }
+  };
+}  // namespace
+
 namespace XAMPP {
   MuonAnalysisAlg::MuonAnalysisAlg( const std::string& name, ISvcLocator* pSvcLocator ) : AthAnalysisAlgorithm( name, pSvcLocator ){
 
     //declareProperty( "Property", m_nProperty = 0, "My Example Integer Property" ); //example property declaration
+    declareProperty( "GoodRunsLists", m_grlFiles = std::vector<std::string>{
+                       "GoodRunsLists/data15_13TeV/20170619/data15_13TeV.periodAllYear_DetStatus-v89-pro21-02_Unknown_PHYS_StandardGRL_All_Good_25ns.xml",
+                       "GoodRunsLists/data16_13TeV/20180129/data16_13TeV.periodAllYear_DetStatus-v89-pro21-01_DQDefects-00-02-04_PHYS_StandardGRL_All_Good_25ns.xml",
+                       "GoodRunsLists/data16_hip/20161216/data16_hip8TeV.periodAllYear_DetStatus-v86-pro20-19_DQDefects-00-02-04_PHYS_HeavyIonP_All_Good.xml",
+                       "GoodRunsLists/data17_13TeV/20180619/data17_13TeV.periodAllYear_DetStatus-v99-pro22-01_Unknown_PHYS_StandardGRL_All_Good_25ns_Triggerno17e33prim.xml",
+                       "GoodRunsLists/data18_13TeV/20190318/data18_13TeV.periodAllYear_DetStatus-v102-pro22-04_Unknown_PHYS_StandardGRL_All_Good_25ns_Triggerno17e33prim.xml"},
+                     "GRL xml files applied to data. They are only read if the job runs on data" );
+    declareProperty( "GRLLookupCache", m_grlLookupCache = "", "Binary file shared across the jobs to store the parsed GRL intervals" );
+    declareProperty( "MuonTriggers", m_muonTriggerNames = std::vector<std::string>{"HLT_mu15", "HLT_mu15_L1MU10", "HLT_mu15_L1MU6"},
+                     "Single muon chains whose decision and per muon match are written" );
+    declareProperty( "SelectionTrigger", m_selectionTrigger = "HLT_mu15", "Chain to which the selected muons in data must be matched" );
+    declareProperty( "TriggerMatchDR", m_triggerMatchDR = 0.05, "Maximum dR between the offline and the online muon" );
+    declareProperty( "ValidateTriggerMatching", m_validateTriggerMatching = false,
+                     "Compare the match matrix with the Trig::MatchingTool and fail if they differ" );
+    declareProperty( "CentralityRunSpecies", m_centralityRunSpecies = "pPb2016", "Run species of the HICentralityTool" );
+    declareProperty( "CentralityCalibFile", m_centralityCalibFile = "",
+                     "Text file with the lower FCal sum ET edges [TeV] and the centrality percentiles of the bins" );
+    declareProperty( "ValidateCentrality", m_validateCentrality = false,
+                     "Compare the FCal sum ET and the centrality with the HICentralityTool and fail if they differ" );
+    declareProperty( "CentralityTableOutput", m_centralityTableOutput = "",
+                     "Write the lowest FCal sum ET of each percentile of the HICentralityTool as CentralityCalibFile at finalize" );
+    declareProperty( "SUSYToolsConfig", m_susyToolsConfig = "MuonAnalysis/MySUSYTools.conf", "Config file of SUSYTools" );
+    declareProperty( "RunSystematics", m_runSystematics = false, "Write a muonTree_<variation> for each kinematic systematic" );
+    declareProperty( "Systematics", m_systematicNames = std::vector<std::string>{},
+                     "Kinematic systematics to run. If empty all kinematic systematics of SUSYTools are run" );
+    declareProperty( "MinSelectedMuons", m_minSelectedMuons = 0, "Skim: Minimum number of selected muons of the written events" );
+    declareProperty( "MinMetTST", m_minMetTST = -1., "Skim: Minimum TST MET [GeV] of the written events. Negative values disable the cut" );
+    declareProperty( "TreeBasketSize", m_treeBasketSize = 0, "Basket size of the branches of the output trees. 0 keeps the ROOT default" );
+    declareProperty( "TreeAutoFlush", m_treeAutoFlush = 0, "AutoFlush setting of the output trees. 0 keeps the ROOT default" );
     //declareProperty("EventInfoHandler", m_XAMPPInfo, "The XAMPPInfo event Handler");
 
   }
@@ -136,6 +193,15 @@ namespace XAMPP {
     //CHECK( histSvc()->regHist("/MYSTREAM/muonHist", m_muonHist) ); //registers histogram to output stream
 
 
+    // Processed and written events with their sum of weights. Filled before the skim
+    m_eventCounter = new TH1D("EventCounter", "EventCounter", 4, 0.5, 4.5);
+    m_eventCounter->Sumw2();
+    m_eventCounter->GetXaxis()->SetBinLabel(1, "Processed events");
+    m_eventCounter->GetXaxis()->SetBinLabel(2, "Processed sum of weights");
+    m_eventCounter->GetXaxis()->SetBinLabel(3, "Written events");
+    m_eventCounter->GetXaxis()->SetBinLabel(4, "Written sum of weights");
+    CHECK( histSvc()->regHist("/MuonAnalysis/EventCounter", m_eventCounter) );
+
     m_muonTree = new TTree("muonTree","muonTree");
     m_muonTree->Branch("runNumber",   &m_runNumber);
     m_muonTree->Branch("eventNumber",   &m_eventNumber);
@@ -143,12 +209,29 @@ namespace XAMPP {
     m_muonTree->Branch("isMC",   &m_isMC);
     m_muonTree->Branch("eventPassesGRL", &eventPassesGRL);
 
-    m_muonTree->Branch("HLT_mu15",          &m_HLT_mu15);
-    m_muonTree->Branch("HLT_mu15_L1MU10", &m_HLT_mu15_L1MU10);
-    m_muonTree->Branch("HLT_mu15_L1MU6", &m_HLT_mu15_L1MU6);
-    m_muonTree->Branch("match_HLT_mu15",          &match_HLT_mu15);
-    m_muonTree->Branch("match_HLT_mu15_L1MU10",          &match_HLT_mu15_L1MU10);
-    m_muonTree->Branch("match_HLT_mu15_L1MU6",          &match_HLT_mu15_L1MU6);
+    // The branches point into m_muonTriggers which must not be resized afterwards
+    m_muonTriggers.clear();
+    m_selectionTriggerIdx = m_muonTriggerNames.size();
+    for (const auto& chain : m_muonTriggerNames) {
+      if (chain == m_selectionTrigger) m_selectionTriggerIdx = m_muonTriggers.size();
+      m_muonTriggers.push_back(MuonTrigger{chain, false, {}, {}, {}});
+    }
+    if (m_selectionTriggerIdx == m_muonTriggers.size()) {
+      ATH_MSG_FATAL( "The selection trigger " << m_selectionTrigger << " is not part of the MuonTriggers" );
+      return StatusCode::FAILURE;
+    }
+    for (auto& trigger : m_muonTriggers) m_muonTree->Branch(trigger.name.c_str(), &trigger.passed);
+    for (auto& trigger : m_muonTriggers) m_muonTree->Branch(("match_" + trigger.name).c_str(), &trigger.matched);
+    // The muon buffers are owned by the algorithm and reused in each event
+    const size_t reserved_muons = 8;
+    for (auto& trigger : m_muonTriggers) trigger.matched.reserve(reserved_muons);
+    m_muon_pt.reserve(reserved_muons);
+    m_muon_eta.reserve(reserved_muons);
+    m_muon_phi.reserve(reserved_muons);
+    m_muon_charge.reserve(reserved_muons);
+    m_muon_quality.reserve(reserved_muons);
+    m_muon_type.reserve(reserved_muons);
+    m_selectedMuons.reserve(reserved_muons);
     m_muonTree->Branch("muon_pt",    &m_muon_pt);
     m_muonTree->Branch("muon_eta",    &m_muon_eta);
     m_muonTree->Branch("muon_phi",    &m_muon_phi);
@@ -161,7 +244,7 @@ namespace XAMPP {
     m_muonTree->Branch("MetTST_mpy", &MetTST_mpy);
     m_muonTree->Branch("MetTST_met", &MetTST_met);
     m_muonTree->Branch("MetTST_sumet", &MetTST_sumet);
-    m_muonTree->Branch("MetTST_phi", &MetTST_met);
+    m_muonTree->Branch("MetTST_phi", &MetTST_phi);
     m_muonTree->Branch("MetTST_et_tst", &MetTST_et_tst);
     m_muonTree->Branch("MetTST_et_el", &MetTST_et_el);
     m_muonTree->Branch("MetTST_et_ph", &MetTST_et_ph);
@@ -172,7 +255,7 @@ namespace XAMPP {
     m_muonTree->Branch("MetCST_mpy", &MetCST_mpy);
     m_muonTree->Branch("MetCST_met", &MetCST_met);
     m_muonTree->Branch("MetCST_sumet", &MetCST_sumet);
-    m_muonTree->Branch("MetCST_phi", &MetCST_met);
+    m_muonTree->Branch("MetCST_phi", &MetCST_phi);
     /*m_muonTree->Branch("MetCST_et_cst", &MetCST_et_cst);
     m_muonTree->Branch("MetCST_et_el", &MetCST_et_el);
     m_muonTree->Branch("MetCST_et_ph", &MetCST_et_ph);
@@ -193,13 +276,17 @@ namespace XAMPP {
     m_muonTree->Branch("Centrality", &Centrality);
     m_muonTree->Branch("ETsumFCal", &ETsumFCal);
     m_muonTree->Branch("nPVx", &nPVx);
+    TuneTree(m_muonTree);
 
 
     m_tdt.setTypeAndName("Trig::TrigDecisionTool/TrigDecisionTool");
     CHECK( m_tdt.initialize() );
 
-    m_tmt.setTypeAndName("Trig::MatchingTool/MyMatchingTool");
-    CHECK( m_tmt.initialize() );
+    // The match matrix is built from the online muons directly. The matching tool is only needed for the validation
+    if (m_validateTriggerMatching) {
+      m_tmt.setTypeAndName("Trig::MatchingTool/MyMatchingTool");
+      CHECK( m_tmt.initialize() );
+    }
 
     m_muonSelection.setTypeAndName("CP::MuonSelectionTool/MyMuonSelectionTool");
     CHECK( m_muonSelection.initialize() );
@@ -215,6 +302,23 @@ namespace XAMPP {
 
     CHECK( histSvc()->regTree("/MuonAnalysis/muonTree", m_muonTree) ); //registers tree to output stream inside a sub-directory
 
+    // The centrality calibration is loaded once. Without a table the HICentralityTool provides the percentiles
+    if (!m_centralityCalibFile.empty() && !m_centralityLookup.load(PathResolverFindCalibFile(m_centralityCalibFile))) {
+      ATH_MSG_FATAL( "Failed to read the centrality calibration " << m_centralityCalibFile );
+      return StatusCode::FAILURE;
+    }
+    if (!m_centralityLookup.isLoaded() || m_validateCentrality || !m_centralityTableOutput.empty()) {
+      m_centralityTool = make_unique<HI::HICentralityTool>("CentralityTool");
+      CHECK( m_centralityTool->setProperty("RunSpecies", m_centralityRunSpecies) );
+      CHECK( m_centralityTool->initialize() );
+    }
+
+    // SUSYTools is set up once for the whole job instead of in each event
+    m_susyTools = make_unique<ST::SUSYObjDef_xAOD>("SUSYObjDef_xAOD");
+    if (!m_susyToolsConfig.empty()) CHECK( m_susyTools->setProperty("ConfigFile", PathResolverFindCalibFile(m_susyToolsConfig)) );
+    CHECK( m_susyTools->initialize() );
+    if (m_runSystematics) CHECK( SetupSystematics() );
+
 
 
     return StatusCode::SUCCESS;
@@ -225,7 +329,7 @@ namespace XAMPP {
     //
     //Things that happen once at the end of the event loop go here
     //
-
+    if (!m_centralityTableOutput.empty() && !CentralityLookup::write(m_centralityTableOutput, m_centralityEdges)) return StatusCode::FAILURE;
 
     return StatusCode::SUCCESS;
   }
@@ -268,15 +372,17 @@ namespace XAMPP {
     //if (!isMC) std::cout << "This is data" << std::endl;
     if (m_isMC) isData = false;
 
+    // The bookkeeping includes the events removed by the skim below
+    const double event_weight = m_isMC ? ei->mcEventWeight() : 1.;
+    m_eventCounter->Fill(1);
+    m_eventCounter->Fill(2, event_weight);
 
 
-    m_HLT_mu15 = m_tdt->isPassed("HLT_mu15");
-    m_HLT_mu15_L1MU10 = m_tdt->isPassed("HLT_mu15_L1MU10");
-    m_HLT_mu15_L1MU6 = m_tdt->isPassed("HLT_mu15_L1MU6");
 
     // loop over muons and save them in vectors
     const xAOD::MuonContainer* CalibMuons = 0;
     CHECK( evtStore()->retrieve(CalibMuons,"CalibratedMuons") );
+    CHECK( MatchMuonTriggers(CalibMuons) );
 
     //const xAOD::MuonRoIContainer* muonrois = 0;
     //CHECK( evtStore()->retrieve(muonrois, "LVL1MuonRoIs") );
@@ -299,196 +405,90 @@ namespace XAMPP {
     CP::CorrectionCode::enableFailure();
 
 
-    // GRL tool
-    asg::AnaToolHandle<IGoodRunsListSelectionTool> m_grl;
-    if (isData) {
-      m_grl.setTypeAndName("GoodRunsListSelectionTool/grl");
-      m_grl.isUserConfigured();
+    // The GRLs are parsed once into sorted lumi block intervals per run at the first data event. Simulation does not need them
+    if (isData && !m_grlLoaded) {
       std::vector<std::string> myGRLs;
-
-      myGRLs.push_back(PathResolverFindCalibFile("GoodRunsLists/data15_13TeV/20170619/data15_13TeV.periodAllYear_DetStatus-v89-pro21-02_Unknown_PHYS_StandardGRL_All_Good_25ns.xml"));
-      myGRLs.push_back(PathResolverFindCalibFile("GoodRunsLists/data16_13TeV/20180129/data16_13TeV.periodAllYear_DetStatus-v89-pro21-01_DQDefects-00-02-04_PHYS_StandardGRL_All_Good_25ns.xml"));
-      myGRLs.push_back(PathResolverFindCalibFile("GoodRunsLists/data16_hip/20161216/data16_hip8TeV.periodAllYear_DetStatus-v86-pro20-19_DQDefects-00-02-04_PHYS_HeavyIonP_All_Good.xml"));
-      myGRLs.push_back(PathResolverFindCalibFile("GoodRunsLists/data17_13TeV/20180619/data17_13TeV.periodAllYear_DetStatus-v99-pro22-01_Unknown_PHYS_StandardGRL_All_Good_25ns_Triggerno17e33prim.xml"));
-      myGRLs.push_back(PathResolverFindCalibFile("GoodRunsLists/data18_13TeV/20190318/data18_13TeV.periodAllYear_DetStatus-v102-pro22-04_Unknown_PHYS_StandardGRL_All_Good_25ns_Triggerno17e33prim.xml"));
-
-      ANA_CHECK( m_grl.setProperty("GoodRunsListVec", myGRLs) );
-      ANA_CHECK( m_grl.setProperty("PassThrough", false) );
-      ANA_CHECK( m_grl.retrieve() );
-
-      ATH_MSG_INFO( "GRL tool retrieve & initialized... " );
+      for (const auto& grl : m_grlFiles) myGRLs.push_back(PathResolverFindCalibFile(grl));
+      if (!m_grlLookup.load(myGRLs, m_grlLookupCache)) {
+        ATH_MSG_FATAL( "Failed to read the GRLs" );
+        return StatusCode::FAILURE;
+      }
+      m_grlLoaded = true;
     }
+    eventPassesGRL = true;
+    if (isData) eventPassesGRL = m_grlLookup.passRunLB(ei->runNumber(), ei->lumiBlock());
 
-    bool eventPassesGRL(true);
-    if (isData) eventPassesGRL = m_grl->passRunLB(ei->runNumber(), ei->lumiBlock());
-
-    std::string config_file = "/srv01/cgrp/users/jpham/Wanalysis_AthAnalysis21.2.69_withSUSYTools/source/MuonAnalysis/data/MySUSYTools.conf";
-
-    // Create the tool(s) to test:
-    ST::SUSYObjDef_xAOD objTool("SUSYObjDef_xAOD");
-    ANA_MSG_INFO(" ABOUT TO INITIALIZE SUSYTOOLS " );
-
-    if(!config_file.empty()) ANA_CHECK( objTool.setProperty("ConfigFile", config_file) );
-
-    if ( objTool.initialize() != StatusCode::SUCCESS) {
-      ANA_MSG_ERROR( "Cannot initialize SUSYObjDef_xAOD..." );
-      ANA_MSG_ERROR( "Exiting... " );
-      exit(-1);
-    } else {
-      ANA_MSG_INFO( "SUSYObjDef_xAOD initialized... " );
+    // Nominal objects calibrated by SUSYTools. They are shared with all variations which do not affect them
+    if (m_susyTools->resetSystematics() != CP::SystematicCode::Ok) {
+      ATH_MSG_ERROR( "Cannot reset SUSYTools to the nominal calibration" );
+      return StatusCode::FAILURE;
     }
-    ANA_MSG_INFO(" INITIALIZED SUSYTOOLS " );
-
-    std::vector<std::string> mu_triggers {"HLT_mu15", "HLT_mu15_L1MU10", "HLT_mu15_L1MU6", "HLT_mu26_ivarmedium", "HLT_mu20_iloose_L1MU15"};
 
     // // Photons
     xAOD::PhotonContainer* photons_nominal(0);
     xAOD::ShallowAuxContainer* photons_nominal_aux(0);
     //if( !xStream.Contains("SUSY12") )//&& !xStream.Contains("SUSY8") ) // Martin : TBC
-    ANA_CHECK( objTool.GetPhotons(photons_nominal,photons_nominal_aux) );
+    ANA_CHECK( m_susyTools->GetPhotons(photons_nominal,photons_nominal_aux) );
 
     // Muons
     xAOD::MuonContainer* muons_nominal(0);
     xAOD::ShallowAuxContainer* muons_nominal_aux(0);
-    ANA_CHECK( objTool.GetMuons(muons_nominal, muons_nominal_aux) );
+    ANA_CHECK( m_susyTools->GetMuons(muons_nominal, muons_nominal_aux) );
 
     // Electrons
     xAOD::ElectronContainer* electrons_nominal(0);
     xAOD::ShallowAuxContainer* electrons_nominal_aux(0);
     //if( !xStream.Contains("SUSY8") ) //SMP derivation, no electrons, no photons // Martin : TBC
-    ANA_CHECK( objTool.GetElectrons(electrons_nominal, electrons_nominal_aux) );
+    ANA_CHECK( m_susyTools->GetElectrons(electrons_nominal, electrons_nominal_aux) );
 
     // Jets
     xAOD::JetContainer* jets_nominal(0);
     xAOD::ShallowAuxContainer* jets_nominal_aux(0);
-    ANA_CHECK( objTool.GetJets(jets_nominal, jets_nominal_aux) );
+    ANA_CHECK( m_susyTools->GetJets(jets_nominal, jets_nominal_aux) );
 
     // TrackJets
     xAOD::JetContainer* trkjets_nominal(0);
     xAOD::ShallowAuxContainer* trkjets_nominal_aux(0);
-    //ANA_CHECK( objTool.GetTrackJets(trkjets_nominal, trkjets_nominal_aux) );
+    //ANA_CHECK( m_susyTools->GetTrackJets(trkjets_nominal, trkjets_nominal_aux) );
 
     //Taus
     //xAOD::TauJetContainer* taus_nominal(0);
     //xAOD::ShallowAuxContainer* taus_nominal_aux(0);
     ////if(xStream.Contains("SUSY3")){
-      //ANA_CHECK( objTool.GetTaus(taus_nominal,taus_nominal_aux) );
+      //ANA_CHECK( m_susyTools->GetTaus(taus_nominal,taus_nominal_aux) );
     ////}
 
 
     // MET
-    xAOD::MissingETContainer* metcst_nominal = new xAOD::MissingETContainer;
-    xAOD::MissingETAuxContainer* metcst_nominal_aux = new xAOD::MissingETAuxContainer;
-    metcst_nominal->setStore(metcst_nominal_aux);
+    auto metcst_nominal = make_unique<xAOD::MissingETContainer>();
+    auto metcst_nominal_aux = make_unique<xAOD::MissingETAuxContainer>();
+    metcst_nominal->setStore(metcst_nominal_aux.get());
     metcst_nominal->reserve(10);
 
-    double metsig_cst (0.);
-
-    xAOD::MissingETContainer* mettst_nominal = new xAOD::MissingETContainer;
-    xAOD::MissingETAuxContainer* mettst_nominal_aux = new xAOD::MissingETAuxContainer;
-    mettst_nominal->setStore(mettst_nominal_aux);
+    auto mettst_nominal = make_unique<xAOD::MissingETContainer>();
+    auto mettst_nominal_aux = make_unique<xAOD::MissingETAuxContainer>();
+    mettst_nominal->setStore(mettst_nominal_aux.get());
     mettst_nominal->reserve(10);
 
-    double metsig_tst (0.);
-
-    xAOD::MissingETContainer* mettrack_nominal = new xAOD::MissingETContainer;
-    xAOD::MissingETAuxContainer* mettrack_nominal_aux = new xAOD::MissingETAuxContainer;
-    mettrack_nominal->setStore(mettrack_nominal_aux);
+    auto mettrack_nominal = make_unique<xAOD::MissingETContainer>();
+    auto mettrack_nominal_aux = make_unique<xAOD::MissingETAuxContainer>();
+    mettrack_nominal->setStore(mettrack_nominal_aux.get());
     mettrack_nominal->reserve(10);
 
-    double metsig_track (0.);
-
-    // Generic pointers for either nominal or systematics copy
+    // The variations are processed in ProcessSystematics() before the skim
     xAOD::ElectronContainer* electrons(electrons_nominal);
     xAOD::PhotonContainer* photons(photons_nominal);
     xAOD::MuonContainer* muons(muons_nominal);
     xAOD::JetContainer* jets(jets_nominal);
-    xAOD::JetContainer* trkjets(trkjets_nominal);
-    //xAOD::TauJetContainer* taus(taus_nominal);
-    xAOD::MissingETContainer* metcst(metcst_nominal);
-    xAOD::MissingETContainer* mettst(mettst_nominal);
-    xAOD::MissingETContainer* mettrack(mettrack_nominal);
-    // Aux containers too
-    xAOD::MissingETAuxContainer* metcst_aux(metcst_nominal_aux);
-    xAOD::MissingETAuxContainer* mettst_aux(mettst_nominal_aux);
-    xAOD::MissingETAuxContainer* mettrack_aux(mettrack_nominal_aux);
-
-    xAOD::JetContainer* goodJets = new xAOD::JetContainer(SG::VIEW_ELEMENTS);
-
-    /*// If necessary (kinematics affected), make a shallow copy with the variation applied
-    bool syst_affectsElectrons = ST::testAffectsObject(xAOD::Type::Electron, sysInfo.affectsType);
-    bool syst_affectsMuons = ST::testAffectsObject(xAOD::Type::Muon, sysInfo.affectsType);
-    bool syst_affectsTaus = ST::testAffectsObject(xAOD::Type::Tau, sysInfo.affectsType);
-    bool syst_affectsPhotons = ST::testAffectsObject(xAOD::Type::Photon, sysInfo.affectsType);
-    bool syst_affectsJets = ST::testAffectsObject(xAOD::Type::Jet, sysInfo.affectsType);
-    bool syst_affectsBTag = ST::testAffectsObject(xAOD::Type::BTag, sysInfo.affectsType);
-    //      bool syst_affectsMET = ST::testAffectsObject(xAOD::Type::MissingET, sysInfo.affectsType);
-
-    if (sysInfo.affectsKinematics) {
-        if (syst_affectsElectrons) {
-          xAOD::ElectronContainer* electrons_syst(0);
-          xAOD::ShallowAuxContainer* electrons_syst_aux(0);
-          ANA_CHECK( objTool.GetElectrons(electrons_syst, electrons_syst_aux) );
-          electrons = electrons_syst;
-        }
+    xAOD::MissingETContainer* metcst(metcst_nominal.get());
+    xAOD::MissingETContainer* mettst(mettst_nominal.get());
+    xAOD::MissingETContainer* mettrack(mettrack_nominal.get());
 
-        if (syst_affectsMuons) {
-          xAOD::MuonContainer* muons_syst(0);
-          xAOD::ShallowAuxContainer* muons_syst_aux(0);
-          ANA_CHECK( objTool.GetMuons(muons_syst, muons_syst_aux) );
-          muons = muons_syst;
-        }
+      ANA_CHECK( m_susyTools->GetMET(*metcst,jets,electrons,muons,photons,0,false,false) );  // 0 for taus, false(1) for CST and false(2) No JVT if you use CST
 
-      	//if(syst_affectsTaus) {
-      	  //xAOD::TauJetContainer* taus_syst(0);
-      	  //xAOD::ShallowAuxContainer* taus_syst_aux(0);
-      	  //if(xStream.Contains("SUSY3")){
-      	    //ANA_CHECK( objTool.GetTaus(taus_syst,taus_syst_aux) );
-      	  //}
-      	  //taus = taus_syst;
-      	//}
-
-        if(syst_affectsPhotons) {
-          xAOD::PhotonContainer* photons_syst(0);
-          xAOD::ShallowAuxContainer* photons_syst_aux(0);
-          ANA_CHECK( objTool.GetPhotons(photons_syst,photons_syst_aux) );
-          photons = photons_syst;
-        }
-
-        if (syst_affectsJets) {
-          xAOD::JetContainer* jets_syst(0);
-          xAOD::ShallowAuxContainer* jets_syst_aux(0);
-          ANA_CHECK( objTool.GetJetsSyst(*jets_nominal, jets_syst, jets_syst_aux) );
-          jets = jets_syst;
-        }
+      ANA_CHECK( m_susyTools->GetMET(*mettst,jets,electrons,muons,photons,0,true,true) );    // 0 for taus, true(1) for TST and true(2)  JVT if you use TST
 
-        //if (syst_affectsBTag) {
-          //xAOD::JetContainer* trkjets_syst(0);
-          //xAOD::ShallowAuxContainer* trkjets_syst_aux(0);
-          //ANA_CHECK( objTool.GetTrackJets(trkjets_syst, trkjets_syst_aux) );
-          //trkjets = trkjets_syst;
-        //}
-
-        xAOD::MissingETContainer* metcst_syst = new xAOD::MissingETContainer;
-        xAOD::MissingETAuxContainer* metcst_syst_aux = new xAOD::MissingETAuxContainer;
-        xAOD::MissingETContainer* mettst_syst = new xAOD::MissingETContainer;
-        xAOD::MissingETAuxContainer* mettst_syst_aux = new xAOD::MissingETAuxContainer;
-        metcst_syst->setStore(metcst_syst_aux);
-        mettst_syst->setStore(mettst_syst_aux);
-        metcst_nominal->reserve(10);
-        metcst_nominal->reserve(10);
-
-        metcst = metcst_syst;
-        mettst = mettst_syst;
-        metcst_aux = metcst_syst_aux;
-        mettst_aux = mettst_syst_aux;
-      } */
-
-      ANA_CHECK( objTool.GetMET(*metcst,jets,electrons,muons,photons,0,false,false) );  // 0 for taus, false(1) for CST and false(2) No JVT if you use CST
-
-      ANA_CHECK( objTool.GetMET(*mettst,jets,electrons,muons,photons,0,true,true) );    // 0 for taus, true(1) for TST and true(2)  JVT if you use TST
-
-      ANA_CHECK( objTool.GetTrackMET(*mettrack,jets,electrons,muons) );
+      ANA_CHECK( m_susyTools->GetTrackMET(*mettrack,jets,electrons,muons) );
 
       MetTST_mpx = (*mettst_nominal)["Final"]->mpx()/1000.;
       MetTST_mpy = (*mettst_nominal)["Final"]->mpy()/1000.;
@@ -553,85 +553,91 @@ namespace XAMPP {
 
 
 
-    for(const auto *muon_itr: *CalibMuons) {
-        bool m_match_HLT_mu15=m_tmt->match( *muon_itr, "HLT_mu15", 0.05, false);
-        match_HLT_mu15->push_back(m_match_HLT_mu15);
-
-        bool m_match_HLT_mu15_L1MU10=m_tmt->match( *muon_itr, "HLT_mu15_L1MU10", 0.05, false);
-        match_HLT_mu15_L1MU10->push_back(m_match_HLT_mu15_L1MU10);
-
-        bool m_match_HLT_mu15_L1MU6=m_tmt->match( *muon_itr, "HLT_mu15_L1MU6", 0.05, false);
-        match_HLT_mu15_L1MU6->push_back(m_match_HLT_mu15_L1MU6);
-
-        xAOD::Muon::Quality my_quality;
-        my_quality = m_muonSelection->getQuality(*muon_itr);
-
-        if ((m_isMC || (!m_isMC && m_HLT_mu15 && m_match_HLT_mu15)) && muon_itr->pt()/1000.>=15. && m_muonSelection->accept(*muon_itr) && m_isoSelection->accept(*muon_itr) ) {
-          if (m_isoSelection->accept( *muon_itr )) printf(" Muon passes Isolation - ");
-          m_muon_pt->push_back(muon_itr->pt()/1000);
-          m_muon_quality->push_back(my_quality);
-          m_muon_eta->push_back(muon_itr->eta());
-          m_muon_phi->push_back(muon_itr->phi());
-          m_muon_charge->push_back(muon_itr->charge());
-          m_muon_type->push_back(muon_itr->muonType());
-
-
-
-
-      } // close if ((isMC || (!isMC && m_HLT_mu15 && m_match_HLT_mu15)) && muon_itr->pt()/1000.>=25. && m_muonSelection->accept(*muon_itr) && m_isoSelection->accept(*muon_itr) && fabs(muon_itr->eta())<=2.4 && my_quality == 0 && muon_itr->muonType() == 0) {
-    } //close main muon loop
-
-
+    // The skim is evaluated before any branch is filled
+    m_selectedMuons.clear();
+    for (size_t m = 0; m < CalibMuons->size(); ++m) {
+      if (SelectMuon(*CalibMuons->at(m), m)) m_selectedMuons.push_back(m);
+    }
+    bool pass_skim = PassSkim(m_selectedMuons.size(), MetTST_met);
+    // The event is written if it passes the skim in any of the variations. Their trees are filled below
+    if (m_runSystematics) {
+      NominalObjects nominal{electrons_nominal, photons_nominal, muons_nominal, jets_nominal, mettst_nominal.get(), metcst_nominal.get(),
+                             mettrack_nominal.get()};
+      CHECK( ProcessSystematics(nominal) );
+      for (const auto& out : m_systOutputs) pass_skim = pass_skim || out->passSkim;
+    }
+    if (!pass_skim) return StatusCode::SUCCESS;
 
     const xAOD::VertexContainer * vertices = 0;
     ATH_CHECK( evtStore()->retrieve (vertices, "PrimaryVertices"));
     nPVx = vertices->size();
     if(vertices->size()<2) return StatusCode::SUCCESS;
-    xAOD::VertexContainer::const_iterator vtx_itr = vertices->begin();
-    xAOD::VertexContainer::const_iterator vtx_end = vertices->end();
-    // find primary vertex
+    // One pass to find the primary vertex and the pile-up vertices with more than 6 tracks
     const xAOD::Vertex* primaryVertex = 0;
-    for(;vtx_itr!=vtx_end;++vtx_itr) {
-          if((*vtx_itr)->vertexType()==xAOD::VxType::PriVtx) {
-                primaryVertex = (*vtx_itr);
-                m_vertex_x = primaryVertex->x();
-                m_vertex_y = primaryVertex->y();
-                m_vertex_z = primaryVertex->z();
-               break;
-          }
-     }
-
-    const xAOD::Vertex* pileup = 0;
-    int pile_up_vertices=0;
-    int trackn = 0;
-    for(;vtx_itr!=vtx_end;++vtx_itr) {
-          if((*vtx_itr)->vertexType()==xAOD::VxType::PileUp) {
-                pileup = (*vtx_itr);
-                trackn = pileup->nTrackParticles();
-                if(trackn>6) pile_up_vertices=1;
-            }
-       }//if the number of tracks>6 then this is a pile up vertex
-     auto centTool = make_unique<HI::HICentralityTool>("CentralityTool");
-     ANA_CHECK( centTool->setProperty("RunSpecies","pPb2016") );
-     ANA_CHECK( centTool->initialize() );
-     ETsumFCal = centTool->getCentralityEstimator();
-     if (!pile_up_vertices) Centrality = centTool->getCentralityPercentile();
+    bool pile_up_vertices = false;
+    for (const xAOD::Vertex* vtx : *vertices) {
+      if (!primaryVertex && vtx->vertexType() == xAOD::VxType::PriVtx) {
+        primaryVertex = vtx;
+        m_vertex_x = primaryVertex->x();
+        m_vertex_y = primaryVertex->y();
+        m_vertex_z = primaryVertex->z();
+      } else if (vtx->vertexType() == xAOD::VxType::PileUp && vtx->nTrackParticles() > 6) {
+        pile_up_vertices = true;
+      }
+    }
+    CHECK( ReadFCalEnergy(ETsumFCal) );
+    // Events with pile-up have no centrality
+    Centrality = -1;
+    if (!pile_up_vertices) {
+      Centrality = m_centralityLookup.isLoaded() ? m_centralityLookup.percentile(ETsumFCal) : m_centralityTool->getCentralityPercentile();
+    }
+    if (!m_centralityTableOutput.empty() && !pile_up_vertices) {
+      const float tool_centrality = m_centralityTool->getCentralityPercentile();
+      std::map<float, float>::iterator edge = m_centralityEdges.find(tool_centrality);
+      if (edge == m_centralityEdges.end()) m_centralityEdges[tool_centrality] = ETsumFCal;
+      else edge->second = std::min(edge->second, ETsumFCal);
+    }
+    if (m_validateCentrality) {
+      const float tool_fcal = m_centralityTool->getCentralityEstimator();
+      const float tool_centrality = pile_up_vertices ? -1 : m_centralityTool->getCentralityPercentile();
+      if (tool_fcal != ETsumFCal || tool_centrality != Centrality) {
+        ATH_MSG_ERROR( "Event " << m_eventNumber << ": FCal sum ET " << ETsumFCal << " TeV and centrality " << Centrality
+                       << " differ from the ones of the HICentralityTool " << tool_fcal << " TeV, " << tool_centrality );
+        return StatusCode::FAILURE;
+      }
+    }
 
+    const size_t n_chains = m_muonTriggers.size();
+    for (auto& trigger : m_muonTriggers) trigger.matched.clear();
+    for (size_t m = 0; m < CalibMuons->size(); ++m) {
+      const char* matches = &m_triggerMatches[m * n_chains];
+      for (size_t c = 0; c < n_chains; ++c) m_muonTriggers[c].matched.push_back(matches[c]);
+    }
+    // Trigger matched, identified and isolated muons
+    m_muon_pt.clear();
+    m_muon_eta.clear();
+    m_muon_phi.clear();
+    m_muon_charge.clear();
+    m_muon_quality.clear();
+    m_muon_type.clear();
+    for (size_t m : m_selectedMuons) {
+      const xAOD::Muon* muon_itr = CalibMuons->at(m);
+      m_muon_pt.push_back(muon_itr->pt()/1000);
+      m_muon_quality.push_back(MuonQuality(*muon_itr));
+      m_muon_eta.push_back(muon_itr->eta());
+      m_muon_phi.push_back(muon_itr->phi());
+      m_muon_charge.push_back(muon_itr->charge());
+      m_muon_type.push_back(muon_itr->muonType());
+    }
 
 
-    ////////////////////
 
+    ////////////////////
 
+    for (const auto& out : m_systOutputs) out->tree->Fill();
     m_muonTree->Fill();
-    match_HLT_mu15->clear();
-    match_HLT_mu15_L1MU10->clear();
-    match_HLT_mu15_L1MU6->clear();
-    m_muon_pt->clear();
-    m_muon_eta->clear();
-    m_muon_phi->clear();
-    m_muon_charge->clear();
-    m_muon_quality->clear();
-    m_muon_type->clear();
+    m_eventCounter->Fill(3);
+    m_eventCounter->Fill(4, event_weight);
 
 
 
@@ -661,6 +667,110 @@ namespace XAMPP {
     return StatusCode::SUCCESS;
   }
 
+  StatusCode MuonAnalysisAlg::MatchMuonTriggers(const xAOD::MuonContainer* muons) {
+    const size_t n_chains = m_muonTriggers.size();
+    m_triggerMatches.assign(muons->size() * n_chains, false);
+    // Copies of the muons, e.g. the ones of SUSYTools, look up their row via the original muon
+    m_originalMuons = nullptr;
+    m_matchRows.clear();
+    for (size_t m = 0; m < muons->size(); ++m) {
+      const xAOD::IParticle* original = xAOD::getOriginalObject(*muons->at(m));
+      if (!original) original = muons->at(m);
+      if (m_originalMuons && original->container() != m_originalMuons) {
+        ATH_MSG_ERROR( "The muons of the trigger match matrix are not copies of the same container" );
+        return StatusCode::FAILURE;
+      }
+      m_originalMuons = original->container();
+      if (m_matchRows.size() <= original->index()) m_matchRows.resize(original->index() + 1, -1);
+      m_matchRows[original->index()] = m;
+    }
+    for (size_t c = 0; c < n_chains; ++c) {
+      MuonTrigger& trigger = m_muonTriggers[c];
+      trigger.passed = m_tdt->isPassed(trigger.name);
+      trigger.online_eta.clear();
+      trigger.online_phi.clear();
+      // Chains which did not fire have no online muons in the physics condition
+      if (!trigger.passed) continue;
+      // The online muons are fetched once per chain instead of once per offline muon
+      const Trig::FeatureContainer features = m_tdt->features(trigger.name);
+      for (const auto& feature : features.containerFeature<xAOD::MuonContainer>()) {
+        if (!feature.cptr()) continue;
+        for (const xAOD::Muon* online : *feature.cptr()) {
+          trigger.online_eta.push_back(online->eta());
+          trigger.online_phi.push_back(online->phi());
+        }
+      }
+      for (size_t m = 0; m < muons->size(); ++m) {
+        const double eta = muons->at(m)->eta();
+        const double phi = muons->at(m)->phi();
+        for (size_t o = 0; o < trigger.online_eta.size(); ++o) {
+          // Same metric as the matching tool, i.e. xAOD::P4Helpers::deltaR with the pseudorapidity
+          const double deta = eta - trigger.online_eta[o];
+          const double dphi = xAOD::P4Helpers::deltaPhi(phi, trigger.online_phi[o]);
+          if (std::sqrt(deta * deta + dphi * dphi) < m_triggerMatchDR) {
+            m_triggerMatches[m * n_chains + c] = true;
+            break;
+          }
+        }
+      }
+    }
+    if (!m_validateTriggerMatching) return StatusCode::SUCCESS;
+    for (size_t m = 0; m < muons->size(); ++m) {
+      for (size_t c = 0; c < n_chains; ++c) {
+        const bool reference = m_tmt->match(*muons->at(m), m_muonTriggers[c].name, m_triggerMatchDR, false);
+        if (reference == bool(m_triggerMatches[m * n_chains + c])) continue;
+        ATH_MSG_ERROR( "Muon " << m << " in event " << m_eventNumber << ": the matching tool " << (reference ? "matches" : "does not match")
+                       << " it to " << m_muonTriggers[c].name << " unlike the match matrix" );
+        return StatusCode::FAILURE;
+      }
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  bool MuonAnalysisAlg::MatchRow(const xAOD::Muon& muon, size_t& row) const {
+    const xAOD::IParticle* original = xAOD::getOriginalObject(muon);
+    if (!original) original = &muon;
+    if (original->container() != m_originalMuons || original->index() >= m_matchRows.size() || m_matchRows[original->index()] < 0)
+      return false;
+    row = m_matchRows[original->index()];
+    return true;
+  }
+
+  bool MuonAnalysisAlg::PassSkim(size_t n_selected_muons, float met_tst) const {
+    return n_selected_muons >= m_minSelectedMuons && (m_minMetTST < 0. || met_tst >= m_minMetTST);
+  }
+
+  bool MuonAnalysisAlg::SelectMuon(const xAOD::Muon& muon, size_t idx) {
+    // Data events require the muon to be matched to the selection trigger
+    if (!m_isMC && (!m_muonTriggers[m_selectionTriggerIdx].passed ||
+                    !m_triggerMatches[idx * m_muonTriggers.size() + m_selectionTriggerIdx]))
+      return false;
+    return muon.pt() / 1000. >= 15. && PassMuonSelection(muon) && PassMuonIsolation(muon);
+  }
+
+  void MuonAnalysisAlg::TuneTree(TTree* tree) const {
+    if (m_treeBasketSize > 0) tree->SetBasketSize("*", m_treeBasketSize);
+    if (m_treeAutoFlush != 0) tree->SetAutoFlush(m_treeAutoFlush);
+  }
+
+  xAOD::Muon::Quality MuonAnalysisAlg::MuonQuality(const xAOD::Muon& muon) {
+    static SG::AuxElement::Decorator<int> dec_quality("MuonAnalysisQuality");
+    if (!dec_quality.isAvailable(muon)) dec_quality(muon) = m_muonSelection->getQuality(muon);
+    return static_cast<xAOD::Muon::Quality>(dec_quality(muon));
+  }
+
+  bool MuonAnalysisAlg::PassMuonSelection(const xAOD::Muon& muon) {
+    static SG::AuxElement::Decorator<char> dec_selection("MuonAnalysisPassSelection");
+    if (!dec_selection.isAvailable(muon)) dec_selection(muon) = bool(m_muonSelection->accept(muon));
+    return dec_selection(muon);
+  }
+
+  bool MuonAnalysisAlg::PassMuonIsolation(const xAOD::Muon& muon) {
+    static SG::AuxElement::Decorator<char> dec_isolation("MuonAnalysisPassIsolation");
+    if (!dec_isolation.isAvailable(muon)) dec_isolation(muon) = bool(m_isoSelection->accept(muon));
+    return dec_isolation(muon);
+  }
+
   double MuonAnalysisAlg::get_dR(const double eta1, const double phi1, const double eta2, const double phi2) {
       double deta = fabs(eta1 - eta2);
       double dphi = fabs(phi1 - phi2) < TMath::Pi() ? fabs(phi1 - phi2) : 2*TMath:: \
@@ -668,40 +778,188 @@ namespace XAMPP {
       return sqrt(deta*deta + dphi*dphi);
     }
 
-  /*double MuonAnalysisAlg::ReturnFCalEnergy() {
-        const xAOD::VertexContainer * vertices = 0;
-        ATH_CHECK( evtStore()->retrieve (vertices, "PrimaryVertices"));
-        xAOD::VertexContainer::const_iterator vtx_itr = vertices->begin();
-        xAOD::VertexContainer::const_iterator vtx_end = vertices->end();
-        const xAOD::Vertex* pileup = 0;
-        int pile_up_vertices=0;
-        int trackn = 0;
-        for(;vtx_itr!=vtx_end;++vtx_itr) {
-              if((*vtx_itr)->vertexType()==xAOD::VxType::PileUp) {
-                    pileup = (*vtx_itr);
-                    trackn = pileup->nTrackParticles();
-                    if(trackn>6) pile_up_vertices=1;
-                }
-           }//if the number of tracks>6 then this is a pile up vertex
-       auto centTool = make_unique<HI::HICentralityTool>("CentralityTool");
-       ANA_CHECK( centTool->setProperty("RunSpecies","pPb2016") );
-       ANA_CHECK( centTool->initialize() );
-    	double ETsumFCal = 0;
-      ETsumFCal = centTool->getCentralityEstimator();
-      return ETsumFCal;
-    	float Centrality = 0;
-    	if (!pile_up_vertices) Centrality = centTool->getCentralityPercentile();
-
-  	  const xAOD::HIEventShapeContainer *hiue(0);
-      CHECK( evtStore()->retrieve(hiue,"CaloSums") );
-  	  xAOD::HIEventShapeContainer::const_iterator es_itr = hiue->begin();
-  	  xAOD::HIEventShapeContainer::const_iterator es_end = hiue->end();
-  	  double m_fcalEt = 0;
-  	  for (;es_itr!=es_end;es_itr++ ) {
-  	      float et = (*es_itr)->et();
-  	      const std::string name = (*es_itr)->auxdataConst<std::string>("Summary");
-  	      if (name=="FCal") m_fcalEt = et*1e-6;
-  	    }
-  	  return m_fcalEt;
-  	}*/
+  StatusCode MuonAnalysisAlg::ReadFCalEnergy(float& fcal_et) {
+    const xAOD::HIEventShapeContainer* hiue = 0;
+    CHECK( evtStore()->retrieve(hiue, "CaloSums") );
+    static SG::AuxElement::ConstAccessor<std::string> acc_summary("Summary");
+    // The layout of CaloSums is the same in all events. Search for the FCal entry only if the cached one does not match
+    if (m_fcalIndex >= hiue->size() || acc_summary(*hiue->at(m_fcalIndex)) != "FCal") {
+      m_fcalIndex = hiue->size();
+      for (size_t i = 0; i < hiue->size(); ++i) {
+        if (acc_summary(*hiue->at(i)) == "FCal") m_fcalIndex = i;
+      }
+      if (m_fcalIndex == hiue->size()) {
+        ATH_MSG_ERROR( "No FCal entry in CaloSums" );
+        return StatusCode::FAILURE;
+      }
+    }
+    fcal_et = hiue->at(m_fcalIndex)->et() * 1e-6;
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode MuonAnalysisAlg::SetupSystematics() {
+    m_systOutputs.clear();
+    for (const auto& syst : m_systematicNames) {
+      bool known = false;
+      for (const ST::SystInfo& info : m_susyTools->getSystInfoList()) known = known || info.systset.name() == syst;
+      if (!known) ATH_MSG_WARNING( "The systematic " << syst << " is not known to SUSYTools" );
+    }
+    for (const ST::SystInfo& info : m_susyTools->getSystInfoList()) {
+      // The nominal is written with the SUSYTools muons as well, such that the variations have a common reference.
+      // Variations only changing the weights leave the muons and the MET untouched
+      const bool nominal = info.systset.name().empty();
+      if (!nominal && !info.affectsKinematics) continue;
+      if (!nominal && !m_systematicNames.empty() &&
+          std::find(m_systematicNames.begin(), m_systematicNames.end(), info.systset.name()) == m_systematicNames.end())
+        continue;
+      std::unique_ptr<SystOutput> out = make_unique<SystOutput>();
+      out->info = info;
+      out->name = nominal ? "Nominal" : info.systset.name();
+      const std::string tree_name = "muonTree_" + out->name;
+      out->tree = new TTree(tree_name.c_str(), tree_name.c_str());
+      out->tree->Branch("runNumber", &m_runNumber);
+      out->tree->Branch("eventNumber", &m_eventNumber);
+      out->tree->Branch("muon_pt", &out->muon_pt);
+      out->tree->Branch("muon_eta", &out->muon_eta);
+      out->tree->Branch("muon_phi", &out->muon_phi);
+      out->tree->Branch("muon_charge", &out->muon_charge);
+      out->tree->Branch("muon_quality", &out->muon_quality);
+      out->tree->Branch("muon_type", &out->muon_type);
+      out->tree->Branch("MetTST_met", &out->MetTST_met);
+      out->tree->Branch("MetTST_mpx", &out->MetTST_mpx);
+      out->tree->Branch("MetTST_mpy", &out->MetTST_mpy);
+      out->tree->Branch("MetTST_phi", &out->MetTST_phi);
+      out->tree->Branch("MetTST_sumet", &out->MetTST_sumet);
+      out->tree->Branch("MetCST_met", &out->MetCST_met);
+      out->tree->Branch("MetCST_mpx", &out->MetCST_mpx);
+      out->tree->Branch("MetCST_mpy", &out->MetCST_mpy);
+      out->tree->Branch("MetCST_phi", &out->MetCST_phi);
+      out->tree->Branch("MetCST_sumet", &out->MetCST_sumet);
+      out->tree->Branch("MetTrack_met", &out->MetTrack_met);
+      out->tree->Branch("MetTrack_mpx", &out->MetTrack_mpx);
+      out->tree->Branch("MetTrack_mpy", &out->MetTrack_mpy);
+      out->tree->Branch("MetTrack_phi", &out->MetTrack_phi);
+      out->tree->Branch("MetTrack_sumet", &out->MetTrack_sumet);
+      TuneTree(out->tree);
+      CHECK( histSvc()->regTree("/MuonAnalysis/" + tree_name, out->tree) );
+      m_systOutputs.push_back(std::move(out));
+    }
+    ATH_MSG_INFO( "Write " << m_systOutputs.size() << " trees with the nominal and the kinematic systematic variations" );
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode MuonAnalysisAlg::ProcessSystematics(const NominalObjects& nominal) {
+    for (auto& out : m_systOutputs) {
+      const ST::SystInfo& info = out->info;
+      if (info.systset.name().empty()) {
+        CHECK( FillSystOutput(*out, nominal.muons, nominal.mettst, nominal.metcst, nominal.mettrack) );
+        continue;
+      }
+      if (m_susyTools->applySystematicVariation(info.systset) != CP::SystematicCode::Ok) {
+        ATH_MSG_ERROR( "Cannot apply the systematic variation " << out->name );
+        return StatusCode::FAILURE;
+      }
+      const bool affects_electrons = ST::testAffectsObject(xAOD::Type::Electron, info.affectsType);
+      const bool affects_muons = ST::testAffectsObject(xAOD::Type::Muon, info.affectsType);
+      const bool affects_photons = ST::testAffectsObject(xAOD::Type::Photon, info.affectsType);
+      const bool affects_jets = ST::testAffectsObject(xAOD::Type::Jet, info.affectsType);
+
+      // Only the containers affected by the variation are calibrated again. The others are the nominal ones
+      const xAOD::ElectronContainer* electrons = nominal.electrons;
+      const xAOD::MuonContainer* muons = nominal.muons;
+      const xAOD::PhotonContainer* photons = nominal.photons;
+      const xAOD::JetContainer* jets = nominal.jets;
+      SystCopy<xAOD::ElectronContainer> electrons_syst;
+      SystCopy<xAOD::MuonContainer> muons_syst;
+      SystCopy<xAOD::PhotonContainer> photons_syst;
+      SystCopy<xAOD::JetContainer> jets_syst;
+      if (affects_electrons) {
+        CHECK( m_susyTools->GetElectrons(electrons_syst.container, electrons_syst.aux, false) );
+        electrons = electrons_syst.container;
+      }
+      if (affects_muons) {
+        CHECK( m_susyTools->GetMuons(muons_syst.container, muons_syst.aux, false) );
+        muons = muons_syst.container;
+      }
+      if (affects_photons) {
+        CHECK( m_susyTools->GetPhotons(photons_syst.container, photons_syst.aux, false) );
+        photons = photons_syst.container;
+      }
+      if (affects_jets) {
+        CHECK( m_susyTools->GetJetsSyst(*nominal.jets, jets_syst.container, jets_syst.aux, false) );
+        jets = jets_syst.container;
+      }
+
+      // The MET terms are rebuilt if one of their inputs or their soft term is varied
+      const bool affects_objects = affects_electrons || affects_muons || affects_photons || affects_jets;
+      const xAOD::MissingETContainer* mettst = nominal.mettst;
+      const xAOD::MissingETContainer* metcst = nominal.metcst;
+      const xAOD::MissingETContainer* mettrack = nominal.mettrack;
+      SystMet mettst_syst, metcst_syst, mettrack_syst;
+      if (affects_objects || info.affectsType == ST::SystObjType::MET_TST) {
+        CHECK( m_susyTools->GetMET(mettst_syst.make(), jets, electrons, muons, photons, 0, true, true) );
+        mettst = mettst_syst.container.get();
+      }
+      if (affects_objects || info.affectsType == ST::SystObjType::MET_CST) {
+        CHECK( m_susyTools->GetMET(metcst_syst.make(), jets, electrons, muons, photons, 0, false, false) );
+        metcst = metcst_syst.container.get();
+      }
+      if (affects_electrons || affects_muons || affects_jets || info.affectsType == ST::SystObjType::MET_Track) {
+        CHECK( m_susyTools->GetTrackMET(mettrack_syst.make(), jets, electrons, muons) );
+        mettrack = mettrack_syst.container.get();
+      }
+      CHECK( FillSystOutput(*out, muons, mettst, metcst, mettrack) );
+    }
+    if (m_susyTools->resetSystematics() != CP::SystematicCode::Ok) {
+      ATH_MSG_ERROR( "Cannot reset SUSYTools to the nominal calibration" );
+      return StatusCode::FAILURE;
+    }
+    return StatusCode::SUCCESS;
+  }
+
+  StatusCode MuonAnalysisAlg::FillSystOutput(SystOutput& out, const xAOD::MuonContainer* muons, const xAOD::MissingETContainer* mettst,
+                                             const xAOD::MissingETContainer* metcst, const xAOD::MissingETContainer* mettrack) {
+    // The SUSYTools muons and the CalibratedMuons of the match matrix are shallow copies of Muons. Their order may differ
+    out.muon_pt.clear();
+    out.muon_eta.clear();
+    out.muon_phi.clear();
+    out.muon_charge.clear();
+    out.muon_quality.clear();
+    out.muon_type.clear();
+    for (size_t m = 0; m < muons->size(); ++m) {
+      const xAOD::Muon* muon = muons->at(m);
+      size_t row = 0;
+      if (!MatchRow(*muon, row)) {
+        ATH_MSG_ERROR( "Muon " << m << " of " << out.name << " is not a copy of one of the muons of the trigger match matrix" );
+        return StatusCode::FAILURE;
+      }
+      if (!SelectMuon(*muon, row)) continue;
+      out.muon_pt.push_back(muon->pt() / 1000);
+      out.muon_eta.push_back(muon->eta());
+      out.muon_phi.push_back(muon->phi());
+      out.muon_charge.push_back(muon->charge());
+      out.muon_quality.push_back(MuonQuality(*muon));
+      out.muon_type.push_back(muon->muonType());
+    }
+    const xAOD::MissingET* tst = (*mettst)["Final"];
+    out.MetTST_met = tst->met() / 1000.;
+    out.MetTST_mpx = tst->mpx() / 1000.;
+    out.MetTST_mpy = tst->mpy() / 1000.;
+    out.MetTST_phi = tst->phi();
+    out.MetTST_sumet = tst->sumet() / 1000.;
+    const xAOD::MissingET* cst = (*metcst)["Final"];
+    out.MetCST_met = cst->met() / 1000.;
+    out.MetCST_mpx = cst->mpx() / 1000.;
+    out.MetCST_mpy = cst->mpy() / 1000.;
+    out.MetCST_phi = cst->phi();
+    out.MetCST_sumet = cst->sumet() / 1000.;
+    const xAOD::MissingET* track = (*mettrack)["Track"];
+    out.MetTrack_met = track->met() / 1000.;
+    out.MetTrack_mpx = track->mpx() / 1000.;
+    out.MetTrack_mpy = track->mpy() / 1000.;
+    out.MetTrack_phi = track->phi();
+    out.MetTrack_sumet = track->sumet() / 1000.;
+    out.passSkim = PassSkim(out.muon_pt.size(), out.MetTST_met);
+    return StatusCode::SUCCESS;
+  }
 }
@@ -10,6 +10,10 @@
 //#include <HIEventUtils/IHICentralityTool.h>
 //#include <HIEventUtils/HICentralityTool.h>
 #include "xAODHIEvent/HIEventShape.h"
+#include "xAODMuon/MuonContainer.h"
+#include "xAODEgamma/ElectronContainer.h"
+#include "xAODEgamma/PhotonContainer.h"
+#include "xAODJet/JetContainer.h"
 #include "xAODTracking/TrackParticleContainer.h"
 #include "xAODTracking/VertexContainer.h"
 #include "xAODTracking/TrackingPrimitives.h"
@@ -30,6 +34,7 @@
 #include <XAMPPbase/AnalysisConfig.h>
 
 #include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/GoodRunsLookup.h>
 #include <XAMPPbase/IAnalysisHelper.h>
 #include <XAMPPbase/IAnalysisModule.h>
 
@@ -48,6 +53,8 @@
 #include <HIEventUtils/HICentralityTool.h>
 #include "CxxUtils/make_unique.h"
 
+#include "CentralityLookup.h"
+
 
 
 //Example ROOT Includes
@@ -112,9 +119,6 @@ namespace XAMPP {
      float m_runNumber;
      float m_eventNumber;
      float m_lumiBlock;
-     bool m_HLT_mu15;
-     bool m_HLT_mu15_L1MU6;
-     bool m_HLT_mu15_L1MU10;
      bool m_isMC;
      bool eventPassesGRL;
 
@@ -159,12 +163,12 @@ namespace XAMPP {
      int nPVx;
      float m_vertex_x, m_vertex_y, m_vertex_z;
 
-     std::vector<float> *m_muon_pt=0;
-     std::vector<float> *m_muon_eta=0;
-     std::vector<float> *m_muon_phi=0;
-     std::vector<float> *m_muon_charge=0;
-     std::vector<unsigned int> *m_muon_quality=0;
-     std::vector<unsigned int> *m_muon_type=0;
+     std::vector<float> m_muon_pt;
+     std::vector<float> m_muon_eta;
+     std::vector<float> m_muon_phi;
+     std::vector<float> m_muon_charge;
+     std::vector<unsigned int> m_muon_quality;
+     std::vector<unsigned int> m_muon_type;
 
      std::vector<float> *m_Lmuon_pt=0;
      std::vector<float> *m_Lmuon_eta=0;
@@ -222,10 +226,86 @@ namespace XAMPP {
      std::vector<float> *m_CBtrackLink_d0sig=0;
      std::vector<float> *m_CBtrackLink_z0sig=0;
 
-     std::vector<bool> *match_HLT_mu15=0;
-     std::vector<bool> *match_HLT_mu15_L1MU10=0;
-     std::vector<bool> *match_HLT_mu15_L1MU6=0;
-
+     // Single muon chains written as <chain> (decision) and match_<chain> (per muon) branches
+     struct MuonTrigger {
+       std::string name;
+       bool passed;
+       std::vector<bool> matched;
+       // Online muons of the chain in the current event
+       std::vector<double> online_eta;
+       std::vector<double> online_phi;
+     };
+     std::vector<std::string> m_muonTriggerNames;
+     std::vector<MuonTrigger> m_muonTriggers;
+     // Data events require the muon to be matched to this chain
+     std::string m_selectionTrigger;
+     size_t m_selectionTriggerIdx;
+     double m_triggerMatchDR;
+     // Run the Trig::MatchingTool for each muon and chain nevertheless and fail if the decisions differ
+     bool m_validateTriggerMatching;
+     // muon x chain match matrix of the current event
+     std::vector<char> m_triggerMatches;
+     // Row of the match matrix for each index in the container of the original muons, -1 if the muon has no row
+     const SG::AuxVectorData* m_originalMuons = nullptr;
+     std::vector<int> m_matchRows;
+     // Indices of the muons passing SelectMuon() in the current event
+     std::vector<size_t> m_selectedMuons;
+
+     // Skim of the written events
+     unsigned int m_minSelectedMuons;
+     float m_minMetTST;
+     // Layout of the output trees
+     int m_treeBasketSize;
+     long long m_treeAutoFlush;
+     TH1D* m_eventCounter = 0;
+
+     // Heavy-ion event characterization
+     std::string m_centralityRunSpecies;
+     std::string m_centralityCalibFile;
+     bool m_validateCentrality;
+     std::string m_centralityTableOutput;
+     std::map<float, float> m_centralityEdges;
+     CentralityLookup m_centralityLookup;
+     std::unique_ptr<HI::HICentralityTool> m_centralityTool;
+     // Position of the FCal summary in CaloSums
+     size_t m_fcalIndex = 0;
+
+
+     // SUSYTools calibrates the objects for the MET and the systematic variations. Set up once in initialize()
+     std::string m_susyToolsConfig;
+     std::unique_ptr<ST::SUSYObjDef_xAOD> m_susyTools;
+
+     // Kinematic systematic variations written as muonTree_<variation> from the same pass over the input.
+     // The trees are filled in lockstep with the muonTree and can be added as its friends
+     bool m_runSystematics;
+     std::vector<std::string> m_systematicNames;
+     struct SystOutput {
+       ST::SystInfo info;
+       std::string name;
+       TTree* tree;
+       std::vector<float> muon_pt;
+       std::vector<float> muon_eta;
+       std::vector<float> muon_phi;
+       std::vector<float> muon_charge;
+       std::vector<unsigned int> muon_quality;
+       std::vector<unsigned int> muon_type;
+       float MetTST_met, MetTST_mpx, MetTST_mpy, MetTST_phi, MetTST_sumet;
+       float MetCST_met, MetCST_mpx, MetCST_mpy, MetCST_phi, MetCST_sumet;
+       float MetTrack_met, MetTrack_mpx, MetTrack_mpy, MetTrack_phi, MetTrack_sumet;
+       // The event passes the skim with the objects of this variation
+       bool passSkim;
+     };
+     std::vector<std::unique_ptr<SystOutput>> m_systOutputs;
+     // Nominal objects of the event which are reused by each variation not affecting them
+     struct NominalObjects {
+       const xAOD::ElectronContainer* electrons;
+       const xAOD::PhotonContainer* photons;
+       const xAOD::MuonContainer* muons;
+       const xAOD::JetContainer* jets;
+       const xAOD::MissingETContainer* mettst;
+       const xAOD::MissingETContainer* metcst;
+       const xAOD::MissingETContainer* mettrack;
+     };
 
      //Example histogram, see initialize method for registration to output histSvc
      //TH1D* m_myHist = 0;
@@ -247,6 +327,12 @@ namespace XAMPP {
      //asg::AnaToolHandle<CP::IsolationSelectionTool > m_isoIDSelection;
 
      asg::AnaToolHandle<IMETMaker> m_metutil;
+
+     // Lumi block intervals of the GRLs, built once at the first data event
+     std::vector<std::string> m_grlFiles;
+     XAMPP::GoodRunsLookup m_grlLookup;
+     std::string m_grlLookupCache;
+     bool m_grlLoaded = false;
      //asg::AnaToolHandle<XAMPP::IEventInfo> m_XAMPPInfoHandle;
      //asg::AnaToolHandle<XAMPP::IEventInfo> m_XAMPPInfo;
      //XAMPP::EventInfo* m_XAMPPInfo;
@@ -314,8 +400,27 @@ namespace XAMPP {
 
 
 
+     StatusCode MatchMuonTriggers(const xAOD::MuonContainer* muons);
+     // Row of the match matrix of a copy of the muons, found via the link to the original muon
+     bool MatchRow(const xAOD::Muon& muon, size_t& row) const;
+     // Trigger matching in data, pt, identification and isolation. idx is the position in the match matrix
+     bool SelectMuon(const xAOD::Muon& muon, size_t idx);
+     // Skim decision on the selected muons and the TST MET [GeV] of the nominal or of a variation
+     bool PassSkim(size_t n_selected_muons, float met_tst) const;
+     void TuneTree(TTree* tree) const;
+     // Quality, identification and isolation of the muon. Evaluated once and cached as decorations
+     xAOD::Muon::Quality MuonQuality(const xAOD::Muon& muon);
+     bool PassMuonSelection(const xAOD::Muon& muon);
+     bool PassMuonIsolation(const xAOD::Muon& muon);
      double get_dR(const double eta1, const double phi1, const double eta2, const double phi2);
-     double ReturnFCalEnergy();
+     // FCal sum ET in TeV from CaloSums
+     StatusCode ReadFCalEnergy(float& fcal_et);
+     StatusCode SetupSystematics();
+     // Calibrates the objects affected by each variation, rebuilds the MET terms depending on them and sets the branches
+     // and the skim decision of each variation. The trees are filled by execute() if the event passes the skim in any variation
+     StatusCode ProcessSystematics(const NominalObjects& nominal);
+     StatusCode FillSystOutput(SystOutput& out, const xAOD::MuonContainer* muons, const xAOD::MissingETContainer* mettst,
+                               const xAOD::MissingETContainer* metcst, const xAOD::MissingETContainer* mettrack);
 
   };
 }
@@ -0,0 +1,117 @@
+#!/bin/bash
+
+##############################
+# Setup                      #
+##############################
+
+# The single pass over the systematics has to write the same muonTree_<variation>
+# as separate jobs running one variation each. The default skim keeps all events
+# such that the trees of the jobs have the same entries
+if [ $# -lt 1 ]; then
+    printf '%s\n' "Usage: $0 <MC AOD with CaloSums> [nEvents] [systematics...]" >&2
+    exit 1
+fi
+INPUTFILE=$1
+if [ -f ${INPUTFILE} ]; then
+    INPUTFILE=`readlink -f ${INPUTFILE}`
+fi
+NEVENTS=${2:-500}
+SYSTEMATICS="${@:3}"
+if [ -z "${SYSTEMATICS}" ]; then
+    SYSTEMATICS="MUON_ID__1up MUON_SCALE__1down MET_SoftTrk_ScaleUp"
+fi
+
+# prepare AthAnalysis or build if not already done so
+if [ -f /xampp/build/${AthAnalysis_PLATFORM}/setup.sh ]; then
+    if [[ -z "${TestArea}" ]]; then
+        export TestArea=/xampp/XAMPPbase
+    fi
+    source /xampp/build/${AthAnalysis_PLATFORM}/setup.sh
+else
+    asetup AthAnalysis,latest,here
+    if [ -f ${TestArea}/build/${AthAnalysis_PLATFORM}/setup.sh ]; then
+        source ${TestArea}/build/${AthAnalysis_PLATFORM}/setup.sh
+    else
+        mkdir -p ${TestArea}/build && cd ${TestArea}/build
+        cmake ..
+        cmake --build .
+        cd .. && source build/${AthAnalysis_PLATFORM}/setup.sh
+    fi
+fi
+
+# definition of folder for storing test results
+TESTDIR=`pwd`/test_job_muon_systematics/
+TESTRESULT=AnalysisOutput.root
+
+##############################
+# Process test sample        #
+##############################
+
+# Runs the MuonAnalysisAlg in the directory $1 with the systematics $2
+run_job() {
+    rm -rf $1 && mkdir -p $1 && cd $1
+    python_list=`echo "$2" | sed -e "s/\([^ ]\+\)/'\1',/g"`
+    cat > SystematicsConfig.py <<EOT
+for alg in athAlgSeq.getChildren():
+    if alg.getType() != "XAMPP::MuonAnalysisAlg": continue
+    alg.RunSystematics = True
+    alg.Systematics = [${python_list}]
+EOT
+    athena MuonAnalysis/MuonAnalysisAlgJobOptions.py SystematicsConfig.py --filesInput ${INPUTFILE} --evtMax ${NEVENTS} > job.log 2>&1
+    status=$?
+    cd ${TESTDIR}
+    if [ ${status} -ne 0 ]; then
+        printf '%s\n' "The job with the systematics '$2' failed. See $1/job.log" >&2
+        exit 1
+    fi
+}
+
+mkdir -p ${TESTDIR}
+cd ${TESTDIR}
+run_job all "${SYSTEMATICS}"
+for syst in ${SYSTEMATICS}; do
+    run_job ${syst} ${syst}
+done
+
+###################################################
+# Compare the trees of the variations             #
+###################################################
+python - ${TESTRESULT} ${SYSTEMATICS} <<"EOT"
+import sys, ROOT
+out_file = sys.argv[1]
+all_file = ROOT.TFile.Open("all/%s" % (out_file), "READ")
+n_deviations = 0
+for syst in sys.argv[2:]:
+    single_file = ROOT.TFile.Open("%s/%s" % (syst, out_file), "READ")
+    for tree_name in ["muonTree_%s" % (syst), "muonTree_Nominal"]:
+        ref = single_file.Get(tree_name)
+        test = all_file.Get(tree_name)
+        if not ref or not test:
+            print("ERROR: %s is missing in the output of %s" % (tree_name, "the single pass" if not test else syst))
+            n_deviations += 1
+            continue
+        if ref.GetEntries() != test.GetEntries():
+            print("ERROR: %s has %d entries in the single pass and %d in the job of %s" % (tree_name, test.GetEntries(), ref.GetEntries(), syst))
+            n_deviations += 1
+            continue
+        branches = [b.GetName() for b in ref.GetListOfBranches()]
+        for i in range(ref.GetEntries()):
+            ref.GetEntry(i)
+            test.GetEntry(i)
+            for b in branches:
+                ref_value = getattr(ref, b)
+                test_value = getattr(test, b)
+                if hasattr(ref_value, "size"):
+                    ref_value = [ref_value[k] for k in range(ref_value.size())]
+                    test_value = [test_value[k] for k in range(test_value.size())]
+                if ref_value != test_value:
+                    print("ERROR: %s of entry %d of %s differs: %s (single pass) vs. %s (job of %s)" % (b, i, tree_name, test_value, ref_value, syst))
+                    n_deviations += 1
+        print("INFO: Compared %d entries of %s with the job of %s" % (ref.GetEntries(), tree_name, syst))
+    single_file.Close()
+sys.exit(1 if n_deviations > 0 else 0)
+EOT
+if [ $? -ne 0 ]; then
+  printf '%s\n' "The trees of the single pass over the systematics differ from the ones of the separate jobs" >&2
+  exit 1
+fi
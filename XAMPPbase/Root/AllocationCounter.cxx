@@ -0,0 +1,56 @@
+#include <XAMPPbase/AllocationCounter.h>
+
+#include <dlfcn.h>
+
+namespace XAMPP {
+    namespace {
+        typedef unsigned long long (*AllocationCountFunc)();
+        AllocationCountFunc allocationHook() {
+            // The symbol is only there if libXAMPPAllocationHook.so is preloaded
+            static AllocationCountFunc hook = reinterpret_cast<AllocationCountFunc>(dlsym(RTLD_DEFAULT, "XAMPP_AllocationCount"));
+            return hook;
+        }
+        AllocationCountFunc deallocationHook() {
+            static AllocationCountFunc hook = reinterpret_cast<AllocationCountFunc>(dlsym(RTLD_DEFAULT, "XAMPP_DeallocationCount"));
+            return hook;
+        }
+    }  // namespace
+    bool AllocationCounter::isAvailable() { return allocationHook() != nullptr; }
+    unsigned long long AllocationCounter::count() {
+        static AllocationCountFunc hook = allocationHook();
+        return hook ? hook() : 0;
+    }
+    long long AllocationCounter::liveAllocations() {
+        static AllocationCountFunc hook = deallocationHook();
+        return hook ? (long long)count() - (long long)hook() : 0;
+    }
+
+    AllocationMonitor::AllocationMonitor(const std::string& stage, long long budget) :
+        m_stage(stage),
+        m_budget(budget),
+        m_start(0),
+        m_event(0),
+        m_last(0),
+        m_total(0),
+        m_max(0),
+        m_nEvents(0),
+        m_nViolations(0) {}
+    void AllocationMonitor::start() { m_start = AllocationCounter::count(); }
+    void AllocationMonitor::stop() { m_event += AllocationCounter::count() - m_start; }
+    bool AllocationMonitor::endEvent() {
+        m_last = m_event;
+        m_event = 0;
+        m_total += m_last;
+        ++m_nEvents;
+        if (m_last > m_max) m_max = m_last;
+        if (m_budget < 0 || m_last <= (unsigned long long)m_budget) return true;
+        ++m_nViolations;
+        return false;
+    }
+    const std::string& AllocationMonitor::stage() const { return m_stage; }
+    long long AllocationMonitor::budget() const { return m_budget; }
+    unsigned long long AllocationMonitor::eventAllocations() const { return m_last; }
+    unsigned long long AllocationMonitor::maxAllocations() const { return m_max; }
+    double AllocationMonitor::meanAllocations() const { return m_nEvents ? (double)m_total / (double)m_nEvents : 0.; }
+    unsigned long long AllocationMonitor::nViolations() const { return m_nViolations; }
+}  // namespace XAMPP
@@ -10,13 +10,23 @@
 #include <TruthUtils/PIDHelpers.h>
 #include <boost/filesystem.hpp>  // loop over folder and its containing elements
 #include <boost/regex.hpp>       // regular expression matching
+#include <cmath>
 #include <iostream>              // std::cout
 #include <locale>                // std::locale, std::tolower
 #include <string>                // std::string
 
-#include <CalcGenericMT2/MT2_ROOT.h>
+#include <XAMPPbase/MT2Solver.h>
+#include <XAMPPbase/ParticleKinematics.h>
 
 namespace XAMPP {
+    namespace {
+        // Kinematics of the combinatorial helpers below. The buffers are kept between the calls
+        const ParticleKinematics& ScratchKinematics(const xAOD::IParticleContainer* particles) {
+            static thread_local ParticleKinematics kinematics;
+            kinematics.fill(particles);
+            return kinematics;
+        }
+    }  // namespace
     double Sign(const double& N) { return N != 0 ? std::fabs(N) / N : 0; }
     std::string RemoveAllExpInStr(std::string Str, std::string Exp) { return ReplaceExpInString(Str, Exp, ""); }
     std::string ReplaceExpInString(std::string str, const std::string& exp, const std::string& rep) {
@@ -129,6 +139,34 @@ namespace XAMPP {
         if (line.find("#") == 0 || line.size() < 1) return GetLine(inf, line);
         return true;
     }
+    bool IsROOTFile(const std::string& file_name) {
+        size_t dot = file_name.rfind('.');
+        if (dot == std::string::npos) return false;
+        const std::string suffix = file_name.substr(dot + 1);
+        if (suffix == "root") return true;
+        // Files from the grid are numbered, e.g. DAOD_SUSY1.15084993._000088.pool.root.1
+        if (suffix.empty() || suffix.find_first_not_of("0123456789") != std::string::npos) return false;
+        const std::string stem = file_name.substr(0, dot);
+        return stem.size() >= 5 && stem.compare(stem.size() - 5, 5, ".root") == 0;
+    }
+    unsigned long long Fnv1aHash(const char* data, size_t size, unsigned long long hash) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+    unsigned long long Fnv1aHash(const std::string& str) { return Fnv1aHash(str.data(), str.size()); }
+    bool Fnv1aHashFile(const std::string& path, unsigned long long& hash) {
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in.good()) return false;
+        std::vector<char> chunk(1 << 20);
+        while (in) {
+            in.read(chunk.data(), chunk.size());
+            hash = Fnv1aHash(chunk.data(), in.gcount(), hash);
+        }
+        return in.eof();
+    }
     std::string EraseWhiteSpaces(std::string str) {
         str.erase(std::remove(str.begin(), str.end(), '\t'), str.end());
         if (str.find(" ") == 0) return EraseWhiteSpaces(str.substr(1, str.size()));
@@ -230,11 +268,11 @@ namespace XAMPP {
     float CalculateAMT2(const xAOD::IParticle& P1, const xAOD::IParticle& P2, const xAOD::MissingET* met, float InvMass1, float InvMass2,
                         float ParticleMass) {
         if (!met) return -1;
-        TLorentzVector visa, visb, met_tlv;
-        visa.SetPtEtaPhiM(P1.pt(), P1.eta(), P1.phi(), (ParticleMass != -1) ? ParticleMass : P1.m());
-        visb.SetPtEtaPhiM(P2.pt(), P2.eta(), P2.phi(), (ParticleMass != -1) ? ParticleMass : P2.m());
-        met_tlv.SetPxPyPzE(met->mpx(), met->mpy(), 0, met->met());
-        return ComputeMT2(visa, visb, met_tlv, InvMass1, InvMass2).Compute();
+        // The solver has no mutable state and is shared by all calls
+        static const MT2Solver solver;
+        return solver.compute((ParticleMass != -1) ? ParticleMass : P1.m(), P1.pt() * std::cos(P1.phi()), P1.pt() * std::sin(P1.phi()),
+                              (ParticleMass != -1) ? ParticleMass : P2.m(), P2.pt() * std::cos(P2.phi()), P2.pt() * std::sin(P2.phi()),
+                              met->mpx(), met->mpy(), InvMass1, InvMass2);
     }
 
     bool Overlaps(const xAOD::IParticle& P1, const xAOD::IParticle& P2, float dR, bool UseRapidity) {
@@ -293,23 +331,11 @@ namespace XAMPP {
     bool IsNotSame(const xAOD::IParticle* P, const xAOD::IParticle* P1) { return !IsSame(P, P1); }
     StatusCode RemoveLowMassLeptons(xAOD::IParticleContainer* Leptons, bool (*pair)(const xAOD::IParticle*, const xAOD::IParticle*),
                                     float Upper_Mll, float Lower_Mll) {
-        static CharDecorator dec_passLMR("passLMR");
-        static CharAccessor acc_passOR("passOR");
         if (!Leptons) {
             Error("RemoveLowMassLeptons", "No lepton container given");
             return StatusCode::FAILURE;
         }
-        for (xAOD::IParticleContainer::const_iterator L = Leptons->begin(); L != Leptons->end(); ++L) {
-            if (!acc_passOR(**L)) continue;
-            for (xAOD::IParticleContainer::const_iterator L1 = Leptons->begin(); L1 != L; ++L1) {
-                if (!acc_passOR(**L1) || IsSame(*L, *L1) || !pair(*L, *L1)) continue;
-                float M = InvariantMass(*L, *L1);
-                if (M > Lower_Mll && M < Upper_Mll) {
-                    dec_passLMR(**L1) = false;
-                    dec_passLMR(**L) = false;
-                }
-            }
-        }
+        ScratchKinematics(Leptons).RemoveLowMassLeptons(pair, Upper_Mll, Lower_Mll);
         return StatusCode::SUCCESS;
     }
     StatusCode RemoveLowMassLeptons(xAOD::IParticleContainer* Leptons, float Upper_Mll, float Lower_Mll) {
@@ -335,38 +361,7 @@ namespace XAMPP {
         return InvariantMass(&P1, &P2, &P3, &P4);
     }
 
-    int GetZVeto(xAOD::IParticleContainer& Particles, float Z_Window) {
-        xAOD::IParticleContainer::const_iterator begin_itr = Particles.begin();
-        xAOD::IParticleContainer::const_iterator end_itr = Particles.end();
-        unsigned int Veto = ZVeto::Pass;
-        for (xAOD::IParticleContainer::const_iterator L = begin_itr; L != end_itr; ++L) {
-            for (xAOD::IParticleContainer::const_iterator L1 = L + 1; L1 != end_itr; ++L1) {
-                bool TwoLep = IsSFOS(*L, *L1);
-                if (TwoLep && fabs(InvariantMass(*L, *L1) - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail2Lep; }
-                // Three Lepton invariant masses
-                for (xAOD::IParticleContainer::const_iterator L2 = L1 + 1; L2 != end_itr; ++L2) {
-                    // Now possible is e+e- mu+  // mu+ e+ e- // e+ mu+ e-
-                    bool ThreeLep = (TwoLep || IsSFOS(*L1, *L2) || IsSFOS(*L, *L2));
-                    if (ThreeLep && fabs(InvariantMass(*L, *L1, *L2) - Z_MASS) < Z_Window) {
-                        // Test if one of the particles is a photon
-                        if (TypeToPdgId(*L) == 22 || TypeToPdgId(*L1) == 22 || TypeToPdgId(*L2) == 22) {
-                            Veto = Veto | ZVeto::Fail2LepPhot;
-                        } else {
-                            Veto = Veto | ZVeto::Fail3Lep;
-                        }
-                    }
-                    for (xAOD::IParticleContainer::const_iterator L3 = L2 + 1; L3 != end_itr; ++L3) {
-                        // Four Lepton invariant masses
-                        // mu mu e e ||
-                        bool SFOSSFOS = (IsSFOS(*L, *L1) && IsSFOS(*L2, *L3)) || (IsSFOS(*L, *L2) && IsSFOS(*L1, *L3)) ||
-                                        (IsSFOS(*L, *L3) && IsSFOS(*L2, *L1));
-                        if (SFOSSFOS && fabs(InvariantMass(*L, *L1, *L2, *L3) - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail4Lep; }
-                    }
-                }
-            }
-        }
-        return Veto;
-    }
+    int GetZVeto(xAOD::IParticleContainer& Particles, float Z_Window) { return ScratchKinematics(&Particles).GetZVeto(Z_Window); }
     int GetZVeto(xAOD::IParticleContainer* Particles, float Z_Window) { return GetZVeto(*Particles, Z_Window); }
     float RelPt(const xAOD::IParticle& v1, const xAOD::IParticle& v2) { return RelPt(&v1, &v2); }
     float RelPt(const xAOD::IParticle* v1, const xAOD::IParticle* v2) {
@@ -0,0 +1,178 @@
+#include <TError.h>
+#include <TROOT.h>
+#include <XAMPPbase/AsyncTreeWriter.h>
+
+#include <chrono>
+#include <unistd.h>
+
+namespace XAMPP {
+    namespace {
+        typedef std::chrono::steady_clock Clock;
+        double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+        // Spin a few times before the thread is sent to sleep
+        void Backoff(unsigned int& attempt) {
+            if (++attempt < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }  // namespace
+    //################################################################################
+    //                              TreeFillBuffer
+    //################################################################################
+    TreeFillBuffer::TreeFillBuffer(TTree* tree, size_t rows) :
+        m_tree(tree),
+        m_nRows(rows),
+        m_columns(),
+        m_inFlight(new std::atomic<bool>[rows]),
+        m_next(0) {
+        for (size_t r = 0; r < m_nRows; ++r) m_inFlight[r].store(false);
+    }
+    TTree* TreeFillBuffer::tree() const { return m_tree; }
+    size_t TreeFillBuffer::capture(double& stall_time) {
+        size_t row = m_next;
+        m_next = (m_next + 1) % m_nRows;
+        if (m_inFlight[row].load(std::memory_order_acquire)) {
+            Clock::time_point start = Clock::now();
+            unsigned int attempt = 0;
+            while (m_inFlight[row].load(std::memory_order_acquire)) Backoff(attempt);
+            stall_time += Seconds(start);
+        }
+        for (auto& column : m_columns) column->capture(row);
+        m_inFlight[row].store(true, std::memory_order_release);
+        return row;
+    }
+    bool TreeFillBuffer::fill(size_t row) {
+        for (auto& column : m_columns) column->release(row);
+        m_inFlight[row].store(false, std::memory_order_release);
+        return m_tree->Fill() >= 0;
+    }
+    //################################################################################
+    //                              AsyncTreeWriter
+    //################################################################################
+    AsyncTreeWriter* AsyncTreeWriter::m_Inst = nullptr;
+    AsyncTreeWriter* AsyncTreeWriter::GetInstance() {
+        if (!m_Inst) m_Inst = new AsyncTreeWriter();
+        return m_Inst;
+    }
+    AsyncTreeWriter::AsyncTreeWriter() :
+        m_enabled(false),
+        m_buffers(),
+        m_queue(),
+        m_capacity(0),
+        m_head(0),
+        m_tail(0),
+        m_thread(),
+        m_threadPid(0),
+        m_stop(false),
+        m_failed(false),
+        m_nFills(0),
+        m_depthSum(0),
+        m_maxDepth(0),
+        m_producerStall(0.),
+        m_writerIdle(0.),
+        m_writerBusy(0.) {}
+    AsyncTreeWriter::~AsyncTreeWriter() { stop(); }
+
+    void AsyncTreeWriter::configure(bool enable, size_t queue_size) {
+        if (m_enabled || !enable) return;
+        if (queue_size == 0) {
+            Warning("AsyncTreeWriter::configure()", "A queue size of 0 is not possible. Keep the synchronous tree filling");
+            return;
+        }
+        // The writer thread streams into the output file while the event loop continues. The configuration happens
+        // before AthenaMP forks the workers, so the thread itself is started at the first fill
+        ROOT::EnableThreadSafety();
+        m_enabled = true;
+        m_capacity = queue_size;
+        m_queue.resize(m_capacity);
+        m_stop = false;
+        Info("AsyncTreeWriter::configure()", "The output trees are filled by a separate thread. The queue holds %lu entries", m_capacity);
+    }
+    bool AsyncTreeWriter::startThread() {
+        if (m_thread.joinable()) {
+            if (m_threadPid == getpid()) return true;
+            Error("AsyncTreeWriter::startThread()", "The writer thread has been started by process %d before it was forked", m_threadPid);
+            m_failed = true;
+            return false;
+        }
+        m_threadPid = getpid();
+        m_thread = std::thread(&AsyncTreeWriter::run, this);
+        return true;
+    }
+    bool AsyncTreeWriter::isEnabled() const { return m_enabled; }
+    void AsyncTreeWriter::registerTree(TTree* tree) {
+        if (!m_enabled || !tree || m_buffers.find(tree) != m_buffers.end()) return;
+        m_buffers[tree] = std::make_unique<TreeFillBuffer>(tree, m_capacity);
+    }
+    bool AsyncTreeWriter::fill(TTree* tree) {
+        std::map<const TTree*, std::unique_ptr<TreeFillBuffer>>::iterator itr = m_buffers.find(tree);
+        if (itr == m_buffers.end()) return tree->Fill() >= 0;
+        if (!m_enabled) {
+            Error("AsyncTreeWriter::fill()", "The writer thread has already been stopped. Cannot fill %s", tree->GetName());
+            return false;
+        }
+        if (m_failed) {
+            Error("AsyncTreeWriter::fill()", "The writer thread failed to fill the trees before");
+            return false;
+        }
+        if (!startThread()) return false;
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t depth = head - m_tail.load(std::memory_order_acquire);
+        if (depth >= m_capacity) {
+            Clock::time_point start = Clock::now();
+            unsigned int attempt = 0;
+            while (head - m_tail.load(std::memory_order_acquire) >= m_capacity) Backoff(attempt);
+            m_producerStall += Seconds(start);
+            depth = m_capacity;
+        }
+        m_queue[head % m_capacity] = Request{itr->second.get(), itr->second->capture(m_producerStall)};
+        m_head.store(head + 1, std::memory_order_release);
+        ++m_nFills;
+        m_depthSum += depth;
+        if (depth > m_maxDepth) m_maxDepth = depth;
+        return true;
+    }
+    void AsyncTreeWriter::run() {
+        unsigned int attempt = 0;
+        Clock::time_point idle_start = Clock::now();
+        while (true) {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail == m_head.load(std::memory_order_acquire)) {
+                if (m_stop.load(std::memory_order_acquire)) break;
+                Backoff(attempt);
+                continue;
+            }
+            m_writerIdle += Seconds(idle_start);
+            attempt = 0;
+            Clock::time_point busy_start = Clock::now();
+            const Request& request = m_queue[tail % m_capacity];
+            if (!request.buffer->fill(request.row)) {
+                Error("AsyncTreeWriter::run()", "Failed to fill the tree %s", request.buffer->tree()->GetName());
+                m_failed = true;
+            }
+            m_tail.store(tail + 1, std::memory_order_release);
+            m_writerBusy += Seconds(busy_start);
+            idle_start = Clock::now();
+        }
+    }
+    bool AsyncTreeWriter::flush() {
+        // Nothing has been queued if the thread has not been started in this process
+        if (!m_enabled || !m_thread.joinable() || m_threadPid != getpid()) return !m_failed;
+        unsigned int attempt = 0;
+        while (m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed)) Backoff(attempt);
+        return !m_failed;
+    }
+    bool AsyncTreeWriter::stop() {
+        if (!m_enabled) return true;
+        bool success = flush();
+        m_stop = true;
+        if (m_thread.joinable() && m_threadPid == getpid()) m_thread.join();
+        m_enabled = false;
+        Info("AsyncTreeWriter::stop()", "Wrote %llu entries to %lu trees. Queue depth: mean %.2f, max %lu of %lu.", m_nFills,
+             m_buffers.size(), m_nFills ? double(m_depthSum) / m_nFills : 0., m_maxDepth, m_capacity);
+        Info("AsyncTreeWriter::stop()", "Event loop stalled on the writer for %.3f s. Writer busy for %.3f s, idle for %.3f s.",
+             m_producerStall, m_writerBusy, m_writerIdle);
+        return success;
+    }
+}  // namespace XAMPP
@@ -0,0 +1,333 @@
+#include <AthContainers/AuxElement.h>
+#include <AthContainers/AuxTypeRegistry.h>
+#include <PATInterfaces/SystematicSet.h>
+#include <TError.h>
+#include <TSystem.h>
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/CalibrationCache.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace XAMPP {
+    namespace {
+        const char s_magic[8] = {'X', 'A', 'M', 'P', 'P', 'C', 'C', '1'};
+        // Kinematic variables are overwritten by the calibration in the shallow copy,
+        // i.e. they are already known to the parent container
+        const std::vector<std::string> s_kinematics{"pt", "eta", "phi", "m", "e", "charge"};
+    }  // namespace
+    CalibrationCache* CalibrationCache::m_Inst = nullptr;
+    CalibrationCache* CalibrationCache::GetInstance() {
+        if (!m_Inst) m_Inst = new CalibrationCache();
+        return m_Inst;
+    }
+    CalibrationCache::CalibrationCache() :
+        m_dir(),
+        m_configHash(0),
+        m_systHash(0),
+        m_systematics(),
+        m_cacheWeights(false),
+        m_mode(Mode::Disabled),
+        m_path(),
+        m_out(),
+        m_mapped(nullptr),
+        m_mappedSize(0),
+        m_index(),
+        m_uncacheable(),
+        m_run(0),
+        m_event(0) {}
+    CalibrationCache::~CalibrationCache() { closeFile(); }
+
+    void CalibrationCache::configure(const std::string& cache_dir, size_t config_hash,
+                                     const std::vector<const CP::SystematicSet*>& systematics, bool cache_weights) {
+        m_dir = cache_dir;
+        m_configHash = config_hash;
+        m_systematics = systematics;
+        m_cacheWeights = cache_weights;
+        std::string syst_names;
+        for (const auto& set : m_systematics) syst_names += set->name() + ";";
+        m_systHash = Fnv1aHash(syst_names);
+        if (!m_dir.empty()) gSystem->mkdir(m_dir.c_str(), true);
+    }
+    bool CalibrationCache::isEnabled() const { return !m_dir.empty(); }
+    bool CalibrationCache::cacheWeights() const { return m_cacheWeights && m_mode != Mode::Disabled; }
+    CalibrationCache::Mode CalibrationCache::mode() const { return m_mode; }
+    void CalibrationCache::setEvent(unsigned int run, unsigned long long event) {
+        m_run = run;
+        m_event = event;
+    }
+    bool CalibrationCache::openFile(const std::string& guid) {
+        if (!closeFile()) return false;
+        if (!isEnabled()) return true;
+        if (guid.empty()) {
+            Warning("CalibrationCache::openFile()", "The input file has no GUID. Disable the cache for this file");
+            return true;
+        }
+        m_path = m_dir + "/" + guid + ".xcache";
+        if (readFile(m_path)) {
+            Info("CalibrationCache::openFile()", "Read %lu cached calibration records from %s", m_index.size(), m_path.c_str());
+            m_mode = Mode::Read;
+            return true;
+        }
+        // Write to a temporary file first. It is only moved to its final destination
+        // once the input file is fully processed
+        m_out = std::make_unique<std::ofstream>(m_path + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!m_out->good()) {
+            Error("CalibrationCache::openFile()", "Failed to create the cache file %s.tmp", m_path.c_str());
+            m_out.reset();
+            return false;
+        }
+        m_out->write(s_magic, sizeof(s_magic));
+        write<unsigned long long>(m_configHash);
+        write<unsigned long long>(m_systHash);
+        Info("CalibrationCache::openFile()", "Write the calibration cache to %s", m_path.c_str());
+        m_mode = Mode::Write;
+        return true;
+    }
+    bool CalibrationCache::closeFile() {
+        bool success = true;
+        if (m_out) {
+            m_out->close();
+            success = !m_out->fail() && std::rename((m_path + ".tmp").c_str(), m_path.c_str()) == 0;
+            if (!success) Error("CalibrationCache::closeFile()", "Failed to commit the cache file %s", m_path.c_str());
+            m_out.reset();
+        }
+        unmap();
+        m_index.clear();
+        m_mode = Mode::Disabled;
+        return success;
+    }
+    void CalibrationCache::unmap() {
+        if (m_mapped) munmap(m_mapped, m_mappedSize);
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+    }
+    bool CalibrationCache::readFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t)(sizeof(s_magic) + 2 * sizeof(unsigned long long))) {
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping stays valid after the file is closed
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            Warning("CalibrationCache::readFile()", "Could not map %s into memory. It will be rewritten", path.c_str());
+            return false;
+        }
+        m_mapped = mapped;
+        m_mappedSize = info.st_size;
+
+        const char* begin = static_cast<const char*>(m_mapped);
+        const char* ptr = begin;
+        const char* end = ptr + m_mappedSize;
+        if (std::memcmp(ptr, s_magic, sizeof(s_magic)) != 0) {
+            unmap();
+            return false;
+        }
+        ptr += sizeof(s_magic);
+        if (read<unsigned long long>(ptr) != m_configHash || read<unsigned long long>(ptr) != m_systHash) {
+            Info("CalibrationCache::readFile()", "The calibration cache %s is outdated. It will be rewritten", path.c_str());
+            unmap();
+            return false;
+        }
+        // Build the index of the records. The payload of the records is skipped
+        static const size_t header_size = sizeof(unsigned char) + 3 * sizeof(unsigned int) + sizeof(unsigned long long);
+        while (end - ptr >= (std::ptrdiff_t)(header_size + sizeof(unsigned int))) {
+            const char* record = ptr;
+            unsigned char type = read<unsigned char>(ptr);
+            unsigned int run = read<unsigned int>(ptr);
+            unsigned long long event = read<unsigned long long>(ptr);
+            unsigned int syst = read<unsigned int>(ptr);
+            unsigned int key_size = read<unsigned int>(ptr);
+            if (end - ptr < (std::ptrdiff_t)(key_size + sizeof(unsigned int))) break;
+            std::string key(ptr, key_size);
+            ptr += key_size;
+            unsigned int length = read<unsigned int>(ptr);
+            if (type != RecordType::Objects && type != RecordType::Weights) break;
+            if (end - ptr < (std::ptrdiff_t)length) break;
+            m_index[RecordKey(run, event, syst, key)] = record - begin;
+            ptr += length;
+        }
+        if (ptr != end) {
+            Warning("CalibrationCache::readFile()", "The calibration cache %s is corrupted. It will be rewritten", path.c_str());
+            unmap();
+            m_index.clear();
+            return false;
+        }
+        return true;
+    }
+    int CalibrationCache::systematicIndex(const CP::SystematicSet* set) const {
+        for (size_t s = 0; s < m_systematics.size(); ++s) {
+            if (m_systematics[s] == set) return s;
+        }
+        return -1;
+    }
+    const char* CalibrationCache::findRecord(RecordType type, const std::string& key, const CP::SystematicSet* set) const {
+        if (m_mode != Mode::Read) return nullptr;
+        int syst = systematicIndex(set);
+        if (syst < 0) return nullptr;
+        std::map<RecordKey, size_t>::const_iterator itr = m_index.find(RecordKey(m_run, m_event, syst, key));
+        if (itr == m_index.end()) return nullptr;
+        const char* ptr = static_cast<const char*>(m_mapped) + itr->second;
+        if (read<unsigned char>(ptr) != type) return nullptr;
+        // Skip the remaining part of the record header
+        read<unsigned int>(ptr);
+        read<unsigned long long>(ptr);
+        read<unsigned int>(ptr);
+        readString(ptr);
+        read<unsigned int>(ptr);
+        return ptr;
+    }
+    void CalibrationCache::writeRecordHeader(RecordType type, const std::string& key, const CP::SystematicSet* set) {
+        write<unsigned char>(type);
+        write<unsigned int>(m_run);
+        write<unsigned long long>(m_event);
+        write<unsigned int>(systematicIndex(set));
+        writeString(key);
+    }
+    template <typename T> void CalibrationCache::write(const T& value) { m_out->write(reinterpret_cast<const char*>(&value), sizeof(T)); }
+    void CalibrationCache::writeString(const std::string& str) {
+        write<unsigned int>(str.size());
+        m_out->write(str.data(), str.size());
+    }
+    template <typename T> T CalibrationCache::read(const char*& ptr) {
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+    std::string CalibrationCache::readString(const char*& ptr) {
+        unsigned int size = read<unsigned int>(ptr);
+        std::string str(ptr, size);
+        ptr += size;
+        return str;
+    }
+    template <typename T>
+    bool CalibrationCache::saveVariable(const std::string& name, const xAOD::IParticleContainer& calibrated, std::vector<char>& data) {
+        SG::AuxElement::ConstAccessor<T> acc(name);
+        for (const auto& particle : calibrated) {
+            // Only variables defined for all objects can be restored
+            if (!acc.isAvailable(*particle)) return false;
+        }
+        for (const auto& particle : calibrated) {
+            const T value = acc(*particle);
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+        return true;
+    }
+    template <typename T>
+    void CalibrationCache::restoreVariable(const std::string& name, const char*& ptr, xAOD::IParticleContainer& calibrated) {
+        SG::AuxElement::Accessor<T> acc(name);
+        for (auto particle : calibrated) acc(*particle) = read<T>(ptr);
+    }
+    bool CalibrationCache::saveObjects(const std::string& key, const CP::SystematicSet* set, const xAOD::IParticleContainer& calibrated,
+                                       const xAOD::ShallowAuxContainer& aux) {
+        if (m_mode != Mode::Write || systematicIndex(set) < 0) return true;
+        const SG::AuxTypeRegistry& registry = SG::AuxTypeRegistry::instance();
+        SG::auxid_set_t parent_ids;
+        if (aux.parent().isValid()) parent_ids = aux.parent()->getAuxIDs();
+
+        unsigned int n_vars = 0;
+        std::vector<char> data;
+        for (const SG::auxid_t id : aux.getAuxIDs()) {
+            const std::string var_name = registry.getName(id);
+            // Variables of the input container are only cached if the calibration overwrites them
+            if (parent_ids.count(id) && std::find(s_kinematics.begin(), s_kinematics.end(), var_name) == s_kinematics.end()) continue;
+            const std::type_info* type = registry.getType(id);
+            std::vector<char> var_data;
+            unsigned char var_type = 0;
+            if (*type == typeid(char) && saveVariable<char>(var_name, calibrated, var_data))
+                var_type = VariableType::Char;
+            else if (*type == typeid(int) && saveVariable<int>(var_name, calibrated, var_data))
+                var_type = VariableType::Int;
+            else if (*type == typeid(unsigned int) && saveVariable<unsigned int>(var_name, calibrated, var_data))
+                var_type = VariableType::UInt;
+            else if (*type == typeid(float) && saveVariable<float>(var_name, calibrated, var_data))
+                var_type = VariableType::Float;
+            else if (*type == typeid(double) && saveVariable<double>(var_name, calibrated, var_data))
+                var_type = VariableType::Double;
+            // Variables which cannot be restored would be missing in the next run. Better not to cache the container at all
+            if (!var_type) {
+                if (m_uncacheable.insert(key).second)
+                    Warning("CalibrationCache::saveObjects()", "The variable %s of %s cannot be cached", var_name.c_str(), key.c_str());
+                return true;
+            }
+            data.push_back(var_type);
+            unsigned int name_size = var_name.size();
+            const char* size_bytes = reinterpret_cast<const char*>(&name_size);
+            data.insert(data.end(), size_bytes, size_bytes + sizeof(name_size));
+            data.insert(data.end(), var_name.begin(), var_name.end());
+            data.insert(data.end(), var_data.begin(), var_data.end());
+            ++n_vars;
+        }
+        writeRecordHeader(RecordType::Objects, key, set);
+        write<unsigned int>(2 * sizeof(unsigned int) + data.size());
+        write<unsigned int>(calibrated.size());
+        write<unsigned int>(n_vars);
+        m_out->write(data.data(), data.size());
+        return m_out->good();
+    }
+    bool CalibrationCache::restoreObjects(const std::string& key, const CP::SystematicSet* set,
+                                          xAOD::IParticleContainer& calibrated) const {
+        const char* ptr = findRecord(RecordType::Objects, key, set);
+        if (!ptr) return false;
+        unsigned int n_objects = read<unsigned int>(ptr);
+        if (n_objects != calibrated.size()) {
+            Warning("CalibrationCache::restoreObjects()", "Found %u cached objects for %s but the container has %lu elements", n_objects,
+                    key.c_str(), calibrated.size());
+            return false;
+        }
+        unsigned int n_vars = read<unsigned int>(ptr);
+        for (unsigned int v = 0; v < n_vars; ++v) {
+            unsigned char var_type = read<unsigned char>(ptr);
+            std::string var_name = readString(ptr);
+            if (var_type == VariableType::Char)
+                restoreVariable<char>(var_name, ptr, calibrated);
+            else if (var_type == VariableType::Int)
+                restoreVariable<int>(var_name, ptr, calibrated);
+            else if (var_type == VariableType::UInt)
+                restoreVariable<unsigned int>(var_name, ptr, calibrated);
+            else if (var_type == VariableType::Float)
+                restoreVariable<float>(var_name, ptr, calibrated);
+            else if (var_type == VariableType::Double)
+                restoreVariable<double>(var_name, ptr, calibrated);
+        }
+        return true;
+    }
+    bool CalibrationCache::saveWeights(const CP::SystematicSet* set, const WeightList& weights) {
+        if (m_mode != Mode::Write || !m_cacheWeights || systematicIndex(set) < 0) return true;
+        unsigned int length = sizeof(unsigned int);
+        for (const auto& weight : weights) length += sizeof(unsigned int) + weight.first.size() + sizeof(double);
+        writeRecordHeader(RecordType::Weights, "", set);
+        write<unsigned int>(length);
+        write<unsigned int>(weights.size());
+        for (const auto& weight : weights) {
+            writeString(weight.first);
+            write<double>(weight.second);
+        }
+        return m_out->good();
+    }
+    bool CalibrationCache::restoreWeights(const CP::SystematicSet* set, WeightList& weights) const {
+        weights.clear();
+        if (!m_cacheWeights) return false;
+        const char* ptr = findRecord(RecordType::Weights, "", set);
+        if (!ptr) return false;
+        unsigned int n_weights = read<unsigned int>(ptr);
+        weights.reserve(n_weights);
+        for (unsigned int w = 0; w < n_weights; ++w) {
+            std::string name = readString(ptr);
+            weights.push_back(std::make_pair(name, read<double>(ptr)));
+        }
+        return true;
+    }
+}  // namespace XAMPP
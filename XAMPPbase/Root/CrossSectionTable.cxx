@@ -0,0 +1,157 @@
+#include <TError.h>
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/CrossSectionTable.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+namespace XAMPP {
+    namespace {
+        const char s_magic[8] = {'X', 'A', 'M', 'P', 'P', 'X', 'S', 'T'};
+        // Increment if the layout of the table changes
+        const unsigned int s_version = 2;
+        struct Header {
+            char magic[8];
+            unsigned int version;
+            unsigned int entry_size;
+            unsigned long long n_entries;
+            unsigned long long source_hash;
+            unsigned long long checksum;
+        };
+        static_assert(std::is_trivially_copyable<CrossSectionTable::Entry>::value, "The entries are copied bytewise");
+        static_assert(sizeof(Header) % alignof(CrossSectionTable::Entry) == 0, "The entries following the header must be aligned");
+
+        std::string BaseName(const std::string& path) {
+            size_t pos = path.rfind('/');
+            return pos == std::string::npos ? path : path.substr(pos + 1);
+        }
+        bool Less(const CrossSectionTable::Entry& a, const CrossSectionTable::Entry& b) {
+            return a.dsid < b.dsid || (a.dsid == b.dsid && a.finalState < b.finalState);
+        }
+    }  // namespace
+    CrossSectionTable::CrossSectionTable() : m_mapped(nullptr), m_mappedSize(0), m_entries(nullptr), m_nEntries(0) {}
+    CrossSectionTable::~CrossSectionTable() { unmap(); }
+    void CrossSectionTable::unmap() {
+        if (m_mapped) munmap(m_mapped, m_mappedSize);
+        m_mapped = nullptr;
+        m_mappedSize = 0;
+        m_entries = nullptr;
+        m_nEntries = 0;
+    }
+    unsigned long long CrossSectionTable::SourceHash(const std::vector<std::string>& txt_files) {
+        std::vector<std::string> sorted(txt_files);
+        std::sort(sorted.begin(), sorted.end(), [](const std::string& a, const std::string& b) { return BaseName(a) < BaseName(b); });
+        // The hash is the same for every build, which is needed as the tables are shared
+        unsigned long long hash = Fnv1aHash(std::string());
+        for (const auto& file : sorted) {
+            const std::string name = BaseName(file);
+            // The terminating null separates the name from the content
+            hash = Fnv1aHash(name.c_str(), name.size() + 1, hash);
+            if (!Fnv1aHashFile(file, hash)) return 0;
+        }
+        return hash;
+    }
+    bool CrossSectionTable::write(const std::string& table_file, std::vector<Entry> entries, unsigned long long source_hash) {
+        std::sort(entries.begin(), entries.end(), Less);
+        entries.erase(std::unique(entries.begin(), entries.end(),
+                                  [](const Entry& a, const Entry& b) { return a.dsid == b.dsid && a.finalState == b.finalState; }),
+                      entries.end());
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, s_magic, sizeof(s_magic));
+        header.version = s_version;
+        header.entry_size = sizeof(Entry);
+        header.n_entries = entries.size();
+        header.source_hash = source_hash;
+        header.checksum = Fnv1aHash(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+        // Write a private file which is moved in place such that running jobs never map a partially written table
+        const std::string tmp_path = table_file + ".tmp" + std::to_string(getpid());
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+        out.close();
+        if (out.fail() || std::rename(tmp_path.c_str(), table_file.c_str()) != 0) {
+            Error("CrossSectionTable::write()", "Failed to write the cross-section table %s", table_file.c_str());
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        Info("CrossSectionTable::write()", "Wrote %lu processes to %s", entries.size(), table_file.c_str());
+        return true;
+    }
+    bool CrossSectionTable::load(const std::string& table_file, unsigned long long source_hash) {
+        unmap();
+        int fd = open(table_file.c_str(), O_RDONLY);
+        if (fd < 0) {
+            Error("CrossSectionTable::load()", "Could not open the cross-section table %s", table_file.c_str());
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(Header)) {
+            Error("CrossSectionTable::load()", "%s is too short to be a cross-section table", table_file.c_str());
+            close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping stays valid after the file is closed
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            Error("CrossSectionTable::load()", "Could not map %s into memory", table_file.c_str());
+            return false;
+        }
+        m_mapped = mapped;
+        m_mappedSize = info.st_size;
+        const Header* header = static_cast<const Header*>(mapped);
+        if (std::memcmp(header->magic, s_magic, sizeof(s_magic)) != 0 || header->version != s_version ||
+            header->entry_size != sizeof(Entry) || m_mappedSize != sizeof(Header) + header->n_entries * sizeof(Entry)) {
+            Error("CrossSectionTable::load()", "%s is not a cross-section table of version %u", table_file.c_str(), s_version);
+            unmap();
+            return false;
+        }
+        const Entry* entries = reinterpret_cast<const Entry*>(static_cast<const char*>(mapped) + sizeof(Header));
+        if (header->checksum != Fnv1aHash(reinterpret_cast<const char*>(entries), header->n_entries * sizeof(Entry))) {
+            Error("CrossSectionTable::load()", "The checksum of %s does not match", table_file.c_str());
+            unmap();
+            return false;
+        }
+        // The answer for unknown processes is sorted to the end
+        if (!header->n_entries || entries[header->n_entries - 1].dsid != UnknownProcess ||
+            entries[header->n_entries - 1].finalState != UnknownProcess) {
+            Error("CrossSectionTable::load()", "%s does not contain the answer for unknown processes", table_file.c_str());
+            unmap();
+            return false;
+        }
+        if (header->source_hash != source_hash) {
+            Warning("CrossSectionTable::load()", "%s has been compiled from different cross-section files", table_file.c_str());
+            unmap();
+            return false;
+        }
+        m_entries = entries;
+        m_nEntries = header->n_entries;
+        return true;
+    }
+    bool CrossSectionTable::isLoaded() const { return m_entries != nullptr; }
+    const CrossSectionTable::Entry* CrossSectionTable::find(unsigned int dsid, unsigned int finalState) const {
+        if (!m_entries) return nullptr;
+        Entry key;
+        key.dsid = dsid;
+        key.finalState = finalState;
+        const Entry* itr = std::lower_bound(begin(), end(), key, Less);
+        if (itr == end() || itr->dsid != dsid || itr->finalState != finalState) return nullptr;
+        return itr;
+    }
+    const CrossSectionTable::Entry* CrossSectionTable::lookup(unsigned int dsid, unsigned int finalState) const {
+        if (!m_entries) return nullptr;
+        const Entry* entry = find(dsid, finalState);
+        return entry ? entry : end() - 1;
+    }
+    size_t CrossSectionTable::size() const { return m_nEntries; }
+    const CrossSectionTable::Entry* CrossSectionTable::begin() const { return m_entries; }
+    const CrossSectionTable::Entry* CrossSectionTable::end() const { return m_entries + m_nEntries; }
+}  // namespace XAMPP
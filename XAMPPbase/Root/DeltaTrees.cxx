@@ -0,0 +1,206 @@
+#include <TError.h>
+#include <TList.h>
+#include <TNamed.h>
+#include <TObjString.h>
+#include <XAMPPbase/AsyncTreeWriter.h>
+#include <XAMPPbase/DeltaTrees.h>
+
+namespace XAMPP {
+    //################################################################################
+    //                              DeltaTreeEncoder
+    //################################################################################
+    DeltaTreeEncoder* DeltaTreeEncoder::m_Inst = nullptr;
+    DeltaTreeEncoder* DeltaTreeEncoder::GetInstance() {
+        if (!m_Inst) m_Inst = new DeltaTreeEncoder();
+        return m_Inst;
+    }
+    DeltaTreeEncoder::DeltaTreeEncoder() : m_enabled(false), m_nominal(), m_delta() {}
+    void DeltaTreeEncoder::configure(bool enable) {
+        if (m_enabled || !enable) return;
+        m_enabled = true;
+        Info("DeltaTreeEncoder::configure()", "The systematic trees only store the branches and entries which differ from nominal");
+    }
+    bool DeltaTreeEncoder::isEnabled() const { return m_enabled; }
+    void DeltaTreeEncoder::registerNominal(TTree* tree) {
+        if (!m_enabled || !tree || m_nominal.find(tree) != m_nominal.end()) return;
+        NominalTree& nominal = m_nominal[tree];
+        nominal.lastEvent = {{0, 0}};
+        nominal.entries = 0;
+    }
+    bool DeltaTreeEncoder::registerDelta(TTree* tree, TTree* nominal) {
+        if (!m_enabled || !tree || m_delta.find(tree) != m_delta.end()) return true;
+        if (m_nominal.find(nominal) == m_nominal.end()) {
+            Error("DeltaTreeEncoder::registerDelta()", "The nominal tree of %s has not been registered before", tree->GetName());
+            return false;
+        }
+        DeltaTree& delta = m_delta[tree];
+        delta.nominal = nominal;
+        delta.nominalEntry = -1;
+        delta.written = false;
+        delta.nEvents = delta.nWritten = delta.nStoredBranches = 0;
+        AsyncTreeWriter* writer = AsyncTreeWriter::GetInstance();
+        if (!tree->Branch("NominalEntry", &writer->branchAddress(tree, delta.nominalEntry)) ||
+            !tree->Branch("DeltaBranches", &writer->branchAddress(tree, delta.changed)) ||
+            !tree->Branch("SameAsNominal", &writer->branchAddress(tree, delta.sameAsNominal))) {
+            Error("DeltaTreeEncoder::registerDelta()", "Failed to create the bookkeeping branches of %s", tree->GetName());
+            return false;
+        }
+        return true;
+    }
+    void DeltaTreeEncoder::nominalFilled(TTree* tree, const std::array<unsigned long long, 2>& event_id) {
+        std::map<const TTree*, NominalTree>::iterator itr = m_nominal.find(tree);
+        if (itr == m_nominal.end()) return;
+        NominalTree& nominal = itr->second;
+        for (auto& ref : nominal.references) ref.second->snapshot();
+        nominal.lastEvent = event_id;
+        ++nominal.entries;
+    }
+    bool DeltaTreeEncoder::encode(TTree* tree, const std::array<unsigned long long, 2>& event_id) {
+        std::map<const TTree*, DeltaTree>::iterator itr = m_delta.find(tree);
+        if (itr == m_delta.end()) return true;
+        DeltaTree& delta = itr->second;
+        const NominalTree& nominal = m_nominal[delta.nominal];
+        const bool has_nominal = nominal.entries > 0 && nominal.lastEvent == event_id;
+        ++delta.nEvents;
+        // The list is carried by the previously written entry
+        if (delta.written) delta.sameAsNominal.clear();
+        delta.written = false;
+        delta.changed.clear();
+        for (size_t c = 0; c < delta.columns.size(); ++c) {
+            if (delta.columns[c]->encode(has_nominal)) delta.changed.push_back(c);
+        }
+        if (has_nominal && delta.changed.empty()) {
+            delta.sameAsNominal.push_back(nominal.entries - 1);
+            return false;
+        }
+        delta.nominalEntry = has_nominal ? nominal.entries - 1 : -1;
+        ++delta.nWritten;
+        delta.nStoredBranches += delta.changed.size();
+        delta.written = true;
+        return true;
+    }
+    bool DeltaTreeEncoder::finalize() {
+        if (!m_enabled) return true;
+        bool success = true;
+        for (auto& itr : m_delta) {
+            TTree* tree = const_cast<TTree*>(itr.first);
+            DeltaTree& delta = itr.second;
+            if (delta.written) delta.sameAsNominal.clear();
+            if (!delta.sameAsNominal.empty()) {
+                // Carrier entry of the events at the end of the job which are identical to nominal
+                delta.nominalEntry = -2;
+                delta.changed.clear();
+                for (auto& column : delta.columns) column->reset();
+                if (!AsyncTreeWriter::GetInstance()->fill(tree)) {
+                    Error("DeltaTreeEncoder::finalize()", "Failed to write the last entry of %s", tree->GetName());
+                    success = false;
+                }
+                delta.sameAsNominal.clear();
+            }
+            TList* encoding = new TList();
+            encoding->SetName("DeltaEncoding");
+            encoding->SetOwner(true);
+            for (const auto& name : delta.names) encoding->Add(new TObjString(name.c_str()));
+            tree->GetUserInfo()->Add(encoding);
+            tree->GetUserInfo()->Add(new TNamed("DeltaNominalTree", delta.nominal->GetName()));
+            Info("DeltaTreeEncoder::finalize()", "%s: %llu out of %llu events written, %.2f of %lu branches stored on average",
+                 tree->GetName(), delta.nWritten, delta.nEvents, delta.nWritten ? double(delta.nStoredBranches) / delta.nWritten : 0., delta.columns.size());
+        }
+        // The columns stay alive as the branches are still bound to them
+        m_enabled = false;
+        return success;
+    }
+    //################################################################################
+    //                              DeltaTreeReader
+    //################################################################################
+    DeltaTreeReader::DeltaTreeReader(TTree* nominal, TTree* delta) :
+        m_nominalTree(nominal),
+        m_deltaTree(delta),
+        m_encoding(),
+        m_index(),
+        m_slots(),
+        m_plain(),
+        m_changedValues(),
+        m_changed(&m_changedValues),
+        m_changedBranch(nullptr),
+        m_init(false) {}
+    bool DeltaTreeReader::Init() {
+        if (m_init) return true;
+        if (!m_nominalTree || !m_deltaTree) {
+            Error("DeltaTreeReader::Init()", "Both the nominal and the delta tree need to be given");
+            return false;
+        }
+        TList* encoding = dynamic_cast<TList*>(m_deltaTree->GetUserInfo()->FindObject("DeltaEncoding"));
+        if (!encoding) {
+            Error("DeltaTreeReader::Init()", "%s is not a delta encoded tree", m_deltaTree->GetName());
+            return false;
+        }
+        for (auto obj : *encoding) m_encoding.push_back(obj->GetName());
+        m_slots.resize(m_encoding.size());
+
+        m_deltaTree->SetBranchStatus("*", 0);
+        m_nominalTree->SetBranchStatus("*", 0);
+        Long64_t nominal_entry = -1;
+        std::vector<Long64_t> same_values;
+        std::vector<Long64_t>* same_as_nominal = &same_values;
+        TBranch* nominal_branch = nullptr;
+        TBranch* same_branch = nullptr;
+        m_deltaTree->SetBranchStatus("NominalEntry", 1);
+        m_deltaTree->SetBranchStatus("SameAsNominal", 1);
+        m_deltaTree->SetBranchStatus("DeltaBranches", 1);
+        if (m_deltaTree->SetBranchAddress("NominalEntry", &nominal_entry, &nominal_branch) < 0 ||
+            m_deltaTree->SetBranchAddress("SameAsNominal", &same_as_nominal, &same_branch) < 0 ||
+            m_deltaTree->SetBranchAddress("DeltaBranches", &m_changed, &m_changedBranch) < 0) {
+            Error("DeltaTreeReader::Init()", "The bookkeeping branches are missing in %s", m_deltaTree->GetName());
+            return false;
+        }
+        // The events identical to nominal precede the entry which lists them
+        const Long64_t n_delta = m_deltaTree->GetEntries();
+        for (Long64_t d = 0; d < n_delta; ++d) {
+            if (nominal_branch->GetEntry(d) <= 0 || same_branch->GetEntry(d) <= 0) {
+                Error("DeltaTreeReader::Init()", "Failed to read entry %lld of %s", d, m_deltaTree->GetName());
+                return false;
+            }
+            for (const auto& same : *same_as_nominal) m_index.push_back(std::pair<Long64_t, Long64_t>(same, -1));
+            if (nominal_entry != -2) m_index.push_back(std::pair<Long64_t, Long64_t>(nominal_entry, d));
+        }
+        m_deltaTree->ResetBranchAddress(nominal_branch);
+        m_deltaTree->ResetBranchAddress(same_branch);
+        m_deltaTree->SetBranchStatus("NominalEntry", 0);
+        m_deltaTree->SetBranchStatus("SameAsNominal", 0);
+        Info("DeltaTreeReader::Init()", "%s contains %lld entries of which %lld are stored in the delta tree", m_deltaTree->GetName(),
+             GetEntries(), n_delta);
+        m_init = true;
+        return true;
+    }
+    Long64_t DeltaTreeReader::GetEntries() const { return m_index.size(); }
+    bool DeltaTreeReader::GetEntry(Long64_t entry) {
+        if (!m_init || entry < 0 || entry >= GetEntries()) return false;
+        const std::pair<Long64_t, Long64_t>& E = m_index[entry];
+        if (E.first >= 0 && m_nominalTree->GetEntry(E.first) <= 0) return false;
+        if (E.second < 0) return true;
+        if (m_changedBranch->GetEntry(E.second) <= 0) return false;
+        for (auto& branch : m_plain) branch->GetEntry(E.second);
+        for (const auto& idx : *m_changed) {
+            if (idx < m_slots.size() && m_slots[idx]) m_slots[idx]->load(E.second);
+        }
+        return true;
+    }
+    bool DeltaTreeReader::activate(const std::string& name, bool& in_nominal) {
+        if (!Init()) return false;
+        if (!m_deltaTree->GetBranch(name.c_str())) {
+            Error("DeltaTreeReader::SetBranchAddress()", "The branch %s is not part of %s", name.c_str(), m_deltaTree->GetName());
+            return false;
+        }
+        m_deltaTree->SetBranchStatus(name.c_str(), 1);
+        in_nominal = m_nominalTree->GetBranch(name.c_str()) != nullptr;
+        if (in_nominal) m_nominalTree->SetBranchStatus(name.c_str(), 1);
+        return true;
+    }
+    int DeltaTreeReader::encodingIndex(const std::string& name) const {
+        for (size_t i = 0; i < m_encoding.size(); ++i) {
+            if (m_encoding[i] == name) return i;
+        }
+        return -1;
+    }
+}  // namespace XAMPP
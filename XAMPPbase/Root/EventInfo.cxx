@@ -4,6 +4,7 @@
 #include <XAMPPbase/TreeBase.h>
 #include <XAMPPbase/TreeHelpers.h>
 
+#include <cstring>
 #include <iostream>
 #include <vector>
 
@@ -19,6 +20,8 @@ namespace XAMPP {
         AsgTool(myname),
         m_ConstEvtInfo(),
         m_EvtInfo(),
+        m_InfoSlots(),
+        m_InfoSlotNames(),
         m_primaryVtx(nullptr),
         m_ActSys(nullptr),
         m_systematics("SystematicsTool"),
@@ -27,11 +30,23 @@ namespace XAMPP {
         m_ApplyPRW(true),
         m_ApplyGRL(true),
         m_Init(false),
+        m_Finalized(false),
         m_Locked(false),
         m_Filter(true),
         m_RecoFlags(true),
         m_MultiPRWPeriods(false),
         m_DecPup(),
+        m_CachePRW(false),
+        m_ValidatePRWCache(false),
+        m_PRWCacheSize(1000000),
+        m_PRWCache(),
+        m_PRWCacheHits(0),
+        m_PRWCacheMisses(0),
+        m_UseGRLLookup(false),
+        m_ValidateGRLLookup(false),
+        m_GoodRunsLists(),
+        m_GRLLookupCache(),
+        m_GRLLookup(),
         m_nNVtx(nullptr),
         m_PassGRL(nullptr),
         m_PassLArTile(nullptr),
@@ -49,6 +64,18 @@ namespace XAMPP {
         declareProperty("OutlierWeightStrategy", m_OutlierStrat);
         declareProperty("OutlierWeightThreshold", m_outlierWeightThreshold);
         declareProperty("SaveRecoFlags", m_RecoFlags);
+        // Serve the pile-up weights of configurations seen before from a lookup table instead of the tool
+        declareProperty("CachePRWResults", m_CachePRW);
+        // Run the tool nevertheless and compare the cached decorations bit by bit
+        declareProperty("ValidatePRWCache", m_ValidatePRWCache);
+        declareProperty("PRWCacheSize", m_PRWCacheSize);
+        // Decide the GRL from sorted lumi block intervals per run built once from the xml files
+        declareProperty("UseGRLLookup", m_UseGRLLookup);
+        // Query the GRL tool nevertheless and fail if the decisions differ
+        declareProperty("ValidateGRLLookup", m_ValidateGRLLookup);
+        declareProperty("GoodRunsLists", m_GoodRunsLists);
+        // Binary file shared across the jobs to store the parsed intervals
+        declareProperty("GRLLookupCache", m_GRLLookupCache);
         m_GrlTool.declarePropertyFor(this, "GRLTool", "The GRLTool");
         m_prwTool.declarePropertyFor(this, "PileupReweightingTool", "The pile up reweighting tool");
 
@@ -88,7 +115,18 @@ namespace XAMPP {
 
         ATH_CHECK(m_systematics.retrieve());
 
-        if (m_systematics->isData() && m_ApplyGRL) ATH_CHECK(m_GrlTool.retrieve());
+        if (m_systematics->isData() && m_ApplyGRL && (m_UseGRLLookup || m_ValidateGRLLookup)) {
+            if (m_GoodRunsLists.empty()) {
+                ATH_MSG_FATAL("The GRL lookup needs the list of GRL files");
+                return StatusCode::FAILURE;
+            }
+            m_GRLLookup = std::make_unique<GoodRunsLookup>();
+            if (!m_GRLLookup->load(GetPathResolvedFileList(m_GoodRunsLists), m_GRLLookupCache)) {
+                ATH_MSG_FATAL("Failed to build the GRL lookup");
+                return StatusCode::FAILURE;
+            }
+        }
+        if (m_systematics->isData() && m_ApplyGRL && (!m_GRLLookup || m_ValidateGRLLookup)) ATH_CHECK(m_GrlTool.retrieve());
         if (!m_systematics->isData()) {
             switch (m_OutlierStrat) {
                 case doNothing: ATH_MSG_INFO("No special treatment for outlier gen weights configured"); break;
@@ -137,7 +175,17 @@ namespace XAMPP {
         ATH_CHECK(evtStore()->retrieve(m_ConstEvtInfo, "EventInfo"));
         // Cache the vertex and determine the cleaning
         ATH_CHECK(FindPrimaryVertex());
-        ATH_CHECK(m_PassGRL->ConstStore((!m_ApplyGRL || isMC() || m_GrlTool->passRunLB(*m_ConstEvtInfo))));
+        bool PassGRL = !m_ApplyGRL || isMC();
+        if (!PassGRL && m_GRLLookup) {
+            PassGRL = m_GRLLookup->passRunLB(m_ConstEvtInfo->runNumber(), m_ConstEvtInfo->lumiBlock());
+            if (m_ValidateGRLLookup && PassGRL != m_GrlTool->passRunLB(*m_ConstEvtInfo)) {
+                ATH_MSG_ERROR("The GRL lookup decides " << PassGRL << " for run " << m_ConstEvtInfo->runNumber() << ", lumi block "
+                                                        << m_ConstEvtInfo->lumiBlock() << " but the tool does not.");
+                return StatusCode::FAILURE;
+            }
+        } else if (!PassGRL)
+            PassGRL = m_GrlTool->passRunLB(*m_ConstEvtInfo);
+        ATH_CHECK(m_PassGRL->ConstStore(PassGRL));
         bool PassLAR = (isMC() || !((m_ConstEvtInfo->errorState(xAOD::EventInfo::LAr) == xAOD::EventInfo::Error) ||
                                     (m_ConstEvtInfo->errorState(xAOD::EventInfo::Tile) == xAOD::EventInfo::Error) ||
                                     (m_ConstEvtInfo->errorState(xAOD::EventInfo::SCT) == xAOD::EventInfo::Error) ||
@@ -151,34 +199,55 @@ namespace XAMPP {
         }
         ATH_CHECK(m_PassLArTile->ConstStore(PassLAR));
         ATH_CHECK(RunPRWTool());
+        // The copies are made after the pile-up decorations are attached to the original
+        ATH_CHECK(CreateInfoSlots());
         return StatusCode::SUCCESS;
     }
     StatusCode EventInfo::SetSystematic(const CP::SystematicSet* set) {
         if (m_ActSys == set) return StatusCode::SUCCESS;
         m_ActSys = set;
-        // Check if the current systematic affects the kinematics-> otherwise
-        // return Nominal Info
-        for (const auto s : m_systematics->GetKinematicSystematics())
-            if (s == set) return GetInfoFromStore(set);
-        ATH_MSG_WARNING("The systematic " << set->name() << " is not part of the kinematics. Load the nominal container");
-        return GetInfoFromStore(m_systematics->GetNominal());
+        m_EvtInfo = GetInfoSlot(set);
+        return m_EvtInfo ? StatusCode::SUCCESS : StatusCode::FAILURE;
     }
-    StatusCode EventInfo::GetInfoFromStore(const CP::SystematicSet* set) {
+    xAOD::EventInfo* EventInfo::GetInfoSlot(const CP::SystematicSet* set) const {
         if (set == nullptr) {
             ATH_MSG_ERROR("The systematic set pointer is nullptr");
-            return StatusCode::FAILURE;
+            return nullptr;
         }
-        // The Info Object is already given in the Event Store
-        std::string storeName = name() + "EvI" + set->name();
-        if (evtStore()->contains<xAOD::EventInfo>(storeName)) {
-            ATH_CHECK(evtStore()->retrieve(m_EvtInfo, storeName));
-            return StatusCode::SUCCESS;
+        int slot = m_systematics->GetKinematicOrdinal(set);
+        // Check if the current systematic affects the kinematics-> otherwise
+        // return Nominal Info
+        if (slot < 0) {
+            ATH_MSG_WARNING("The systematic " << set->name() << " is not part of the kinematics. Load the nominal container");
+            slot = m_systematics->GetKinematicOrdinal(m_systematics->GetNominal());
+        }
+        if (slot < 0 || (size_t)slot >= m_InfoSlots.size()) {
+            ATH_MSG_ERROR("No EventInfo copy has been created for the systematic " << set->name());
+            return nullptr;
+        }
+        return m_InfoSlots[slot];
+    }
+    StatusCode EventInfo::CreateInfoSlots() {
+        std::vector<const CP::SystematicSet*> kinematics = m_systematics->GetKinematicSystematics();
+        // The store names only need to be assembled once
+        if (m_InfoSlotNames.size() != kinematics.size()) {
+            m_InfoSlotNames.clear();
+            for (const auto& set : kinematics) m_InfoSlotNames.push_back(name() + "EvI" + set->name());
+        }
+        m_InfoSlots.assign(kinematics.size(), nullptr);
+        for (size_t s = 0; s < m_InfoSlotNames.size(); ++s) {
+            const std::string& storeName = m_InfoSlotNames[s];
+            // The Info Object is already given in the Event Store
+            if (evtStore()->contains<xAOD::EventInfo>(storeName)) {
+                ATH_CHECK(evtStore()->retrieve(m_InfoSlots[s], storeName));
+                continue;
+            }
+            // Create a new object and copy the information from the original to the  new container
+            std::pair<xAOD::EventInfo*, xAOD::ShallowAuxInfo*> copy = shallowCopyObject(*m_ConstEvtInfo);
+            ATH_CHECK(evtStore()->record(copy.first, storeName));
+            ATH_CHECK(evtStore()->record(copy.second, storeName + "Aux."));
+            m_InfoSlots[s] = copy.first;
         }
-        // Create a new object and copy the information from the original to the  new container
-        std::pair<xAOD::EventInfo*, xAOD::ShallowAuxInfo*> copy = shallowCopyObject(*m_ConstEvtInfo);
-        ATH_CHECK(evtStore()->record(copy.first, storeName));
-        ATH_CHECK(evtStore()->record(copy.second, storeName + "Aux."));
-        m_EvtInfo = copy.first;
         return StatusCode::SUCCESS;
     }
     StatusCode EventInfo::FindPrimaryVertex() {
@@ -229,7 +298,11 @@ namespace XAMPP {
             }
             PileUpDecorators& Decorator = Itr->second;
             ATH_CHECK(m_systematics->setSystematic(set));
-            ATH_CHECK(m_prwTool->apply(*m_ConstEvtInfo));
+            if (!m_CachePRW || !LoadPRWFromCache(set)) {
+                ATH_CHECK(m_prwTool->apply(*m_ConstEvtInfo));
+                if (m_CachePRW) SavePRWToCache(set);
+            } else if (m_ValidatePRWCache)
+                ATH_CHECK(ValidatePRWCache(set));
             if (acc_CaX.isAvailable(*m_ConstEvtInfo))
                 ATH_CHECK(Decorator.AverageCross->ConstStore(acc_CaX(*m_ConstEvtInfo)));
             else
@@ -249,14 +322,105 @@ namespace XAMPP {
         ATH_CHECK(m_mu_density->ConstStore(pu_density));
         return StatusCode::SUCCESS;
     }
+    bool EventInfo::PRWCacheKey::operator==(const PRWCacheKey& other) const {
+        return mcChannelNumber == other.mcChannelNumber && runNumber == other.runNumber && lumiBlock == other.lumiBlock &&
+               muBits == other.muBits && systematic == other.systematic;
+    }
+    size_t EventInfo::PRWCacheKeyHash::operator()(const PRWCacheKey& key) const {
+        size_t hash = std::hash<const CP::SystematicSet*>()(key.systematic);
+        for (unsigned int v : {(unsigned int)key.mcChannelNumber, key.runNumber, key.lumiBlock, key.muBits}) {
+            hash ^= std::hash<unsigned int>()(v) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+    EventInfo::PRWCacheKey EventInfo::MakePRWCacheKey(const CP::SystematicSet* set) const {
+        PRWCacheKey key;
+        key.mcChannelNumber = isMC() ? m_ConstEvtInfo->mcChannelNumber() : 0;
+        key.runNumber = m_ConstEvtInfo->runNumber();
+        key.lumiBlock = m_ConstEvtInfo->lumiBlock();
+        float mu = m_ConstEvtInfo->averageInteractionsPerCrossing();
+        std::memcpy(&key.muBits, &mu, sizeof(mu));
+        key.systematic = set;
+        return key;
+    }
+    bool EventInfo::LoadPRWFromCache(const CP::SystematicSet* set) {
+        static FloatDecorator dec_PuW("PileupWeight");
+        static FloatDecorator dec_CaX("corrected_averageInteractionsPerCrossing");
+        static UIntDecorator dec_Random("RandomRunNumber");
+        static UIntDecorator dec_Lumi("RandomLumiBlockNumber");
+        static SG::AuxElement::Decorator<ULong64_t> dec_Hash("PRWHash");
+
+        std::unordered_map<PRWCacheKey, PRWCacheEntry, PRWCacheKeyHash>::const_iterator Itr = m_PRWCache.find(MakePRWCacheKey(set));
+        if (Itr == m_PRWCache.end()) {
+            ++m_PRWCacheMisses;
+            return false;
+        }
+        ++m_PRWCacheHits;
+        const PRWCacheEntry& entry = Itr->second;
+        if (entry.hasPileupWeight) dec_PuW(*m_ConstEvtInfo) = entry.PileupWeight;
+        if (entry.hasCorrectedMu) dec_CaX(*m_ConstEvtInfo) = entry.CorrectedMu;
+        if (isMC()) {
+            // The random run number is drawn from a generator seeded by the channel and the event number.
+            // The lumi block is drawn afterwards from the same sequence. Hence, the draws reproduce apply()
+            unsigned int rrn = m_prwTool->getRandomRunNumber(*m_ConstEvtInfo, true);
+            dec_Random(*m_ConstEvtInfo) = rrn;
+            dec_Lumi(*m_ConstEvtInfo) = rrn == 0 ? 0 : m_prwTool->expert()->GetRandomLumiBlockNumber(rrn);
+            dec_Hash(*m_ConstEvtInfo) = m_prwTool->getPRWHash(*m_ConstEvtInfo);
+        }
+        return true;
+    }
+    void EventInfo::SavePRWToCache(const CP::SystematicSet* set) {
+        static FloatAccessor acc_PuW("PileupWeight");
+        static FloatAccessor acc_CaX("corrected_averageInteractionsPerCrossing");
+        if (m_PRWCache.size() >= m_PRWCacheSize) return;
+        PRWCacheEntry entry;
+        entry.hasPileupWeight = acc_PuW.isAvailable(*m_ConstEvtInfo);
+        entry.PileupWeight = entry.hasPileupWeight ? acc_PuW(*m_ConstEvtInfo) : 0.;
+        entry.hasCorrectedMu = acc_CaX.isAvailable(*m_ConstEvtInfo);
+        entry.CorrectedMu = entry.hasCorrectedMu ? acc_CaX(*m_ConstEvtInfo) : 0.;
+        m_PRWCache.insert(std::pair<PRWCacheKey, PRWCacheEntry>(MakePRWCacheKey(set), entry));
+    }
+    StatusCode EventInfo::ValidatePRWCache(const CP::SystematicSet* set) {
+        static FloatAccessor acc_PuW("PileupWeight");
+        static FloatAccessor acc_CaX("corrected_averageInteractionsPerCrossing");
+        static UIntAccessor acc_Random("RandomRunNumber");
+        static UIntAccessor acc_Lumi("RandomLumiBlockNumber");
+        static SG::AuxElement::Accessor<ULong64_t> acc_Hash("PRWHash");
+
+        float cached_PuW = acc_PuW.isAvailable(*m_ConstEvtInfo) ? acc_PuW(*m_ConstEvtInfo) : 0.;
+        float cached_CaX = acc_CaX.isAvailable(*m_ConstEvtInfo) ? acc_CaX(*m_ConstEvtInfo) : 0.;
+        unsigned int cached_Random = isMC() ? acc_Random(*m_ConstEvtInfo) : 0;
+        unsigned int cached_Lumi = isMC() ? acc_Lumi(*m_ConstEvtInfo) : 0;
+        ULong64_t cached_Hash = isMC() ? acc_Hash(*m_ConstEvtInfo) : 0;
+
+        ATH_CHECK(m_prwTool->apply(*m_ConstEvtInfo));
+        bool match = std::memcmp(&cached_CaX, &acc_CaX(*m_ConstEvtInfo), sizeof(float)) == 0;
+        if (isMC()) {
+            match &= std::memcmp(&cached_PuW, &acc_PuW(*m_ConstEvtInfo), sizeof(float)) == 0;
+            match &= cached_Random == acc_Random(*m_ConstEvtInfo) && cached_Lumi == acc_Lumi(*m_ConstEvtInfo) &&
+                     cached_Hash == acc_Hash(*m_ConstEvtInfo);
+        }
+        if (!match) {
+            ATH_MSG_ERROR("The cached prw results of event " << eventNumber() << " (run: " << m_ConstEvtInfo->runNumber()
+                                                             << ", systematic: " << set->name() << ") differ from the tool.");
+            ATH_MSG_ERROR("Corrected mu: " << cached_CaX << " vs. " << acc_CaX(*m_ConstEvtInfo));
+            if (isMC()) {
+                ATH_MSG_ERROR("PileupWeight: " << cached_PuW << " vs. " << acc_PuW(*m_ConstEvtInfo) << ", RandomRunNumber: " << cached_Random
+                                               << " vs. " << acc_Random(*m_ConstEvtInfo) << ", RandomLumiBlockNumber: " << cached_Lumi
+                                               << " vs. " << acc_Lumi(*m_ConstEvtInfo));
+            }
+            return StatusCode::FAILURE;
+        }
+        return StatusCode::SUCCESS;
+    }
     StatusCode EventInfo::CopyInfoFromNominal(const CP::SystematicSet* To) {
         if (To == m_systematics->GetNominal()) {
             ATH_MSG_ERROR("Cannot copy the nominal EventInfo to itself");
             return StatusCode::SUCCESS;
         }
-        ATH_CHECK(GetInfoFromStore(m_systematics->GetNominal()));
-        xAOD::EventInfo* NominalInfo = m_EvtInfo;
-        ATH_CHECK(GetInfoFromStore(To));
+        xAOD::EventInfo* NominalInfo = GetInfoSlot(m_systematics->GetNominal());
+        m_EvtInfo = GetInfoSlot(To);
+        if (!NominalInfo || !m_EvtInfo) return StatusCode::FAILURE;
         *m_EvtInfo = *NominalInfo;
         return StatusCode::SUCCESS;
     }
@@ -366,6 +530,21 @@ namespace XAMPP {
     }
     const xAOD::EventInfo* EventInfo::GetOrigInfo() const { return m_ConstEvtInfo; }
     const CP::SystematicSet* EventInfo::GetSystematic() const { return m_ActSys; }
+    StatusCode EventInfo::finalize() {
+        // The tool service may finalize the tool after the analysis helper
+        if (m_Finalized) return StatusCode::SUCCESS;
+        m_Finalized = true;
+        if (m_CachePRW && m_PRWCacheHits + m_PRWCacheMisses > 0) {
+            ATH_MSG_INFO("The prw cache served " << m_PRWCacheHits << " out of " << (m_PRWCacheHits + m_PRWCacheMisses)
+                                                 << " tool calls (hit rate: " << (100. * m_PRWCacheHits / (m_PRWCacheHits + m_PRWCacheMisses))
+                                                 << "%) from " << m_PRWCache.size() << " distinct configurations.");
+        }
+        if (m_GRLLookup && m_GRLLookup->nQueries() > 0) {
+            ATH_MSG_INFO("The GRL lookup answered " << m_GRLLookup->nLastHits() << " out of " << m_GRLLookup->nQueries()
+                                                    << " queries from the last lumi block interval.");
+        }
+        return StatusCode::SUCCESS;
+    }
     EventInfo::~EventInfo() {
         delete StorageKeeper::GetInstance();
         ATH_MSG_DEBUG("Destructor called");
@@ -396,6 +575,25 @@ namespace XAMPP {
         ATH_MSG_WARNING("The current event has no mcWeight saved. Return 1.");
         return 1.;
     }
+    unsigned int EventInfo::GetGenWeights(std::vector<double>& weights) const {
+        weights.clear();
+        if (m_systematics->isData() || !m_ConstEvtInfo) return 0;
+        const std::vector<float>& raw = m_ConstEvtInfo->mcEventWeights();
+        const size_t n = raw.size();
+        weights.resize(n);
+        // Same correction as GetGenWeight(idx) without the per-weight virtual calls and range checks
+        const bool check = m_OutlierStrat != doNothing;
+        const double threshold = m_outlierWeightThreshold;
+        unsigned int n_outliers = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const double w = raw[i];
+            const bool outlier = check && fabs(w) > threshold;
+            n_outliers += outlier;
+            // Any other strategy is rejected in initialize()
+            weights[i] = !outlier ? w : (m_OutlierStrat == ignoreEvent ? 0. : w / fabs(w));
+        }
+        return n_outliers;
+    }
 
     bool EventInfo::isOutlierGenWeight(unsigned int idx) const { return isOutlierGenWeight(GetRawGenWeight(idx)); }
 
@@ -0,0 +1,225 @@
+#include <TError.h>
+#include <TFriendElement.h>
+#include <TUUID.h>
+#include <XAMPPbase/FriendTreeReader.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace XAMPP {
+    namespace {
+        const char s_magic[8] = {'X', 'A', 'M', 'P', 'P', 'H', 'I', '1'};
+        // Finalizer of splitmix64. The event number and the channel/run word are well mixed afterwards
+        ULong64_t Mix(ULong64_t x) {
+            x ^= x >> 30;
+            x *= 0xbf58476d1ce4e5b9ULL;
+            x ^= x >> 27;
+            x *= 0x94d049bb133111ebULL;
+            x ^= x >> 31;
+            return x;
+        }
+    }  // namespace
+    //################################################################################
+    //                              EventHashIndex
+    //################################################################################
+    EventHashIndex::EventHashIndex() : m_entries(0), m_mask(0), m_keys(), m_values() {}
+    size_t EventHashIndex::slot(ULong64_t hash0, ULong64_t hash1) const { return Mix(hash0 ^ Mix(hash1)) & m_mask; }
+    bool EventHashIndex::build(TTree* tree) {
+        if (!tree) return false;
+        TBranch* branch = tree->GetBranch("CommonEventHash");
+        if (!branch) {
+            Error("EventHashIndex::build()", "%s has no CommonEventHash branch", tree->GetName());
+            return false;
+        }
+        m_entries = tree->GetEntries();
+        // Keep the load factor below 0.5
+        size_t capacity = 16;
+        while (capacity < 2 * (size_t)m_entries) capacity <<= 1;
+        m_mask = capacity - 1;
+        m_keys.assign(2 * capacity, 0);
+        m_values.assign(capacity, -1);
+
+        ULong64_t hash[2] = {0, 0};
+        void* old_address = branch->GetAddress();
+        branch->SetAddress(hash);
+        Long64_t duplicates = 0;
+        for (Long64_t e = 0; e < m_entries; ++e) {
+            if (branch->GetEntry(e) <= 0) {
+                Error("EventHashIndex::build()", "Failed to read entry %lld of %s", e, tree->GetName());
+                branch->SetAddress(old_address);
+                return false;
+            }
+            size_t s = slot(hash[0], hash[1]);
+            while (m_values[s] >= 0 && (m_keys[2 * s] != hash[0] || m_keys[2 * s + 1] != hash[1])) s = (s + 1) & m_mask;
+            // Keep the first occurance of the event
+            if (m_values[s] >= 0) {
+                ++duplicates;
+                continue;
+            }
+            m_keys[2 * s] = hash[0];
+            m_keys[2 * s + 1] = hash[1];
+            m_values[s] = e;
+        }
+        branch->SetAddress(old_address);
+        if (duplicates) Warning("EventHashIndex::build()", "%s contains %lld events more than once", tree->GetName(), duplicates);
+        return true;
+    }
+    Long64_t EventHashIndex::find(ULong64_t hash0, ULong64_t hash1) const {
+        if (m_values.empty()) return -1;
+        size_t s = slot(hash0, hash1);
+        while (m_values[s] >= 0) {
+            if (m_keys[2 * s] == hash0 && m_keys[2 * s + 1] == hash1) return m_values[s];
+            s = (s + 1) & m_mask;
+        }
+        return -1;
+    }
+    Long64_t EventHashIndex::entries() const { return m_entries; }
+    size_t EventHashIndex::memory() const { return m_keys.size() * sizeof(ULong64_t) + m_values.size() * sizeof(Long64_t); }
+    bool EventHashIndex::save(const std::string& path, const std::string& uuid) const {
+        std::ofstream out(path + ".tmp", std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.good()) return false;
+        unsigned int uuid_size = uuid.size();
+        unsigned long long capacity = m_values.size();
+        out.write(s_magic, sizeof(s_magic));
+        out.write(reinterpret_cast<const char*>(&uuid_size), sizeof(uuid_size));
+        out.write(uuid.data(), uuid_size);
+        out.write(reinterpret_cast<const char*>(&m_entries), sizeof(m_entries));
+        out.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+        out.write(reinterpret_cast<const char*>(m_keys.data()), m_keys.size() * sizeof(ULong64_t));
+        out.write(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(Long64_t));
+        out.close();
+        return !out.fail() && std::rename((path + ".tmp").c_str(), path.c_str()) == 0;
+    }
+    bool EventHashIndex::load(const std::string& path, const std::string& uuid, Long64_t entries) {
+        std::ifstream in(path, std::ios::in | std::ios::binary);
+        if (!in.good()) return false;
+        char magic[sizeof(s_magic)];
+        unsigned int uuid_size = 0;
+        if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, s_magic, sizeof(s_magic)) != 0) return false;
+        if (!in.read(reinterpret_cast<char*>(&uuid_size), sizeof(uuid_size)) || uuid_size != uuid.size()) return false;
+        std::string stored_uuid(uuid_size, ' ');
+        if (!in.read(&stored_uuid[0], uuid_size) || stored_uuid != uuid) return false;
+        Long64_t stored_entries = 0;
+        unsigned long long capacity = 0;
+        if (!in.read(reinterpret_cast<char*>(&stored_entries), sizeof(stored_entries)) || stored_entries != entries) return false;
+        if (!in.read(reinterpret_cast<char*>(&capacity), sizeof(capacity)) || capacity == 0 || (capacity & (capacity - 1))) return false;
+        std::vector<ULong64_t> keys(2 * capacity);
+        std::vector<Long64_t> values(capacity);
+        if (!in.read(reinterpret_cast<char*>(keys.data()), keys.size() * sizeof(ULong64_t))) return false;
+        if (!in.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(Long64_t))) return false;
+        m_entries = stored_entries;
+        m_mask = capacity - 1;
+        m_keys = std::move(keys);
+        m_values = std::move(values);
+        return true;
+    }
+    //################################################################################
+    //                              FriendTreeReader
+    //################################################################################
+    std::map<std::string, std::weak_ptr<EventHashIndex>> FriendTreeReader::m_indexCache;
+    FriendTreeReader::FriendTreeReader(TFile* file, const std::string& tree_name, const std::string& index_dir) :
+        m_file(file),
+        m_indexDir(index_dir),
+        m_main(),
+        m_friends(),
+        m_hash{0, 0},
+        m_init(false) {
+        m_main.tree = nullptr;
+        m_main.entry = -1;
+        if (m_file) m_file->GetObject(tree_name.c_str(), m_main.tree);
+        if (!m_main.tree) Error("FriendTreeReader()", "The tree %s does not exist", tree_name.c_str());
+    }
+    bool FriendTreeReader::addFriend(const std::string& tree_name) {
+        if (m_init) {
+            Error("FriendTreeReader::addFriend()", "The reader has already been initialized");
+            return false;
+        }
+        TTree* tree = nullptr;
+        if (m_file) m_file->GetObject(tree_name.c_str(), tree);
+        if (!tree) {
+            Error("FriendTreeReader::addFriend()", "The tree %s does not exist", tree_name.c_str());
+            return false;
+        }
+        std::unique_ptr<Source> source = std::make_unique<Source>();
+        source->tree = tree;
+        source->entry = -1;
+        m_friends.push_back(std::move(source));
+        return true;
+    }
+    std::shared_ptr<EventHashIndex> FriendTreeReader::friendIndex(TTree* tree) {
+        std::string path = m_file->GetName();
+        if (!m_indexDir.empty()) path = m_indexDir + "/" + path.substr(path.rfind("/") + 1);
+        path += std::string(".") + tree->GetName() + ".hashidx";
+        std::shared_ptr<EventHashIndex> index = m_indexCache[path].lock();
+        if (index) return index;
+
+        index = std::make_shared<EventHashIndex>();
+        const std::string uuid = m_file->GetUUID().AsString();
+        if (index->load(path, uuid, tree->GetEntries())) {
+            Info("FriendTreeReader::Init()", "Read the index of %s from %s", tree->GetName(), path.c_str());
+        } else {
+            if (!index->build(tree)) return std::shared_ptr<EventHashIndex>();
+            Info("FriendTreeReader::Init()", "Built the index of %s with %lld entries (%.2f MB)", tree->GetName(), index->entries(),
+                 index->memory() / 1.e6);
+            if (!index->save(path, uuid)) Warning("FriendTreeReader::Init()", "Failed to write the index to %s", path.c_str());
+        }
+        m_indexCache[path] = index;
+        return index;
+    }
+    bool FriendTreeReader::Init() {
+        if (m_init) return true;
+        if (!m_main.tree) return false;
+        // The friends registered by the TreeBase would be read at the entry of the main tree instead of the indexed one
+        if (m_main.tree->GetListOfFriends()) {
+            std::vector<TTree*> root_friends;
+            for (TObject* obj : *m_main.tree->GetListOfFriends()) {
+                TFriendElement* element = dynamic_cast<TFriendElement*>(obj);
+                if (element && element->GetTree()) root_friends.push_back(element->GetTree());
+            }
+            for (auto& fr : root_friends) m_main.tree->RemoveFriend(fr);
+        }
+        m_main.tree->SetBranchStatus("*", 0);
+        if (!m_friends.empty()) {
+            m_main.tree->SetBranchStatus("CommonEventHash", 1);
+            if (m_main.tree->SetBranchAddress("CommonEventHash", m_hash) < 0) {
+                Error("FriendTreeReader::Init()", "%s has no CommonEventHash branch", m_main.tree->GetName());
+                return false;
+            }
+        }
+        for (auto& fr : m_friends) {
+            fr->index = friendIndex(fr->tree);
+            if (!fr->index) return false;
+            fr->tree->SetBranchStatus("*", 0);
+        }
+        m_init = true;
+        return true;
+    }
+    Long64_t FriendTreeReader::GetEntries() const { return m_main.tree ? m_main.tree->GetEntries() : 0; }
+    bool FriendTreeReader::GetEntry(Long64_t entry) {
+        if (!Init()) return false;
+        if (m_main.tree->GetEntry(entry) <= 0) return false;
+        m_main.entry = entry;
+        for (auto& fr : m_friends) {
+            fr->entry = fr->index->find(m_hash[0], m_hash[1]);
+            // Only read the friend if a column is connected to it
+            if (fr->entry >= 0 && !fr->columns.empty() && fr->tree->GetEntry(fr->entry) <= 0) return false;
+        }
+        return true;
+    }
+    bool FriendTreeReader::hasFriendEntry(const std::string& tree_name) const {
+        for (const auto& fr : m_friends) {
+            if (tree_name == fr->tree->GetName()) return fr->entry >= 0;
+        }
+        return false;
+    }
+    FriendTreeReader::Source* FriendTreeReader::findSource(const std::string& branch) {
+        if (!Init()) return nullptr;
+        if (m_main.tree->GetBranch(branch.c_str())) return &m_main;
+        for (auto& fr : m_friends) {
+            if (fr->tree->GetBranch(branch.c_str())) return fr.get();
+        }
+        Error("FriendTreeReader::column()", "The branch %s is neither part of %s nor of its friends", branch.c_str(), m_main.tree->GetName());
+        return nullptr;
+    }
+}  // namespace XAMPP
@@ -0,0 +1,229 @@
+#include <TError.h>
+#include <XAMPPbase/GoodRunsLookup.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace XAMPP {
+    namespace {
+        const char s_magic[8] = {'X', 'A', 'M', 'P', 'P', 'G', 'R', 'L'};
+        // Increment if the layout of the cache file changes
+        const unsigned int s_version = 1;
+        template <class T> void WriteValue(std::string& buffer, const T& value) {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        template <class T> void WriteVector(std::string& buffer, const std::vector<T>& vec) {
+            WriteValue(buffer, (unsigned int)vec.size());
+            if (!vec.empty()) buffer.append(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+        }
+        template <class T> bool ReadValue(const std::string& buffer, size_t& pos, T& value) {
+            if (pos + sizeof(value) > buffer.size()) return false;
+            std::memcpy(&value, buffer.data() + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        }
+        template <class T> bool ReadVector(const std::string& buffer, size_t& pos, std::vector<T>& vec) {
+            unsigned int size = 0;
+            if (!ReadValue(buffer, pos, size) || pos + size * sizeof(T) > buffer.size()) return false;
+            vec.resize(size);
+            if (size) std::memcpy(vec.data(), buffer.data() + pos, size * sizeof(T));
+            pos += size * sizeof(T);
+            return true;
+        }
+        // Reads the unsigned attribute <name>="<value>" of the xml tag
+        bool ReadAttribute(const std::string& tag, const std::string& name, unsigned int& value) {
+            size_t pos = tag.find(name + "=\"");
+            if (pos == std::string::npos) return false;
+            value = std::strtoul(tag.c_str() + pos + name.size() + 2, nullptr, 10);
+            return true;
+        }
+        // The cache is identified by the files it has been built from
+        size_t SourceHash(const std::vector<std::string>& xml_files) {
+            std::stringstream source;
+            for (const auto& file : xml_files) {
+                struct stat info;
+                if (stat(file.c_str(), &info) != 0) return 0;
+                source << file << ":" << info.st_size << ":" << info.st_mtime << ";";
+            }
+            return std::hash<std::string>()(source.str());
+        }
+    }  // namespace
+    GoodRunsLookup::GoodRunsLookup() :
+        m_runs(),
+        m_offsets(),
+        m_ranges(),
+        m_hasLast(false),
+        m_lastRun(0),
+        m_lastRange{0, 0},
+        m_lastDecision(false),
+        m_queries(0),
+        m_lastHits(0) {}
+    bool GoodRunsLookup::load(const std::vector<std::string>& xml_files, const std::string& cache_file) {
+        m_hasLast = false;
+        const size_t source_hash = cache_file.empty() ? 0 : SourceHash(xml_files);
+        if (source_hash != 0 && readCache(cache_file, source_hash)) {
+            Info("GoodRunsLookup::load()", "Read %lu runs with %lu lumi block ranges from %s", m_runs.size(), m_ranges.size(),
+                 cache_file.c_str());
+            return true;
+        }
+        std::vector<RunRange> ranges;
+        for (const auto& xml : xml_files) {
+            if (!parseXML(xml, ranges)) return false;
+        }
+        build(ranges);
+        Info("GoodRunsLookup::load()", "Parsed %lu runs with %lu lumi block ranges from %lu GRL(s)", m_runs.size(), m_ranges.size(),
+             xml_files.size());
+        if (source_hash != 0 && !writeCache(cache_file, source_hash))
+            Warning("GoodRunsLookup::load()", "Failed to write the GRL cache %s", cache_file.c_str());
+        return true;
+    }
+    bool GoodRunsLookup::parseXML(const std::string& xml_file, std::vector<RunRange>& ranges) const {
+        std::ifstream in(xml_file);
+        if (!in.good()) {
+            Error("GoodRunsLookup::parseXML()", "Could not open the GRL %s", xml_file.c_str());
+            return false;
+        }
+        std::stringstream content;
+        content << in.rdbuf();
+        const std::string xml = content.str();
+        // The lumi block ranges of a LumiBlockCollection follow its <Run> tag
+        bool has_run = false;
+        unsigned int run = 0;
+        size_t pos = 0;
+        while ((pos = xml.find('<', pos)) != std::string::npos) {
+            size_t end = xml.find('>', pos);
+            if (end == std::string::npos) break;
+            const std::string tag = xml.substr(pos, end - pos + 1);
+            if (tag == "<Run>") {
+                run = std::strtoul(xml.c_str() + end + 1, nullptr, 10);
+                has_run = true;
+            } else if (tag.compare(0, 8, "<LBRange") == 0) {
+                std::pair<unsigned int, unsigned int> range(0, UINT_MAX);
+                if (!has_run || !ReadAttribute(tag, "Start", range.first)) {
+                    Error("GoodRunsLookup::parseXML()", "Malformed lumi block range %s in %s", tag.c_str(), xml_file.c_str());
+                    return false;
+                }
+                // Ranges without end are open
+                ReadAttribute(tag, "End", range.second);
+                if (range.first <= range.second) ranges.push_back(std::make_pair(run, range));
+            } else if (tag == "</LumiBlockCollection>") {
+                has_run = false;
+            }
+            pos = end + 1;
+        }
+        return true;
+    }
+    void GoodRunsLookup::build(std::vector<RunRange>& ranges) {
+        std::sort(ranges.begin(), ranges.end());
+        m_runs.clear();
+        m_offsets.clear();
+        m_ranges.clear();
+        for (const auto& run_range : ranges) {
+            if (m_runs.empty() || m_runs.back() != run_range.first) {
+                m_runs.push_back(run_range.first);
+                m_offsets.push_back(m_ranges.size());
+            } else if (m_ranges.back().last == UINT_MAX || run_range.second.first <= m_ranges.back().last + 1) {
+                // Overlapping or adjacent ranges of the same run are merged
+                m_ranges.back().last = std::max(m_ranges.back().last, run_range.second.second);
+                continue;
+            }
+            m_ranges.push_back(LumiRange{run_range.second.first, run_range.second.second});
+        }
+        m_offsets.push_back(m_ranges.size());
+    }
+    bool GoodRunsLookup::passRunLB(unsigned int run, unsigned int lumi_block) const {
+        ++m_queries;
+        if (m_hasLast && run == m_lastRun && lumi_block >= m_lastRange.first && lumi_block <= m_lastRange.last) {
+            ++m_lastHits;
+            return m_lastDecision;
+        }
+        m_hasLast = true;
+        m_lastRun = run;
+        std::vector<unsigned int>::const_iterator run_itr = std::lower_bound(m_runs.begin(), m_runs.end(), run);
+        if (run_itr == m_runs.end() || *run_itr != run) {
+            m_lastRange = LumiRange{0, UINT_MAX};
+            m_lastDecision = false;
+            return false;
+        }
+        const size_t r = run_itr - m_runs.begin();
+        std::vector<LumiRange>::const_iterator begin = m_ranges.begin() + m_offsets[r];
+        std::vector<LumiRange>::const_iterator end = m_ranges.begin() + m_offsets[r + 1];
+        // First range starting after the lumi block. The one before is the only candidate to contain it
+        std::vector<LumiRange>::const_iterator next =
+            std::upper_bound(begin, end, lumi_block, [](unsigned int lb, const LumiRange& range) { return lb < range.first; });
+        if (next != begin && lumi_block <= (next - 1)->last) {
+            m_lastRange = *(next - 1);
+            m_lastDecision = true;
+            return true;
+        }
+        // The lumi block is in the gap between two good ranges
+        m_lastRange.first = next != begin ? (next - 1)->last + 1 : 0;
+        m_lastRange.last = next != end ? next->first - 1 : UINT_MAX;
+        m_lastDecision = false;
+        return false;
+    }
+    std::vector<unsigned int> GoodRunsLookup::runs() const { return m_runs; }
+    size_t GoodRunsLookup::nIntervals() const { return m_ranges.size(); }
+    unsigned long long GoodRunsLookup::nQueries() const { return m_queries; }
+    unsigned long long GoodRunsLookup::nLastHits() const { return m_lastHits; }
+    bool GoodRunsLookup::readCache(const std::string& cache_file, size_t source_hash) {
+        std::ifstream in(cache_file, std::ios::in | std::ios::binary);
+        if (!in.good()) return false;
+        std::stringstream content;
+        content << in.rdbuf();
+        const std::string buffer = content.str();
+        size_t checksum = 0;
+        if (buffer.size() < sizeof(s_magic) + sizeof(checksum)) return false;
+        const size_t payload = buffer.size() - sizeof(checksum);
+        std::memcpy(&checksum, buffer.data() + payload, sizeof(checksum));
+        if (checksum != std::hash<std::string>()(buffer.substr(0, payload))) {
+            Warning("GoodRunsLookup::readCache()", "The checksum of %s does not match. The file is ignored", cache_file.c_str());
+            return false;
+        }
+        if (std::memcmp(buffer.data(), s_magic, sizeof(s_magic)) != 0) return false;
+        size_t pos = sizeof(s_magic);
+        unsigned int version = 0;
+        size_t hash = 0;
+        if (!ReadValue(buffer, pos, version) || version != s_version) return false;
+        if (!ReadValue(buffer, pos, hash) || hash != source_hash) {
+            Info("GoodRunsLookup::readCache()", "%s has been built from different GRLs", cache_file.c_str());
+            return false;
+        }
+        std::vector<unsigned int> runs, offsets;
+        std::vector<LumiRange> ranges;
+        if (!ReadVector(buffer, pos, runs) || !ReadVector(buffer, pos, offsets) || !ReadVector(buffer, pos, ranges)) return false;
+        if (pos != payload || offsets.size() != runs.size() + 1 || offsets.back() != ranges.size()) return false;
+        m_runs = std::move(runs);
+        m_offsets = std::move(offsets);
+        m_ranges = std::move(ranges);
+        return true;
+    }
+    bool GoodRunsLookup::writeCache(const std::string& cache_file, size_t source_hash) const {
+        std::string buffer(s_magic, sizeof(s_magic));
+        WriteValue(buffer, s_version);
+        WriteValue(buffer, source_hash);
+        WriteVector(buffer, m_runs);
+        WriteVector(buffer, m_offsets);
+        WriteVector(buffer, m_ranges);
+        WriteValue(buffer, std::hash<std::string>()(buffer));
+        // Several jobs may create the cache at the same time. Each of them writes a private file which is moved in place
+        const std::string tmp_path = cache_file + ".tmp" + std::to_string(getpid());
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), buffer.size());
+        out.close();
+        if (out.fail() || std::rename(tmp_path.c_str(), cache_file.c_str()) != 0) {
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        Info("GoodRunsLookup::writeCache()", "Wrote the GRL cache %s", cache_file.c_str());
+        return true;
+    }
+}  // namespace XAMPP
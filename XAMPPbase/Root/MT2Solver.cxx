@@ -0,0 +1,352 @@
+#include <XAMPPbase/MT2Solver.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace XAMPP {
+    namespace {
+        // Massless visible particles define parabolas instead of ellipses. The bisection
+        // assigns them a small mass in units of the event scale to keep the regions bounded.
+        // Nearly collinear visible momenta need a larger value for the ellipse test to stay stable
+        constexpr double MinimalMass = 1.e-8;
+        constexpr double MinimalMassCollinear = 1.e-6;
+        constexpr unsigned int MaxIterations = 64;
+
+        inline double Cross(double ax, double ay, double bx, double by) { return ax * by - ay * bx; }
+        inline double MtSq(double m, double vx, double vy, double mInv, double qx, double qy) {
+            return m * m + mInv * mInv +
+                   2. * (std::sqrt(m * m + vx * vx + vy * vy) * std::sqrt(mInv * mInv + qx * qx + qy * qy) - vx * qx - vy * qy);
+        }
+        // Checks whether the regions mT(a, q1) <= M and mT(b, pmiss - q1) <= M do not overlap.
+        // Both are ellipses x^T A x <= 0 in homogeneous coordinates x = (q1x, q1y, 1). They are
+        // disjoint iff det(lambda A + B) has three real roots and two of them are positive.
+        inline bool Disjoint(double M, double ma, double ax, double ay, double mb, double bx, double by, double px, double py, double ca,
+                             double cb) {
+            const double M2 = M * M;
+            const double Ea2 = ma * ma + ax * ax + ay * ay, Eb2 = mb * mb + bx * bx + by * by;
+            const double Ka = 0.5 * (M2 - ma * ma - ca * ca), Kb = 0.5 * (M2 - mb * mb - cb * cb);
+            // Ea^2 (mInv^2 + q^2) <= (Ka + a.q)^2
+            const double a11 = Ea2 - ax * ax, a22 = Ea2 - ay * ay, a12 = -ax * ay;
+            const double a13 = -Ka * ax, a23 = -Ka * ay, a33 = Ea2 * ca * ca - Ka * Ka;
+            // Same for the second side after the substitution q2 = pmiss - q1
+            const double bp = bx * px + by * py;
+            const double Ppx = Eb2 * px - bx * bp, Ppy = Eb2 * py - by * bp;
+            const double b11 = Eb2 - bx * bx, b22 = Eb2 - by * by, b12 = -bx * by;
+            const double b13 = Kb * bx - Ppx, b23 = Kb * by - Ppy, b33 = px * Ppx + py * Ppy - 2. * Kb * bp + Eb2 * cb * cb - Kb * Kb;
+            // Adjugates of the two matrices
+            const double A11 = a22 * a33 - a23 * a23, A22 = a11 * a33 - a13 * a13, A33 = a11 * a22 - a12 * a12;
+            const double A12 = a13 * a23 - a12 * a33, A13 = a12 * a23 - a13 * a22, A23 = a12 * a13 - a11 * a23;
+            const double B11 = b22 * b33 - b23 * b23, B22 = b11 * b33 - b13 * b13, B33 = b11 * b22 - b12 * b12;
+            const double B12 = b13 * b23 - b12 * b33, B13 = b12 * b23 - b13 * b22, B23 = b12 * b13 - b11 * b23;
+            // det(lambda A + B) = c3 lambda^3 + c2 lambda^2 + c1 lambda + c0
+            const double c3 = a11 * A11 + a12 * A12 + a13 * A13;
+            const double c2 = A11 * b11 + A22 * b22 + A33 * b33 + 2. * (A12 * b12 + A13 * b13 + A23 * b23);
+            const double c1 = B11 * a11 + B22 * a22 + B33 * a33 + 2. * (B12 * a12 + B13 * a13 + B23 * a23);
+            const double c0 = b11 * B11 + b12 * B12 + b13 * B13;
+            const double disc = 18. * c3 * c2 * c1 * c0 - 4. * c2 * c2 * c2 * c0 + c2 * c2 * c1 * c1 - 4. * c3 * c1 * c1 * c1 - 27. * c3 * c3 * c0 * c0;
+            // If all roots are real, Descartes' rule of signs counts the positive ones exactly
+            const int changes = (c3 * c2 < 0.) + (c2 * c1 < 0.) + (c1 * c0 < 0.);
+            return (disc > 0.) & (changes == 2);
+        }
+        // Real roots of x^3 + a x^2 + b x + c
+        int SolveCubic(double a, double b, double c, double* x) {
+            const double q = (a * a - 3. * b) / 9., r = (2. * a * a * a - 9. * a * b + 27. * c) / 54.;
+            if (r * r < q * q * q) {
+                const double theta = std::acos(std::max(-1., std::min(1., r / std::sqrt(q * q * q))));
+                const double sq = -2. * std::sqrt(q);
+                x[0] = sq * std::cos(theta / 3.) - a / 3.;
+                x[1] = sq * std::cos((theta + 2. * M_PI) / 3.) - a / 3.;
+                x[2] = sq * std::cos((theta - 2. * M_PI) / 3.) - a / 3.;
+                return 3;
+            }
+            const double A = -std::copysign(std::cbrt(std::fabs(r) + std::sqrt(r * r - q * q * q)), r);
+            x[0] = (A + (A != 0. ? q / A : 0.)) - a / 3.;
+            return 1;
+        }
+        int SolveQuadratic(double b, double c, double* x) {
+            // x^2 + b x + c
+            double disc = b * b - 4. * c;
+            // Tangential solutions are smeared by the rounding. They are validated afterwards
+            if (disc < -1.e-12 * std::max(1., b * b)) return 0;
+            disc = std::sqrt(std::max(0., disc));
+            x[0] = 0.5 * (-b + disc);
+            x[1] = 0.5 * (-b - disc);
+            return 2;
+        }
+        // Real roots of c[4] x^4 + c[3] x^3 + c[2] x^2 + c[1] x + c[0] following Ferrari
+        int SolveQuartic(const double* c, double* x) {
+            const double a = c[3] / c[4], b = c[2] / c[4], cc = c[1] / c[4], d = c[0] / c[4];
+            // Depressed quartic y^4 + p y^2 + q y + r with x = y - a / 4
+            const double a2 = a * a;
+            const double p = b - 3. * a2 / 8.;
+            const double q = cc - a * b / 2. + a2 * a / 8.;
+            const double r = d - a * cc / 4. + a2 * b / 16. - 3. * a2 * a2 / 256.;
+            int n = 0;
+            if (std::fabs(q) < 1.e-14) {
+                double z[2];
+                for (int i = SolveQuadratic(p, r, z) - 1; i >= 0; --i) {
+                    if (z[i] < 0.) continue;
+                    x[n++] = std::sqrt(z[i]) - a / 4.;
+                    x[n++] = -std::sqrt(z[i]) - a / 4.;
+                }
+            } else {
+                // The resolvent cubic has always one positive root
+                double m[3];
+                int nm = SolveCubic(p, p * p / 4. - r, -q * q / 8., m);
+                double m0 = m[0];
+                for (int i = 1; i < nm; ++i) m0 = std::max(m0, m[i]);
+                if (m0 <= 0.) return 0;
+                const double s = std::sqrt(2. * m0);
+                double y[2];
+                for (int i = SolveQuadratic(-s, p / 2. + m0 + q / (2. * s), y) - 1; i >= 0; --i) x[n++] = y[i] - a / 4.;
+                for (int i = SolveQuadratic(s, p / 2. + m0 - q / (2. * s), y) - 1; i >= 0; --i) x[n++] = y[i] - a / 4.;
+            }
+            // Polish the roots against the original polynomial
+            for (int i = 0; i < n; ++i) {
+                for (int it = 0; it < 2; ++it) {
+                    const double t = x[i];
+                    const double f = (((c[4] * t + c[3]) * t + c[2]) * t + c[1]) * t + c[0];
+                    const double df = ((4. * c[4] * t + 3. * c[3]) * t + 2. * c[2]) * t + c[1];
+                    if (df != 0.) x[i] = t - f / df;
+                }
+            }
+            return n;
+        }
+        // Product of two quadratic polynomials given by their coefficients in ascending order
+        void Multiply(const double* u, const double* v, double* w) {
+            w[0] = u[0] * v[0];
+            w[1] = u[0] * v[1] + u[1] * v[0];
+            w[2] = u[0] * v[2] + u[1] * v[1] + u[2] * v[0];
+            w[3] = u[1] * v[2] + u[2] * v[1];
+            w[4] = u[2] * v[2];
+        }
+        // Massless mt2 and the momentum q1 of the corresponding split of pmiss. Returns -1 for degenerate configurations
+        double MasslessSolution(double ax, double ay, double bx, double by, double px, double py, double& q1x, double& q1y) {
+            const double na = std::hypot(ax, ay), nb = std::hypot(bx, by), np = std::hypot(px, py);
+            q1x = q1y = 0.;
+            // A vanishing visible momentum absorbs any invisible momentum with mT = 0
+            if (na == 0. || np == 0.) {
+                q1x = px;
+                q1y = py;
+                return 0.;
+            }
+            if (nb == 0.) return 0.;
+            const double uax = ax / na, uay = ay / na, ubx = bx / nb, uby = by / nb, upx = px / np, upy = py / np;
+            const double ab = Cross(uax, uay, ubx, uby);
+            if (std::fabs(ab) < 1.e-9) return -1.;
+            // Invisible momenta parallel to the visible ones give mT = 0
+            const double r1 = Cross(px, py, ubx, uby) / ab, r2 = Cross(uax, uay, px, py) / ab;
+            if (r1 >= 0. && r2 >= 0.) {
+                q1x = r1 * uax;
+                q1y = r1 * uay;
+                return 0.;
+            }
+            // At the balanced solution q1 and q2 are the visible momenta reflected at a common axis n = (cos beta, sin beta).
+            // The reflected pmiss decomposes into r1 a + r2 b and mT^2 = 4 |a| r1 (a x n)^2 = 4 |b| r2 (b x n)^2.
+            // In terms of w = (1, tan beta), the balance condition reads
+            //   |a| Im(b p conj(w)^2) (a x w)^2 = |b| Im(conj(p a) w^2) (b x w)^2
+            // with the momenta interpreted as unit complex numbers.
+            const double ur = ubx * upx - uby * upy, ui = ubx * upy + uby * upx;
+            const double vr = upx * uax - upy * uay, vi = -(upx * uay + upy * uax);
+            const double L[3] = {ui, -2. * ur, -ui}, Sa[3] = {uay * uay, -2. * uax * uay, uax * uax};
+            const double R[3] = {vi, 2. * vr, -vi}, Sb[3] = {uby * uby, -2. * ubx * uby, ubx * ubx};
+            double P1[5], P2[5], poly[5];
+            Multiply(L, Sa, P1);
+            Multiply(R, Sb, P2);
+            double norm = 0.;
+            for (int k = 0; k < 5; ++k) {
+                poly[k] = na * P1[k] - nb * P2[k];
+                norm = std::max(norm, std::fabs(poly[k]));
+            }
+            // Solve in cot(beta) instead, if the axis is closer to the y-direction
+            const bool inverted = std::fabs(poly[4]) < std::fabs(poly[0]);
+            if (inverted) std::reverse(poly, poly + 5);
+            if (std::fabs(poly[4]) < 1.e-12 * norm) return -1.;
+            double roots[4];
+            const int n = SolveQuartic(poly, roots);
+            double best = -1.;
+            for (int i = 0; i < n; ++i) {
+                const double wx = inverted ? roots[i] : 1., wy = inverted ? 1. : roots[i];
+                const double nw = std::hypot(wx, wy), nx = wx / nw, ny = wy / nw;
+                // Reflect pmiss at the axis and decompose it into the visible directions
+                const double dp = px * nx + py * ny;
+                const double rx = 2. * dp * nx - px, ry = 2. * dp * ny - py;
+                const double s1 = Cross(rx, ry, ubx, uby) / ab, s2 = Cross(uax, uay, rx, ry) / ab;
+                const double sa = Cross(uax, uay, nx, ny), sb = Cross(ubx, uby, nx, ny);
+                // The gradients of both mT's must point into the same direction
+                if (s1 <= 0. || s2 <= 0. || sa * sb <= 0.) continue;
+                const double mt2a = 4. * na * s1 * sa * sa, mt2b = 4. * nb * s2 * sb * sb;
+                if (std::fabs(mt2a - mt2b) > 1.e-6 * std::max(mt2a, mt2b)) continue;
+                if (best >= 0. && mt2a >= best) continue;
+                best = mt2a;
+                const double da = uax * nx + uay * ny;
+                q1x = s1 * (2. * da * nx - uax);
+                q1y = s1 * (2. * da * ny - uay);
+            }
+            return best >= 0. ? std::sqrt(best) : -1.;
+        }
+    }  // namespace
+    //################################################################################
+    //                              MT2Batch
+    //################################################################################
+    void MT2Batch::clear() {
+        for (auto* v : {&ma, &pxa, &pya, &mb, &pxb, &pyb, &pxmiss, &pymiss, &mInvA, &mInvB}) v->clear();
+    }
+    void MT2Batch::reserve(size_t n) {
+        for (auto* v : {&ma, &pxa, &pya, &mb, &pxb, &pyb, &pxmiss, &pymiss, &mInvA, &mInvB}) v->reserve(n);
+    }
+    size_t MT2Batch::size() const { return ma.size(); }
+    void MT2Batch::add(double m_a, double px_a, double py_a, double m_b, double px_b, double py_b, double px_miss, double py_miss,
+                       double m_invA, double m_invB) {
+        ma.push_back(m_a);
+        pxa.push_back(px_a);
+        pya.push_back(py_a);
+        mb.push_back(m_b);
+        pxb.push_back(px_b);
+        pyb.push_back(py_b);
+        pxmiss.push_back(px_miss);
+        pymiss.push_back(py_miss);
+        mInvA.push_back(m_invA);
+        mInvB.push_back(m_invB);
+    }
+    //################################################################################
+    //                              MT2Solver
+    //################################################################################
+    void MT2Solver::Scratch::clear() {
+        index.clear();
+        for (auto* v : {&scale, &ma, &ax, &ay, &mb, &bx, &by, &px, &py, &ca, &cb, &lo, &hi}) v->clear();
+    }
+    void MT2Solver::Scratch::add(const Problem& P, size_t idx) {
+        index.push_back(idx);
+        scale.push_back(P.scale);
+        ma.push_back(P.ma);
+        ax.push_back(P.ax);
+        ay.push_back(P.ay);
+        mb.push_back(P.mb);
+        bx.push_back(P.bx);
+        by.push_back(P.by);
+        px.push_back(P.px);
+        py.push_back(P.py);
+        ca.push_back(P.ca);
+        cb.push_back(P.cb);
+        lo.push_back(P.lo);
+        hi.push_back(P.hi);
+    }
+    MT2Solver::MT2Solver(double precision) : m_precision(precision) {}
+    double MT2Solver::precision() const { return m_precision; }
+
+    double MT2Solver::computeMassless(double pxa, double pya, double pxb, double pyb, double pxmiss, double pymiss) {
+        double q1x(0.), q1y(0.);
+        return MasslessSolution(pxa, pya, pxb, pyb, pxmiss, pymiss, q1x, q1y);
+    }
+    bool MT2Solver::prepare(Problem& P, double ma, double pxa, double pya, double mb, double pxb, double pyb, double pxmiss, double pymiss,
+                            double mInvA, double mInvB) const {
+        ma = std::fabs(ma);
+        mb = std::fabs(mb);
+        mInvA = std::fabs(mInvA);
+        mInvB = std::fabs(mInvB);
+        P.scale = std::max({std::hypot(pxa, pya), std::hypot(pxb, pyb), std::hypot(pxmiss, pymiss), ma, mb, mInvA, mInvB});
+        if (P.scale <= 0.) {
+            P.scale = P.lo = P.hi = 0.;
+            return true;
+        }
+        const double inv = 1. / P.scale;
+        P.ma = ma * inv;
+        P.ax = pxa * inv;
+        P.ay = pya * inv;
+        P.mb = mb * inv;
+        P.bx = pxb * inv;
+        P.by = pyb * inv;
+        P.px = pxmiss * inv;
+        P.py = pymiss * inv;
+        P.ca = mInvA * inv;
+        P.cb = mInvB * inv;
+
+        double mx(0.), my(0.);
+        const double massless = MasslessSolution(P.ax, P.ay, P.bx, P.by, P.px, P.py, mx, my);
+        if (massless >= 0. && P.ma == 0. && P.mb == 0. && P.ca == 0. && P.cb == 0.) {
+            P.lo = P.hi = massless;
+            return true;
+        }
+        // Unbalanced solutions: The lighter side stays below the minimum of the heavier one
+        const double Ma = P.ma + P.ca, Mb = P.mb + P.cb;
+        const double q1x = P.ma > 0. ? P.ca / P.ma * P.ax : 0., q1y = P.ma > 0. ? P.ca / P.ma * P.ay : 0.;
+        const double q2x = P.mb > 0. ? P.cb / P.mb * P.bx : 0., q2y = P.mb > 0. ? P.cb / P.mb * P.by : 0.;
+        if (P.ma > 0. && Ma >= Mb && MtSq(P.mb, P.bx, P.by, P.cb, P.px - q1x, P.py - q1y) <= Ma * Ma) {
+            P.lo = P.hi = Ma;
+            return true;
+        }
+        if (P.mb > 0. && Mb >= Ma && MtSq(P.ma, P.ax, P.ay, P.ca, P.px - q2x, P.py - q2y) <= Mb * Mb) {
+            P.lo = P.hi = Mb;
+            return true;
+        }
+        // The upper edge of the bracket is the best of a few trial splits
+        auto Trial = [&P](double x, double y) { return std::max(MtSq(P.ma, P.ax, P.ay, P.ca, x, y), MtSq(P.mb, P.bx, P.by, P.cb, P.px - x, P.py - y)); };
+        double hi2 = Trial(0.5 * P.px, 0.5 * P.py);
+        if (massless >= 0.) hi2 = std::min(hi2, Trial(mx, my));
+        if (P.ma > 0.) hi2 = std::min(hi2, Trial(q1x, q1y));
+        if (P.mb > 0.) hi2 = std::min(hi2, Trial(P.px - q2x, P.py - q2y));
+
+        const double na = std::hypot(P.ax, P.ay), nb = std::hypot(P.bx, P.by);
+        const bool collinear = std::fabs(Cross(P.ax, P.ay, P.bx, P.by)) < 1.e-3 * na * nb;
+        P.ma = std::max(P.ma, collinear ? MinimalMassCollinear : MinimalMass);
+        P.mb = std::max(P.mb, collinear ? MinimalMassCollinear : MinimalMass);
+        P.lo = std::max(P.ma + P.ca, P.mb + P.cb);
+        P.hi = std::max(std::sqrt(hi2), P.lo);
+        return P.hi - P.lo <= m_precision * P.hi;
+    }
+    unsigned int MT2Solver::iterations(const Problem& P) const {
+        const double ratio = (P.hi - P.lo) / (m_precision * P.lo);
+        if (ratio <= 1.) return 0;
+        return std::min(MaxIterations, (unsigned int)std::ceil(std::log2(ratio)));
+    }
+    double MT2Solver::compute(double ma, double pxa, double pya, double mb, double pxb, double pyb, double pxmiss, double pymiss,
+                              double mInvA, double mInvB) const {
+        Problem P;
+        if (!prepare(P, ma, pxa, pya, mb, pxb, pyb, pxmiss, pymiss, mInvA, mInvB)) {
+            for (unsigned int i = iterations(P); i > 0; --i) {
+                const double M = 0.5 * (P.lo + P.hi);
+                if (Disjoint(M, P.ma, P.ax, P.ay, P.mb, P.bx, P.by, P.px, P.py, P.ca, P.cb))
+                    P.lo = M;
+                else
+                    P.hi = M;
+            }
+        }
+        return P.scale * 0.5 * (P.lo + P.hi);
+    }
+    void MT2Solver::compute(const MT2Batch& batch, std::vector<double>& result) const {
+        Scratch scratch;
+        compute(batch, result, scratch);
+    }
+    void MT2Solver::compute(const MT2Batch& batch, std::vector<double>& result, Scratch& scratch) const {
+        const size_t n = batch.size();
+        result.assign(n, 0.);
+        scratch.clear();
+        unsigned int steps = 0;
+        for (size_t i = 0; i < n; ++i) {
+            Problem P;
+            if (prepare(P, batch.ma[i], batch.pxa[i], batch.pya[i], batch.mb[i], batch.pxb[i], batch.pyb[i], batch.pxmiss[i], batch.pymiss[i],
+                        batch.mInvA[i], batch.mInvB[i])) {
+                result[i] = P.scale * 0.5 * (P.lo + P.hi);
+                continue;
+            }
+            scratch.add(P, i);
+            steps = std::max(steps, iterations(P));
+        }
+        // All open configurations are bisected in lockstep
+        const size_t nl = scratch.index.size();
+        const double *ma = scratch.ma.data(), *ax = scratch.ax.data(), *ay = scratch.ay.data();
+        const double *mb = scratch.mb.data(), *bx = scratch.bx.data(), *by = scratch.by.data();
+        const double *px = scratch.px.data(), *py = scratch.py.data(), *ca = scratch.ca.data(), *cb = scratch.cb.data();
+        double *lo = scratch.lo.data(), *hi = scratch.hi.data();
+        for (unsigned int s = 0; s < steps; ++s) {
+            for (size_t l = 0; l < nl; ++l) {
+                const double M = 0.5 * (lo[l] + hi[l]);
+                const bool disjoint = Disjoint(M, ma[l], ax[l], ay[l], mb[l], bx[l], by[l], px[l], py[l], ca[l], cb[l]);
+                lo[l] = disjoint ? M : lo[l];
+                hi[l] = disjoint ? hi[l] : M;
+            }
+        }
+        for (size_t l = 0; l < nl; ++l) result[scratch.index[l]] = scratch.scale[l] * 0.5 * (lo[l] + hi[l]);
+    }
+}  // namespace XAMPP
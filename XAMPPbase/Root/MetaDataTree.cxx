@@ -18,8 +18,12 @@
 #ifndef XAOD_STANDALONE
 #include <AthAnalysisBaseComps/AthAnalysisHelper.h>
 #include <EventInfo/EventStreamInfo.h>
+#include <GaudiKernel/FileIncident.h>
 #include <GaudiKernel/ITHistSvc.h>
 #endif
+#include <TSystem.h>
+#include <fstream>
+#include <unistd.h>
 namespace XAMPP {
     // List of prcoess IDs
     // https://twiki.cern.ch/twiki/bin/view/AtlasProtected/SUSYSignalUncertainties#Subprocess_IDs
@@ -49,6 +53,12 @@ namespace XAMPP {
         m_histSvc("THistSvc", myname),
         m_isData(false),
         m_init(false),
+        m_claimDir(),
+        m_motherPID(-1),
+        m_currentFile(),
+        m_currentFileName(),
+        m_pendingFile(),
+        m_bookCurrentFile(true),
         m_analysis_helper("AnalysisHelper"),
         m_XAMPPInfo("EventInfoHandler"),
         m_MetaDB(),
@@ -60,6 +70,9 @@ namespace XAMPP {
         declareProperty("useFileMetaData", m_UseFileMetaData);
         declareProperty("fillLHEWeights", m_fillLHEWeights);
         declareProperty("SwitchOnDSIDshift", m_shiftMetaDSID);
+        // Settings of the multi-process mode. See runAthena.py --nProcs
+        declareProperty("FileClaimDirectory", m_claimDir);
+        declareProperty("MotherProcessID", m_motherPID);
         m_XAMPPInfo.declarePropertyFor(this, "EventInfoHandler", "The XAMPPInfo event Handler");
     }
 
@@ -107,6 +120,12 @@ namespace XAMPP {
         }
     }
     StatusCode MetaDataTree::beginEvent() {
+        // The first file is opened by the mother process before the workers are forked. The
+        // worker reading the first event of that file books its information instead
+        if (!m_pendingFile.empty()) {
+            if (m_pendingFile == m_currentFile) ATH_CHECK(BookInputFile());
+            m_pendingFile.clear();
+        }
         ATH_CHECK(m_analysis_helper->LoadContainers());
         if (m_XAMPPInfo->isMC() == m_isData) {
             ATH_MSG_FATAL("The analysis is configured to run over data while the input file is MC...");
@@ -146,6 +165,7 @@ namespace XAMPP {
                                                           << ") runNumbers for lumiblock range " << lumi->startRunNumber() << "-"
                                                           << lumi->stopLumiBlockNumber());
             LoadRunMetaData(lumi->startRunNumber());
+            m_ActDB->second->setBookFileInformation(m_bookCurrentFile);
             ATH_CHECK(m_ActDB->second->newFile(lumi));
         }
         HasCont = true;
@@ -180,6 +200,18 @@ namespace XAMPP {
         }
         return m_ActDB->second->fillVariation(Idx + 1000, W);
     }
+    StatusCode MetaDataTree::fillLHEMetaData(const std::vector<double>& weights) {
+        if (m_isData) {
+            ATH_MSG_ERROR("Data does not have any weight variations");
+            return StatusCode::FAILURE;
+        }
+        if (!m_fillLHEWeights) {
+            ATH_MSG_DEBUG("No lhe meta-data should be stored");
+            return StatusCode::SUCCESS;
+        }
+        LoadMCMetaData(m_XAMPPInfo->mcChannelNumber(), m_XAMPPInfo->runNumber());
+        return m_ActDB->second->fillVariations(weights, m_analysis_helper->finalState());
+    }
     std::vector<std::string> MetaDataTree::getLHEWeightNames() const {
         std::vector<std::string> ret;
         if (m_isData) return ret;
@@ -196,11 +228,49 @@ namespace XAMPP {
         return ret;
     }
 
+#ifndef XAOD_STANDALONE
+    void MetaDataTree::handle(const Incident& inc) {
+        if (inc.type() == IncidentType::BeginInputFile) {
+            const FileIncident* file_inc = dynamic_cast<const FileIncident*>(&inc);
+            if (file_inc) {
+                m_currentFile = file_inc->fileGuid().empty() ? file_inc->fileName() : file_inc->fileGuid();
+                m_currentFileName = file_inc->fileName();
+            }
+        }
+        asg::AsgMetadataTool::handle(inc);
+    }
+#endif
+    bool MetaDataTree::isParallelMother() const { return !m_claimDir.empty() && m_motherPID == getpid(); }
+    bool MetaDataTree::ClaimInputFile() const {
+        if (m_claimDir.empty()) return true;
+        if (m_currentFile.empty()) {
+            ATH_MSG_WARNING("The input file has no GUID. Cannot claim it for this worker");
+            return false;
+        }
+        // Creating a directory is atomic. Only the first worker succeeds
+        const std::string claim = m_claimDir + "/" + m_currentFile;
+        if (gSystem->MakeDirectory(claim.c_str()) != 0) return false;
+        // The name of the claimed file lets runAthena find the input files which no process has
+        // opened, i.e. files without any event. Their metadata is collected in a serial job afterwards
+        std::ofstream name_file(claim + "/file_name");
+        name_file << m_currentFileName << std::endl;
+        return true;
+    }
     StatusCode MetaDataTree::beginInputFile() {
         if (!m_UseFileMetaData) {
             ATH_MSG_INFO("File meta data is disabled");
             return StatusCode::SUCCESS;
         }
+        if (isParallelMother()) {
+            ATH_MSG_DEBUG("Defer the booking of file " << m_currentFile << " to the workers");
+            m_pendingFile = m_currentFile;
+            return StatusCode::SUCCESS;
+        }
+        return BookInputFile();
+    }
+    StatusCode MetaDataTree::BookInputFile() {
+        m_bookCurrentFile = ClaimInputFile();
+        if (!m_bookCurrentFile) ATH_MSG_DEBUG("The file " << m_currentFile << " has already been booked by another worker");
         bool HasLumiCont = false;
         if (m_isData) {
             ATH_CHECK(CheckLumiBlockContainer("LumiBlocks", HasLumiCont));
@@ -225,6 +295,7 @@ namespace XAMPP {
                                    (m_shiftMetaDSID || m_XAMPPInfo->applyDSIDShift() ? m_XAMPPInfo->dsidOffSet() : 0),
                                (*esi->getRunNumbers().begin()));
                 MC = m_ActDB->second;
+                MC->setBookFileInformation(m_bookCurrentFile);
 
                 if (m_fillLHEWeights) {
                     std::map<std::string, int> VariationNames;
@@ -242,6 +313,7 @@ namespace XAMPP {
             else if (!HasLumiCont) {
                 if (m_DummyEntry) ATH_MSG_WARNING("There is still an instance of the dummy meta");
                 m_DummyEntry = std::shared_ptr<MetaDataElement>(new runMetaData(-1, m_XAMPPInfo.getHandle()));
+                m_DummyEntry->setBookFileInformation(m_bookCurrentFile);
                 ATH_CHECK(m_DummyEntry->newFile(bks));
             }
         } else {
@@ -272,8 +344,13 @@ namespace XAMPP {
     //########################################################################################################
     //                                 MetaDataElement
     //########################################################################################################
-    MetaDataElement::MetaDataElement(ToolHandle<XAMPP::IEventInfo> XAMPPInfo) : m_XAMPPInfo(XAMPPInfo), m_LHE_WeightNames() {}
+    MetaDataElement::MetaDataElement(ToolHandle<XAMPP::IEventInfo> XAMPPInfo) :
+        m_XAMPPInfo(XAMPPInfo),
+        m_LHE_WeightNames(),
+        m_bookFileInfo(true) {}
     void MetaDataElement::setLHEWeightNames(const std::vector<std::string>& weights) { m_LHE_WeightNames = weights; }
+    void MetaDataElement::setBookFileInformation(bool B) { m_bookFileInfo = B; }
+    bool MetaDataElement::bookFileInformation() const { return m_bookFileInfo; }
     size_t MetaDataElement::numOfWeights() const { return m_LHE_WeightNames.size(); }
     const xAOD::CutBookkeeper* MetaDataElement::FindCutBookKeeper(const xAOD::CutBookkeeperContainer* container,
                                                                   MetaDataElement::BookKeeperType Type, unsigned int procID) {
@@ -332,6 +409,7 @@ namespace XAMPP {
         m_Data(),
         m_ActMeta(m_Data.end()),
         m_Inclusive(0),
+        m_Variations(),
         m_init(false) {
         m_init = m_helper.retrieve().isSuccess() && m_XAMPPInfo.retrieve().isSuccess();
         if (m_init) LoadMetaData(0);
@@ -453,7 +531,29 @@ namespace XAMPP {
         return StatusCode::SUCCESS;
     }
 
-    void MetaDataMC::AddEventInformation(std::shared_ptr<MetaDataMC::MetaData> Meta, double GenWeight) {
+    StatusCode MetaDataMC::fillVariations(const std::vector<double>& weights, unsigned int finalState) {
+        if (finalState > 0) {
+            const std::vector<std::shared_ptr<MetaDataMC::MetaData>>& Variations = LoadVariations(finalState, weights.size());
+            for (size_t Idx = 1; Idx < weights.size(); ++Idx) AddEventInformation(Variations[Idx], weights[Idx]);
+        }
+        const std::vector<std::shared_ptr<MetaDataMC::MetaData>>& Variations = LoadVariations(0, weights.size());
+        for (size_t Idx = 1; Idx < weights.size(); ++Idx) AddEventInformation(Variations[Idx], weights[Idx]);
+        return StatusCode::SUCCESS;
+    }
+    const std::vector<std::shared_ptr<MetaDataMC::MetaData>>& MetaDataMC::LoadVariations(unsigned int finalState, size_t nWeights) {
+        std::vector<std::shared_ptr<MetaDataMC::MetaData>>& Variations = m_Variations[finalState];
+        for (size_t Idx = Variations.size(); Idx < nWeights; ++Idx) {
+            if (Idx == 0) {
+                Variations.push_back(nullptr);
+                continue;
+            }
+            // Same process ids as in MetaDataTree::fillLHEMetaData(unsigned int)
+            LoadMetaData(finalState > 0 ? (Idx + 1000) * 1.e4 + finalState : Idx + 1000);
+            Variations.push_back(m_ActMeta->second);
+        }
+        return Variations;
+    }
+    void MetaDataMC::AddEventInformation(const std::shared_ptr<MetaDataMC::MetaData>& Meta, double GenWeight) {
         ++Meta->NumProcessedEvents;
         if (!Meta->MetaInit) {
             // Retrieve the processId
@@ -555,9 +655,11 @@ namespace XAMPP {
     }
     MetaDataMC::~MetaDataMC() {}
     void MetaDataMC::AddFileInformation(std::shared_ptr<MetaDataMC::MetaData> Meta, Long64_t TotEv, double SumW, double SumW2) {
-        Meta->NumTotalEvents = Meta->NumTotalEvents + TotEv;
-        Meta->SumW = Meta->SumW + SumW;
-        Meta->SumW2 = Meta->SumW2 + SumW2;
+        if (bookFileInformation()) {
+            Meta->NumTotalEvents = Meta->NumTotalEvents + TotEv;
+            Meta->SumW = Meta->SumW + SumW;
+            Meta->SumW2 = Meta->SumW2 + SumW2;
+        }
         Meta->KeeperAvailable = true;
         if (Meta->ProcID > 1000 && Meta->ProcID < 1000 + m_LHE_WeightNames.size()) {
             Meta->procName = m_LHE_WeightNames.at(Meta->ProcID - 1000);
@@ -577,11 +679,15 @@ namespace XAMPP {
             Error("MetaDataMC::CopyStore()", "Wrong MC channel");
             return StatusCode::FAILURE;
         }
+        // The other store has already decided whether its file information is booked
+        const bool book_file = bookFileInformation();
+        setBookFileInformation(true);
         for (auto& toCopy : Other->m_Data) {
             LoadMetaData(toCopy.second->ProcID);
             AddFileInformation(m_ActMeta->second, toCopy.second->NumTotalEvents, toCopy.second->SumW, toCopy.second->SumW2);
             m_ActMeta->second->procName = toCopy.second->procName;
         }
+        setBookFileInformation(book_file);
         return StatusCode::SUCCESS;
     }
 
@@ -603,7 +709,7 @@ namespace XAMPP {
             return StatusCode::FAILURE;
         }
         CutBookKeeperAvailable(true);
-        m_NumTotalEvents = m_NumTotalEvents + all->nAcceptedEvents();
+        if (bookFileInformation()) m_NumTotalEvents = m_NumTotalEvents + all->nAcceptedEvents();
         return StatusCode::SUCCESS;
     }
     StatusCode runMetaData::newEvent() {
@@ -656,11 +762,13 @@ namespace XAMPP {
             Error("runMetaData::newFile()", "No LumiBlock element given");
             return StatusCode::FAILURE;
         }
-        m_NumTotalEvents = m_NumTotalEvents + LumiBlock->eventsSeen();
+        // The lumi blocks are merged as a set. Only the event count must not be booked twice
+        if (bookFileInformation()) m_NumTotalEvents = m_NumTotalEvents + LumiBlock->eventsSeen();
         for (unsigned int L = LumiBlock->startLumiBlockNumber(); L <= LumiBlock->stopLumiBlockNumber(); ++L) m_TotalBlocks.insert(L);
 
         return StatusCode::SUCCESS;
     }
     StatusCode runMetaData::fillVariation(unsigned int, double) { return StatusCode::FAILURE; }
+    StatusCode runMetaData::fillVariations(const std::vector<double>&, unsigned int) { return StatusCode::FAILURE; }
 
 }  // namespace XAMPP
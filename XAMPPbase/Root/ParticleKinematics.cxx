@@ -0,0 +1,247 @@
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/Defs.h>
+#include <XAMPPbase/ParticleKinematics.h>
+
+#include <FourMomUtils/xAODP4Helpers.h>
+#include <TruthUtils/PIDHelpers.h>
+
+#include <cfloat>
+#include <cmath>
+
+namespace XAMPP {
+    ParticleKinematics::ParticleKinematics() :
+        m_particles(),
+        m_pt(),
+        m_eta(),
+        m_phi(),
+        m_m(),
+        m_px(),
+        m_py(),
+        m_pz(),
+        m_e(),
+        m_hasFlavour(false),
+        m_charge(),
+        m_pdgId(),
+        m_flavour(),
+        m_sfos() {}
+    void ParticleKinematics::clear() {
+        m_particles.clear();
+        m_pt.clear();
+        m_eta.clear();
+        m_phi.clear();
+        m_m.clear();
+        m_px.clear();
+        m_py.clear();
+        m_pz.clear();
+        m_e.clear();
+        m_hasFlavour = false;
+        m_charge.clear();
+        m_pdgId.clear();
+        m_flavour.clear();
+    }
+    void ParticleKinematics::fill(const xAOD::IParticleContainer* particles, const xAOD::IParticleContainer* exclude) {
+        clear();
+        if (!particles) return;
+        for (const auto P : *particles) {
+            if (exclude && IsInContainer(P, *exclude)) continue;
+            const TLorentzVector p4 = P->p4();
+            m_particles.push_back(P);
+            m_pt.push_back(P->pt());
+            m_eta.push_back(P->eta());
+            m_phi.push_back(P->phi());
+            m_m.push_back(P->m());
+            m_px.push_back(p4.Px());
+            m_py.push_back(p4.Py());
+            m_pz.push_back(p4.Pz());
+            m_e.push_back(p4.E());
+        }
+    }
+    void ParticleKinematics::FillFlavour() const {
+        if (m_hasFlavour) return;
+        m_hasFlavour = true;
+        for (const auto P : m_particles) {
+            m_charge.push_back(Charge(P));
+            const int pdgId = TypeToPdgId(P);
+            m_pdgId.push_back(pdgId);
+            // Same definition as SameFlavour()
+            if (IsRecoLepton(P))
+                m_flavour.push_back(P->type());
+            else if (P->type() == xAOD::Type::ObjectType::TruthParticle && MC::PID::isChLepton(pdgId))
+                m_flavour.push_back(1000 + std::abs(pdgId));
+            else
+                m_flavour.push_back(-1);
+        }
+    }
+    size_t ParticleKinematics::size() const { return m_particles.size(); }
+    const xAOD::IParticle* ParticleKinematics::particle(size_t i) const { return m_particles[i]; }
+    const double* ParticleKinematics::pt() const { return m_pt.data(); }
+    const double* ParticleKinematics::eta() const { return m_eta.data(); }
+    const double* ParticleKinematics::phi() const { return m_phi.data(); }
+    const double* ParticleKinematics::m() const { return m_m.data(); }
+    const double* ParticleKinematics::px() const { return m_px.data(); }
+    const double* ParticleKinematics::py() const { return m_py.data(); }
+    const double* ParticleKinematics::pz() const { return m_pz.data(); }
+    const double* ParticleKinematics::e() const { return m_e.data(); }
+    const float* ParticleKinematics::charge() const {
+        FillFlavour();
+        return m_charge.data();
+    }
+    const int* ParticleKinematics::pdgId() const {
+        FillFlavour();
+        return m_pdgId.data();
+    }
+
+    float ParticleKinematics::Mass(double px, double py, double pz, double e) const {
+        // TLorentzVector::M()
+        const double mm = e * e - (px * px + py * py + pz * pz);
+        return mm < 0.0 ? -std::sqrt(-mm) : std::sqrt(mm);
+    }
+    float ParticleKinematics::InvariantMass(size_t i, size_t j) const {
+        return Mass(m_px[i] + m_px[j], m_py[i] + m_py[j], m_pz[i] + m_pz[j], m_e[i] + m_e[j]);
+    }
+    float ParticleKinematics::InvariantMass(size_t i, size_t j, size_t k) const {
+        return Mass(m_px[i] + m_px[j] + m_px[k], m_py[i] + m_py[j] + m_py[k], m_pz[i] + m_pz[j] + m_pz[k], m_e[i] + m_e[j] + m_e[k]);
+    }
+    float ParticleKinematics::InvariantMass(size_t i, size_t j, size_t k, size_t l) const {
+        return Mass(m_px[i] + m_px[j] + m_px[k] + m_px[l], m_py[i] + m_py[j] + m_py[k] + m_py[l], m_pz[i] + m_pz[j] + m_pz[k] + m_pz[l],
+                    m_e[i] + m_e[j] + m_e[k] + m_e[l]);
+    }
+    float ParticleKinematics::ComputeMt(size_t i, const xAOD::MissingET* met) const {
+        return std::sqrt(2 * (m_pt[i] * met->met() - m_px[i] * met->mpx() - m_py[i] * met->mpy()));
+    }
+    float ParticleKinematics::ComputeMt(size_t i, const xAOD::IParticle* P) const {
+        if (m_particles[i] == P) return 0.;
+        const TLorentzVector p4 = P->p4();
+        return std::sqrt(2 * (m_pt[i] * P->pt() - m_px[i] * p4.Px() - m_py[i] * p4.Py()));
+    }
+    bool ParticleKinematics::IsSFOS(size_t i, size_t j) const {
+        FillFlavour();
+        return m_particles[i] != m_particles[j] && m_charge[i] * m_charge[j] < 0. && m_flavour[i] >= 0 && m_flavour[i] == m_flavour[j];
+    }
+    int ParticleKinematics::ClosestInPhi(double phi) const {
+        int closest = -1;
+        double minDPhi = 99.;
+        for (size_t i = 0; i < m_phi.size(); ++i) {
+            float dPhi = std::fabs(xAOD::P4Helpers::deltaPhi(m_phi[i], phi));
+            if (dPhi < minDPhi) {
+                closest = i;
+                minDPhi = dPhi;
+            }
+        }
+        return closest;
+    }
+    int ParticleKinematics::FarestInPhi(double phi) const {
+        int farest = -1;
+        double maxDPhi = -99.;
+        for (size_t i = 0; i < m_phi.size(); ++i) {
+            float dPhi = std::fabs(xAOD::P4Helpers::deltaPhi(m_phi[i], phi));
+            if (dPhi > maxDPhi) {
+                farest = i;
+                maxDPhi = dPhi;
+            }
+        }
+        return farest;
+    }
+    float ParticleKinematics::ComputeMtMin(const xAOD::MissingET* met) const {
+        if (!met) return -1.;
+        int closest = ClosestInPhi(met->phi());
+        return closest < 0 ? -1. : ComputeMt(closest, met);
+    }
+    float ParticleKinematics::ComputeMtMin(const xAOD::IParticle* P) const {
+        if (!P) return -1.;
+        int closest = ClosestInPhi(P->phi());
+        return closest < 0 ? -1. : ComputeMt(closest, P);
+    }
+    float ParticleKinematics::ComputeMtMax(const xAOD::MissingET* met) const {
+        if (!met) return -1.;
+        int farest = FarestInPhi(met->phi());
+        return farest < 0 ? -1. : ComputeMt(farest, met);
+    }
+    float ParticleKinematics::ComputeMtMax(const xAOD::IParticle* P) const {
+        if (!P) return -1.;
+        int farest = FarestInPhi(P->phi());
+        return farest < 0 ? -1. : ComputeMt(farest, P);
+    }
+    float ParticleKinematics::ComputeDPhiMin(const xAOD::MissingET* met, unsigned int NToUse) const {
+        if (!met) return -FLT_MAX;
+        if (NToUse == 0 || NToUse > size()) NToUse = size();
+        const double met_phi = met->phi();
+        float minDPhi = 99.;
+        int closest = -1;
+        for (size_t i = 0; i < NToUse; ++i) {
+            float dP = std::fabs(xAOD::P4Helpers::deltaPhi(m_phi[i], met_phi));
+            if (dP < minDPhi) {
+                closest = i;
+                minDPhi = dP;
+            }
+        }
+        if (closest >= 0) return xAOD::P4Helpers::deltaPhi(m_phi[closest], met_phi);
+        return -FLT_MAX;
+    }
+    int ParticleKinematics::GetZVeto(float Z_Window) const {
+        const size_t n = size();
+        FillFlavour();
+        // The flavour and charge combinations are evaluated once per pair
+        m_sfos.assign(n * n, false);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) m_sfos[i * n + j] = m_sfos[j * n + i] = IsSFOS(i, j);
+        }
+        unsigned int Veto = ZVeto::Pass;
+        for (size_t i = 0; i < n; ++i) {
+            const char* sfos_i = &m_sfos[i * n];
+            for (size_t j = i + 1; j < n; ++j) {
+                const char* sfos_j = &m_sfos[j * n];
+                bool TwoLep = sfos_i[j];
+                if (TwoLep && std::fabs(InvariantMass(i, j) - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail2Lep; }
+                // Partial sums in the order of TLorentzVector P1 + P2 + P3 (+ P4)
+                const double px_ij = m_px[i] + m_px[j], py_ij = m_py[i] + m_py[j], pz_ij = m_pz[i] + m_pz[j], e_ij = m_e[i] + m_e[j];
+                for (size_t k = j + 1; k < n; ++k) {
+                    const double px_ijk = px_ij + m_px[k], py_ijk = py_ij + m_py[k], pz_ijk = pz_ij + m_pz[k], e_ijk = e_ij + m_e[k];
+                    bool ThreeLep = (TwoLep || sfos_j[k] || sfos_i[k]);
+                    if (ThreeLep && std::fabs(Mass(px_ijk, py_ijk, pz_ijk, e_ijk) - Z_MASS) < Z_Window) {
+                        // Test if one of the particles is a photon
+                        if (m_pdgId[i] == 22 || m_pdgId[j] == 22 || m_pdgId[k] == 22) {
+                            Veto = Veto | ZVeto::Fail2LepPhot;
+                        } else {
+                            Veto = Veto | ZVeto::Fail3Lep;
+                        }
+                    }
+                    const char* sfos_k = &m_sfos[k * n];
+                    for (size_t l = k + 1; l < n; ++l) {
+                        bool SFOSSFOS = (TwoLep && sfos_k[l]) || (sfos_i[k] && sfos_j[l]) || (sfos_i[l] && sfos_k[j]);
+                        if (!SFOSSFOS) continue;
+                        float M = Mass(px_ijk + m_px[l], py_ijk + m_py[l], pz_ijk + m_pz[l], e_ijk + m_e[l]);
+                        if (std::fabs(M - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail4Lep; }
+                    }
+                }
+            }
+        }
+        return Veto;
+    }
+    float ParticleKinematics::CalculateHt(float MinPt) const {
+        float Ht = 0;
+        for (size_t i = 0; i < m_pt.size(); ++i) {
+            if (m_pt[i] > MinPt) Ht += m_pt[i];
+        }
+        return Ht;
+    }
+    void ParticleKinematics::RemoveLowMassLeptons(bool (*pair)(const xAOD::IParticle*, const xAOD::IParticle*), float Upper_Mll,
+                                                  float Lower_Mll) const {
+        static CharDecorator dec_passLMR("passLMR");
+        static CharAccessor acc_passOR("passOR");
+        const size_t n = size();
+        std::vector<char> passOR(n);
+        for (size_t i = 0; i < n; ++i) passOR[i] = acc_passOR(*m_particles[i]);
+        for (size_t i = 0; i < n; ++i) {
+            if (!passOR[i]) continue;
+            for (size_t j = 0; j < i; ++j) {
+                if (!passOR[j] || m_particles[i] == m_particles[j] || !pair(m_particles[i], m_particles[j])) continue;
+                float M = InvariantMass(i, j);
+                if (M > Lower_Mll && M < Upper_Mll) {
+                    dec_passLMR(*m_particles[j]) = false;
+                    dec_passLMR(*m_particles[i]) = false;
+                }
+            }
+        }
+    }
+}  // namespace XAMPP
@@ -1,5 +1,6 @@
 #include <PATInterfaces/SystematicSet.h>
 #include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/CalibrationCache.h>
 #include <XAMPPbase/EventInfo.h>
 #include <XAMPPbase/ISystematics.h>
 #include <XAMPPbase/ParticleSelector.h>
@@ -36,6 +37,8 @@ namespace XAMPP {
         m_ActSys(nullptr),
         m_ContainerKey(),
         m_storeName(),
+        m_systName(),
+        m_storeKeys(),
         m_ObjectType(XAMPP::SelectionObject::Other),
         m_init(false),
         m_PreSelDecorName("baseline"),
@@ -45,6 +48,8 @@ namespace XAMPP {
         m_ORutilsDecorName("selected"),
         m_ORUtils_InFlag(1),
         m_syst_checked(false),
+        m_affectingSyst(),
+        m_affectingSystCached(false),
         m_eventSFstores(),
         m_WriteSFperParticle(false),
         m_EvInfoHandle("EventInfoHandler"),
@@ -145,7 +150,8 @@ namespace XAMPP {
             ATH_MSG_WARNING("Could not set the systematic " << Set->name() << " to EventInfo");
         if (m_ActSys == Set) return;
         m_ActSys = Set;
-        m_storeName = name() + SystName();
+        m_systName = Set->name().empty() ? "" : "_" + Set->name();
+        m_storeName = name() + m_systName;
         ATH_MSG_DEBUG("Loaded systematic. Update StoreName to " << StoreName());
     }
 
@@ -169,19 +175,56 @@ namespace XAMPP {
 
     const std::string& ParticleSelector::ContainerKey() const { return m_ContainerKey; }
 
-    std::string ParticleSelector::SystName(bool InclUnderScore) const {
+    const std::string& ParticleSelector::SystName(bool InclUnderScore) const {
+        static const std::string empty;
         if (!m_ActSys) {
             ATH_MSG_WARNING("No current systematic defined");
-            return "";
+            return empty;
         }
-        if (m_ActSys->name().empty() || !InclUnderScore) { return m_ActSys->name(); }
-        return "_" + m_ActSys->name();
+        if (!InclUnderScore) { return m_ActSys->name(); }
+        return m_systName;
+    }
+    const ParticleSelector::StoreKeys& ParticleSelector::GetStoreKeys(const std::string& Key, const CP::SystematicSet* Set) const {
+        std::map<std::string, StoreKeys>& keys = m_storeKeys[Set];
+        std::map<std::string, StoreKeys>::const_iterator itr = keys.find(Key);
+        if (itr != keys.end()) return itr->second;
+        const std::string store_name = !Set ? StoreName() : name() + (Set->name().empty() ? "" : "_" + Set->name());
+        StoreKeys& new_keys = keys[Key];
+        new_keys.view = Key + store_name;
+        new_keys.link = store_name + "_" + Key;
+        new_keys.link_aux = new_keys.link + "Aux.";
+        return new_keys;
+    }
+
+    bool ParticleSelector::RestoreCalibration(const std::string& Key, xAOD::IParticleContainer& Cont) const {
+        CalibrationCache* cache = CalibrationCache::GetInstance();
+        if (cache->mode() != CalibrationCache::Mode::Read) return false;
+        // The systematic is part of the record itself. Use the nominal link name as record key
+        if (!cache->restoreObjects(GetStoreKeys(Key, m_systematics->GetNominal()).link, m_ActSys, Cont)) return false;
+        ATH_MSG_DEBUG("Restored the calibration of " << Key << " for systematic " << SystName(false) << " from the cache");
+        return true;
+    }
+    StatusCode ParticleSelector::CacheCalibration(const std::string& Key, const xAOD::IParticleContainer& Cont,
+                                                  const xAOD::ShallowAuxContainer& AuxCont) {
+        CalibrationCache* cache = CalibrationCache::GetInstance();
+        if (cache->mode() != CalibrationCache::Mode::Write) return StatusCode::SUCCESS;
+        if (!cache->saveObjects(GetStoreKeys(Key, m_systematics->GetNominal()).link, m_ActSys, Cont, AuxCont)) {
+            ATH_MSG_ERROR("Failed to write the calibration of " << Key << " to the cache");
+            return StatusCode::FAILURE;
+        }
+        return StatusCode::SUCCESS;
     }
 
     void ParticleSelector::SetSystematics(const CP::SystematicSet& Set) { SetSystematics(&Set); }
 
     bool ParticleSelector::SystematicAffects(const CP::SystematicSet* Set) const {
-        bool Affects = IsInVector(Set, m_systematics->GetKinematicSystematics(m_ObjectType));
+        // Do not copy the list of systematics from the tool in each call
+        if (!m_affectingSystCached) {
+            if (!m_systematics->SystematicsFixed()) return IsInVector(Set, m_systematics->GetKinematicSystematics(m_ObjectType));
+            m_affectingSyst = m_systematics->GetKinematicSystematics(m_ObjectType);
+            m_affectingSystCached = true;
+        }
+        bool Affects = IsInVector(Set, m_affectingSyst);
         ATH_MSG_DEBUG("Systematic " << Set->name() << " affects tool " << (Affects ? "yes" : "no"));
         return Affects;
     }
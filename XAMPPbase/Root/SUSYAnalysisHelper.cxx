@@ -1,4 +1,7 @@
 #include <XAMPPbase/AnalysisConfig.h>
+#include <XAMPPbase/AsyncTreeWriter.h>
+#include <XAMPPbase/DeltaTrees.h>
+#include <XAMPPbase/CalibrationCache.h>
 #include <XAMPPbase/EventInfo.h>
 #include <XAMPPbase/HistoBase.h>
 #include <XAMPPbase/IDiTauSelector.h>
@@ -14,6 +17,8 @@
 #include <XAMPPbase/ReconstructedParticles.h>
 #include <XAMPPbase/SUSYAnalysisHelper.h>
 #include <XAMPPbase/SUSYSystematics.h>
+#include <XAMPPbase/StartupProfiler.h>
+#include <XAMPPbase/StartupSnapshot.h>
 #include <XAMPPbase/TreeBase.h>
 
 // Tool includes
@@ -27,6 +32,7 @@
 #include <SUSYTools/SUSYObjDef_xAOD.h>
 
 #include <fstream>
+#include <future>
 #include <iostream>
 
 namespace XAMPP {
@@ -60,8 +66,14 @@ namespace XAMPP {
         m_CleanCosmicMuon(true),
         m_CleanBadJet(true),
         m_FillLHEWeights(false),
+        m_LHEWeightsAsVector(false),
         m_shiftMetaDSID(false),
+        m_FileClaimDir(),
+        m_MotherPID(-1),
         m_LHEWeights(),
+        m_LHEWeightVector(nullptr),
+        m_LHEGenWeights(),
+        m_LHEOutliers(0),
         m_dec_NumBadMuon(nullptr),
         m_decNumBadJet(nullptr),
         m_decNumCosmicMuon(nullptr),
@@ -69,7 +81,22 @@ namespace XAMPP {
         m_PRWConfigFiles(),
         m_PRWLumiCalcFiles(),
         m_useXsecPMGTool(false),
+        m_CalibCacheDir(),
+        m_CalibCacheWeights(true),
+        m_ConfigHash(0),
+        m_AsyncTrees(false),
+        m_AsyncQueueSize(64),
+        m_NominalTreeCompression(),
+        m_SystTreeCompression(),
+        m_NominalTreeAutoFlush(0),
+        m_SystTreeAutoFlush(0),
+        m_DeltaSystTrees(false),
+        m_StartupSnapshot(),
+        m_XsecSnapshot(),
+        m_ValidateXsecSnapshot(false),
         m_XsecDB(),
+        m_XsecTable(),
+        m_XsecFiles(),
         m_histoVec(),
         m_treeVec(),
         m_buildCommonTree(false),
@@ -127,8 +154,14 @@ namespace XAMPP {
         // fill the weights of the LHE variations
         // only for recent derivations avilable
         declareProperty("fillLHEWeights", m_FillLHEWeights);
+        // Write the LHE weights into one vector branch GenWeight_LHE instead of one branch per variation
+        declareProperty("LHEWeightsAsVector", m_LHEWeightsAsVector);
         // Shift the DSID of the meta data
         declareProperty("MetaDataDDSIDshift", m_shiftMetaDSID);
+        // Multi-process mode: The workers claim the input files in this directory such that
+        // the file meta-data is booked exactly once
+        declareProperty("MetaDataFileClaimDir", m_FileClaimDir);
+        declareProperty("MotherProcessID", m_MotherPID);
 
         // SUSYTools properties and settings
         declareProperty("STConfigFile", m_STConfigFile = "SUSYTools/SUSYTools_Default.conf");
@@ -138,6 +171,29 @@ namespace XAMPP {
         declareProperty("PRWLumiCalcFiles", m_PRWLumiCalcFiles);
         declareProperty("useXsecPMGTool", m_useXsecPMGTool);
         declareProperty("XsecPMGToolFile", m_XsecPMGToolFile = "dev/PMGTools/PMGxsecDB_mc16.txt");
+        // Binary table compiled by CompileCrossSections from the files in STCrossSectionDB. It replaces the parsing
+        // of the text files unless it has been compiled from other files. Disabled if empty
+        declareProperty("XsecSnapshot", m_XsecSnapshot);
+        // Parse the text files nevertheless and compare them to the snapshot
+        declareProperty("ValidateXsecSnapshot", m_ValidateXsecSnapshot);
+        // Directory to cache the calibrated objects of each input file. The cache is disabled if empty
+        declareProperty("CalibrationCacheDir", m_CalibCacheDir);
+        // Cache the event scale-factors as well. Needs to be switched off if the per-object scale-factors are written
+        declareProperty("CalibrationCacheWeights", m_CalibCacheWeights);
+        // Fill the output trees in a separate thread. The queue size is the maximum number of entries in flight
+        declareProperty("AsyncTreeWriting", m_AsyncTrees);
+        declareProperty("AsyncTreeQueueSize", m_AsyncQueueSize);
+        // Compression (<Algorithm>:<Level>) and auto flush (entries if positive, bytes if negative) of the output trees.
+        // The nominal policy also applies to the common and the systematic group trees
+        declareProperty("NominalTreeCompression", m_NominalTreeCompression);
+        declareProperty("SystTreeCompression", m_SystTreeCompression);
+        declareProperty("NominalTreeAutoFlush", m_NominalTreeAutoFlush);
+        declareProperty("SystTreeAutoFlush", m_SystTreeAutoFlush);
+        // The systematic trees only store the branches and events which differ from nominal. Use the DeltaTreeReader to read them
+        declareProperty("DeltaSystTrees", m_DeltaSystTrees);
+        // File to store the systematic lists, the systematic routing and the trigger thresholds resolved by the first job
+        // such that the subsequent jobs with the same configuration can skip resolving them. Disabled if empty
+        declareProperty("StartupSnapshot", m_StartupSnapshot);
     }
 
     SUSYAnalysisHelper::~SUSYAnalysisHelper() { ATH_MSG_DEBUG("Destructor called"); }
@@ -168,6 +224,25 @@ namespace XAMPP {
         SUSYToolsSystematicToolHandle* SUSYToolsHandle = new SUSYToolsSystematicToolHandle(m_susytools);
 
         ATH_CHECK(SUSYToolsHandle->initialize());
+        if (!m_CalibCacheDir.empty() || !m_StartupSnapshot.empty()) {
+            // Everything which changes the outcome of the calibration enters the hash
+            // of the cache files and of the startup snapshot. Cut changes in the analysis configuration do not.
+            // The contents of the files are hashed as the same file name may refer to another version of the file
+            std::stringstream config;
+            config << "isData=" << isData() << ";isAF2=" << m_systematics->isAF2() << ";";
+            unsigned long long hash = Fnv1aHash(config.str());
+            std::vector<std::string> config_files{m_STConfigFile};
+            CopyVector(m_PRWConfigFiles, config_files, false);
+            CopyVector(m_PRWLumiCalcFiles, config_files, false);
+            for (const auto& config_file : config_files) {
+                hash = Fnv1aHash(";", 1, hash);
+                if (!Fnv1aHashFile(PathResolverFindCalibFile(config_file), hash)) {
+                    ATH_MSG_FATAL("Could not read " << config_file << " to hash the calibration configuration");
+                    return StatusCode::FAILURE;
+                }
+            }
+            m_ConfigHash = hash;
+        }
         m_PRWConfigFiles.clear();
         m_PRWLumiCalcFiles.clear();
         return StatusCode::SUCCESS;
@@ -194,8 +269,14 @@ namespace XAMPP {
     }
     StatusCode SUSYAnalysisHelper::initializeAnalysisTools() {
         ATH_MSG_INFO("Starting Analysis Setup");
-        ATH_CHECK(initializeSUSYTools());
-        ATH_CHECK(initializeGRLTool());
+        {
+            StartupTimer timer("SUSYTools");
+            ATH_CHECK(initializeSUSYTools());
+        }
+        {
+            StartupTimer timer("GoodRunsListSelectionTool");
+            ATH_CHECK(initializeGRLTool());
+        }
         return StatusCode::SUCCESS;
     }
     StatusCode SUSYAnalysisHelper::initializeOuputFormat() {
@@ -211,7 +292,12 @@ namespace XAMPP {
                                                        << " names we found");
             }
 
-            for (size_t E = Info->mcEventWeights().size() - 1; E > 0; --E) {
+            if (m_LHEWeightsAsVector) {
+                // The names of the variations are saved in the meta data
+                ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<std::vector<double>>("GenWeight_LHE", true, false));
+                m_LHEWeightVector = m_XAMPPInfo->GetVariableStorage<std::vector<double>>("GenWeight_LHE");
+            }
+            for (size_t E = Info->mcEventWeights().size() - 1; E > 0 && !m_LHEWeightsAsVector; --E) {
                 std::string WeightName = "GenWeight_LHE_" + std::to_string(E + 1000);
                 if (m_storeLHEbyName) WeightName = "GenWeight_LHE_" + LHEnames.at(E);
 
@@ -237,6 +323,9 @@ namespace XAMPP {
             m_histoVec.insert(std::pair<const CP::SystematicSet*, std::shared_ptr<HistoBase>>(current_syst, histo));
             std::shared_ptr<TreeBase> tree = CreateTreeClass(current_syst);
             tree->SetListOfFriends(group_trees);
+            if (m_DeltaSystTrees && current_syst != m_systematics->GetNominal()) {
+                tree->SetDeltaReference(m_treeVec[m_systematics->GetNominal()]);
+            }
             ATH_CHECK(initTreeClass(tree));
             m_treeVec.insert(std::pair<const CP::SystematicSet*, std::shared_ptr<TreeBase>>(current_syst, tree));
         }
@@ -250,85 +339,147 @@ namespace XAMPP {
         m_init = true;
         CP::CorrectionCode::enableFailure();
         ATH_MSG_INFO("Initializing...");
-        ATH_CHECK(m_systematics.retrieve());
+        {
+            StartupTimer timer("Systematics");
+            ATH_CHECK(m_systematics.retrieve());
+        }
         ATH_MSG_DEBUG("initialize the analysis tools");
-        ATH_CHECK(initializeAnalysisTools());
-        if (!m_InfoHandle.isUserConfigured()) {
-            ATH_MSG_DEBUG("Create the event info");
-            m_InfoHandle.setTypeAndName("XAMPP::EventInfo/EventInfoHandler");
-            ATH_CHECK(m_InfoHandle.setProperty("ApplyPRW", m_doPRW));
-            ATH_CHECK(m_InfoHandle.setProperty("ApplyGRLTool", m_useGRLTool));
-            ATH_CHECK(m_InfoHandle.setProperty("FilterOutput", m_CleanEvent));
-            ATH_CHECK(m_InfoHandle.setProperty("SaveRecoFlags", m_StoreRecoFlags));
-            ATH_CHECK(m_InfoHandle.setProperty("OutlierWeightStrategy", m_OutlierStrat));
-            ATH_CHECK(m_InfoHandle.setProperty("OutlierWeightThreshold", m_outlierWeightThreshold));
+        {
+            StartupTimer timer("Analysis tools");
+            ATH_CHECK(initializeAnalysisTools());
         }
-
-        ATH_CHECK(m_InfoHandle.retrieve());
-        m_XAMPPInfo = dynamic_cast<XAMPP::EventInfo*>(m_InfoHandle.operator->());
-
+        StartupSnapshot::GetInstance()->configure(m_StartupSnapshot, m_ConfigHash);
+        {
+            StartupTimer timer("EventInfo");
+            if (!m_InfoHandle.isUserConfigured()) {
+                ATH_MSG_DEBUG("Create the event info");
+                m_InfoHandle.setTypeAndName("XAMPP::EventInfo/EventInfoHandler");
+                ATH_CHECK(m_InfoHandle.setProperty("ApplyPRW", m_doPRW));
+                ATH_CHECK(m_InfoHandle.setProperty("ApplyGRLTool", m_useGRLTool));
+                ATH_CHECK(m_InfoHandle.setProperty("FilterOutput", m_CleanEvent));
+                ATH_CHECK(m_InfoHandle.setProperty("SaveRecoFlags", m_StoreRecoFlags));
+                ATH_CHECK(m_InfoHandle.setProperty("OutlierWeightStrategy", m_OutlierStrat));
+                ATH_CHECK(m_InfoHandle.setProperty("OutlierWeightThreshold", m_outlierWeightThreshold));
+            }
+            ATH_CHECK(m_InfoHandle.retrieve());
+            m_XAMPPInfo = dynamic_cast<XAMPP::EventInfo*>(m_InfoHandle.operator->());
+        }
+        // The text files of the cross-section database are parsed in the background while the
+        // CP tools are set up. Only the database itself is touched by the parsing and it is not
+        // queried before the first event. The future joins the thread in any case
+        std::future<void> xsec_loading;
         if (!isData() && m_useXsecPMGTool) {
+            StartupTimer timer("Cross-section database");
             ATH_MSG_DEBUG("Setup the cross section database with the PMG cross section tool");
             // SUSY::CrossSectionDB::CrossSectionDB(const std::string& txtfilename, bool usePathResolver, bool isExtended, bool usePMGTool)
             m_XsecDB = std::make_unique<SUSY::CrossSectionDB>(m_XsecPMGToolFile, true, false, true);
         } else if (!isData() && !m_XsecDBDir.empty()) {
             ATH_MSG_DEBUG("Setup the cross section database with directory " << m_XsecDBDir);
-            // SUSY::CrossSectionDB::CrossSectionDB(const std::string& txtfilename, bool usePathResolver, bool isExtended, bool usePMGTool)
-            m_XsecDB = std::make_unique<SUSY::CrossSectionDB>("", false, false, false);
             // read files in directory by matching file ending to .txt (note that e.g. .txt.bak or .txt.1 will be skipped)
-            std::vector<std::string> xsecFiles = ListDirectory(PathResolverFindCalibDirectory(m_XsecDBDir), "", "(.*\\.txt)");
-            for (const auto& xsecFile : xsecFiles) {
-                ATH_MSG_DEBUG("Load cross-sections from " << xsecFile);
-                m_XsecDB->loadFile(xsecFile);
+            m_XsecFiles = ListDirectory(PathResolverFindCalibDirectory(m_XsecDBDir), "", "(.*\\.txt)");
+            for (const auto& xsecFile : m_XsecFiles) { ATH_MSG_DEBUG("Load cross-sections from " << xsecFile); }
+            if (!m_XsecSnapshot.empty()) {
+                StartupTimer timer("Cross-section snapshot");
+                const std::string snapshot = PathResolverFindCalibFile(m_XsecSnapshot);
+                m_XsecTable = std::make_unique<CrossSectionTable>();
+                if (!snapshot.empty() && m_XsecTable->load(snapshot, CrossSectionTable::SourceHash(m_XsecFiles))) {
+                    ATH_MSG_INFO("Read " << m_XsecTable->size() << " processes from the cross-section snapshot " << snapshot);
+                } else {
+                    ATH_MSG_WARNING("The cross-section snapshot " << m_XsecSnapshot << " cannot be used. Parse the text files instead");
+                    m_XsecTable.reset();
+                }
+            }
+            // Both are loaded in the validation mode. The startup profile then shows the time of each of them
+            if (!m_XsecTable || m_ValidateXsecSnapshot) {
+                // SUSY::CrossSectionDB(const std::string& txtfilename, bool usePathResolver, bool isExtended, bool usePMGTool)
+                m_XsecDB = std::make_unique<SUSY::CrossSectionDB>("", false, false, false);
+                SUSY::CrossSectionDB* xsec_db = m_XsecDB.get();
+                std::vector<std::string> xsecFiles = m_XsecFiles;
+                xsec_loading = std::async(std::launch::async, [xsec_db, xsecFiles]() {
+                    StartupTimer timer("Cross-section database");
+                    for (const auto& xsecFile : xsecFiles) xsec_db->loadFile(xsecFile);
+                });
             }
             m_XsecDBDir.clear();
         } else if (isData()) {
             m_doTruth = false;
         }
-        if (!m_MDTree.isUserConfigured()) {
-            ATH_MSG_DEBUG("Create new metadata tree");
-            m_MDTree.setTypeAndName("XAMPP::MetaDataTree/MetaDataTree");
-            ATH_CHECK(m_MDTree.setProperty("isData", isData()));
-            ATH_CHECK(m_MDTree.setProperty("useFileMetaData", m_UseFileMetadata));
-            ATH_CHECK(m_MDTree.setProperty("fillLHEWeights", m_FillLHEWeights));
-            ATH_CHECK(m_MDTree.setProperty("SwitchOnDSIDshift", m_shiftMetaDSID));
-        } else {
-            ATH_MSG_DEBUG("Use configured meta data tree");
+        {
+            StartupTimer timer("MetaDataTree");
+            if (!m_MDTree.isUserConfigured()) {
+                ATH_MSG_DEBUG("Create new metadata tree");
+                m_MDTree.setTypeAndName("XAMPP::MetaDataTree/MetaDataTree");
+                ATH_CHECK(m_MDTree.setProperty("isData", isData()));
+                ATH_CHECK(m_MDTree.setProperty("useFileMetaData", m_UseFileMetadata));
+                ATH_CHECK(m_MDTree.setProperty("fillLHEWeights", m_FillLHEWeights));
+                ATH_CHECK(m_MDTree.setProperty("SwitchOnDSIDshift", m_shiftMetaDSID));
+                ATH_CHECK(m_MDTree.setProperty("FileClaimDirectory", m_FileClaimDir));
+                ATH_CHECK(m_MDTree.setProperty("MotherProcessID", m_MotherPID));
+            } else {
+                ATH_MSG_DEBUG("Use configured meta data tree");
+            }
+            ATH_CHECK(m_MDTree.retrieve());
         }
-
-        ATH_CHECK(m_MDTree.retrieve());
         if (!m_ParticleConstructor.isUserConfigured()) {
             ATH_MSG_DEBUG("Create class for handling of the reconstructed particles like Z, W, top candidates");
             m_ParticleConstructor.setTypeAndName("XAMPP::ReconstructedParticles/ParticleConstructor");
             ATH_CHECK(m_ParticleConstructor->initialize());
         }
-        ATH_CHECK(initializeObjectTools());
+        {
+            StartupTimer timer("Object selectors");
+            ATH_CHECK(initializeObjectTools());
+        }
         ATH_MSG_DEBUG("Fix the systematics tool");
-        ATH_CHECK(m_systematics->FixSystematics());
-        ATH_CHECK(m_analysis_modules.retrieve());
-        m_hasModules = !m_analysis_modules.empty();
-
-        // Initialize the event weights in MC
-        if (!isData()) {
-            ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<int>("SUSYFinalState"));
-            ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<bool>(+"HasPathologicalWeight",
-                                                                m_XAMPPInfo->getOutlierWeightStrategy() == IEventInfo::resetWeight));
-            ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<double>("GenWeight"));
+        {
+            StartupTimer timer("FixSystematics");
+            ATH_CHECK(m_systematics->FixSystematics());
         }
-        ATH_CHECK(initializeEventVariables());
-        if (m_hasModules) {
-            for (auto& module : m_analysis_modules) ATH_CHECK(module->bookVariables());
+        if (!m_CalibCacheDir.empty()) {
+            ATH_MSG_INFO("Cache the calibrated objects in " << m_CalibCacheDir);
+            CalibrationCache::GetInstance()->configure(m_CalibCacheDir, m_ConfigHash, m_systematics->GetKinematicSystematics(),
+                                                       m_CalibCacheWeights && !isData());
         }
-        // Overload this function in order to add event variables to your output
-        // files
-        // -----------------
+        if (m_doTrees) AsyncTreeWriter::GetInstance()->configure(m_AsyncTrees, m_AsyncQueueSize);
+        if (m_doTrees) DeltaTreeEncoder::GetInstance()->configure(m_DeltaSystTrees);
+        {
+            StartupTimer timer("Event variables and analysis modules");
+            ATH_CHECK(m_analysis_modules.retrieve());
+            m_hasModules = !m_analysis_modules.empty();
 
-        ATH_CHECK(m_XAMPPInfo->initialize());
-        m_XAMPPInfo->Lock();
-        // -----------------
-        ATH_CHECK(m_config.retrieve());
+            // Initialize the event weights in MC
+            if (!isData()) {
+                ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<int>("SUSYFinalState"));
+                ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<bool>(+"HasPathologicalWeight",
+                                                                    m_XAMPPInfo->getOutlierWeightStrategy() == IEventInfo::resetWeight));
+                ATH_CHECK(m_XAMPPInfo->NewCommonEventVariable<double>("GenWeight"));
+            }
+            ATH_CHECK(initializeEventVariables());
+            if (m_hasModules) {
+                for (auto& module : m_analysis_modules) ATH_CHECK(module->bookVariables());
+            }
+            // Overload this function in order to add event variables to your output
+            // files
+            // -----------------
 
-        ATH_CHECK(m_config->initialize());
+            ATH_CHECK(m_XAMPPInfo->initialize());
+            m_XAMPPInfo->Lock();
+        }
+        // -----------------
+        {
+            StartupTimer timer("AnalysisConfig");
+            ATH_CHECK(m_config.retrieve());
+            ATH_CHECK(m_config->initialize());
+        }
+        if (xsec_loading.valid()) {
+            StartupTimer timer("Wait for the cross-section database");
+            xsec_loading.get();
+        }
+        if (m_XsecTable && m_ValidateXsecSnapshot && !ValidateXsecSnapshot()) {
+            ATH_MSG_WARNING("The cross-section snapshot deviates from the text files. Use the text files");
+            m_XsecTable.reset();
+        }
+        if (!StartupSnapshot::GetInstance()->write()) ATH_MSG_WARNING("The startup snapshot could not be written");
+        StartupProfiler::GetInstance()->print();
 
         ATH_MSG_INFO("Current info: isData: " << isData() << ", isAF2: " << m_systematics->isAF2() << ", doTruth: " << m_doTruth
                                               << ", doPRW: " << m_doPRW);
@@ -336,36 +487,62 @@ namespace XAMPP {
     }
 
     StatusCode SUSYAnalysisHelper::initializeObjectTools() {
-        if (!isData()) ATH_CHECK(m_truth_selection.retrieve());
-        ATH_CHECK(m_triggers.retrieve());
+        {
+            StartupTimer timer("Retrieve the selectors");
+            if (!isData()) ATH_CHECK(m_truth_selection.retrieve());
+            ATH_CHECK(m_triggers.retrieve());
 
-        ATH_CHECK(m_electron_selection.retrieve());
-        ATH_CHECK(m_muon_selection.retrieve());
-        ATH_CHECK(m_jet_selection.retrieve());
+            ATH_CHECK(m_electron_selection.retrieve());
+            ATH_CHECK(m_muon_selection.retrieve());
+            ATH_CHECK(m_jet_selection.retrieve());
 
-        ATH_CHECK(m_photon_selection.retrieve());
-        ATH_CHECK(m_tau_selection.retrieve());
-        if (m_systematics->ProcessObject(XAMPP::SelectionObject::DiTau)) { ATH_CHECK(m_ditau_selection.retrieve()); }
-
-        ATH_CHECK(m_met_selection.retrieve());
+            ATH_CHECK(m_photon_selection.retrieve());
+            ATH_CHECK(m_tau_selection.retrieve());
+            if (m_systematics->ProcessObject(XAMPP::SelectionObject::DiTau)) { ATH_CHECK(m_ditau_selection.retrieve()); }
 
+            ATH_CHECK(m_met_selection.retrieve());
+        }
         // The XAMPP particle selectors are protected against the
         // arbitray initialization of athena
-
-        ATH_CHECK(m_triggers->initialize());
-
-        ATH_CHECK(m_electron_selection->initialize());
-        ATH_CHECK(m_muon_selection->initialize());
-        ATH_CHECK(m_jet_selection->initialize());
-        ATH_CHECK(m_photon_selection->initialize());
-        ATH_CHECK(m_tau_selection->initialize());
-        if (m_systematics->ProcessObject(XAMPP::SelectionObject::DiTau)) { ATH_CHECK(m_ditau_selection->initialize()); }
-        if (!isData()) ATH_CHECK(m_truth_selection->initialize());
+        {
+            StartupTimer timer(m_triggers.name());
+            ATH_CHECK(m_triggers->initialize());
+        }
+        {
+            StartupTimer timer(m_electron_selection.name());
+            ATH_CHECK(m_electron_selection->initialize());
+        }
+        {
+            StartupTimer timer(m_muon_selection.name());
+            ATH_CHECK(m_muon_selection->initialize());
+        }
+        {
+            StartupTimer timer(m_jet_selection.name());
+            ATH_CHECK(m_jet_selection->initialize());
+        }
+        {
+            StartupTimer timer(m_photon_selection.name());
+            ATH_CHECK(m_photon_selection->initialize());
+        }
+        {
+            StartupTimer timer(m_tau_selection.name());
+            ATH_CHECK(m_tau_selection->initialize());
+        }
+        if (m_systematics->ProcessObject(XAMPP::SelectionObject::DiTau)) {
+            StartupTimer timer(m_ditau_selection.name());
+            ATH_CHECK(m_ditau_selection->initialize());
+        }
+        if (!isData()) {
+            StartupTimer timer(m_truth_selection.name());
+            ATH_CHECK(m_truth_selection->initialize());
+        }
         CleaningForOutput("BadMuon", m_dec_NumBadMuon, m_CleanBadMuon);
         CleaningForOutput("CosmicMuon", m_decNumCosmicMuon, m_CleanCosmicMuon);
         CleaningForOutput("BadJet", m_decNumBadJet, m_CleanBadJet);
-
-        ATH_CHECK(m_met_selection->initialize());
+        {
+            StartupTimer timer(m_met_selection.name());
+            ATH_CHECK(m_met_selection->initialize());
+        }
 
         return StatusCode::SUCCESS;
     }
@@ -380,6 +557,14 @@ namespace XAMPP {
         TreeClass->SetEventInfoHandler(m_XAMPPInfo);
         TreeClass->SetSystematicsTool(m_systematics);
         TreeClass->SetAnalysisConfig(m_config);
+        const bool is_syst = TreeClass->systematic() && TreeClass->systematic() != m_systematics->GetNominal();
+        const std::string& policy = is_syst ? m_SystTreeCompression : m_NominalTreeCompression;
+        int compression = TreeBase::CompressionSettings(policy);
+        if (compression < -1) {
+            ATH_MSG_ERROR("Invalid compression policy " << policy << ". Please use <Algorithm>:<Level> with ZLIB, LZMA, LZ4 or ZSTD");
+            return StatusCode::FAILURE;
+        }
+        TreeClass->SetOutputPolicy(compression, is_syst ? m_SystTreeAutoFlush : m_NominalTreeAutoFlush);
         return TreeClass->InitializeTree();
     }
     StatusCode SUSYAnalysisHelper::initHistoClass(std::shared_ptr<HistoBase> HistoClass) {
@@ -396,6 +581,7 @@ namespace XAMPP {
         ATH_CHECK(initializeOuputFormat());
         ATH_MSG_DEBUG("Load all containers from the Store gate");
         ATH_CHECK(m_XAMPPInfo->LoadInfo());
+        CalibrationCache::GetInstance()->setEvent(m_XAMPPInfo->runNumber(), m_XAMPPInfo->eventNumber());
         ATH_MSG_DEBUG("Electrons...");
         ATH_CHECK(m_electron_selection->LoadContainers());
         ATH_MSG_DEBUG("Muons...");
@@ -441,7 +627,15 @@ namespace XAMPP {
         ATH_CHECK(dec_FinalState->ConstStore(finalState()));
         ATH_CHECK(dec_GenW->ConstStore(m_XAMPPInfo->GetGenWeight()));
         hasPathological |= m_XAMPPInfo->isOutlierGenWeight();
-        if (m_FillLHEWeights) {
+        if (m_FillLHEWeights && m_LHEWeightVector) {
+            if (!m_LHEWeightVector->isAvailable()) {
+                // The weights are read once and added to the meta data in a single loop
+                m_LHEOutliers = m_XAMPPInfo->GetGenWeights(m_LHEGenWeights);
+                ATH_CHECK(m_MDTree->fillLHEMetaData(m_LHEGenWeights));
+                ATH_CHECK(m_LHEWeightVector->ConstStore(m_LHEGenWeights));
+                hasPathological |= m_LHEOutliers > 0;
+            }
+        } else if (m_FillLHEWeights) {
             for (const auto& LHE : m_LHEWeights) {
                 if (LHE.second->isAvailable()) continue;
                 ATH_CHECK(m_MDTree->fillLHEMetaData(LHE.first));
@@ -462,7 +656,18 @@ namespace XAMPP {
                 m_MDTree->subtractEventFromMetaData(0);
             } else
                 has_good = true;
-            if (m_FillLHEWeights) {
+            if (m_FillLHEWeights && m_LHEWeightVector) {
+                // The outliers have been counted in SaveCrossSection. The loop is skipped if there are none
+                const size_t n_weights = m_LHEGenWeights.size();
+                for (size_t Idx = 1; Idx < n_weights && m_LHEOutliers > 0; ++Idx) {
+                    if (m_XAMPPInfo->isOutlierGenWeight((unsigned int)Idx)) {
+                        ATH_MSG_WARNING("The " << Idx << "-th LHE weight in event " << m_XAMPPInfo->eventNumber()
+                                               << " in DSID: " << m_XAMPPInfo->mcChannelNumber() << " exceeds the LHE limit ");
+                        m_MDTree->subtractEventFromMetaData(Idx);
+                    }
+                }
+                if (m_LHEOutliers < n_weights) has_good = true;
+            } else if (m_FillLHEWeights) {
                 for (const auto& LHE : m_LHEWeights) {
                     if (m_XAMPPInfo->isOutlierGenWeight(LHE.first)) {
                         ATH_MSG_WARNING("The " << LHE.first << "-th LHE weight in event " << m_XAMPPInfo->eventNumber()
@@ -525,8 +730,25 @@ namespace XAMPP {
         ATH_CHECK(m_met_selection->FillMet(*systset));
         return StatusCode::SUCCESS;
     }
+    StatusCode SUSYAnalysisHelper::beginInputFile(const std::string& guid) {
+        if (!CalibrationCache::GetInstance()->openFile(guid)) {
+            ATH_MSG_ERROR("Failed to open the calibration cache for file " << guid);
+            return StatusCode::FAILURE;
+        }
+        return StatusCode::SUCCESS;
+    }
     StatusCode SUSYAnalysisHelper::finalize() {
+        if (!CalibrationCache::GetInstance()->closeFile()) return StatusCode::FAILURE;
+        if (!DeltaTreeEncoder::GetInstance()->finalize()) {
+            ATH_MSG_ERROR("Failed to write the last entries of the delta encoded trees");
+            return StatusCode::FAILURE;
+        }
+        if (!AsyncTreeWriter::GetInstance()->stop()) {
+            ATH_MSG_ERROR("The tree writer thread failed");
+            return StatusCode::FAILURE;
+        }
         ATH_CHECK(m_MDTree->finalize());
+        ATH_CHECK(m_XAMPPInfo->finalize());
         for (auto& Tree : m_treeVec) ATH_CHECK(Tree.second->FinalizeTree());
         if (m_doTrees) ATH_MSG_INFO("All trees were written successfully.");
         for (auto& Histo : m_histoVec) Histo.second->FinalizeHistos();
@@ -546,12 +768,43 @@ namespace XAMPP {
     }
     StatusCode SUSYAnalysisHelper::FillEventWeights() {
         if (m_systematics->AffectsOnlyMET(m_systematics->GetCurrent())) return StatusCode::SUCCESS;
+        CalibrationCache* cache = CalibrationCache::GetInstance();
+        CalibrationCache::WeightList cached_weights;
+        if (cache->cacheWeights() && cache->restoreWeights(m_systematics->GetCurrent(), cached_weights)) {
+            ATH_MSG_DEBUG("Restore " << cached_weights.size() << " scale-factors from the calibration cache");
+            for (const auto& weight : cached_weights) {
+                XAMPP::Storage<double>* store = m_XAMPPInfo->GetVariableStorage<double>(weight.first);
+                if (!store) return StatusCode::FAILURE;
+                ATH_CHECK(store->Store(weight.second));
+            }
+            return StatusCode::SUCCESS;
+        }
+        // Remember which weights are already known before the selectors are called. Only the
+        // new ones are written to the cache afterwards
+        std::vector<XAMPP::Storage<double>*> weight_stores;
+        std::vector<bool> was_available;
+        const bool write_cache = cache->cacheWeights() && cache->mode() == CalibrationCache::Mode::Write;
+        if (write_cache) {
+            weight_stores = StorageKeeper::GetInstance()->GetEventStorages<double>(m_XAMPPInfo);
+            was_available.reserve(weight_stores.size());
+            for (const auto& store : weight_stores) was_available.push_back(store->isAvailable());
+        }
         ATH_CHECK(m_electron_selection->SaveScaleFactor());
         ATH_CHECK(m_muon_selection->SaveScaleFactor());
         ATH_CHECK(m_photon_selection->SaveScaleFactor());
         ATH_CHECK(m_tau_selection->SaveScaleFactor());
         ATH_CHECK(m_jet_selection->SaveScaleFactor());
         ATH_CHECK(m_met_selection->SaveScaleFactor());
+        if (write_cache) {
+            for (size_t s = 0; s < weight_stores.size(); ++s) {
+                if (!was_available[s] && weight_stores[s]->isAvailable())
+                    cached_weights.push_back(std::make_pair(weight_stores[s]->name(), weight_stores[s]->GetValue()));
+            }
+            if (!cache->saveWeights(m_systematics->GetCurrent(), cached_weights)) {
+                ATH_MSG_ERROR("Failed to write the scale-factors to the calibration cache");
+                return StatusCode::FAILURE;
+            }
+        }
         return StatusCode::SUCCESS;
     }
     StatusCode SUSYAnalysisHelper::FillEvent(const CP::SystematicSet* set) {
@@ -593,20 +846,55 @@ namespace XAMPP {
     }
     bool SUSYAnalysisHelper::CheckTrigger() { return m_triggers->CheckTrigger(); }
     bool SUSYAnalysisHelper::EventCleaning() const { return m_XAMPPInfo->PassCleaning(); }
+    const CrossSectionTable::Entry* SUSYAnalysisHelper::FindXsecEntry(unsigned int mc_channel_number, unsigned int finalState) const {
+        // The table is complete. A process which is not stored is unknown to the text files as well
+        return m_XsecTable ? m_XsecTable->lookup(mc_channel_number, finalState) : nullptr;
+    }
+    SUSY::CrossSectionDB* SUSYAnalysisHelper::XsecTextDB() {
+        if (!m_XsecDB && !m_XsecFiles.empty()) {
+            ATH_MSG_INFO("Parse the cross-section text files");
+            m_XsecDB = std::make_unique<SUSY::CrossSectionDB>("", false, false, false);
+            for (const auto& xsecFile : m_XsecFiles) m_XsecDB->loadFile(xsecFile);
+        }
+        return m_XsecDB.get();
+    }
+    bool SUSYAnalysisHelper::ValidateXsecSnapshot() const {
+        size_t n_deviations = 0;
+        for (const CrossSectionTable::Entry* entry = m_XsecTable->begin(); entry != m_XsecTable->end(); ++entry) {
+            const unsigned int id = entry->dsid, fs = entry->finalState;
+            if (entry->xsect != m_XsecDB->rawxsect(id, fs) || entry->kfactor != m_XsecDB->kfactor(id, fs) ||
+                entry->efficiency != m_XsecDB->efficiency(id, fs) || entry->relunc != m_XsecDB->rel_uncertainty(id, fs) ||
+                entry->xsectTimesEff != m_XsecDB->xsectTimesEff(id, fs)) {
+                ATH_MSG_DEBUG("The snapshot entry of DSID " << id << " and final state " << fs << " deviates from the text files");
+                ++n_deviations;
+            }
+        }
+        ATH_MSG_INFO("Validated " << m_XsecTable->size() << " processes of the cross-section snapshot. " << n_deviations
+                                  << " of them deviate from the text files");
+        return n_deviations == 0;
+    }
     double SUSYAnalysisHelper::GetMCXsec(unsigned int mc_channel_number, unsigned int finalState) {
-        if (m_XsecDB == nullptr) {
+        const CrossSectionTable::Entry* entry = FindXsecEntry(mc_channel_number, finalState);
+        if (entry) return entry->xsect;
+        SUSY::CrossSectionDB* xsec_db = XsecTextDB();
+        if (xsec_db == nullptr) {
             ATH_MSG_WARNING("I do not know about the cross-section");
             return -1;
         }
-        return m_XsecDB->rawxsect(mc_channel_number, finalState);
+        return xsec_db->rawxsect(mc_channel_number, finalState);
     }
 
     void SUSYAnalysisHelper::GetMCXsecErrors(bool& error_exists, double& rel_err_down, double& rel_err_up, unsigned int mc_channel_number,
                                              unsigned int finalState) {
         error_exists = false;
-        if (m_XsecDB == nullptr) { ATH_MSG_WARNING("I do not know about the cross-section"); }
+        const CrossSectionTable::Entry* entry = FindXsecEntry(mc_channel_number, finalState);
+        SUSY::CrossSectionDB* xsec_db = entry ? nullptr : XsecTextDB();
+        if (entry == nullptr && xsec_db == nullptr) {
+            ATH_MSG_WARNING("I do not know about the cross-section");
+            return;
+        }
         // the SUSY thing seems to have symmetric errors??!
-        double relErr = m_XsecDB->rel_uncertainty(mc_channel_number, finalState);
+        double relErr = entry ? entry->relunc : xsec_db->rel_uncertainty(mc_channel_number, finalState);
         if (relErr > 0) {
             error_exists = true;
             rel_err_down = relErr;
@@ -614,25 +902,34 @@ namespace XAMPP {
         }
     }
     double SUSYAnalysisHelper::GetMCFilterEff(unsigned int mc_channel_number, unsigned int finalState) {
-        if (m_XsecDB == nullptr) {
+        const CrossSectionTable::Entry* entry = FindXsecEntry(mc_channel_number, finalState);
+        if (entry) return entry->efficiency;
+        SUSY::CrossSectionDB* xsec_db = XsecTextDB();
+        if (xsec_db == nullptr) {
             ATH_MSG_WARNING("I do not know about the filter efficiency");
             return -1;
         }
-        return m_XsecDB->efficiency(mc_channel_number, finalState);
+        return xsec_db->efficiency(mc_channel_number, finalState);
     }
     double SUSYAnalysisHelper::GetMCkFactor(unsigned int mc_channel_number, unsigned int finalState) {
-        if (m_XsecDB == nullptr) {
+        const CrossSectionTable::Entry* entry = FindXsecEntry(mc_channel_number, finalState);
+        if (entry) return entry->kfactor;
+        SUSY::CrossSectionDB* xsec_db = XsecTextDB();
+        if (xsec_db == nullptr) {
             ATH_MSG_WARNING("I do not know about the k-factor");
             return -1;
         }
-        return m_XsecDB->kfactor(mc_channel_number, finalState);
+        return xsec_db->kfactor(mc_channel_number, finalState);
     }
     double SUSYAnalysisHelper::GetMCXsectTimesEff(unsigned int mc_channel_number, unsigned int finalState) {
-        if (m_XsecDB == nullptr) {
+        const CrossSectionTable::Entry* entry = FindXsecEntry(mc_channel_number, finalState);
+        if (entry) return entry->xsectTimesEff;
+        SUSY::CrossSectionDB* xsec_db = XsecTextDB();
+        if (xsec_db == nullptr) {
             ATH_MSG_WARNING("I do not know about the cross-section");
             return -1;
         }
-        return m_XsecDB->xsectTimesEff(mc_channel_number, finalState);
+        return xsec_db->xsectTimesEff(mc_channel_number, finalState);
     }
     StatusCode SUSYAnalysisHelper::DumpNtuple(const CP::SystematicSet* sys) {
         if (!m_doTrees) return StatusCode::SUCCESS;
@@ -2,6 +2,7 @@
 #include <XAMPPbase/AnalysisUtils.h>
 #include <XAMPPbase/SUSYElectronSelector.h>
 #include <XAMPPbase/SUSYTriggerTool.h>
+#include <XAMPPbase/StartupProfiler.h>
 #include <xAODEgamma/EgammaxAODHelpers.h>
 
 #include <IsolationSelection/IIsolationSelectionTool.h>
@@ -9,8 +10,11 @@
 
 #include <XAMPPbase/ToolHandleSystematics.h>
 
+#include <set>
+
 #define CONFIG_BASELINE_IDISO_SFTOOl(TOOLHANDLE, TOOLNAME, ISOWP)                                                                        \
     if (TOOLHANDLE.empty()) {                                                                                                            \
+        StartupTimer timer(m_Baseline_Id_WP + TOOLNAME);                                                                                 \
         asg::AnaToolHandle<EleEffTool> AnaTool("AsgElectronEfficiencyCorrectionTool/" + m_Baseline_Id_WP + TOOLNAME);                    \
         ATH_CHECK(AnaTool.setProperty("IdKey", eleId));                                                                                  \
         ATH_CHECK(AnaTool.setProperty("ForceDataType",                                                                                   \
@@ -420,13 +424,31 @@ namespace XAMPP {
         return StatusCode::SUCCESS;
     }
     StatusCode SUSYElectronSelector::initializeTriggerSFTools(TrigSFTool_Map& map, bool use_signal) {
+        // The tool of a configuration is only used if it is the best match of one of the trigger expressions. With the
+        // TOTAL correlation model all trigger tools declare the same single nuisance parameter, so the configurations which
+        // are not selected by any trigger can be skipped without changing the weight systematics
+        std::set<std::string> selected;
+        const bool skip_unselected = m_CorrelationModel == "TOTAL";
+        if (skip_unselected) {
+            TrigSFTool_Map candidates = map;
+            for (auto& SF : m_TriggerSFConf) candidates.insert(TrigSFTool(SF, EleEffToolHandle("")));
+            for (auto& Trigger : m_TriggerExp) selected.insert(FindBestSFTool(candidates, Trigger));
+        }
+        unsigned int n_skipped = 0;
         for (auto& SF : m_TriggerSFConf) {
             if (map.find(SF) != map.end()) {
                 ATH_MSG_DEBUG("Configuration " << SF << " has already been created by SUSYTools");
                 continue;
             }
+            if (skip_unselected && selected.find(SF) == selected.end()) {
+                ATH_MSG_INFO("Configuration " << SF << " is not selected by any trigger. Do not setup a SF tool for it.");
+                ++n_skipped;
+                continue;
+            }
+            StartupTimer timer("TriggerSF " + SF);
+            // Keep the tool names as if all configurations were set up
             asg::AnaToolHandle<EleEffTool> NewTool("AsgElectronEfficiencyCorrectionTool/ElectronTriggerSF " + Trig_EG_WP(SF, use_signal) +
-                                                   std::to_string(map.size()));
+                                                   std::to_string(map.size() + n_skipped));
             std::string trig_sf_key = SF.substr(0, std::min(SF.find(":"), SF.find(";")));
             ATH_MSG_INFO("Setup new SF tool using " << trig_sf_key << " as config with " << Trig_EG_WP(SF, use_signal) << " and isolation "
                                                     << Trig_Iso_WP(SF, true) << ".");
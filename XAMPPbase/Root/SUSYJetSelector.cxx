@@ -177,31 +177,34 @@ namespace XAMPP {
         if (Link == LinkStatus::Failed)
             return StatusCode::FAILURE;
         else if (Link == LinkStatus::Created) {
-            if (Cone == JetAlgorithm::AntiKt10) {
-                ATH_CHECK(preCalibCorrection(Container));
-                ATH_CHECK(m_susytools->GetFatJets(Container, AuxContainer, false, Key, m_doLargeRdecors));
-            } else if (Cone == JetAlgorithm::AntiKt2) {
-                ATH_CHECK(m_susytools->GetTrackJets(Container, AuxContainer, false, Key));
-            } else if (Cone == JetAlgorithm::AntiKt4) {
-                if (m_XAMPPInfo->GetSystematic() == m_systematics->GetNominal()) {
-                    ATH_CHECK(m_susytools->GetJets(Container, AuxContainer, false));
-                } else {
-                    xAOD::JetContainer* nominal_container = nullptr;
-                    ATH_CHECK(LoadContainer(name() + "_" + Key, nominal_container));
+            if (!RestoreCalibration(Key, *Container)) {
+                if (Cone == JetAlgorithm::AntiKt10) {
+                    ATH_CHECK(preCalibCorrection(Container));
+                    ATH_CHECK(m_susytools->GetFatJets(Container, AuxContainer, false, Key, m_doLargeRdecors));
+                } else if (Cone == JetAlgorithm::AntiKt2) {
+                    ATH_CHECK(m_susytools->GetTrackJets(Container, AuxContainer, false, Key));
+                } else if (Cone == JetAlgorithm::AntiKt4) {
+                    if (m_XAMPPInfo->GetSystematic() == m_systematics->GetNominal()) {
+                        ATH_CHECK(m_susytools->GetJets(Container, AuxContainer, false));
+                    } else {
+                        xAOD::JetContainer* nominal_container = nullptr;
+                        ATH_CHECK(LoadContainer(name() + "_" + Key, nominal_container));
 
-                    xAOD::JetContainer::const_iterator nominal_begin = nominal_container->begin();
-                    xAOD::JetContainer::const_iterator nominal_end = nominal_container->end();
+                        xAOD::JetContainer::const_iterator nominal_begin = nominal_container->begin();
+                        xAOD::JetContainer::const_iterator nominal_end = nominal_container->end();
 
-                    xAOD::JetContainer::iterator copy_begin = Container->begin();
-                    xAOD::JetContainer::iterator copy_end = Container->end();
+                        xAOD::JetContainer::iterator copy_begin = Container->begin();
+                        xAOD::JetContainer::iterator copy_end = Container->end();
 
-                    for (; copy_begin != copy_end && nominal_begin != nominal_end; ++nominal_begin, ++copy_begin) {
-                        (**copy_begin) = (**nominal_begin);
-                        ATH_CHECK(m_susytools->FillJet(**copy_begin, false));
-                        m_susytools->IsBadJet(**copy_begin);
-                        m_susytools->IsSignalJet(**copy_begin, -1, 10);
+                        for (; copy_begin != copy_end && nominal_begin != nominal_end; ++nominal_begin, ++copy_begin) {
+                            (**copy_begin) = (**nominal_begin);
+                            ATH_CHECK(m_susytools->FillJet(**copy_begin, false));
+                            m_susytools->IsBadJet(**copy_begin);
+                            m_susytools->IsSignalJet(**copy_begin, -1, 10);
+                        }
                     }
                 }
+                ATH_CHECK(CacheCalibration(Key, *Container, *AuxContainer));
             }
             ATH_CHECK(ViewElementsContainer(PreSelName.empty() ? "JetPreSel" : PreSelName, PreSelected));
             for (const auto& Jet : *Container) {
@@ -250,6 +253,9 @@ namespace XAMPP {
         ATH_CHECK(ViewElementsContainer("bjet", m_BJets));
         ATH_CHECK(ViewElementsContainer("light", m_LightJets));
 
+        // Read the track multiplicities directly from the aux store instead of copying the vector for each jet
+        static const SG::AuxElement::ConstAccessor<std::vector<int>> acc_NumTrkPt500("NumTrkPt500");
+        const xAOD::Vertex* primVtx = m_PreJets->empty() ? nullptr : m_XAMPPInfo->GetPrimaryVertex();
         int NBadJets = 0;
         for (const auto& ijet : *m_PreJets) {
             if (IsBadJet(*ijet)) {
@@ -257,9 +263,7 @@ namespace XAMPP {
                 continue;
             }
             m_jetDecorations->MV2c10.set(*ijet, BtagBDT(*ijet));
-            std::vector<int> nTrkVec;
-            ijet->getAttribute(xAOD::JetAttribute::NumTrkPt500, nTrkVec);
-            m_jetDecorations->nTracks.set(*ijet, nTrkVec.at(m_XAMPPInfo->GetPrimaryVertex()->index()));
+            m_jetDecorations->nTracks.set(*ijet, acc_NumTrkPt500(*ijet).at(primVtx->index()));
 
             if (PassBaseline(*ijet)) { m_BaselineJets->push_back(ijet); }
             if (!PassSignalKinematics(*ijet)) continue;
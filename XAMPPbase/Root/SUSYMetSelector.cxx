@@ -11,6 +11,7 @@
 #include <XAMPPbase/ISystematics.h>
 #include <XAMPPbase/ITauSelector.h>
 #include <XAMPPbase/SUSYMetSelector.h>
+#include <XAMPPbase/StartupProfiler.h>
 #include <xAODJet/JetContainerInfo.h>
 #include <functional>
 namespace XAMPP {
@@ -311,7 +312,10 @@ namespace XAMPP {
             EraseFromVector(m_metSignifHandlers, std::function<bool(const MetSignificanceHandler_Ptr&)>(
                                                      [](const MetSignificanceHandler_Ptr& obj) { return obj->isDisabled(); }));
             ATH_CHECK(initializeMetSignificance());
-            for (const auto& sign : m_metSignifHandlers) { ATH_CHECK(sign->initialize()); }
+            for (const auto& sign : m_metSignifHandlers) {
+                StartupTimer timer("MetSignificance " + sign->group());
+                ATH_CHECK(sign->initialize());
+            }
         } else
             m_metSignifHandlers.clear();
         m_init = true;
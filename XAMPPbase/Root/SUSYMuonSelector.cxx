@@ -1,6 +1,7 @@
 #include <XAMPPbase/AnalysisUtils.h>
 #include <XAMPPbase/Cuts.h>
 #include <XAMPPbase/SUSYMuonSelector.h>
+#include <XAMPPbase/StartupProfiler.h>
 
 #include <IsolationSelection/IIsolationSelectionTool.h>
 #include <MuonAnalysisInterfaces/IMuonEfficiencyScaleFactors.h>
@@ -206,7 +207,10 @@ namespace XAMPP {
             m_SFtool_BasTrig = m_SFtool_Trig;
             ATH_CHECK(m_SFtool_Trig.retrieve());
         }
-        ATH_CHECK(SetupScaleFactors());
+        {
+            StartupTimer timer("Scale factors");
+            ATH_CHECK(SetupScaleFactors());
+        }
         return StatusCode::SUCCESS;
     }
     StatusCode SUSYMuonSelector::SetupScaleFactors() {
@@ -8,12 +8,15 @@
 #include <SUSYTools/SUSYCrossSection.h>
 #include <XAMPPbase/AnalysisUtils.h>
 #include <XAMPPbase/SUSYSystematics.h>
+#include <XAMPPbase/StartupProfiler.h>
+#include <XAMPPbase/StartupSnapshot.h>
 
 namespace XAMPP {
     SUSYSystematics::SUSYSystematics(const std::string& myname) :
         AsgTool(myname),
         m_syst_all(),
         m_syst_kin(),
+        m_kin_ordinal(),
         m_syst_kin_ele(),
         m_syst_kin_muo(),
         m_syst_kin_jet(),
@@ -48,6 +51,11 @@ namespace XAMPP {
         m_doSyst(true),
         m_doWeights(true),
         m_Tools(),
+        m_routing(),
+        m_applied(),
+        m_nSetRequests(0),
+        m_nSetSwitches(0),
+        m_nToolSwitches(0),
         m_excluded_syst(),
         m_init(false),
         m_isData(false),
@@ -256,18 +264,27 @@ namespace XAMPP {
         CopySystematics(m_syst_kin_tau, m_syst_kin);
         CopySystematics(m_syst_kin_jet, m_syst_kin);
         CopySystematics(m_syst_kin_pho, m_syst_kin);
-        std::sort(m_syst_kin.begin(), m_syst_kin.end(), [this](const CP::SystematicSet* a, const CP::SystematicSet* b) {
-            if (a->name().empty()) {
-                return true;
-            } else if (b->name().empty()) {
-                return false;
-            } else if (AffectsOnlyMET(a) && !AffectsOnlyMET(b)) {
-                return true;
-            } else if (AffectsOnlyMET(b) && !AffectsOnlyMET(a)) {
-                return false;
+        {
+            StartupTimer timer("Order the kinematic systematics");
+            if (!OrderFromSnapshot(m_syst_kin, "KinematicSystematics")) {
+                std::sort(m_syst_kin.begin(), m_syst_kin.end(), [this](const CP::SystematicSet* a, const CP::SystematicSet* b) {
+                    if (a->name().empty()) {
+                        return true;
+                    } else if (b->name().empty()) {
+                        return false;
+                    } else if (AffectsOnlyMET(a) && !AffectsOnlyMET(b)) {
+                        return true;
+                    } else if (AffectsOnlyMET(b) && !AffectsOnlyMET(a)) {
+                        return false;
+                    }
+                    return a->name() < b->name();
+                });
             }
-            return a->name() < b->name();
-        });
+            std::vector<std::string> order;
+            for (const auto& set : m_syst_kin) order.push_back(set->name());
+            StartupSnapshot::GetInstance()->set("KinematicSystematics", order);
+        }
+        for (size_t k = 0; k < m_syst_kin.size(); ++k) m_kin_ordinal[m_syst_kin[k]] = k;
         if (m_doWeights) {
             if (ProcessObject(XAMPP::SelectionObject::BTag)) AppendSystematic(m_syst_weight_btag, GetNominal());
             m_syst_weight.push_back(m_empty_syst);
@@ -282,9 +299,84 @@ namespace XAMPP {
         PromptSystList(m_syst_weight_met, "MET ScaleFactor");
         PromptSystList(m_syst_weight_trk, "Track ScaleFactor");
         PromptSystList(m_syst_weight_evtweight, "Event weight");
+        // The weight systematics are declared by the tools themselves. They only enter the snapshot to validate it
+        std::vector<std::string> weights;
+        for (const auto& set : m_syst_weight) weights.push_back(set->name());
+        StartupSnapshot::GetInstance()->set("WeightSystematics", weights);
         m_init = true;
+        BuildRoutingTable();
         return StatusCode::SUCCESS;
     }
+    bool SUSYSystematics::OrderFromSnapshot(std::vector<const CP::SystematicSet*>& List, const std::string& key) const {
+        std::vector<std::string> order;
+        if (!StartupSnapshot::GetInstance()->get(key, order) || order.size() != List.size()) return false;
+        std::map<std::string, const CP::SystematicSet*> by_name;
+        for (const auto& set : List) by_name[set->name()] = set;
+        std::vector<const CP::SystematicSet*> ordered;
+        for (const auto& name : order) {
+            std::map<std::string, const CP::SystematicSet*>::const_iterator itr = by_name.find(name);
+            if (itr == by_name.end()) return false;
+            ordered.push_back(itr->second);
+        }
+        List = ordered;
+        return true;
+    }
+    void SUSYSystematics::BuildRoutingTable() {
+        StartupTimer timer("Systematic routing table");
+        m_routing.clear();
+        // The masks are stored as string of 0 and 1 followed by the name of the systematic. They can only be
+        // taken from the snapshot if the tool services are the same
+        StartupSnapshot* snapshot = StartupSnapshot::GetInstance();
+        const std::string suffix = "_" + std::to_string(m_Tools.size());
+        std::vector<std::string> services, cached;
+        for (const auto& tool : m_Tools) services.push_back(tool->name());
+        std::map<std::string, std::string> cached_masks;
+        if (snapshot->get("SystematicServices" + suffix, cached) && cached == services &&
+            snapshot->get("SystematicRouting" + suffix, cached)) {
+            for (const auto& entry : cached) {
+                if (entry.size() > m_Tools.size()) cached_masks[entry.substr(m_Tools.size() + 1)] = entry.substr(0, m_Tools.size());
+            }
+        }
+        std::vector<std::string> routing;
+        for (const auto& set : m_syst_all) {
+            ServiceMask& mask = m_routing[set.get()];
+            std::map<std::string, std::string>::const_iterator itr = cached_masks.find(set->name());
+            if (itr != cached_masks.end()) {
+                mask.assign(m_Tools.size(), false);
+                for (size_t t = 0; t < m_Tools.size(); ++t) mask[t] = itr->second[t] == '1';
+            } else
+                mask = AffectedServices(set.get());
+            std::string encoded;
+            for (const auto& affected : mask) encoded += affected ? '1' : '0';
+            routing.push_back(encoded + " " + set->name());
+        }
+        snapshot->set("SystematicServices" + suffix, services);
+        snapshot->set("SystematicRouting" + suffix, routing);
+        m_applied.assign(m_Tools.size(), nullptr);
+        ATH_MSG_DEBUG("Built the routing table of " << m_routing.size() << " systematics to " << m_Tools.size() << " tool services");
+    }
+    SUSYSystematics::ServiceMask SUSYSystematics::AffectedServices(const CP::SystematicSet* Set) const {
+        ServiceMask mask(m_Tools.size(), false);
+        // The nominal set is applied to the tools explicitly when they need to be reset
+        if (Set == m_empty_syst) return mask;
+        for (size_t t = 0; t < m_Tools.size(); ++t) mask[t] = m_Tools[t]->isAffectedBySystematic(Set);
+        return mask;
+    }
+    StatusCode SUSYSystematics::SwitchService(size_t service, const CP::SystematicSet* Set) {
+        if (m_applied[service] == Set) return StatusCode::SUCCESS;
+        if (!m_Tools[service]->setSystematic(Set).isSuccess()) {
+            ATH_MSG_ERROR("Failed to apply systematic " << Set->name() << " to " << m_Tools[service]->name());
+            return StatusCode::FAILURE;
+        }
+        m_applied[service] = Set;
+        ++m_nToolSwitches;
+        return StatusCode::SUCCESS;
+    }
+    void SUSYSystematics::PrintSwitchSummary() const {
+        ATH_MSG_INFO("Systematic switches: " << m_nSetRequests << " requests, " << m_nSetSwitches << " changes of the set, "
+                                             << m_nToolSwitches << " reconfigurations of the " << m_Tools.size()
+                                             << " tool services (" << m_nSetSwitches * m_Tools.size() << " without routing)");
+    }
     void SUSYSystematics::PromptSystList(std::vector<const CP::SystematicSet*>& List, const std::string& Type) const {
         if (List.empty()) return;
         ATH_MSG_INFO("Systematics affecting the " << Type << ": ");
@@ -296,12 +388,18 @@ namespace XAMPP {
             return StatusCode::SUCCESS;
         }
         if (m_act_syst == m_empty_syst) return StatusCode::SUCCESS;
-        for (const auto& Service : m_Tools) ATH_CHECK(Service->resetSystematic());
+        for (size_t t = 0; t < m_Tools.size(); ++t) {
+            if (m_applied[t] == m_empty_syst) continue;
+            ATH_CHECK(m_Tools[t]->resetSystematic());
+            m_applied[t] = m_empty_syst;
+            ++m_nToolSwitches;
+        }
         m_act_syst = nullptr;
         return StatusCode::SUCCESS;
     }
 
     StatusCode SUSYSystematics::setSystematic(const CP::SystematicSet* Set) {
+        ++m_nSetRequests;
         if (Set == m_act_syst) return StatusCode::SUCCESS;
         if (!Set) {
             ATH_MSG_ERROR("nullptr pointer given");
@@ -312,11 +410,15 @@ namespace XAMPP {
             return StatusCode::SUCCESS;
         }
         ATH_MSG_DEBUG("Apply systematic variation " << Set->name());
-        for (const auto& Service : m_Tools) {
-            if (!Service->setSystematic(Set).isSuccess()) {
-                ATH_MSG_ERROR("Failed to apply systematic " << Set->name() << " to " << Service->name());
-                return StatusCode::FAILURE;
-            }
+        ++m_nSetSwitches;
+        // Only tools affected by the set are switched to it. All others need to be at nominal
+        std::map<const CP::SystematicSet*, ServiceMask>::const_iterator route = m_routing.find(Set);
+        if (route == m_routing.end()) {
+            // Sets not known to the tool are not cached as their address might be reused
+            const ServiceMask affected = AffectedServices(Set);
+            for (size_t t = 0; t < m_Tools.size(); ++t) ATH_CHECK(SwitchService(t, affected[t] ? Set : m_empty_syst));
+        } else {
+            for (size_t t = 0; t < m_Tools.size(); ++t) ATH_CHECK(SwitchService(t, route->second[t] ? Set : m_empty_syst));
         }
         m_act_syst = Set;
         return StatusCode::SUCCESS;
@@ -346,6 +448,7 @@ namespace XAMPP {
         ATH_MSG_INFO("Add new systematic service " << Service->name());
 
         m_Tools.push_back(std::shared_ptr<XAMPP::ISystematicToolService>(Service));
+        if (SystematicsFixed()) BuildRoutingTable();
         return StatusCode::SUCCESS;
     }
     bool SUSYSystematics::ProcessObject(XAMPP::SelectionObject T) const {
@@ -370,6 +473,10 @@ namespace XAMPP {
         return all;
     }
     bool SUSYSystematics::isData() const { return m_isData; }
+    int SUSYSystematics::GetKinematicOrdinal(const CP::SystematicSet* Set) const {
+        std::unordered_map<const CP::SystematicSet*, int>::const_iterator Itr = m_kin_ordinal.find(Set);
+        return Itr != m_kin_ordinal.end() ? Itr->second : -1;
+    }
     bool SUSYSystematics::SystematicsFixed() const { return m_init; }
 
     //########################################################################################################################
@@ -420,6 +527,10 @@ namespace XAMPP {
             FatalMSG("Failed to retrieve SUSYTools instance");
             return StatusCode::FAILURE;
         }
+        // Needs to be known before the service is added to the routing of the ISystematics tool
+        for (const auto& isys : m_SUSYTools->getSystInfoList()) {
+            for (const auto& var : isys.systset) m_affecting.insert(var.name());
+        }
         if (!m_systematic.retrieve().isSuccess() || !m_systematic->InsertSystematicToolService(this).isSuccess()) {
             FatalMSG("Could not register myself with the ISystematicsTool");
             return StatusCode::FAILURE;
@@ -458,6 +569,12 @@ namespace XAMPP {
         m_init = true;
         return StatusCode::SUCCESS;
     }
+    bool SUSYToolsSystematicToolHandle::isAffectedBySystematic(const CP::SystematicSet* Set) const {
+        for (const auto& var : *Set) {
+            if (m_affecting.count(var.name())) return true;
+        }
+        return false;
+    }
     std::string SUSYToolsSystematicToolHandle::name() const { return "XAMPP.Srv" + m_SUSYTools.name(); }
     void SUSYToolsSystematicToolHandle::FatalMSG(const std::string& MSG) const { Fatal(name().c_str(), MSG.c_str()); }
     void SUSYToolsSystematicToolHandle::InfoMSG(const std::string& MSG) const { Info(name().c_str(), MSG.c_str()); }
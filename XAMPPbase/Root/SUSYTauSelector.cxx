@@ -3,6 +3,7 @@
 #include <TauAnalysisTools/TauSelectionTool.h>
 #include <TauAnalysisTools/TauTruthMatchingTool.h>
 #include <XAMPPbase/SUSYTauSelector.h>
+#include <XAMPPbase/StartupProfiler.h>
 #include <XAMPPbase/SUSYTriggerTool.h>
 #include <XAMPPbase/ToolHandleSystematics.h>
 #include <xAODTau/TauxAODHelpers.h>
@@ -197,6 +198,7 @@ namespace XAMPP {
 
         std::string TauWP = (&selectionTool == &m_SignalTauSelectionTool ? "signal" : "baseline");
         for (auto& effi : EffiTypes) {
+            StartupTimer timer(TauWP + "TauEfficiencySFs_" + to_string(effi));
             asg::AnaToolHandle<TauEffiTool> AnaTool("TauAnalysisTools::TauEfficiencyCorrectionsTool/" + TauWP + "TauEfficiencySFs_" +
                                                     to_string(effi));
             ATH_CHECK(AnaTool.setProperty("TauSelectionTool", selectionTool));
@@ -224,6 +226,7 @@ namespace XAMPP {
         std::string TauWP = (&selectionTool == &m_SignalTauSelectionTool ? "signal" : "baseline");
         unsigned int TauID = GetProperty<int>("JetIDWP", selectionTool);
         for (auto& Trigger : m_TriggerExp) {
+            StartupTimer timer(TauWP + "TauTriggerEffi" + Trigger);
             asg::AnaToolHandle<TauEffiTool> AnaTool("TauAnalysisTools::TauEfficiencyCorrectionsTool/" + TauWP + "TauTriggerEffi" + Trigger);
             ATH_CHECK(AnaTool.setProperty("TauSelectionTool", selectionTool));
             ATH_CHECK(AnaTool.setProperty("EfficiencyCorrectionTypes", std::vector<int>({TauAnalysisTools::SFTriggerHadTau})));
@@ -2,6 +2,8 @@
 #include <XAMPPbase/AnalysisUtils.h>
 #include <XAMPPbase/EventInfo.h>
 #include <XAMPPbase/SUSYTriggerTool.h>
+#include <XAMPPbase/StartupProfiler.h>
+#include <XAMPPbase/StartupSnapshot.h>
 #include <XAMPPbase/TreeHelpers.h>
 #include <xAODTrigMissingET/TrigMissingETContainer.h>
 #include <xAODTrigger/EnergySumRoI.h>
@@ -9,6 +11,9 @@
 // Required to use some functions (see header explanation)
 #include "TrigDecisionTool/TrigDecisionTool.h"
 
+#include <cstdio>
+#include <cstdlib>
+
 namespace XAMPP {
     //############################################################################################
     //                                      TriggerInterface
@@ -132,6 +137,29 @@ namespace XAMPP {
         return false;
     }
     void TriggerInterface::GetMatchingThresholds() {
+        // The thresholds are stored in the snapshot as "<object type> <threshold>" with the threshold in hexadecimal
+        // floating point notation to restore it exactly
+        const std::string key = "TriggerThresholds_" + name();
+        std::vector<std::string> table;
+        if (StartupSnapshot::GetInstance()->get(key, table)) {
+            for (const auto& entry : table) {
+                char* end = nullptr;
+                OfflineMatching M;
+                M.Object = std::strtol(entry.c_str(), &end, 10);
+                M.PtThreshold = std::strtof(end, nullptr);
+                m_Thresholds.push_back(M);
+            }
+        } else
+            ParseMatchingThresholds();
+        table.clear();
+        for (const auto& M : m_Thresholds) {
+            char entry[64];
+            std::snprintf(entry, sizeof(entry), "%d %a", M.Object, M.PtThreshold);
+            table.push_back(entry);
+        }
+        StartupSnapshot::GetInstance()->set(key, table);
+    }
+    void TriggerInterface::ParseMatchingThresholds() {
         std::string TriggerString = name();
         xAOD::Type::ObjectType Type = xAOD::Type::ObjectType::Other;
         // Removing expressions which are not separated by _ from the object
@@ -485,7 +513,10 @@ namespace XAMPP {
         TriggerInterface::SaveObjectMatching(m_StoreObjectMatching);
 
         /// Fill the triggers from the names
-        ATH_CHECK(FillTriggerVector(m_trigger_names));
+        {
+            StartupTimer timer("Trigger interfaces");
+            ATH_CHECK(FillTriggerVector(m_trigger_names));
+        }
 
         if (isData()) { m_MetTrigEmulation = false; }
         if (m_MetTrigEmulation) {
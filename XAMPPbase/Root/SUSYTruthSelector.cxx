@@ -704,15 +704,15 @@ in your derived class to suppress this warning.");
     }
     bool SUSYTruthSelector::doTruthJets() const { return m_JetDefs.doObject; }
     bool SUSYTruthSelector::doTruthParticles() const { return m_doTruthParticles; }
-    std::string SUSYTruthSelector::TauKey() const { return m_TauDefs.ContainerKey; }
-    std::string SUSYTruthSelector::ElectronKey() const { return m_ElectronDefs.ContainerKey; }
-    std::string SUSYTruthSelector::MuonKey() const { return m_MuonDefs.ContainerKey; }
-    std::string SUSYTruthSelector::PhotonKey() const { return m_PhotonDefs.ContainerKey; }
-    std::string SUSYTruthSelector::NeutrinoKey() const { return m_NeutrinoDefs.ContainerKey; }
-    std::string SUSYTruthSelector::BosonKey() const { return m_BosonKey; }
-    std::string SUSYTruthSelector::BSMKey() const { return m_BSMKey; }
-    std::string SUSYTruthSelector::TopKey() const { return m_TopKey; }
-    std::string SUSYTruthSelector::JetKey() const { return m_JetDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::TauKey() const { return m_TauDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::ElectronKey() const { return m_ElectronDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::MuonKey() const { return m_MuonDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::PhotonKey() const { return m_PhotonDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::NeutrinoKey() const { return m_NeutrinoDefs.ContainerKey; }
+    const std::string& SUSYTruthSelector::BosonKey() const { return m_BosonKey; }
+    const std::string& SUSYTruthSelector::BSMKey() const { return m_BSMKey; }
+    const std::string& SUSYTruthSelector::TopKey() const { return m_TopKey; }
+    const std::string& SUSYTruthSelector::JetKey() const { return m_JetDefs.ContainerKey; }
 
     void SUSYTruthSelector::setupDecorations(std::shared_ptr<TruthDecorations> input) {
         // as for the particle selector, use the input if provided, or use a default
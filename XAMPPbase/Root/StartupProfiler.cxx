@@ -0,0 +1,58 @@
+#include <TError.h>
+#include <XAMPPbase/StartupProfiler.h>
+
+namespace XAMPP {
+    namespace {
+        // Number of open timers of the current thread
+        thread_local unsigned int s_depth = 0;
+    }  // namespace
+    StartupProfiler* StartupProfiler::m_Inst = nullptr;
+    StartupProfiler* StartupProfiler::GetInstance() {
+        if (!m_Inst) m_Inst = new StartupProfiler();
+        return m_Inst;
+    }
+    StartupProfiler::StartupProfiler() : m_mutex(), m_mainThread(std::this_thread::get_id()), m_entries() {}
+    size_t StartupProfiler::start(const std::string& name) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Entry entry;
+        entry.name = name;
+        entry.depth = s_depth++;
+        entry.concurrent = std::this_thread::get_id() != m_mainThread;
+        entry.seconds = 0.;
+        entry.finished = false;
+        entry.start = Clock::now();
+        m_entries.push_back(entry);
+        return m_entries.size() - 1;
+    }
+    void StartupProfiler::stop(size_t entry) {
+        const Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> guard(m_mutex);
+        if (s_depth > 0) --s_depth;
+        if (entry >= m_entries.size() || m_entries[entry].finished) return;
+        m_entries[entry].seconds = std::chrono::duration<double>(now - m_entries[entry].start).count();
+        m_entries[entry].finished = true;
+    }
+    void StartupProfiler::print() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        double total = 0.;
+        for (const auto& entry : m_entries) {
+            if (entry.finished && entry.depth == 0 && !entry.concurrent) total += entry.seconds;
+        }
+        if (total <= 0.) return;
+        Info("StartupProfiler::print()", "Time spent in the initialization: %.2f s", total);
+        for (const auto& entry : m_entries) {
+            if (!entry.finished) continue;
+            Info("StartupProfiler::print()", "%9.3f s %6.1f%%  %s%s%s", entry.seconds, 100. * entry.seconds / total,
+                 std::string(2 * entry.depth, ' ').c_str(), entry.name.c_str(), entry.concurrent ? " (concurrent)" : "");
+        }
+        // Open entries are kept such that their timers can still stop them
+        bool pending = false;
+        for (const auto& entry : m_entries) pending = pending || !entry.finished;
+        if (!pending) m_entries.clear();
+    }
+    //################################################################################
+    //                              StartupTimer
+    //################################################################################
+    StartupTimer::StartupTimer(const std::string& name) : m_entry(StartupProfiler::GetInstance()->start(name)) {}
+    StartupTimer::~StartupTimer() { StartupProfiler::GetInstance()->stop(m_entry); }
+}  // namespace XAMPP
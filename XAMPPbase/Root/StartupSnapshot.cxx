@@ -0,0 +1,144 @@
+#include <TError.h>
+#include <XAMPPbase/StartupSnapshot.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unistd.h>
+
+namespace XAMPP {
+    namespace {
+        const char s_magic[8] = {'X', 'A', 'M', 'P', 'P', 'S', 'S', '1'};
+        template <class T> void WriteValue(std::string& buffer, const T& value) {
+            buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        void WriteString(std::string& buffer, const std::string& str) {
+            WriteValue(buffer, (unsigned int)str.size());
+            buffer.append(str);
+        }
+        template <class T> bool ReadValue(const std::string& buffer, size_t& pos, T& value) {
+            if (pos + sizeof(value) > buffer.size()) return false;
+            std::memcpy(&value, buffer.data() + pos, sizeof(value));
+            pos += sizeof(value);
+            return true;
+        }
+        bool ReadString(const std::string& buffer, size_t& pos, std::string& str) {
+            unsigned int size = 0;
+            if (!ReadValue(buffer, pos, size) || pos + size > buffer.size()) return false;
+            str = buffer.substr(pos, size);
+            pos += size;
+            return true;
+        }
+    }  // namespace
+    StartupSnapshot* StartupSnapshot::m_Inst = nullptr;
+    // Increment if the content of one of the tables changes
+    const unsigned int StartupSnapshot::m_version = 1;
+    StartupSnapshot* StartupSnapshot::GetInstance() {
+        if (!m_Inst) m_Inst = new StartupSnapshot();
+        return m_Inst;
+    }
+    StartupSnapshot::StartupSnapshot() : m_path(), m_configHash(0), m_enabled(false), m_loaded(false), m_stale(false), m_tables() {}
+    void StartupSnapshot::configure(const std::string& path, size_t config_hash) {
+        if (m_enabled || path.empty()) return;
+        m_path = path;
+        m_configHash = config_hash;
+        m_enabled = true;
+        m_loaded = read();
+        if (m_loaded)
+            Info("StartupSnapshot::configure()", "Read %lu tables from the startup snapshot %s", m_tables.size(), m_path.c_str());
+        else
+            Info("StartupSnapshot::configure()", "No valid startup snapshot found in %s. It will be created", m_path.c_str());
+    }
+    bool StartupSnapshot::isEnabled() const { return m_enabled; }
+    bool StartupSnapshot::isLoaded() const { return m_loaded && !m_stale; }
+    bool StartupSnapshot::read() {
+        std::ifstream in(m_path, std::ios::in | std::ios::binary);
+        if (!in.good()) return false;
+        std::stringstream content;
+        content << in.rdbuf();
+        const std::string buffer = content.str();
+        // The checksum of the content is appended at the end
+        size_t checksum = 0;
+        if (buffer.size() < sizeof(s_magic) + sizeof(checksum)) return false;
+        const size_t payload = buffer.size() - sizeof(checksum);
+        std::memcpy(&checksum, buffer.data() + payload, sizeof(checksum));
+        if (checksum != std::hash<std::string>()(buffer.substr(0, payload))) {
+            Warning("StartupSnapshot::read()", "The checksum of %s does not match. The file is ignored", m_path.c_str());
+            return false;
+        }
+        if (std::memcmp(buffer.data(), s_magic, sizeof(s_magic)) != 0) return false;
+        size_t pos = sizeof(s_magic);
+        unsigned int version = 0, n_tables = 0;
+        size_t config_hash = 0;
+        if (!ReadValue(buffer, pos, version) || version != m_version) {
+            Info("StartupSnapshot::read()", "%s has been written with format version %u instead of %u", m_path.c_str(), version, m_version);
+            return false;
+        }
+        if (!ReadValue(buffer, pos, config_hash) || config_hash != m_configHash) {
+            Info("StartupSnapshot::read()", "%s has been produced with a different configuration", m_path.c_str());
+            return false;
+        }
+        if (!ReadValue(buffer, pos, n_tables)) return false;
+        std::map<std::string, std::vector<std::string>> tables;
+        for (unsigned int t = 0; t < n_tables; ++t) {
+            std::string key;
+            unsigned int n_values = 0;
+            if (!ReadString(buffer, pos, key) || !ReadValue(buffer, pos, n_values)) return false;
+            std::vector<std::string>& values = tables[key];
+            values.resize(n_values);
+            for (auto& value : values) {
+                if (!ReadString(buffer, pos, value)) return false;
+            }
+        }
+        if (pos != payload) return false;
+        m_tables = std::move(tables);
+        return true;
+    }
+    bool StartupSnapshot::get(const std::string& key, std::vector<std::string>& values) const {
+        if (!isLoaded()) return false;
+        std::map<std::string, std::vector<std::string>>::const_iterator itr = m_tables.find(key);
+        if (itr == m_tables.end()) return false;
+        values = itr->second;
+        return true;
+    }
+    void StartupSnapshot::set(const std::string& key, const std::vector<std::string>& values) {
+        if (!m_enabled) return;
+        std::map<std::string, std::vector<std::string>>::iterator itr = m_tables.find(key);
+        if (itr != m_tables.end() && itr->second == values) return;
+        if (m_loaded && !m_stale) {
+            Warning("StartupSnapshot::set()", "The table %s differs from the snapshot %s. The snapshot will be rewritten", key.c_str(),
+                    m_path.c_str());
+            m_stale = true;
+        }
+        m_tables[key] = values;
+    }
+    bool StartupSnapshot::write() {
+        if (!m_enabled || isLoaded()) return true;
+        std::string buffer(s_magic, sizeof(s_magic));
+        WriteValue(buffer, m_version);
+        WriteValue(buffer, m_configHash);
+        WriteValue(buffer, (unsigned int)m_tables.size());
+        for (const auto& table : m_tables) {
+            WriteString(buffer, table.first);
+            WriteValue(buffer, (unsigned int)table.second.size());
+            for (const auto& value : table.second) WriteString(buffer, value);
+        }
+        WriteValue(buffer, std::hash<std::string>()(buffer));
+        // Several jobs may create the snapshot at the same time. Each of them writes a private file which is moved in place
+        const std::string tmp_path = m_path + ".tmp" + std::to_string(getpid());
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), buffer.size());
+        out.close();
+        if (out.fail() || std::rename(tmp_path.c_str(), m_path.c_str()) != 0) {
+            Warning("StartupSnapshot::write()", "Failed to write the startup snapshot %s", m_path.c_str());
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+        Info("StartupSnapshot::write()", "Wrote %lu tables to the startup snapshot %s", m_tables.size(), m_path.c_str());
+        m_loaded = true;
+        m_stale = false;
+        return true;
+    }
+}  // namespace XAMPP
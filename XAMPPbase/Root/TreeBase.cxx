@@ -2,13 +2,25 @@
 #include <PATInterfaces/SystematicSet.h>
 #include <XAMPPbase/AnalysisConfig.h>
 #include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/AsyncTreeWriter.h>
+#include <XAMPPbase/DeltaTrees.h>
 #include <XAMPPbase/EventInfo.h>
 #include <XAMPPbase/ISystematics.h>
 #include <XAMPPbase/TreeBase.h>
 #include <XAMPPbase/TreeHelpers.h>
+
+#include <TBranch.h>
+
+#include <chrono>
 #include <iostream>
+#include <map>
+#include <sstream>
 
 namespace XAMPP {
+    namespace {
+        typedef std::chrono::steady_clock Clock;
+        double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+    }  // namespace
 
     TreeBase::TreeBase(const CP::SystematicSet* set) : TreeBase(set, std::shared_ptr<SystematicGroup>()) {}
     TreeBase::TreeBase(const CP::SystematicSet* set, std::shared_ptr<SystematicGroup> grp) :
@@ -23,11 +35,13 @@ namespace XAMPP {
         m_isWritten(false),
         m_histSvc("THistSvc", set != nullptr ? RemoveAllExpInStr("TreeBase" + set->name(), "_") : "CommonTree"),
         m_friend_trees(),
+        m_delta_reference(),
         m_Branches(),
         m_mcChannelNumber(-1),
-        m_eventId() {
-        m_eventId[0] = m_eventId[1] = 0;
-    }
+        m_eventId{{0, 0}},
+        m_compression(-1),
+        m_autoFlush(-3000000),
+        m_fillTime(0.) {}
 
     TreeBase::~TreeBase() {}
     std::shared_ptr<SystematicGroup> TreeBase::getSystematicGroup() const { return m_syst_group; }
@@ -48,6 +62,24 @@ namespace XAMPP {
         if (!m_init) m_config = config.operator->();
     }
 
+    void TreeBase::SetOutputPolicy(int compression, Long64_t auto_flush) {
+        if (m_init) return;
+        m_compression = compression;
+        if (auto_flush != 0) m_autoFlush = auto_flush;
+    }
+    int TreeBase::CompressionSettings(const std::string& policy) {
+        if (policy.empty()) return -1;
+        static const std::map<std::string, int> algorithms{{"ZLIB", 1}, {"LZMA", 2}, {"OLD", 3}, {"LZ4", 4}, {"ZSTD", 5}};
+        size_t pos = policy.find(":");
+        std::map<std::string, int>::const_iterator alg = algorithms.find(policy.substr(0, pos));
+        if (alg == algorithms.end()) return -2;
+        int level = 1;
+        if (pos != std::string::npos) {
+            std::stringstream sstr(policy.substr(pos + 1));
+            if (!(sstr >> level) || level < 0 || level > 9) return -2;
+        }
+        return alg->second * 100 + level;
+    }
     void TreeBase::SetEventInfoHandler(const XAMPP::EventInfo* Info) {
         if (!m_init) m_XAMPPInfo = Info;
     }
@@ -59,6 +91,9 @@ namespace XAMPP {
         if (IsInVector(tree_base, m_friend_trees)) return;
         m_friend_trees.push_back(tree_base);
     }
+    void TreeBase::SetDeltaReference(std::shared_ptr<TreeBase> nominal) {
+        if (!m_init && nominal.get() != this) m_delta_reference = nominal;
+    }
     void TreeBase::SetSystematicsTool(const ToolHandle<XAMPP::ISystematics>& Syst) {
         if (!m_init) m_systematics = Syst.operator->();
     }
@@ -97,9 +132,25 @@ namespace XAMPP {
         m_tree = std::make_unique<TTree>(tree_name().c_str(), "SmallTree for fast analysis");
         /// cf. documentation
         /// here https://root.cern.ch/doc/v614/classTTree.html#ad4c7c7d70caf5657104832bcfbd83a9f
-        /// Set the autoflush value to 3MB of data.
-        m_tree->SetAutoFlush(-3000000);
+        /// Set the autoflush value to 3MB of data by default. After the first cluster ROOT
+        /// converts the value into a number of entries and optimizes the basket sizes
+        /// The header of the tree is rewritten at each auto save. Keep it byte-based, otherwise a
+        /// positive auto flush would rewrite the header every N entries
+        m_tree->SetAutoFlush(m_autoFlush);
         m_tree->SetAutoSave(-3000000);
+        /// The branches must be created after the tree is known to the writer
+        AsyncTreeWriter* writer = AsyncTreeWriter::GetInstance();
+        writer->registerTree(Tree());
+        DeltaTreeEncoder* encoder = DeltaTreeEncoder::GetInstance();
+        if (m_set == m_systematics->GetNominal() && !m_syst_group) {
+            encoder->registerNominal(Tree());
+        } else if (m_delta_reference) {
+            if (!m_delta_reference->isInitialized()) {
+                Error("TreeBase::InitializeTree()", "The nominal tree needs to be initialized before %s", tree_name().c_str());
+                return StatusCode::FAILURE;
+            }
+            if (!encoder->registerDelta(Tree(), m_delta_reference->Tree())) return StatusCode::FAILURE;
+        }
         if (!m_histSvc->regTree(Form("/XAMPP/%s", tree_name().c_str()), Tree()).isSuccess()) { return StatusCode::FAILURE; }
         m_directory = m_tree->GetDirectory();
         if (!m_directory) {
@@ -107,9 +158,13 @@ namespace XAMPP {
             return StatusCode::FAILURE;
         }
         if (!m_systematics->isData()) {
-            if (!m_set || (m_friend_trees.empty() && !m_syst_group)) { m_tree->Branch("mcChannelNumber", &m_mcChannelNumber); }
+            if (!m_set || (m_friend_trees.empty() && !m_syst_group)) {
+                m_tree->Branch("mcChannelNumber", &writer->branchAddress(Tree(), m_mcChannelNumber));
+            }
+        }
+        if (!m_friend_trees.empty() || !m_set || m_syst_group) {
+            m_tree->Branch("CommonEventHash", writer->branchAddress(Tree(), m_eventId).data(), "CommonEventHash[2]/l");
         }
-        if (!m_friend_trees.empty() || !m_set || m_syst_group) m_tree->Branch("CommonEventHash", m_eventId, "CommonEventHash[2]/l");
         CreateBranches();
         std::vector<XAMPP::Storage<XAMPPmet>*> MetStorageVector = m_XAMPPInfo->GetStorages<XAMPPmet>(IEventInfo::OutputElement::Tree);
         for (auto& entry : MetStorageVector) {
@@ -134,6 +189,7 @@ namespace XAMPP {
             Error("TreeBase::initializeTree()", "%s has no branches assigned.", tree_name().c_str());
             return StatusCode::FAILURE;
         }
+        if (m_compression >= 0) SetCompression(m_tree->GetListOfBranches());
         m_isWritten = false;
         m_init = true;
         return StatusCode::SUCCESS;
@@ -179,15 +235,28 @@ namespace XAMPP {
                 return StatusCode::FAILURE;
             }
         }
-        if (m_tree->Fill() < 0) {
+        /// Events which are identical to nominal are only referenced in the delta mode
+        DeltaTreeEncoder* encoder = DeltaTreeEncoder::GetInstance();
+        if (!encoder->encode(Tree(), m_eventId)) return StatusCode::SUCCESS;
+        Clock::time_point start = Clock::now();
+        if (!AsyncTreeWriter::GetInstance()->fill(Tree())) {
             Error("TreeBase::FillTree()", "Failed to fill the tree");
             return StatusCode::FAILURE;
         }
+        m_fillTime += Seconds(start);
+        encoder->nominalFilled(Tree(), m_eventId);
         return StatusCode::SUCCESS;
     }
     StatusCode TreeBase::FinalizeTree() {
         if (m_isWritten) { return StatusCode::SUCCESS; }
         m_isWritten = true;
+        // The event loop waits for the entries still in the queue of the writer thread
+        Clock::time_point start = Clock::now();
+        if (!AsyncTreeWriter::GetInstance()->flush()) {
+            Error("TreeBase::FinalizeTree()", "Not all entries of %s could be written", tree_name().c_str());
+            return StatusCode::FAILURE;
+        }
+        m_fillTime += Seconds(start);
         if (!m_histSvc->deReg(Tree()).isSuccess()) {
             Error("TreeBase::FinalizeTree()", "Failed to put the tree out of the HistService");
             return StatusCode::FAILURE;
@@ -199,8 +268,17 @@ namespace XAMPP {
                 return StatusCode::FAILURE;
             }
         }
+        start = Clock::now();
         m_directory->WriteObject(m_tree.get(), m_tree->GetName());
+        // Wall time the event loop spent on the tree. The work of the writer thread in parallel to the event loop is not counted
+        const double write_time = m_fillTime + Seconds(start);
+        const double raw_MB = m_tree->GetTotBytes() / 1.e6;
+        const double zip_MB = m_tree->GetZipBytes() / 1.e6;
         Info("TreeBase::FinalizeTree()", "Successfully written %s containing %llu entries.", tree_name().c_str(), m_tree->GetEntries());
+        int compression = m_compression;
+        if (compression < 0 && m_directory->GetFile()) compression = m_directory->GetFile()->GetCompressionSettings();
+        Info("TreeBase::FinalizeTree()", "%s: %.2f MB uncompressed, %.2f MB on disk (ratio %.2f, compression %d), written with %.2f MB/s",
+             tree_name().c_str(), raw_MB, zip_MB, zip_MB > 0 ? raw_MB / zip_MB : 0., compression, write_time > 0 ? raw_MB / write_time : 0.);
         if (!m_friend_trees.empty() || !(!m_set || m_syst_group)) {
             m_tree.reset();
             m_Branches.clear();
@@ -211,6 +289,15 @@ namespace XAMPP {
     void TreeBase::SetHistService(ServiceHandle<ITHistSvc>& Handle) {
         if (!m_init) m_histSvc = Handle;
     }
+    void TreeBase::SetCompression(TObjArray* branches) const {
+        if (!branches) return;
+        for (auto obj : *branches) {
+            TBranch* branch = dynamic_cast<TBranch*>(obj);
+            if (!branch) continue;
+            branch->SetCompressionSettings(m_compression);
+            SetCompression(branch->GetListOfBranches());
+        }
+    }
     bool TreeBase::addVariable(XAMPP::IStorage* store) const {
         if (m_set == nullptr) return store->IsCommonVariable();
         if (!m_friend_trees.empty() && store->IsCommonVariable()) return false;
@@ -0,0 +1,54 @@
+#ifndef XAMPPbase_AllocationCounter_H
+#define XAMPPbase_AllocationCounter_H
+
+#include <string>
+
+//#############################################################################
+//  The AllocationCounter reads out the number of operator new/delete calls   #
+//  counted by the XAMPPAllocationHook library. It must be preloaded via      #
+//      LD_PRELOAD=libXAMPPAllocationHook.so athena.py ...                    #
+//  Without the hook the counter is not available and the monitors are idle.  #
+//  The AllocationMonitor accumulates the allocations of one processing stage #
+//  per event and checks them against a budget                                #
+//#############################################################################
+namespace XAMPP {
+    class AllocationCounter {
+    public:
+        static bool isAvailable();
+        // Total number of allocations since the start of the process
+        static unsigned long long count();
+        // Number of allocations which have not been released yet
+        static long long liveAllocations();
+    };
+
+    class AllocationMonitor {
+    public:
+        // A negative budget only monitors the stage
+        AllocationMonitor(const std::string& stage, long long budget = -1);
+
+        void start();
+        void stop();
+        // Closes the current event. Returns false if the budget is exceeded
+        bool endEvent();
+
+        const std::string& stage() const;
+        long long budget() const;
+        // Allocations of the current/ last closed event
+        unsigned long long eventAllocations() const;
+        unsigned long long maxAllocations() const;
+        double meanAllocations() const;
+        unsigned long long nViolations() const;
+
+    private:
+        std::string m_stage;
+        long long m_budget;
+        unsigned long long m_start;
+        unsigned long long m_event;
+        unsigned long long m_last;
+        unsigned long long m_total;
+        unsigned long long m_max;
+        unsigned long long m_nEvents;
+        unsigned long long m_nViolations;
+    };
+}  // namespace XAMPP
+#endif
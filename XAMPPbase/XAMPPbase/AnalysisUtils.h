@@ -141,6 +141,13 @@ namespace XAMPP {
     std::string ReplaceExpInString(std::string str, const std::string& exp, const std::string& rep);
     std::string ToLower(const std::string& str);
     bool GetLine(std::ifstream& inf, std::string& line);
+    // Same as IsROOTFile of ClusterSubmission.Utils: <name>.root or <name>.root.<N>
+    bool IsROOTFile(const std::string& file_name);
+    // 64 bit FNV-1a hash. Unlike std::hash it is the same for every build, i.e. suited for files shared between jobs
+    unsigned long long Fnv1aHash(const char* data, size_t size, unsigned long long hash = 14695981039346656037ULL);
+    unsigned long long Fnv1aHash(const std::string& str);
+    // Continues the hash with the content of the file, which is read in chunks. Returns false if it cannot be read
+    bool Fnv1aHashFile(const std::string& path, unsigned long long& hash);
 
     MSG::Level setOutputLevel(int m_output_level_int);
     xAOD::IParticle* FindLeadingParticle(xAOD::IParticleContainer* Particles);
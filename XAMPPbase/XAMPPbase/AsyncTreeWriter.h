@@ -0,0 +1,128 @@
+#ifndef XAMPPbase_AsyncTreeWriter_H
+#define XAMPPbase_AsyncTreeWriter_H
+
+#include <TTree.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <sys/types.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//###############################################################################
+//  The AsyncTreeWriter moves the TTree::Fill calls of the output trees, i.e.   #
+//  the serialization of the branches, the basket compression and the flushes   #
+//  to the disk, to a dedicated writer thread. The TTree branches are not bound #
+//  to the variables of the event loop, but to private copies. After the        #
+//  branches are updated, the event thread copies the current values into a     #
+//  row buffer of the tree and hands it over to the writer via a bounded        #
+//  single-producer single-consumer queue. The writer processes the rows in     #
+//  the order they were queued. Hence each tree is filled with exactly the same #
+//  sequence of entries as in the synchronous mode.                             #
+//###############################################################################
+namespace XAMPP {
+    class ITreeColumn {
+    public:
+        virtual ~ITreeColumn() = default;
+        // Event thread: Copy the value of the source variable into the row
+        virtual void capture(size_t row) = 0;
+        // Writer thread: Move the row into the variable the branch is bound to
+        virtual void release(size_t row) = 0;
+    };
+
+    template <class T> class TreeColumn : public ITreeColumn {
+    public:
+        TreeColumn(const T& source, size_t rows) : m_source(source), m_sink(), m_rows(new T[rows]) {}
+        T& sink() { return m_sink; }
+        void capture(size_t row) override { m_rows[row] = m_source; }
+        // The swap keeps the capacity of the vectors alive
+        void release(size_t row) override { std::swap(m_sink, m_rows[row]); }
+
+    private:
+        const T& m_source;
+        T m_sink;
+        std::unique_ptr<T[]> m_rows;
+    };
+
+    // Row buffers of one output tree
+    class TreeFillBuffer {
+    public:
+        TreeFillBuffer(TTree* tree, size_t rows);
+        TTree* tree() const;
+        template <class T> T& addColumn(const T& source) {
+            TreeColumn<T>* column = new TreeColumn<T>(source, m_nRows);
+            m_columns.push_back(std::unique_ptr<ITreeColumn>(column));
+            return column->sink();
+        }
+        // Event thread: Copy the current values into the next row. Waits if the row is still queued
+        size_t capture(double& stall_time);
+        // Writer thread: Fill the row into the tree
+        bool fill(size_t row);
+
+    private:
+        TTree* m_tree;
+        size_t m_nRows;
+        std::vector<std::unique_ptr<ITreeColumn>> m_columns;
+        std::unique_ptr<std::atomic<bool>[]> m_inFlight;
+        size_t m_next;
+    };
+
+    class AsyncTreeWriter {
+    public:
+        static AsyncTreeWriter* GetInstance();
+        ~AsyncTreeWriter();
+
+        // Called once by the analysis helper before the trees are initialized
+        void configure(bool enable, size_t queue_size);
+        bool isEnabled() const;
+
+        // Trees registered before their branches are created are filled asynchronously
+        void registerTree(TTree* tree);
+        // Returns the variable the branch needs to be bound to in order to store the source
+        template <class T> T& branchAddress(TTree* tree, T& source) {
+            std::map<const TTree*, std::unique_ptr<TreeFillBuffer>>::iterator itr = m_buffers.find(tree);
+            if (itr == m_buffers.end()) return source;
+            return itr->second->addColumn(source);
+        }
+        // Event thread: Queue the current entry of the tree
+        bool fill(TTree* tree);
+        // Wait until all queued entries are written. Returns false if the writer failed
+        bool flush();
+        // Stop the writer thread and print the queue metrics
+        bool stop();
+
+    private:
+        AsyncTreeWriter();
+        static AsyncTreeWriter* m_Inst;
+        void run();
+        // Starts the writer thread at the first fill, i.e. in the AthenaMP workers after the fork
+        bool startThread();
+
+        struct Request {
+            TreeFillBuffer* buffer;
+            size_t row;
+        };
+        bool m_enabled;
+        std::map<const TTree*, std::unique_ptr<TreeFillBuffer>> m_buffers;
+        std::vector<Request> m_queue;
+        size_t m_capacity;
+        std::atomic<size_t> m_head;
+        std::atomic<size_t> m_tail;
+        std::thread m_thread;
+        // Threads do not survive a fork. The process which started the writer thread
+        pid_t m_threadPid;
+        std::atomic<bool> m_stop;
+        std::atomic<bool> m_failed;
+
+        // Queue metrics
+        unsigned long long m_nFills;
+        unsigned long long m_depthSum;
+        size_t m_maxDepth;
+        double m_producerStall;
+        double m_writerIdle;
+        double m_writerBusy;
+    };
+}  // namespace XAMPP
+#endif
@@ -0,0 +1,104 @@
+#ifndef XAMPPbase_CalibrationCache_H
+#define XAMPPbase_CalibrationCache_H
+
+#include <xAODBase/IParticleContainer.h>
+#include <xAODCore/ShallowAuxContainer.h>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace CP {
+    class SystematicSet;
+}
+//###############################################################################
+//  The CalibrationCache persists the outcome of the CP calibration per event   #
+//  and kinematic systematic, i.e. the variables written by SUSYTools onto the   #
+//  shallow copies of the particle containers (four-momenta, selection flags)   #
+//  and the event scale-factors. One cache file per input file is written to    #
+//          <CalibrationCacheDir>/<file GUID>.xcache                            #
+//  The file is only read back if the hash of the SUSYTools configuration and   #
+//  the list of kinematic systematics agree with the current job. Otherwise it  #
+//  is silently rewritten. Subsequent runs which only change the analysis cuts  #
+//  thus skip the calls to the CP tools. The hash covers the contents of the    #
+//  SUSYTools configuration and of the pile-up reweighting files.               #
+//###############################################################################
+namespace XAMPP {
+    class CalibrationCache {
+    public:
+        enum Mode { Disabled = 0, Write, Read };
+        typedef std::vector<std::pair<std::string, double>> WeightList;
+
+        static CalibrationCache* GetInstance();
+        ~CalibrationCache();
+
+        // Called once by the analysis helper after the systematics are fixed
+        void configure(const std::string& cache_dir, size_t config_hash, const std::vector<const CP::SystematicSet*>& systematics,
+                       bool cache_weights);
+        bool isEnabled() const;
+        bool cacheWeights() const;
+        Mode mode() const;
+
+        // Switch to the cache of the next input file. The cache written for the previous file is committed
+        bool openFile(const std::string& guid);
+        // Commits the cache file written so far
+        bool closeFile();
+        void setEvent(unsigned int run, unsigned long long event);
+
+        // Restore the calibrated variables of the shallow copy. Returns false if nothing is cached for the event
+        bool restoreObjects(const std::string& key, const CP::SystematicSet* set, xAOD::IParticleContainer& calibrated) const;
+        // Save the variables written by the calibration onto the shallow copy
+        bool saveObjects(const std::string& key, const CP::SystematicSet* set, const xAOD::IParticleContainer& calibrated,
+                         const xAOD::ShallowAuxContainer& aux);
+
+        bool restoreWeights(const CP::SystematicSet* set, WeightList& weights) const;
+        bool saveWeights(const CP::SystematicSet* set, const WeightList& weights);
+
+    private:
+        CalibrationCache();
+        static CalibrationCache* m_Inst;
+
+        enum RecordType { Objects = 1, Weights = 2 };
+        enum VariableType { Char = 1, Int, UInt, Float, Double };
+        typedef std::tuple<unsigned int, unsigned long long, unsigned int, std::string> RecordKey;
+
+        bool readFile(const std::string& path);
+        void unmap();
+        int systematicIndex(const CP::SystematicSet* set) const;
+        const char* findRecord(RecordType type, const std::string& key, const CP::SystematicSet* set) const;
+        void writeRecordHeader(RecordType type, const std::string& key, const CP::SystematicSet* set);
+
+        template <typename T> void write(const T& value);
+        void writeString(const std::string& str);
+        template <typename T> static T read(const char*& ptr);
+        static std::string readString(const char*& ptr);
+
+        template <typename T>
+        static bool saveVariable(const std::string& name, const xAOD::IParticleContainer& calibrated, std::vector<char>& data);
+        template <typename T> static void restoreVariable(const std::string& name, const char*& ptr, xAOD::IParticleContainer& calibrated);
+
+        std::string m_dir;
+        size_t m_configHash;
+        size_t m_systHash;
+        std::vector<const CP::SystematicSet*> m_systematics;
+        bool m_cacheWeights;
+        Mode m_mode;
+
+        std::string m_path;
+        std::unique_ptr<std::ofstream> m_out;
+        // The cache file which is read is mapped into memory. Only the pages of the records accessed are loaded
+        void* m_mapped;
+        size_t m_mappedSize;
+        std::map<RecordKey, size_t> m_index;
+        std::set<std::string> m_uncacheable;
+
+        unsigned int m_run;
+        unsigned long long m_event;
+    };
+}  // namespace XAMPP
+#endif
@@ -0,0 +1,70 @@
+#ifndef XAMPPbase_CrossSectionTable_H
+#define XAMPPbase_CrossSectionTable_H
+
+#include <string>
+#include <vector>
+
+//###############################################################################
+//  Compiled snapshot of the SUSYTools cross-section database                   #
+//  The CompileCrossSections executable queries the text database for each      #
+//  DSID and final state and writes the answers into a binary file as a flat    #
+//  array sorted by (DSID, final state). The file is mapped into memory at      #
+//  startup and the entries are found by a binary search, i.e. no text is       #
+//  parsed. The table is complete: it holds every process the text database     #
+//  knows, including those with negative values, and the answer of the          #
+//  database for an unknown process. Hence, a process missing in the table is   #
+//  unknown to the text database as well. The header carries a hash over the    #
+//  names and the contents of the text files the snapshot has been compiled     #
+//  from. If the text files in use differ, the snapshot is rejected and the     #
+//  text database must be used.                                                 #
+//###############################################################################
+namespace XAMPP {
+    class CrossSectionTable {
+    public:
+        // Answers of the text database for one process. Unknown values are -1 like in SUSYTools
+        struct Entry {
+            unsigned int dsid;
+            unsigned int finalState;
+            double xsect;
+            double kfactor;
+            double efficiency;
+            double relunc;
+            double xsectTimesEff;
+        };
+
+        // Key of the entry storing the answer of the text database for processes it does not know
+        static const unsigned int UnknownProcess = 0xFFFFFFFF;
+
+        CrossSectionTable();
+        ~CrossSectionTable();
+
+        // Hash over the file names and contents. Independent of the order and location of the files.
+        // All files are read in full, which is part of the startup time of the snapshot
+        static unsigned long long SourceHash(const std::vector<std::string>& txt_files);
+        static bool write(const std::string& table_file, std::vector<Entry> entries, unsigned long long source_hash);
+
+        // Maps the table into memory. Fails if the file is corrupted or has been built from other text files
+        bool load(const std::string& table_file, unsigned long long source_hash);
+        bool isLoaded() const;
+
+        // Returns a nullptr if the process is not part of the table
+        const Entry* find(unsigned int dsid, unsigned int finalState) const;
+        // Returns the entry of the process or the answer for unknown processes. Only a nullptr if the table is not loaded
+        const Entry* lookup(unsigned int dsid, unsigned int finalState) const;
+
+        size_t size() const;
+        const Entry* begin() const;
+        const Entry* end() const;
+
+    private:
+        CrossSectionTable(const CrossSectionTable&) = delete;
+        void operator=(const CrossSectionTable&) = delete;
+        void unmap();
+
+        void* m_mapped;
+        size_t m_mappedSize;
+        const Entry* m_entries;
+        size_t m_nEntries;
+    };
+}  // namespace XAMPP
+#endif
@@ -0,0 +1,237 @@
+#ifndef XAMPPbase_DeltaTrees_H
+#define XAMPPbase_DeltaTrees_H
+
+#include <TBranch.h>
+#include <TTree.h>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//###############################################################################
+//  Delta encoding of the kinematic systematic trees                            #
+//  Most branches of a systematic tree carry the same values as the nominal     #
+//  tree for the same event, e.g. the electrons in a muon variation. In the     #
+//  delta mode a systematic tree only stores what differs from nominal:         #
+//   - NominalEntry:  Entry of the same event in the nominal tree. -1 if the    #
+//                    event did not pass the nominal selection, -2 if the entry #
+//                    only carries the SameAsNominal list of the end of the job #
+//   - DeltaBranches: Indices of the branches which differ from nominal. The    #
+//                    remaining branches are reset to their default value, such #
+//                    that they compress to almost nothing                      #
+//   - SameAsNominal: Nominal entries of the events which passed the variation  #
+//                    without any difference. They are not written themselves,  #
+//                    but precede the current entry in the systematic view      #
+//  The names of the encoded branches are saved in the UserInfo of the tree as  #
+//  TList called DeltaEncoding. The position in the list is the branch index.   #
+//  The DeltaTreeReader reconstructs the full systematic tree by merging the    #
+//  delta tree with the nominal one.                                            #
+//###############################################################################
+namespace XAMPP {
+    // Resets the values of unchanged branches
+    template <class T> void ResetDeltaValue(T& value) { value = T(); }
+    template <class T> void ResetDeltaValue(std::vector<T>& value) { value.clear(); }
+
+    class IDeltaReference {
+    public:
+        virtual ~IDeltaReference() = default;
+        // Copy the value written to the nominal tree
+        virtual void snapshot() = 0;
+    };
+    template <class T> class DeltaReference : public IDeltaReference {
+    public:
+        DeltaReference(const T& source) : m_source(source), m_value() {}
+        void snapshot() override { m_value = m_source; }
+        const T& value() const { return m_value; }
+
+    private:
+        const T& m_source;
+        T m_value;
+    };
+
+    class IDeltaColumn {
+    public:
+        virtual ~IDeltaColumn() = default;
+        // Copies the source into the branch if it differs from nominal. Otherwise the branch is reset
+        virtual bool encode(bool has_nominal) = 0;
+        virtual void reset() = 0;
+    };
+    template <class T> class DeltaColumn : public IDeltaColumn {
+    public:
+        DeltaColumn(const T& source, const DeltaReference<T>* reference) : m_source(source), m_reference(reference), m_sink() {}
+        T& sink() { return m_sink; }
+        bool encode(bool has_nominal) override {
+            if (has_nominal && m_reference && m_reference->value() == m_source) {
+                ResetDeltaValue(m_sink);
+                return false;
+            }
+            m_sink = m_source;
+            return true;
+        }
+        void reset() override { ResetDeltaValue(m_sink); }
+
+    private:
+        const T& m_source;
+        const DeltaReference<T>* m_reference;
+        T m_sink;
+    };
+
+    class DeltaTreeEncoder {
+    public:
+        static DeltaTreeEncoder* GetInstance();
+        ~DeltaTreeEncoder() = default;
+
+        // Called once by the analysis helper before the trees are initialized
+        void configure(bool enable);
+        bool isEnabled() const;
+
+        // The trees need to be registered before their branches are created. The
+        // nominal tree must be initialized before the systematic trees
+        void registerNominal(TTree* tree);
+        bool registerDelta(TTree* tree, TTree* nominal);
+
+        // Returns the variable the branch needs to be bound to in order to store the source
+        template <class T> T& branchAddress(TTree* tree, const std::string& name, T& source) {
+            std::map<const TTree*, NominalTree>::iterator nominal = m_nominal.find(tree);
+            if (nominal != m_nominal.end()) {
+                DeltaReference<T>* reference = new DeltaReference<T>(source);
+                nominal->second.references[name] = std::unique_ptr<IDeltaReference>(reference);
+                return source;
+            }
+            std::map<const TTree*, DeltaTree>::iterator delta = m_delta.find(tree);
+            if (delta == m_delta.end()) return source;
+            const DeltaReference<T>* reference = nullptr;
+            std::map<const TTree*, NominalTree>::const_iterator ref_tree = m_nominal.find(delta->second.nominal);
+            if (ref_tree != m_nominal.end()) {
+                std::map<std::string, std::unique_ptr<IDeltaReference>>::const_iterator itr = ref_tree->second.references.find(name);
+                if (itr != ref_tree->second.references.end()) reference = dynamic_cast<const DeltaReference<T>*>(itr->second.get());
+            }
+            DeltaColumn<T>* column = new DeltaColumn<T>(source, reference);
+            delta->second.columns.push_back(std::unique_ptr<IDeltaColumn>(column));
+            delta->second.names.push_back(name);
+            return column->sink();
+        }
+        // Called after the nominal tree has been filled for the event
+        void nominalFilled(TTree* tree, const std::array<unsigned long long, 2>& event_id);
+        // Encodes the current entry of the systematic tree. Returns false if the
+        // event is identical to nominal and the tree must not be filled
+        bool encode(TTree* tree, const std::array<unsigned long long, 2>& event_id);
+        // Writes the pending SameAsNominal lists and the encoding. Must be called before the
+        // AsyncTreeWriter is stopped
+        bool finalize();
+
+    private:
+        DeltaTreeEncoder();
+        static DeltaTreeEncoder* m_Inst;
+
+        struct NominalTree {
+            std::map<std::string, std::unique_ptr<IDeltaReference>> references;
+            std::array<unsigned long long, 2> lastEvent;
+            Long64_t entries;
+        };
+        struct DeltaTree {
+            TTree* nominal;
+            std::vector<std::unique_ptr<IDeltaColumn>> columns;
+            std::vector<std::string> names;
+            Long64_t nominalEntry;
+            std::vector<UInt_t> changed;
+            std::vector<Long64_t> sameAsNominal;
+            bool written;
+            // Statistics
+            unsigned long long nEvents;
+            unsigned long long nWritten;
+            unsigned long long nStoredBranches;
+        };
+        bool m_enabled;
+        std::map<const TTree*, NominalTree> m_nominal;
+        std::map<const TTree*, DeltaTree> m_delta;
+    };
+
+    class DeltaTreeReader {
+    public:
+        DeltaTreeReader(TTree* nominal, TTree* delta);
+        ~DeltaTreeReader() = default;
+        // Reads the encoding and builds the index of the systematic view
+        bool Init();
+
+        // Number of entries of the systematic tree
+        Long64_t GetEntries() const;
+        bool GetEntry(Long64_t entry);
+
+        // Connects a variable to the branch of the systematic view. Objects like std::vector need to be passed
+        // as pointer to pointer analogous to TTree::SetBranchAddress
+        template <class T> bool SetBranchAddress(const std::string& name, T* address) {
+            bool in_nominal = false;
+            if (!activate(name, in_nominal)) return false;
+            if (in_nominal) m_nominalTree->SetBranchAddress(name.c_str(), address);
+            // Branches missing in the nominal tree are always stored in the delta tree
+            int idx = in_nominal ? encodingIndex(name) : -1;
+            if (idx < 0) {
+                m_deltaTree->SetBranchAddress(name.c_str(), address);
+                m_plain.push_back(m_deltaTree->GetBranch(name.c_str()));
+                return true;
+            }
+            Slot<T>* slot = new Slot<T>(address);
+            m_deltaTree->SetBranchAddress(name.c_str(), slot->address());
+            slot->setBranch(m_deltaTree->GetBranch(name.c_str()));
+            m_slots[idx] = std::unique_ptr<ISlot>(slot);
+            return true;
+        }
+
+    private:
+        class ISlot {
+        public:
+            virtual ~ISlot() = default;
+            virtual void load(Long64_t entry) = 0;
+        };
+        template <class T> class Slot : public ISlot {
+        public:
+            Slot(T* target) : m_target(target), m_value(), m_branch(nullptr) {}
+            T* address() { return &m_value; }
+            void setBranch(TBranch* branch) { m_branch = branch; }
+            void load(Long64_t entry) override {
+                m_branch->GetEntry(entry);
+                *m_target = m_value;
+            }
+
+        private:
+            T* m_target;
+            T m_value;
+            TBranch* m_branch;
+        };
+        template <class T> class Slot<T*> : public ISlot {
+        public:
+            Slot(T** target) : m_target(target), m_value(), m_ptr(&m_value), m_branch(nullptr) {}
+            T** address() { return &m_ptr; }
+            void setBranch(TBranch* branch) { m_branch = branch; }
+            void load(Long64_t entry) override {
+                m_branch->GetEntry(entry);
+                if (!*m_target) *m_target = new T();
+                **m_target = m_value;
+            }
+
+        private:
+            T** m_target;
+            T m_value;
+            T* m_ptr;
+            TBranch* m_branch;
+        };
+        bool activate(const std::string& name, bool& in_nominal);
+        int encodingIndex(const std::string& name) const;
+
+        TTree* m_nominalTree;
+        TTree* m_deltaTree;
+        std::vector<std::string> m_encoding;
+        // Pairs of nominal and delta entries for each entry of the systematic view
+        std::vector<std::pair<Long64_t, Long64_t>> m_index;
+        std::vector<std::unique_ptr<ISlot>> m_slots;
+        std::vector<TBranch*> m_plain;
+        std::vector<UInt_t> m_changedValues;
+        std::vector<UInt_t>* m_changed;
+        TBranch* m_changedBranch;
+        bool m_init;
+    };
+}  // namespace XAMPP
+#endif
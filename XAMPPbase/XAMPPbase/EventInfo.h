@@ -2,6 +2,7 @@
 #define XAMPPbase_EventInfo_H
 
 #include <XAMPPbase/EventStorage.h>
+#include <XAMPPbase/GoodRunsLookup.h>
 
 #include <XAMPPbase/IEventInfo.h>
 #include <XAMPPbase/ISystematics.h>
@@ -15,6 +16,7 @@
 #include <AsgTools/ToolHandle.h>
 
 #include <memory>
+#include <unordered_map>
 
 namespace CP {
     class SystematicSet;
@@ -32,6 +34,7 @@ namespace XAMPP {
         ASG_TOOL_CLASS(EventInfo, XAMPP::IEventInfo)
 
         virtual StatusCode initialize();
+        virtual StatusCode finalize();
         virtual StatusCode LoadInfo();
         virtual StatusCode SetSystematic(const CP::SystematicSet* set);
 
@@ -86,6 +89,7 @@ namespace XAMPP {
 
         virtual double GetGenWeight(unsigned int idx = 0) const;
         virtual double GetRawGenWeight(unsigned int idx = 0) const;
+        virtual unsigned int GetGenWeights(std::vector<double>& weights) const;
         virtual StatusCode CopyInfoFromNominal(const CP::SystematicSet* To);
 
         virtual bool isLocked() const;
@@ -104,13 +108,22 @@ namespace XAMPP {
 
     private:
         StatusCode FindPrimaryVertex();
-        StatusCode GetInfoFromStore(const CP::SystematicSet* set);
+        // Creates the shallow copies of the EventInfo for all kinematic systematics of the event
+        StatusCode CreateInfoSlots();
+        xAOD::EventInfo* GetInfoSlot(const CP::SystematicSet* set) const;
         bool returnStorage(IStorage* store, unsigned int bit_mask) const;
 
         double GetPeriodWeight();
         StatusCode RunPRWTool();
+        // Decorates the event with the cached prw results. Returns false if the configuration is not yet known
+        bool LoadPRWFromCache(const CP::SystematicSet* set);
+        void SavePRWToCache(const CP::SystematicSet* set);
+        StatusCode ValidatePRWCache(const CP::SystematicSet* set);
         const xAOD::EventInfo* m_ConstEvtInfo;
         xAOD::EventInfo* m_EvtInfo;
+        // One copy per kinematic systematic indexed by ISystematics::GetKinematicOrdinal
+        std::vector<xAOD::EventInfo*> m_InfoSlots;
+        std::vector<std::string> m_InfoSlotNames;
         const xAOD::Vertex* m_primaryVtx;
 
         const CP::SystematicSet* m_ActSys;
@@ -120,6 +133,7 @@ namespace XAMPP {
         bool m_ApplyPRW;
         bool m_ApplyGRL;
         bool m_Init;
+        bool m_Finalized;
         bool m_Locked;
         bool m_Filter;
         bool m_RecoFlags;
@@ -131,6 +145,40 @@ namespace XAMPP {
             XAMPP::Storage<unsigned int>* RandomLumiBlock;
         };
         std::map<const CP::SystematicSet*, PileUpDecorators> m_DecPup;  // PileupWeight
+
+        // The pile-up weight and the corrected mu only depend on the inputs below.
+        // The mu is compared via its bit pattern
+        struct PRWCacheKey {
+            int mcChannelNumber;
+            unsigned int runNumber;
+            unsigned int lumiBlock;
+            unsigned int muBits;
+            const CP::SystematicSet* systematic;
+            bool operator==(const PRWCacheKey& other) const;
+        };
+        struct PRWCacheKeyHash {
+            size_t operator()(const PRWCacheKey& key) const;
+        };
+        struct PRWCacheEntry {
+            float PileupWeight;
+            float CorrectedMu;
+            bool hasPileupWeight;
+            bool hasCorrectedMu;
+        };
+        PRWCacheKey MakePRWCacheKey(const CP::SystematicSet* set) const;
+        bool m_CachePRW;
+        bool m_ValidatePRWCache;
+        size_t m_PRWCacheSize;
+        std::unordered_map<PRWCacheKey, PRWCacheEntry, PRWCacheKeyHash> m_PRWCache;
+        unsigned long long m_PRWCacheHits;
+        unsigned long long m_PRWCacheMisses;
+
+        // Decide the GRL from the interval lookup built from the xml files instead of the tool
+        bool m_UseGRLLookup;
+        bool m_ValidateGRLLookup;
+        std::vector<std::string> m_GoodRunsLists;
+        std::string m_GRLLookupCache;
+        std::unique_ptr<GoodRunsLookup> m_GRLLookup;
         XAMPP::Storage<int>* m_nNVtx;
         XAMPP::Storage<char>* m_PassGRL;
         XAMPP::Storage<char>* m_PassLArTile;
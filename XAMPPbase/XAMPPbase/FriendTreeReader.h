@@ -0,0 +1,133 @@
+#ifndef XAMPPbase_FriendTreeReader_H
+#define XAMPPbase_FriendTreeReader_H
+
+#include <TBranch.h>
+#include <TError.h>
+#include <TFile.h>
+#include <TTree.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+//###############################################################################
+//  Reader of the XAMPP ntuples which joins a tree with its friends, i.e. the   #
+//  common tree and the trees of the systematic groups, on the CommonEventHash. #
+//  For each friend an open-addressing hash table from the CommonEventHash to   #
+//  the entry is built once. It is persisted as sidecar file next to the ROOT   #
+//  file (<file>.<tree>.hashidx) and is reused as long as the UUID of the ROOT  #
+//  file does not change. Only the branches requested via column() are read.   #
+//  The columns point to the buffers the branches are bound to, so no values    #
+//  are copied per entry. The friend indices are shared if several readers are  #
+//  created for the same file, e.g. one per systematic tree. The friends which  #
+//  the TreeBase registered to the tree in ROOT are removed by Init(), so they  #
+//  are only read at the entries found via the index.                           #
+//###############################################################################
+namespace XAMPP {
+    class EventHashIndex {
+    public:
+        EventHashIndex();
+        // Reads the CommonEventHash branch of the tree
+        bool build(TTree* tree);
+        bool save(const std::string& path, const std::string& uuid) const;
+        // Returns false if the file does not exist or was created for another file or tree
+        bool load(const std::string& path, const std::string& uuid, Long64_t entries);
+
+        // Returns -1 if the event is not part of the tree
+        Long64_t find(ULong64_t hash0, ULong64_t hash1) const;
+        Long64_t entries() const;
+        size_t memory() const;
+
+    private:
+        size_t slot(ULong64_t hash0, ULong64_t hash1) const;
+
+        Long64_t m_entries;
+        size_t m_mask;
+        // Two words of the CommonEventHash per slot
+        std::vector<ULong64_t> m_keys;
+        // Entry of the tree per slot, -1 for empty slots
+        std::vector<Long64_t> m_values;
+    };
+
+    class FriendTreeReader {
+    public:
+        FriendTreeReader(TFile* file, const std::string& tree_name, const std::string& index_dir = "");
+        ~FriendTreeReader() = default;
+        bool addFriend(const std::string& tree_name);
+        bool Init();
+
+        Long64_t GetEntries() const;
+        // Loads the entry of the tree and the corresponding entries of the friends
+        bool GetEntry(Long64_t entry);
+        // Whether the current event is contained in the friend tree
+        bool hasFriendEntry(const std::string& tree_name) const;
+
+        // Returns the buffer of the branch which is updated by each GetEntry call. The branch is searched in the tree first and then
+        // in the friends. A nullptr is returned if the branch does not exist or if its type does not match. The columns of a friend
+        // are only valid if the current event is contained in the friend tree
+        template <class T> const T* column(const std::string& branch) {
+            Source* source = findSource(branch);
+            if (!source) return nullptr;
+            std::map<std::string, std::unique_ptr<IColumn>>::iterator itr = source->columns.find(branch);
+            if (itr != source->columns.end()) {
+                Column<T>* existing = dynamic_cast<Column<T>*>(itr->second.get());
+                return existing ? existing->value() : nullptr;
+            }
+            Column<T>* col = new Column<T>();
+            source->tree->SetBranchStatus(branch.c_str(), 1);
+            if (col->bind(source->tree, branch) < 0) {
+                Error("FriendTreeReader::column()", "Failed to connect %s of %s", branch.c_str(), source->tree->GetName());
+                delete col;
+                return nullptr;
+            }
+            source->columns[branch] = std::unique_ptr<IColumn>(col);
+            return col->value();
+        }
+
+    private:
+        class IColumn {
+        public:
+            virtual ~IColumn() = default;
+        };
+        template <class T, bool Fundamental = std::is_fundamental<T>::value> class Column : public IColumn {
+        public:
+            Column() : m_value() {}
+            Int_t bind(TTree* tree, const std::string& branch) { return tree->SetBranchAddress(branch.c_str(), &m_value); }
+            const T* value() const { return &m_value; }
+
+        private:
+            T m_value;
+        };
+        // Objects need to be connected via a pointer to the pointer
+        template <class T> class Column<T, false> : public IColumn {
+        public:
+            Column() : m_value(), m_ptr(&m_value) {}
+            Int_t bind(TTree* tree, const std::string& branch) { return tree->SetBranchAddress(branch.c_str(), &m_ptr); }
+            const T* value() const { return &m_value; }
+
+        private:
+            T m_value;
+            T* m_ptr;
+        };
+        struct Source {
+            TTree* tree;
+            std::shared_ptr<EventHashIndex> index;
+            Long64_t entry;
+            std::map<std::string, std::unique_ptr<IColumn>> columns;
+        };
+        Source* findSource(const std::string& branch);
+        std::shared_ptr<EventHashIndex> friendIndex(TTree* tree);
+
+        TFile* m_file;
+        std::string m_indexDir;
+        Source m_main;
+        std::vector<std::unique_ptr<Source>> m_friends;
+        ULong64_t m_hash[2];
+        bool m_init;
+        // Indices of the friends shared among the readers of the same file
+        static std::map<std::string, std::weak_ptr<EventHashIndex>> m_indexCache;
+    };
+}  // namespace XAMPP
+#endif
@@ -0,0 +1,67 @@
+#ifndef XAMPPbase_GoodRunsLookup_H
+#define XAMPPbase_GoodRunsLookup_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+//###############################################################################
+//  Compact representation of the good runs lists                               #
+//  The lumi block ranges of the GRL xml files are merged (logical OR as in     #
+//  the GoodRunsListSelectionTool) into sorted and disjoint intervals per run.  #
+//  The runs and their intervals are stored in flat arrays. The lookup          #
+//  remembers the last lumi block interval on which the decision is constant,   #
+//  either a good range or the gap between two of them. As the data are sorted  #
+//  by run and lumi block, nearly all queries are answered by the comparison    #
+//  with this interval.                                                         #
+//  Optionally, the parsed intervals are stored in a binary cache file which    #
+//  is shared across the jobs. It is identified by the paths, sizes and         #
+//  modification times of the xml files and protected by a checksum.           #
+//###############################################################################
+namespace XAMPP {
+    class GoodRunsLookup {
+    public:
+        GoodRunsLookup();
+        ~GoodRunsLookup() = default;
+
+        // Builds the lookup from the xml files. An empty cache path disables the binary cache
+        bool load(const std::vector<std::string>& xml_files, const std::string& cache_file = "");
+
+        bool passRunLB(unsigned int run, unsigned int lumi_block) const;
+
+        std::vector<unsigned int> runs() const;
+        size_t nIntervals() const;
+
+        // Number of queries and the number of them answered by the last interval
+        unsigned long long nQueries() const;
+        unsigned long long nLastHits() const;
+
+    private:
+        // First and last lumi block of the range. Both are included
+        struct LumiRange {
+            unsigned int first;
+            unsigned int last;
+        };
+        // Run number and the lumi block range of one LBRange entry
+        typedef std::pair<unsigned int, std::pair<unsigned int, unsigned int>> RunRange;
+
+        bool parseXML(const std::string& xml_file, std::vector<RunRange>& ranges) const;
+        void build(std::vector<RunRange>& ranges);
+
+        bool readCache(const std::string& cache_file, size_t source_hash);
+        bool writeCache(const std::string& cache_file, size_t source_hash) const;
+
+        // Sorted run numbers. The intervals of run i are m_ranges[m_offsets[i]] ... m_ranges[m_offsets[i+1] - 1]
+        std::vector<unsigned int> m_runs;
+        std::vector<unsigned int> m_offsets;
+        std::vector<LumiRange> m_ranges;
+
+        mutable bool m_hasLast;
+        mutable unsigned int m_lastRun;
+        mutable LumiRange m_lastRange;
+        mutable bool m_lastDecision;
+        mutable unsigned long long m_queries;
+        mutable unsigned long long m_lastHits;
+    };
+}  // namespace XAMPP
+#endif
@@ -24,6 +24,8 @@ namespace XAMPP {
         virtual StatusCode FillObjects(const CP::SystematicSet* systset) = 0;
         virtual StatusCode CheckCutFlow(const CP::SystematicSet* systset) = 0;
         virtual StatusCode finalize() = 0;
+        // Called by the algorithm each time a new input file is opened
+        virtual StatusCode beginInputFile(const std::string& guid) = 0;
 
         virtual bool CheckTrigger() = 0;
 
@@ -22,6 +22,8 @@ namespace XAMPP {
         };
 
         virtual StatusCode initialize() = 0;
+        // Called by the analysis helper after the event loop
+        virtual StatusCode finalize() = 0;
         virtual StatusCode LoadInfo() = 0;
         // sets the current systematic such that the underlying variables
         // and branches can be filled
@@ -54,6 +56,9 @@ namespace XAMPP {
         virtual double GetGenWeight(unsigned int idx = 0) const = 0;
         // the the MC generator weight *without* applying the outlier correction
         virtual double GetRawGenWeight(unsigned int idx = 0) const = 0;
+        // all MC generator weights of the event in one go with the outlier correction applied.
+        // Returns the number of outlier weights
+        virtual unsigned int GetGenWeights(std::vector<double>& weights) const = 0;
 
         /// Propagation of the luminosity to the meta-data
         virtual double GetPileUpLuminosity() = 0;
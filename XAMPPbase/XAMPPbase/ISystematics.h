@@ -16,9 +16,13 @@ namespace XAMPP {
     class ISystematicToolService {
     public:
         virtual StatusCode resetSystematic() = 0;
+        // Applies the set to the tool. The ISystematics tool only calls the method if the tool
+        // is affected by the set or if the tool needs to be switched back to nominal
         virtual StatusCode setSystematic(const CP::SystematicSet* Set) = 0;
         virtual StatusCode initialize() = 0;
         virtual std::string name() const = 0;
+        // Evaluated once per systematic set when the systematics are fixed
+        virtual bool isAffectedBySystematic(const CP::SystematicSet*) const { return true; }
         virtual ~ISystematicToolService() {}
     };
     class ISystematics : virtual public asg::IAsgTool {
@@ -47,8 +51,14 @@ namespace XAMPP {
                                                   XAMPP::SelectionObject T = XAMPP::SelectionObject::Other) = 0;
         virtual StatusCode InsertSystematicToolService(ISystematicToolService* Service) = 0;
 
+        // Position of the set in GetKinematicSystematics() assigned in FixSystematics.
+        // Returns -1 if the set does not affect the kinematics
+        virtual int GetKinematicOrdinal(const CP::SystematicSet* Set) const = 0;
+
         virtual bool SystematicsFixed() const = 0;
         virtual StatusCode FixSystematics() = 0;
+        // Prints how often the systematic was switched and how many tools were reconfigured
+        virtual void PrintSwitchSummary() const = 0;
         virtual ~ISystematics() {}
     };
 
@@ -0,0 +1,95 @@
+#ifndef XAMPPbase_MT2Solver_H
+#define XAMPPbase_MT2Solver_H
+
+#include <cstddef>
+#include <vector>
+
+//###############################################################################
+//  Solver of the asymmetric stransverse mass                                   #
+//     mt2 = min_{q1 + q2 = pmiss} max( mT(a, q1, mInvA), mT(b, q2, mInvB) )    #
+//  The inputs are rescaled to O(1) before the minimization. Three paths exist: #
+//   - Massless visible and invisible particles: The balanced solution is the   #
+//     root of a quartic polynomial in tan(beta), where beta is the axis which  #
+//     reflects the visible momenta onto the invisible ones. The quartic is     #
+//     solved in closed form.                                                   #
+//   - Unbalanced solution: One side is at its minimum mVis + mInv while the    #
+//     other side is below this value. Checked in closed form                   #
+//   - General case: Bisection in mt2. At each step the two ellipses of         #
+//     mT <= mt2 are tested for an overlap via the characteristic cubic         #
+//     det(lambda A + B). They are disjoint iff it has two distinct positive    #
+//     roots. The lower edge of the bracket is the unbalanced bound, the upper  #
+//     edge is the best of a few trial splits of pmiss, among them the massless #
+//     solution.                                                                #
+//  The batched interface processes the configurations in structure-of-arrays   #
+//  form. The bisection steps are executed in lockstep such that the inner loop #
+//  is free of branches and can be vectorized by the compiler. The solver has   #
+//  no mutable state and can be shared across threads. The scratch space of the #
+//  batched bisection is owned by the caller.                                   #
+//###############################################################################
+namespace XAMPP {
+    struct MT2Batch {
+        void clear();
+        void reserve(size_t n);
+        size_t size() const;
+        void add(double ma, double pxa, double pya, double mb, double pxb, double pyb, double pxmiss, double pymiss, double mInvA = 0.,
+                 double mInvB = 0.);
+
+        std::vector<double> ma;
+        std::vector<double> pxa;
+        std::vector<double> pya;
+        std::vector<double> mb;
+        std::vector<double> pxb;
+        std::vector<double> pyb;
+        std::vector<double> pxmiss;
+        std::vector<double> pymiss;
+        std::vector<double> mInvA;
+        std::vector<double> mInvB;
+    };
+
+    class MT2Solver {
+    private:
+        struct Problem;
+
+    public:
+        // Scratch space of the batched bisection in structure-of-arrays form. Reuse it across
+        // the calls of one thread to avoid the allocations
+        class Scratch {
+        private:
+            friend class MT2Solver;
+            void clear();
+            void add(const Problem& P, size_t idx);
+            std::vector<size_t> index;
+            std::vector<double> scale, ma, ax, ay, mb, bx, by, px, py, ca, cb, lo, hi;
+        };
+
+        // The precision is relative to the value of mt2
+        MT2Solver(double precision = 1.e-7);
+        double precision() const;
+
+        double compute(double ma, double pxa, double pya, double mb, double pxb, double pyb, double pxmiss, double pymiss, double mInvA = 0.,
+                       double mInvB = 0.) const;
+        // Results are written to result[i] for each configuration i of the batch
+        void compute(const MT2Batch& batch, std::vector<double>& result) const;
+        void compute(const MT2Batch& batch, std::vector<double>& result, Scratch& scratch) const;
+
+        // Closed form solution if the visible and invisible particles are massless.
+        // Returns -1 if the configuration is degenerate, i.e. the visible momenta are collinear
+        static double computeMassless(double pxa, double pya, double pxb, double pyb, double pxmiss, double pymiss);
+
+    private:
+        // Configuration rescaled to O(1) together with the bisection bracket
+        struct Problem {
+            double scale;
+            double ma, ax, ay, mb, bx, by, px, py, ca, cb;
+            double lo, hi;
+        };
+        // Rescales the configuration and tries the closed form solutions. Returns true if the problem is solved.
+        // Otherwise the bracket of the bisection is defined
+        bool prepare(Problem& P, double ma, double pxa, double pya, double mb, double pxb, double pyb, double pxmiss, double pymiss,
+                     double mInvA, double mInvB) const;
+        unsigned int iterations(const Problem& P) const;
+
+        double m_precision;
+    };
+}  // namespace XAMPP
+#endif
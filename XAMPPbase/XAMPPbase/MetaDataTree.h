@@ -32,6 +32,8 @@ namespace XAMPP {
         virtual StatusCode beginEvent() = 0;
         virtual StatusCode finalize() = 0;
         virtual StatusCode fillLHEMetaData(unsigned int Idx) = 0;
+        // Adds all variational weights of the event at once. The first element is the nominal weight and skipped
+        virtual StatusCode fillLHEMetaData(const std::vector<double>& weights) = 0;
         virtual void subtractEventFromMetaData() = 0;
         virtual void subtractEventFromMetaData(unsigned int index) = 0;
 
@@ -53,9 +55,15 @@ namespace XAMPP {
         virtual StatusCode finalize(TTree* MetaDataTree) = 0;
         virtual StatusCode CopyStore(const MetaDataElement* Store) = 0;
         virtual StatusCode fillVariation(unsigned int, double) = 0;
+        virtual StatusCode fillVariations(const std::vector<double>& weights, unsigned int finalState) = 0;
 
         void setLHEWeightNames(const std::vector<std::string>& weights);
         size_t numOfWeights() const;
+        // In the multi-process mode each input file is read by several workers. Only
+        // one of them adds the file information (i.e. the CutBookkeeper sums) to its
+        // meta-data. The others only keep track that the information is available
+        void setBookFileInformation(bool B);
+        bool bookFileInformation() const;
         virtual void SubtractEvent(unsigned int, double) {}
 
     protected:
@@ -93,6 +101,7 @@ namespace XAMPP {
 
         ToolHandle<XAMPP::IEventInfo> m_XAMPPInfo;
         std::vector<std::string> m_LHE_WeightNames;
+        bool m_bookFileInfo;
     };
 
     class MetaDataTree : public asg::AsgMetadataTool, virtual public IMetaDataTree {
@@ -107,15 +116,25 @@ namespace XAMPP {
         virtual StatusCode finalize();
         virtual StatusCode initialize();
         virtual StatusCode fillLHEMetaData(unsigned int Idx);
+        virtual StatusCode fillLHEMetaData(const std::vector<double>& weights);
         virtual void subtractEventFromMetaData();
         virtual void subtractEventFromMetaData(unsigned int ix);
 
         virtual std::vector<std::string> getLHEWeightNames() const;
 
+#ifndef XAOD_STANDALONE
+        // Catch the GUID of the file before the incident is passed to beginInputFile
+        virtual void handle(const Incident& inc);
+#endif
+
     private:
         void LoadMCMetaData(unsigned int mcChannel, unsigned int periodNumber);
         void LoadRunMetaData(unsigned int run);
         StatusCode CheckLumiBlockContainer(const std::string& Container, bool& HasCont);
+        StatusCode BookInputFile();
+        // Returns true if this process is the first one to read the current file
+        bool ClaimInputFile() const;
+        bool isParallelMother() const;
         std::string m_TreeName;
         bool m_UseFileMetaData;
         bool m_fillLHEWeights;
@@ -127,6 +146,14 @@ namespace XAMPP {
 
         bool m_isData;
         bool m_init;
+        // Shared directory in which the workers of a multi-process job claim the input files
+        std::string m_claimDir;
+        // Process ID of the mother process which forks the workers
+        int m_motherPID;
+        std::string m_currentFile;
+        std::string m_currentFileName;
+        std::string m_pendingFile;
+        bool m_bookCurrentFile;
         ToolHandle<XAMPP::IAnalysisHelper> m_analysis_helper;
         asg::AnaToolHandle<XAMPP::IEventInfo> m_XAMPPInfo;
         //  In order to disentangle mc16a from mc16c the code must ensure that
@@ -152,6 +179,7 @@ namespace XAMPP {
         virtual StatusCode finalize(TTree* MetaDataTree);
         virtual StatusCode CopyStore(const MetaDataElement* Store);
         virtual StatusCode fillVariation(unsigned int Id, double W);
+        virtual StatusCode fillVariations(const std::vector<double>& weights, unsigned int finalState);
         virtual ~MetaDataMC();
         virtual void SubtractEvent(unsigned int Id, double W);
 
@@ -191,11 +219,13 @@ namespace XAMPP {
             // prw information to be propagated into the meta-data
             double luminosity;
         };
-        void AddEventInformation(std::shared_ptr<MetaDataMC::MetaData> Meta, double GenWeight);
+        void AddEventInformation(const std::shared_ptr<MetaDataMC::MetaData>& Meta, double GenWeight);
         void AddFileInformation(std::shared_ptr<MetaDataMC::MetaData> Meta, Long64_t TotEv, double SumW, double SumW2);
         void SubtractEvent(std::shared_ptr<MetaDataMC::MetaData> Meta, double GenWeight);
 
         void LoadMetaData(unsigned int ID);
+        // Meta data of the LHE variations indexed by the weight index. Resolved once per final state
+        const std::vector<std::shared_ptr<MetaDataMC::MetaData>>& LoadVariations(unsigned int finalState, size_t nWeights);
         bool SaveMetaDataInTree(std::shared_ptr<MetaDataMC::MetaData> Meta, TTree* tree);
 
         unsigned int m_MC;
@@ -204,6 +234,7 @@ namespace XAMPP {
         std::map<unsigned int, std::shared_ptr<MetaDataMC::MetaData>> m_Data;
         std::map<unsigned int, std::shared_ptr<MetaDataMC::MetaData>>::iterator m_ActMeta;
         std::shared_ptr<MetaDataMC::MetaData> m_Inclusive;
+        std::map<unsigned int, std::vector<std::shared_ptr<MetaDataMC::MetaData>>> m_Variations;
         bool m_init;
     };
     class runMetaData : virtual public MetaDataElement {
@@ -216,6 +247,7 @@ namespace XAMPP {
         virtual StatusCode finalize(TTree* MetaDataTree);
         virtual StatusCode CopyStore(const MetaDataElement* Store);
         virtual StatusCode fillVariation(unsigned int, double);
+        virtual StatusCode fillVariations(const std::vector<double>&, unsigned int);
 
         virtual ~runMetaData();
 
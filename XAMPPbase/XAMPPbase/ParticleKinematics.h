@@ -0,0 +1,97 @@
+#ifndef XAMPPbase_ParticleKinematics_H
+#define XAMPPbase_ParticleKinematics_H
+
+#include <xAODBase/IParticleContainer.h>
+#include <xAODMissingET/MissingET.h>
+
+#include <vector>
+
+//###############################################################################
+//  Kinematics of a particle container in structure-of-arrays form             #
+//  The pt, eta, phi, m and the cartesian momenta of each particle are read     #
+//  once via the IParticle interface and stored in contiguous arrays. The       #
+//  charge and the flavour need aux-store lookups and are extracted on the      #
+//  first request. The pairwise and container-wide helpers of AnalysisUtils     #
+//  (invariant masses, mt, Z veto, ...) loop over these arrays instead of       #
+//  calling the virtual p4() for each combination.                              #
+//  The arithmetic follows the one of TLorentzVector in the same order, hence   #
+//  the results are identical to the ones of the per-particle implementations. #
+//  The cartesian components are taken from p4() to reproduce the rounding of   #
+//  the object specific four-momenta.                                           #
+//  Fill the object once per event and systematic and query it as often as     #
+//  needed. The buffers are reused between the events.                          #
+//###############################################################################
+namespace XAMPP {
+    class ParticleKinematics {
+    public:
+        ParticleKinematics();
+        ~ParticleKinematics() = default;
+
+        // Particles which are also in the exclusion container are skipped
+        void fill(const xAOD::IParticleContainer* particles, const xAOD::IParticleContainer* exclude = nullptr);
+        void clear();
+
+        size_t size() const;
+        const xAOD::IParticle* particle(size_t i) const;
+
+        const double* pt() const;
+        const double* eta() const;
+        const double* phi() const;
+        const double* m() const;
+        const double* px() const;
+        const double* py() const;
+        const double* pz() const;
+        const double* e() const;
+        const float* charge() const;
+        const int* pdgId() const;
+
+        // Identical to the IParticle based functions of AnalysisUtils
+        float InvariantMass(size_t i, size_t j) const;
+        float InvariantMass(size_t i, size_t j, size_t k) const;
+        float InvariantMass(size_t i, size_t j, size_t k, size_t l) const;
+
+        float ComputeMt(size_t i, const xAOD::MissingET* met) const;
+        float ComputeMt(size_t i, const xAOD::IParticle* P) const;
+
+        bool IsSFOS(size_t i, size_t j) const;
+
+        // Index of the particle with the smallest (largest) |dPhi| to the angle. Returns -1 for an empty container
+        int ClosestInPhi(double phi) const;
+        int FarestInPhi(double phi) const;
+
+        float ComputeMtMin(const xAOD::MissingET* met) const;
+        float ComputeMtMin(const xAOD::IParticle* P) const;
+        float ComputeMtMax(const xAOD::MissingET* met) const;
+        float ComputeMtMax(const xAOD::IParticle* P) const;
+        // Signed dPhi between the met and the closest of the first NToUse particles
+        float ComputeDPhiMin(const xAOD::MissingET* met, unsigned int NToUse = 0) const;
+
+        int GetZVeto(float Z_Window) const;
+        float CalculateHt(float MinPt = 0.) const;
+        // Decorates passLMR = false to the pairs passing the overlap removal with Lower_Mll < mll < Upper_Mll
+        void RemoveLowMassLeptons(bool (*pair)(const xAOD::IParticle*, const xAOD::IParticle*), float Upper_Mll, float Lower_Mll) const;
+
+    private:
+        // The sum of the four-momenta is built from left to right like TLorentzVector::operator+
+        float Mass(double px, double py, double pz, double e) const;
+        void FillFlavour() const;
+
+        std::vector<const xAOD::IParticle*> m_particles;
+        std::vector<double> m_pt;
+        std::vector<double> m_eta;
+        std::vector<double> m_phi;
+        std::vector<double> m_m;
+        std::vector<double> m_px;
+        std::vector<double> m_py;
+        std::vector<double> m_pz;
+        std::vector<double> m_e;
+        mutable bool m_hasFlavour;
+        mutable std::vector<float> m_charge;
+        mutable std::vector<int> m_pdgId;
+        // Particles of the same flavour share the code. -1 if the particle has no lepton flavour
+        mutable std::vector<int> m_flavour;
+        // Pairwise same-flavour opposite-sign flags, filled on demand by GetZVeto
+        mutable std::vector<char> m_sfos;
+    };
+}  // namespace XAMPP
+#endif
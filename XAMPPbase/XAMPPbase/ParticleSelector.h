@@ -11,6 +11,7 @@
 #include <XAMPPbase/Defs.h>
 #include <xAODBase/ObjectType.h>
 #include <xAODCore/ShallowCopy.h>
+#include <map>
 #include <memory>
 
 namespace CP {
@@ -188,7 +189,17 @@ namespace XAMPP {
         // from this selector into the store gate
         const std::string& StoreName() const;
         // Current systematic name set by SetSystematics
-        std::string SystName(bool InclUnderScore = true) const;
+        const std::string& SystName(bool InclUnderScore = true) const;
+
+        // StoreGate keys derived from a container key. They are assembled once per
+        // systematic and then reused in each event instead of concatenating the strings
+        // over and over again
+        struct StoreKeys {
+            std::string view;      // Key + StoreName()
+            std::string link;      // StoreName() + "_" + Key
+            std::string link_aux;  // StoreName() + "_" + Key + "Aux."
+        };
+        const StoreKeys& GetStoreKeys(const std::string& Key, const CP::SystematicSet* Set) const;
 
         // Is a given systematic affecting the kinemtic of this
         // Particle type. Known systematics are distributed from
@@ -212,6 +223,12 @@ namespace XAMPP {
         ParticleSelector::LinkStatus CreateContainerLinks(const std::string& Key, Container*& Cont,
                                                           xAOD::ShallowAuxContainer*& AuxContainer, bool linkOriginal = true);
 
+        // Interface to the CalibrationCache. RestoreCalibration returns true if the calibrated
+        // variables of the freshly created shallow copy could be read back from the cache. Otherwise
+        // the CP tools need to be called and the result is saved via CacheCalibration afterwards
+        bool RestoreCalibration(const std::string& Key, xAOD::IParticleContainer& Cont) const;
+        StatusCode CacheCalibration(const std::string& Key, const xAOD::IParticleContainer& Cont, const xAOD::ShallowAuxContainer& AuxCont);
+
         //
         // Helper method to store the particle weights
         //
@@ -259,6 +276,8 @@ namespace XAMPP {
         const CP::SystematicSet* m_ActSys;
         std::string m_ContainerKey;
         std::string m_storeName;
+        std::string m_systName;
+        mutable std::map<const CP::SystematicSet*, std::map<std::string, StoreKeys>> m_storeKeys;
         SelectionObject m_ObjectType;
         bool m_init;
 
@@ -283,6 +302,10 @@ namespace XAMPP {
         SelectionDecorator m_dec_ORUtils_in;
         int m_ORUtils_InFlag;
         mutable bool m_syst_checked;
+        // Kinematic systematics affecting this selector. Cached once the systematics are fixed
+        mutable std::vector<const CP::SystematicSet*> m_affectingSyst;
+        // The list may be empty if no kinematic systematic affects the selector
+        mutable bool m_affectingSystCached;
         std::vector<XAMPP::Storage<double>*> m_eventSFstores;
         bool m_WriteSFperParticle;
         asg::AnaToolHandle<XAMPP::IEventInfo> m_EvInfoHandle;
@@ -19,7 +19,7 @@ namespace XAMPP {
         }
         ATH_MSG_DEBUG("Create new SG::VIEW_ELEMENTS container for " << Key);
         Cont = new Container(SG::VIEW_ELEMENTS);
-        return evtStore()->record(Cont, Key + StoreName());
+        return evtStore()->record(Cont, GetStoreKeys(Key, m_ActSys).view);
     }
     template <typename Container>
     StatusCode ParticleSelector::LoadViewElementsContainer(const std::string& Key, Container*& Cont, bool LoadNominal) const {
@@ -29,9 +29,9 @@ namespace XAMPP {
         }
         if (LoadNominal) {
             ATH_MSG_DEBUG("Load nominal SG::VIEW_ELEMENTS container " << Key);
-            return LoadContainer(Key + name(), Cont);
+            return LoadContainer(GetStoreKeys(Key, m_systematics->GetNominal()).view, Cont);
         }
-        return LoadContainer(Key + StoreName(), Cont);
+        return LoadContainer(GetStoreKeys(Key, m_ActSys).view, Cont);
     }
     template <typename Container> StatusCode ParticleSelector::LoadContainer(const std::string& Key, const Container*& Cont) const {
         if (!isInitialized()) {
@@ -75,13 +75,15 @@ namespace XAMPP {
     ParticleSelector::LinkStatus ParticleSelector::CreateContainerLinks(const std::string& Key, Container*& Cont,
                                                                         xAOD::ShallowAuxContainer*& AuxContainer, bool linkOriginal) {
         if (!checkForValidSystematics()) return ParticleSelector::LinkStatus::Failed;
-        std::string storeName = StoreName() + "_" + Key;
-        std::string nominalStore = name() + "_" + Key;
+        const StoreKeys& storeKeys = GetStoreKeys(Key, m_ActSys);
+        const StoreKeys& nominalKeys = GetStoreKeys(Key, m_systematics->GetNominal());
+        const std::string& storeName = storeKeys.link;
+        const std::string& nominalStore = nominalKeys.link;
         // All calibrated containers are stored in the event store
         // Check if the container is already stored
         if (evtStore()->contains<Container>(storeName)) {
             ATH_MSG_DEBUG("Container " << storeName << " is already in the StoreGate. Load this container instead");
-            if (!LoadContainer(storeName, Cont).isSuccess() || !LoadContainer(storeName + "Aux.", AuxContainer).isSuccess())
+            if (!LoadContainer(storeName, Cont).isSuccess() || !LoadContainer(storeKeys.link_aux, AuxContainer).isSuccess())
                 return ParticleSelector::LinkStatus::Failed;  // Failed to retrieve Container
             return ParticleSelector::LinkStatus::Loaded;      // The container is
                                                               // loaded from the
@@ -92,7 +94,7 @@ namespace XAMPP {
         else if (!SystematicAffects(m_ActSys) && evtStore()->contains<Container>(nominalStore)) {
             ATH_MSG_DEBUG("Current systemtatic " << SystName(false) << " does not affect container " << Key
                                                  << ". Load the nominal Container");
-            if (!LoadContainer(nominalStore, Cont).isSuccess() || !LoadContainer(nominalStore + "Aux.", AuxContainer).isSuccess())
+            if (!LoadContainer(nominalStore, Cont).isSuccess() || !LoadContainer(nominalKeys.link_aux, AuxContainer).isSuccess())
                 return ParticleSelector::LinkStatus::Failed;  // Failed to
                                                               // retrieve
                                                               // Container
@@ -109,7 +111,7 @@ namespace XAMPP {
             ATH_MSG_ERROR("Failed to set original object links on " << Key);
             return ParticleSelector::LinkStatus::Failed;
         }
-        if (!evtStore()->record(Cont, storeName).isSuccess() || !evtStore()->record(AuxContainer, storeName + "Aux.").isSuccess()) {
+        if (!evtStore()->record(Cont, storeName).isSuccess() || !evtStore()->record(AuxContainer, storeKeys.link_aux).isSuccess()) {
             ATH_MSG_ERROR("Failed to parse the containers to the Store Gate");
             return ParticleSelector::LinkStatus::Failed;
         }
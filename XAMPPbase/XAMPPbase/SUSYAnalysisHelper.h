@@ -2,6 +2,7 @@
 #define XAMPPbase_SUSYAnalysisHelper_H
 
 #include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/CrossSectionTable.h>
 #include <XAMPPbase/IAnalysisHelper.h>
 #include <XAMPPbase/IAnalysisModule.h>
 
@@ -67,6 +68,7 @@ namespace XAMPP {
         virtual StatusCode initialize();
         virtual StatusCode CheckCutFlow(const CP::SystematicSet* systset);
         virtual StatusCode finalize();
+        virtual StatusCode beginInputFile(const std::string& guid);
         virtual StatusCode LoadContainers();
         virtual StatusCode FillInitialObjects(const CP::SystematicSet* systset);
         virtual StatusCode FillObjects(const CP::SystematicSet* systset);
@@ -119,6 +121,11 @@ namespace XAMPP {
         StatusCode SaveCrossSection();
 
     private:
+        // Entry of the compiled cross-section snapshot or nullptr if the process has to be looked up in the text database
+        const CrossSectionTable::Entry* FindXsecEntry(unsigned int mc_channel_number, unsigned int finalState) const;
+        SUSY::CrossSectionDB* XsecTextDB();
+        bool ValidateXsecSnapshot() const;
+
         ServiceHandle<ITHistSvc> m_histSvc;
 
     protected:
@@ -180,9 +187,16 @@ namespace XAMPP {
         bool m_CleanBadJet;
 
         bool m_FillLHEWeights;
+        bool m_LHEWeightsAsVector;
         bool m_shiftMetaDSID;
+        std::string m_FileClaimDir;
+        int m_MotherPID;
 
         std::map<unsigned int, XAMPP::Storage<double>*> m_LHEWeights;
+        // All generator weights of the event in one branch, indexed like EventInfo::mcEventWeights()
+        XAMPP::Storage<std::vector<double>>* m_LHEWeightVector;
+        std::vector<double> m_LHEGenWeights;
+        unsigned int m_LHEOutliers;
         XAMPP::Storage<int>* m_dec_NumBadMuon;
         XAMPP::Storage<int>* m_decNumBadJet;
         XAMPP::Storage<int>* m_decNumCosmicMuon;
@@ -195,9 +209,25 @@ namespace XAMPP {
         std::vector<std::string> m_PRWLumiCalcFiles;
 
         bool m_useXsecPMGTool;
+        std::string m_CalibCacheDir;
+        bool m_CalibCacheWeights;
+        size_t m_ConfigHash;
+        bool m_AsyncTrees;
+        unsigned int m_AsyncQueueSize;
+        std::string m_NominalTreeCompression;
+        std::string m_SystTreeCompression;
+        int m_NominalTreeAutoFlush;
+        int m_SystTreeAutoFlush;
+        bool m_DeltaSystTrees;
+        std::string m_StartupSnapshot;
         std::string m_XsecPMGToolFile;
+        std::string m_XsecSnapshot;
+        bool m_ValidateXsecSnapshot;
 
         std::unique_ptr<SUSY::CrossSectionDB> m_XsecDB;
+        std::unique_ptr<CrossSectionTable> m_XsecTable;
+        // Text files of the database. Parsed on demand if a process is missing in the snapshot
+        std::vector<std::string> m_XsecFiles;
 
         std::map<const CP::SystematicSet*, std::shared_ptr<HistoBase>> m_histoVec;
         std::map<const CP::SystematicSet*, std::shared_ptr<TreeBase>> m_treeVec;
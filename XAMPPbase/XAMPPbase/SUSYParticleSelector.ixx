@@ -16,7 +16,10 @@ namespace XAMPP {
     StatusCode SUSYParticleSelector::FillFromSUSYTools(Container*& Cont, xAOD::ShallowAuxContainer*& AuxCont, Container*& PreSelCont) {
         ParticleSelector::LinkStatus Status = CreateContainerLinks(ContainerKey(), Cont, AuxCont);
         if (Status == ParticleSelector::LinkStatus::Created) {
-            ATH_CHECK(CallSUSYTools());
+            if (!RestoreCalibration(ContainerKey(), *Cont)) {
+                ATH_CHECK(CallSUSYTools());
+                ATH_CHECK(CacheCalibration(ContainerKey(), *Cont, *AuxCont));
+            }
             ATH_CHECK(ViewElementsContainer("presel", PreSelCont));
             for (const auto& ipart : *Cont)
                 if (PassPreSelection(*ipart)) PreSelCont->push_back(ipart);
@@ -8,6 +8,10 @@
 #include <SUSYTools/ISUSYObjDef_xAODTool.h>
 #include <XAMPPbase/ISystematics.h>
 
+#include <map>
+#include <set>
+#include <unordered_map>
+
 namespace XAMPP {
     class SUSYSystematics : public asg::AsgTool, virtual public ISystematics {
     public:
@@ -38,10 +42,22 @@ namespace XAMPP {
         virtual StatusCode InsertWeightSystematic(const CP::SystematicSet& set, XAMPP::SelectionObject T = XAMPP::SelectionObject::Other);
         virtual StatusCode InsertSystematicToolService(XAMPP::ISystematicToolService* Service);
 
+        virtual int GetKinematicOrdinal(const CP::SystematicSet* Set) const;
+
         virtual bool SystematicsFixed() const;
         virtual StatusCode FixSystematics();
+        virtual void PrintSwitchSummary() const;
 
     private:
+        // Flags which of the tool services are affected by the set
+        typedef std::vector<bool> ServiceMask;
+        void BuildRoutingTable();
+        // Brings the list into the order stored in the startup snapshot. Returns false if the snapshot
+        // does not contain the same systematics
+        bool OrderFromSnapshot(std::vector<const CP::SystematicSet*>& List, const std::string& key) const;
+        ServiceMask AffectedServices(const CP::SystematicSet* Set) const;
+        StatusCode SwitchService(size_t service, const CP::SystematicSet* Set);
+
         const CP::SystematicSet* CreateCopy(const CP::SystematicSet& Set);
 
         void PromptSystList(std::vector<const CP::SystematicSet*>& List, const std::string& Type) const;
@@ -51,6 +67,7 @@ namespace XAMPP {
         std::vector<std::shared_ptr<CP::SystematicSet>> m_syst_all;
 
         std::vector<const CP::SystematicSet*> m_syst_kin;
+        std::unordered_map<const CP::SystematicSet*, int> m_kin_ordinal;
         std::vector<const CP::SystematicSet*> m_syst_kin_ele;
         std::vector<const CP::SystematicSet*> m_syst_kin_muo;
         std::vector<const CP::SystematicSet*> m_syst_kin_jet;
@@ -89,6 +106,12 @@ namespace XAMPP {
         bool m_doWeights;
 
         std::vector<std::shared_ptr<XAMPP::ISystematicToolService>> m_Tools;
+        // Routing table built in FixSystematics and the set currently applied to each tool service
+        std::map<const CP::SystematicSet*, ServiceMask> m_routing;
+        std::vector<const CP::SystematicSet*> m_applied;
+        unsigned long long m_nSetRequests;
+        unsigned long long m_nSetSwitches;
+        unsigned long long m_nToolSwitches;
         std::vector<std::string> m_excluded_syst;
         bool m_init;
         bool m_isData;
@@ -105,6 +128,7 @@ namespace XAMPP {
         virtual StatusCode setSystematic(const CP::SystematicSet* Set);
         virtual StatusCode initialize();
         virtual std::string name() const;
+        virtual bool isAffectedBySystematic(const CP::SystematicSet* Set) const;
         virtual ~SUSYToolsSystematicToolHandle();
 
     private:
@@ -122,6 +146,7 @@ namespace XAMPP {
         ToolHandle<XAMPP::ISystematics> m_systematic;
         bool m_init;
         std::vector<xAOD::Type::ObjectType> m_objTypes;
+        std::set<std::string> m_affecting;
     };
 
 }  // namespace XAMPP
@@ -109,7 +109,9 @@ namespace XAMPP {
         };
         FinalStrObjMatching FindObjectInTriggerString(const std::string& TriggerString, const ObjMatchVec& Matching) const;
 
+        // Takes the thresholds from the startup snapshot if available
         void GetMatchingThresholds();
+        void ParseMatchingThresholds();
         int ExtractPtThreshold(std::string& TriggerString, int& M, xAOD::Type::ObjectType& T);
         bool AssignMatching(xAOD::Type::ObjectType T) const;
 
@@ -94,16 +94,16 @@ namespace XAMPP {
         bool doTruthJets() const;
         bool doTruthParticles() const;
 
-        std::string TauKey() const;
-        std::string ElectronKey() const;
-        std::string MuonKey() const;
-        std::string PhotonKey() const;
-
-        std::string NeutrinoKey() const;
-        std::string BosonKey() const;
-        std::string BSMKey() const;
-        std::string TopKey() const;
-        std::string JetKey() const;
+        const std::string& TauKey() const;
+        const std::string& ElectronKey() const;
+        const std::string& MuonKey() const;
+        const std::string& PhotonKey() const;
+
+        const std::string& NeutrinoKey() const;
+        const std::string& BosonKey() const;
+        const std::string& BSMKey() const;
+        const std::string& TopKey() const;
+        const std::string& JetKey() const;
 
         struct ObjectDefinition {
             ObjectDefinition() {
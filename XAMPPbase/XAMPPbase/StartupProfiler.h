@@ -0,0 +1,60 @@
+#ifndef XAMPPbase_StartupProfiler_H
+#define XAMPPbase_StartupProfiler_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//###############################################################################
+//  Breakdown of the time spent in the initialization of the job                #
+//  Each StartupTimer measures the time of its scope and is booked in the       #
+//  order of its creation. Timers created inside the scope of another timer on  #
+//  the same thread are nested below it. Timers of other threads, e.g. the      #
+//  background loading of the cross-section database, are marked as            #
+//  concurrent. The SUSYAnalysisHelper prints the table at the end of its       #
+//  initialization.                                                             #
+//###############################################################################
+namespace XAMPP {
+    class StartupProfiler {
+    public:
+        static StartupProfiler* GetInstance();
+        ~StartupProfiler() = default;
+
+        // Returns the index of the new entry
+        size_t start(const std::string& name);
+        void stop(size_t entry);
+        // Prints the table of all finished entries and clears them afterwards
+        void print();
+
+    private:
+        StartupProfiler();
+        static StartupProfiler* m_Inst;
+
+        typedef std::chrono::steady_clock Clock;
+        struct Entry {
+            std::string name;
+            unsigned int depth;
+            bool concurrent;
+            Clock::time_point start;
+            double seconds;
+            bool finished;
+        };
+        std::mutex m_mutex;
+        std::thread::id m_mainThread;
+        std::vector<Entry> m_entries;
+    };
+
+    class StartupTimer {
+    public:
+        StartupTimer(const std::string& name);
+        ~StartupTimer();
+
+    private:
+        StartupTimer(const StartupTimer&) = delete;
+        void operator=(const StartupTimer&) = delete;
+        size_t m_entry;
+    };
+}  // namespace XAMPP
+#endif
@@ -0,0 +1,55 @@
+#ifndef XAMPPbase_StartupSnapshot_H
+#define XAMPPbase_StartupSnapshot_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+//###############################################################################
+//  Snapshot of the configuration resolved during the initialization           #
+//  The jobs of a production resolve the same systematic lists, the same        #
+//  routing of the systematics to the tools and the same trigger thresholds.    #
+//  If a snapshot file is given, the first job writes these tables to it and    #
+//  the subsequent jobs take them from there. The file carries a format         #
+//  version, the hash of the configuration it has been produced with and a      #
+//  checksum of its content. A snapshot failing one of the checks is ignored    #
+//  and rewritten at the end of the initialization.                             #
+//  The clients register each table via set(). If a table differs from the one  #
+//  in the snapshot, the snapshot is marked as stale and is rewritten as well.  #
+//###############################################################################
+namespace XAMPP {
+    class StartupSnapshot {
+    public:
+        static StartupSnapshot* GetInstance();
+        ~StartupSnapshot() = default;
+
+        // Called once by the analysis helper before the tools are set up. An empty path disables the snapshot
+        void configure(const std::string& path, size_t config_hash);
+        bool isEnabled() const;
+        // Whether a valid snapshot has been read from the file
+        bool isLoaded() const;
+
+        // Returns false if the snapshot does not contain the table
+        bool get(const std::string& key, std::vector<std::string>& values) const;
+        // Records the table which has been used by the job
+        void set(const std::string& key, const std::vector<std::string>& values);
+
+        // Writes the recorded tables if the snapshot did not exist or is stale
+        bool write();
+
+    private:
+        StartupSnapshot();
+        static StartupSnapshot* m_Inst;
+        static const unsigned int m_version;
+
+        bool read();
+
+        std::string m_path;
+        size_t m_configHash;
+        bool m_enabled;
+        bool m_loaded;
+        bool m_stale;
+        std::map<std::string, std::vector<std::string>> m_tables;
+    };
+}  // namespace XAMPP
+#endif
@@ -18,6 +18,7 @@ namespace XAMPP {
         virtual StatusCode initialize();
         StatusCode initTool();
         virtual std::string name() const;
+        virtual bool isAffectedBySystematic(const CP::SystematicSet* Set) const;
 
         template <typename P> StatusCode setProperty(const std::string& Property, P Value);
 
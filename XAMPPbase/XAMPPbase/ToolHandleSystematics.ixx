@@ -47,10 +47,12 @@ namespace XAMPP {
         m_affectWeight(Weight) {}
     template <class T> StatusCode ToolHandleSystematics<T>::resetSystematic() { return setSystematic(m_systematics->GetNominal()); }
     template <class T> StatusCode ToolHandleSystematics<T>::setSystematic(const CP::SystematicSet* Set) {
-        if (!ToolIsAffectedBySystematic(m_handle, Set)) { return StatusCode::SUCCESS; }
         if (m_handle->applySystematicVariation(*Set) != CP::SystematicCode::Ok) { return StatusCode::FAILURE; }
         return StatusCode::SUCCESS;
     }
+    template <class T> bool ToolHandleSystematics<T>::isAffectedBySystematic(const CP::SystematicSet* Set) const {
+        return ToolIsAffectedBySystematic(m_handle, Set);
+    }
     template <class T> StatusCode ToolHandleSystematics<T>::initialize() {
         if (!m_handle.retrieve().isSuccess()) {
             Error(name().c_str(), "No valid instance of the tool handle found");
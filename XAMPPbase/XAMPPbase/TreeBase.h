@@ -6,6 +6,7 @@
 #include <AsgTools/ToolHandle.h>
 
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <iostream>
 #include <memory>
@@ -39,6 +40,17 @@ namespace XAMPP {
         void SetSystematicsTool(const ToolHandle<XAMPP::ISystematics>& Syst);
         void SetAnalysisConfig(const ToolHandle<XAMPP::IAnalysisConfig>& config);
 
+        /// Compression settings (algorithm * 100 + level, -1 keeps the setting of the output file) and
+        /// the auto flush of the tree. Positive values flush every N entries, negative ones after -N bytes.
+        /// The baskets are resized according to the content of the first cluster
+        void SetOutputPolicy(int compression, Long64_t auto_flush);
+        /// Translates <Algorithm>:<Level>, e.g. LZ4:4, ZSTD:5, LZMA:7, ZLIB:1, into the ROOT compression settings.
+        /// An empty string yields -1, an invalid one -2
+        static int CompressionSettings(const std::string& policy);
+
+        /// In the delta mode the systematic tree only stores the differences w.r.t. the given nominal tree
+        void SetDeltaReference(std::shared_ptr<TreeBase> nominal);
+
         void SetListOfFriends(const std::vector<std::shared_ptr<TreeBase>>& friends);
         void AddFriend(std::shared_ptr<TreeBase> tree_base);
         TTree* Tree() const;
@@ -75,10 +87,16 @@ namespace XAMPP {
         ServiceHandle<ITHistSvc> m_histSvc;
         /// Friend trees rely on
         std::vector<std::shared_ptr<TreeBase>> m_friend_trees;
+        std::shared_ptr<TreeBase> m_delta_reference;
         std::vector<std::shared_ptr<XAMPP::ITreeBranchVariable>> m_Branches;
         bool addVariable(IStorage* store) const;
+        void SetCompression(TObjArray* branches) const;
         int m_mcChannelNumber;
-        ULong64_t m_eventId[2];
+        std::array<ULong64_t, 2> m_eventId;
+
+        int m_compression;
+        Long64_t m_autoFlush;
+        double m_fillTime;
     };
 }  // namespace XAMPP
 #endif
@@ -1,5 +1,7 @@
 #ifndef XAMPPBASE_TREEHELPERS_IXX
 #define XAMPPBASE_TREEHELPERS_IXX
+#include <XAMPPbase/AsyncTreeWriter.h>
+#include <XAMPPbase/DeltaTrees.h>
 #include <XAMPPbase/EventStorage.h>
 #include <XAMPPbase/TreeHelpers.h>
 #include <memory>
@@ -14,7 +16,8 @@ namespace XAMPP {
             Error("TreeHelper::AddBranch()", "The branch %s already exists in TTree %s", Name.c_str(), m_tree->GetName());
             return false;
         }
-        if (m_tree->Branch(bName.c_str(), &Element) == nullptr) {
+        T& address = DeltaTreeEncoder::GetInstance()->branchAddress(m_tree, bName, Element);
+        if (m_tree->Branch(bName.c_str(), &AsyncTreeWriter::GetInstance()->branchAddress(m_tree, address)) == nullptr) {
             Error("TreeHelper::AddBranch()", "Could not create the branch %s in TTree %s", Name.c_str(), m_tree->GetName());
             return false;
         }
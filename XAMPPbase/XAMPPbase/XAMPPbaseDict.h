@@ -3,6 +3,7 @@
 
 #include <XAMPPbase/AnalysisConfig.h>
 #include <XAMPPbase/EventInfo.h>
+#include <XAMPPbase/FriendTreeReader.h>
 #include <XAMPPbase/MetaDataTree.h>
 #include <XAMPPbase/SUSYAnalysisHelper.h>
 #include <XAMPPbase/SUSYElectronSelector.h>
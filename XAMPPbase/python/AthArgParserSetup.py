@@ -20,6 +20,85 @@ def attachArgs(theParser):
                            choices=["", "BFilter", "CFilterBVeto", "CVetoBVeto"],
                            default=None)
     theParser.add_argument("--jobOptions", help="The athena jobOptions file to be executed", default="XAMPPbase/runXAMPPbase.py")
+    theParser.add_argument("--allocationBudgets",
+                           help="Count the calls to operator new per event and stage and fail if the budget is exceeded. " +
+                           "Format: <Stage>:<Budget> with the stages LoadContainers, FillInitialObjects, RemoveOverlap, FillObjects, FillEvent",
+                           nargs="+",
+                           default=[])
+    theParser.add_argument("--allocationReport",
+                           help="Write the maximum calls to operator new per event and stage to this file. " +
+                           "Its content can be passed to --allocationBudgets",
+                           default="")
+    theParser.add_argument("--maxAllocationGrowth",
+                           help="Fail if the live allocations grow by more than this per event after the first 100 events. " +
+                           "Negative values disable the check",
+                           type=float,
+                           default=-1.)
+    theParser.add_argument("--nProcs",
+                           help="Process the events with N forked workers (AthenaMP). The outputs are merged afterwards",
+                           type=int,
+                           default=0)
+    theParser.add_argument("--eventsPerRange",
+                           help="Number of consecutive events a worker pulls from the shared queue in the --nProcs mode",
+                           type=int,
+                           default=100)
+    theParser.add_argument("--calibrationCache",
+                           help="Directory to cache the calibrated objects and scale-factors per input file. " +
+                           "Subsequent runs over the same files with the same SUSYTools configuration skip the CP tools. " +
+                           "Ignored with --nProcs",
+                           default="")
+    theParser.add_argument("--startupSnapshot",
+                           help="File to store the systematic lists, the systematic routing and the trigger thresholds resolved at startup. " +
+                           "It is written by the first job and read by the subsequent jobs with the same SUSYTools configuration",
+                           default="")
+    theParser.add_argument("--asyncTreeWriting",
+                           help="Fill the output trees in a separate writer thread. The value is the number of entries the queue can hold",
+                           type=int,
+                           default=0)
+    theParser.add_argument("--treeCompression",
+                           help="Compression of the nominal, common and group trees given as <Algorithm>:<Level>, e.g. LZ4:4, ZSTD:5 or LZMA:7",
+                           default="")
+    theParser.add_argument("--systTreeCompression", help="Compression of the systematic trees given as <Algorithm>:<Level>", default="")
+    theParser.add_argument("--treeAutoFlush",
+                           help="Auto flush of the nominal trees. Positive values flush every N entries, negative values after -N bytes. " +
+                           "The baskets are sized according to the first cluster",
+                           type=int,
+                           default=0)
+    theParser.add_argument("--systTreeAutoFlush", help="Auto flush of the systematic trees. Same convention as --treeAutoFlush", type=int, default=0)
+    theParser.add_argument("--deltaSystTrees",
+                           help="Store only the branches and events of the systematic trees which differ from nominal. " +
+                           "Read them with XAMPP::DeltaTreeReader",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--lheWeightsAsVector",
+                           help="Write the LHE weights into the vector branch GenWeight_LHE indexed like the mcEventWeights " +
+                           "instead of one branch per variation",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--cachePRW",
+                           help="Cache the pile-up reweighting results per channel, run, lumi block, mu and systematic",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--validatePRWCache",
+                           help="Run the pile-up reweighting tool also for cached configurations and fail if the results differ",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--grlLookup",
+                           help="Decide the GRL from sorted lumi block intervals per run instead of querying the GoodRunsListSelectionTool",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--validateGRLLookup",
+                           help="Query the GoodRunsListSelectionTool also in the --grlLookup mode and fail if the decisions differ",
+                           action='store_true',
+                           default=False)
+    theParser.add_argument("--grlLookupCache", help="Binary file shared across the jobs to store the parsed GRL intervals", default="")
+    theParser.add_argument("--xsecSnapshot",
+                           help="Binary cross-section table compiled by CompileCrossSections. Replaces the parsing of the text files",
+                           default="")
+    theParser.add_argument("--validateXsecSnapshot",
+                           help="Compare the cross-section snapshot to the text files and print the time needed to load each of them",
+                           action='store_true',
+                           default=False)
     theParser.add_argument("--valgrind",
                            help="Search for memory leaks/call structure using valgrind",
                            choices=["", "memcheck", "callgrind"],
@@ -3,6 +3,9 @@ from XAMPPbase.runAthena import AssembleRemoteRunCmd
 from XAMPPbase.Utils import IsTextFile, IsListIn
 from ClusterSubmission.Utils import TimeToSeconds, prettyPrint, IsROOTFile, ReadListFromFile, WriteList, ResolvePath, CreateDirectory, ClearFromDuplicates, setup_engine, setupBatchSubmitArgParser
 from XAMPPbase.AthArgParserSetup import attachArgs
+from ClusterSubmission.DatasetCatalog import DatasetCatalog, LogicalName
+from ClusterSubmission.ResourceReport import ResourceModel, ConfigHash, SecondsToTime
+from ClusterSubmission.ClusterEngine import SGEEngine
 
 
 class NtupleMakerSubmit(object):
@@ -19,12 +22,19 @@ class NtupleMakerSubmit(object):
             hold_jobs=[],
             files_per_merge=10,
             final_split=1,
+            catalog=None,  ### DatasetCatalog to resolve the datasets and to split them without opening the files
+            size_per_job=-1,  ### Maximum size of the input of each job in bytes. Requires the catalog
+            report_dir="",  ### Directory of the resource reports written by the jobs and read to size the next jobs
+            target_run_time="",  ### Run time each job should take according to the resource reports
+            resource_safety=1.3,  ### Margin on the predicted memory and run time
     ):
         self.__cluster_engine = cluster_engine
         ### Job splitting configurations
         self.__events_per_job = events_per_job
         self.__dcache_dir = dcache_dir
         self.__dcache_loc = ResolvePath(dcache_dir)
+        self.__catalog = catalog
+        self.__size_per_job = size_per_job if catalog else -1
 
         ### analysis job configurations
         self.__job_options = jobOptions
@@ -32,6 +42,16 @@ class NtupleMakerSubmit(object):
         self.__run_time = run_time
         self.__vmem = vmem
 
+        ### Resource feedback. The memory and the run time of the array are the maxima over the samples
+        self.__report_dir = report_dir
+        self.__resource_config = ConfigHash(jobOptions, " ".join(alg_opt))
+        self.__resource_model = ResourceModel(report_dir, self.__resource_config) if len(report_dir) > 0 else None
+        self.__target_time = TimeToSeconds(target_run_time) if len(target_run_time) > 0 else -1
+        self.__resource_safety = resource_safety
+        self.__est_mem = -1
+        self.__est_time = -1
+        self.__sized_all = True
+
         ### Hold jobs
         self.__hold_jobs = [H for H in hold_jobs]
         ### Merging
@@ -49,7 +69,8 @@ class NtupleMakerSubmit(object):
         print "INFO <_prepare_input>: Assemble configuration for %s" % (in_ds)
         ### Name to be piped to the job
         out_name = in_ds[in_ds.rfind("/") + 1:in_ds.rfind(".")] if IsTextFile(in_ds) or IsROOTFile(in_ds) else in_ds
-        split_dir = "%s/Datasets/%s" % (self.split_cfg_dir(), out_name)
+        events_per_job = self.__size_from_reports(LogicalName(out_name))
+        split_dir = "%s/Datasets/%s" % (self.split_cfg_dir(events_per_job), out_name)
         root_files = []
         ### Now we need to find the corresponding ROOT files
         ### 1) The dataset is a root file itself
@@ -65,7 +86,7 @@ class NtupleMakerSubmit(object):
             if in_ds.endswith("/"):
                 in_ds = in_ds[:in_ds.rfind("/")]
                 out_name = in_ds[in_ds.rfind("/") + 1:]
-            split_dir = "%s/Directory/%s" % (self.split_cfg_dir(), out_name)
+            split_dir = "%s/Directory/%s" % (self.split_cfg_dir(events_per_job), out_name)
             root_files = ["%s/%s" % (in_ds, F) for F in os.listdir(in_ds) if IsROOTFile(F)]
         ### 4) It's a logical dataset stored on d-cache
         else:
@@ -86,7 +107,11 @@ class NtupleMakerSubmit(object):
             print "INFO: Assemble new split for %s" % (in_ds)
             CreateDirectory(split_dir, True)
             WriteList(root_files, main_list)
-            os.system("CreateBatchJobSplit -I %s -O %s -EpJ %i" % (main_list, split_dir, self.__events_per_job))
+            ### Only the files unknown to the catalog are opened
+            if self.__catalog and self.__catalog.update(root_files):
+                self.__catalog.write_split(root_files, split_dir, events_per_job, self.__size_per_job)
+            else:
+                os.system("CreateBatchJobSplit -I %s -O %s -EpJ %i" % (main_list, split_dir, events_per_job))
         ### Each of the lists contains the ROOT files to process per each sub job
         split_lists = ["%s/%s" % (split_dir, F) for F in os.listdir(split_dir) if IsTextFile(F)]
         n_jobs = len(split_lists)
@@ -94,11 +119,13 @@ class NtupleMakerSubmit(object):
 
         assembled_in = [] if not os.path.exists(self.job_input()) else ReadListFromFile(self.job_input())
         assembled_out = [] if not os.path.exists(self.job_out_names()) else ReadListFromFile(self.job_out_names())
+        assembled_samples = [] if not os.path.exists(self.job_samples()) else ReadListFromFile(self.job_samples())
         start_reg = len(assembled_in)
 
         ### Write what we've
         WriteList(assembled_in + split_lists, self.job_input())
         WriteList(assembled_out + subjob_outs, self.job_out_names())
+        WriteList(assembled_samples + [LogicalName(out_name) for i in range(n_jobs)], self.job_samples())
         #### Submit the merge jobs
         self.__merge_interfaces += [
             self.engine().create_merge_interface(out_name=out_name,
@@ -110,6 +137,20 @@ class NtupleMakerSubmit(object):
         self.__nsheduled += n_jobs
         return True
 
+    def __size_from_reports(self, sample):
+        """Events per job of the sample such that its jobs take the target run time. The predicted memory and run time
+           of the jobs enter the requirements of the array"""
+        estimate = self.__resource_model.estimate(sample) if self.__resource_model and self.__target_time > 0 else None
+        if not estimate:
+            self.__sized_all = False
+            return self.__events_per_job
+        events_per_job = estimate.events_per_job(self.__target_time, self.__resource_safety)
+        self.__est_mem = max(self.__est_mem, estimate.memory(self.__resource_safety))
+        self.__est_time = max(self.__est_time, estimate.run_time(events_per_job, self.__resource_safety))
+        print "INFO: %s is split into jobs of %d events. %d earlier jobs needed %.0f s to start, %.2f s per event and up to %d MB" % (
+            sample, events_per_job, estimate.n_reports, estimate.startup_time, estimate.time_per_event, estimate.peak_rss)
+        return events_per_job
+
     def __extract_root_files(self, file_list=""):
         content = ReadListFromFile(file_list)
         if len(content) == 0:
@@ -129,6 +170,15 @@ class NtupleMakerSubmit(object):
         return root_files
 
     def __find_on_dcache(self, ds):
+        ### The catalog knows the files of the dataset from a previous submission or from the RucioListBuilder
+        if self.__catalog:
+            root_files = self.__catalog.dataset_files(ds)
+            if len(root_files) > 0: return root_files
+        root_files = self.__find_in_group_disk_lists(ds)
+        if self.__catalog and len(root_files) > 0: self.__catalog.register(ds, root_files)
+        return root_files
+
+    def __find_in_group_disk_lists(self, ds):
         if not self.__dcache_loc or not os.path.isdir(self.__dcache_loc):
             print "WARNING %s is not a valid directory" % (self.__dcache_dir)
             return []
@@ -140,7 +190,7 @@ class NtupleMakerSubmit(object):
             ds_name = ds_name[1:]
         ### The dataset has the form
         ### mc16_13TeV:mc16_13TeV.<Blah>
-        if ds_name.find(":") != -1: ds_name = ds_name[ds_name.find(":") + 1:]
+        ds_name = LogicalName(ds_name)
 
         ### Try if there is a common list with one of these endings
         txt_endings = ["txt", "conf", "list"]
@@ -158,8 +208,11 @@ class NtupleMakerSubmit(object):
     def engine(self):
         return self.__cluster_engine
 
-    def split_cfg_dir(self):
-        return "%s/.SplitConfigs/%d/" % (self.engine().base_dir(), self.__events_per_job)
+    def split_cfg_dir(self, events_per_job=-1):
+        if events_per_job < 0: events_per_job = self.__events_per_job
+        if self.__size_per_job > 0:
+            return "%s/.SplitConfigs/%d_%dMB/" % (self.engine().base_dir(), events_per_job, self.__size_per_job / 1024 / 1024)
+        return "%s/.SplitConfigs/%d/" % (self.engine().base_dir(), events_per_job)
 
     ### Location where the input job cfg is stored
     def job_input(self):
@@ -169,6 +222,10 @@ class NtupleMakerSubmit(object):
     def job_out_names(self):
         return "%s/out_fileNames.conf" % (self.engine().config_dir())
 
+    ### Sample processed by each job. Needed by the resource reports
+    def job_samples(self):
+        return "%s/Samples.conf" % (self.engine().config_dir())
+
     def hold_jobs(self):
         return self.__hold_jobs
 
@@ -176,9 +233,17 @@ class NtupleMakerSubmit(object):
         return self.__nsheduled
 
     def run_time(self):
+        ### The jobs of samples without a resource estimate still need the configured run time
+        if self.__est_time > 0:
+            est_time = SecondsToTime(self.__est_time)
+            if self.__sized_all: return est_time
+            return est_time if self.__est_time > TimeToSeconds(self.__run_time) else self.__run_time
         return self.__run_time
 
     def memory(self):
+        ### h_vmem of the SGE limits the virtual memory of which the measured peak RSS is only a lower bound
+        if self.__est_mem > 0 and not isinstance(self.engine(), SGEEngine):
+            return self.__est_mem if self.__sized_all else max(self.__est_mem, self.__vmem)
         return self.__vmem
 
     def submit_job(self):
@@ -195,6 +260,10 @@ class NtupleMakerSubmit(object):
                                               ("Execute", self.__job_options),
                                               ("OutCfg", self.job_out_names()),
                                               ("InCfg", self.job_input()),
+                                              ("SampleCfg", self.job_samples()),
+                                              ("ResourceReportDir", self.__report_dir),
+                                              ("ResourceConfig", self.__resource_config),
+                                              ("ResourceCatalog", os.path.abspath(self.__catalog.path()) if self.__catalog else ""),
                                           ],
                                           array_size=self.n_sheduled()):
             return False
@@ -216,6 +285,18 @@ def exclusiveBatchOpt():
     parser.add_argument("--RSE", help='RSE storage element for files located via dcache.', default='MPPMU_LOCALGROUPDISK')
     parser.add_argument('--RunTime', help='Changes the RunTime of the Jobs: default 19:59:59 ', default='19:59:59')
     parser.add_argument('--EventsPerJob', help='Changes the Events per Batch job. Default: 10000 ', default=10000, type=int)
+    parser.add_argument('--DatasetCatalog',
+                        help='SQLite catalog of the input files. Datasets and files in there are neither looked up nor opened again',
+                        default="")
+    parser.add_argument('--SizePerJob', help='Maximum input size per job in MB. Requires the --DatasetCatalog', default=-1, type=int)
+    parser.add_argument('--ResourceReports',
+                        help='Directory where the jobs write their resource usage. The reports of earlier jobs size the new ones',
+                        default="")
+    parser.add_argument('--TargetRunTime',
+                        help='Split the samples known from the --ResourceReports into jobs of this run time and derive the memory ' +
+                        'and run time of the array from the reports. The partition follows from the run time',
+                        default="")
+    parser.add_argument('--ResourceSafety', help='Margin on the memory and run time predicted from the reports', default=1.3, type=float)
     parser.add_argument('--FilesPerMergeJob', help='Number of files per merge', default=8, type=int)
     parser.add_argument("--FinalSplit", help="How many files should be left after merge", default=1, type=int)
     parser.add_argument('--vmem', help='Virtual memory reserved for each analysis  jobs', default=3500, type=int)
@@ -267,6 +348,11 @@ def main():
         hold_jobs=options.HoldJob,
         files_per_merge=options.FilesPerMergeJob,
         final_split=options.FinalSplit,
+        catalog=DatasetCatalog(options.DatasetCatalog) if len(options.DatasetCatalog) > 0 else None,
+        size_per_job=options.SizePerJob * 1024 * 1024,
+        report_dir=options.ResourceReports,
+        target_run_time=options.TargetRunTime,
+        resource_safety=options.ResourceSafety,
     )
     Submit_Class.submit_job()
 
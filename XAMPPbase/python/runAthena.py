@@ -108,7 +108,8 @@ def ExecuteAthena(RunOptions, AthenaArgs):
     @param      RunOptions  The run options (these are modified to satisfy athena style)
     @param      AthenaArgs  The athena arguments (are directly joined to the athena command)
     """
-    ExeCmd = "athena.py %s %s" % (BringToAthenaStyle(RunOptions.jobOptions), " ".join(AthenaArgs))
+    ExeCmd = "athena.py %s%s %s" % ("--nprocs=%d " % (RunOptions.nProcs) if RunOptions.nProcs > 1 else "",
+                                     BringToAthenaStyle(RunOptions.jobOptions), " ".join(AthenaArgs))
     if RunOptions.outFile.find("/") != -1:
         print("INFO: Will execute Athena in directory " + RunOptions.outFile.rsplit("/", 1)[0])
         CreateDirectory(RunOptions.outFile.rsplit("/", 1)[0], False)
@@ -117,6 +118,12 @@ def ExecuteAthena(RunOptions, AthenaArgs):
         print("ERROR: Please give a file to save not only the directory")
         exit(1)
 
+    # count the allocations per event and stage
+    if len(RunOptions.allocationBudgets) > 0 or len(RunOptions.allocationReport) > 0 or RunOptions.maxAllocationGrowth >= 0:
+        ExeCmd = "LD_PRELOAD=libXAMPPAllocationHook.so " + ExeCmd
+        print("INFO: Preload the allocation counter. Execute command modified to:")
+        print(ExeCmd)
+
     # options to run with valgrind
     # ----------------------------------------------------------------------------------------------------
     if RunOptions.valgrind:
@@ -143,6 +150,79 @@ def ExecuteAthena(RunOptions, AthenaArgs):
         print("ERROR: Athena execeution failed")
         os.system("rm %s" % (RunOptions.outFile))
         exit(1)
+    if RunOptions.nProcs > 1 and not RecoverUnclaimedFiles(RunOptions, AthenaArgs):
+        print("ERROR: The meta-data of the input files without events could not be collected")
+        exit(1)
+    if RunOptions.nProcs > 1 and not MergeParallelOutputs(RunOptions):
+        print("ERROR: Merging of the worker outputs failed")
+        exit(1)
+
+
+def RecoverUnclaimedFiles(RunOptions, AthenaArgs, WorkerDir="athenaMP_workers"):
+    """
+    @brief      The workers only open the input files from which they read events. Input files
+                without any event are never claimed by a worker and their meta-data would be
+                missing in the merged output. These files are processed by a serial job whose
+                output is merged as the last worker.
+    
+    @param      RunOptions  The run options
+    @param      AthenaArgs  The athena arguments of the parallel job
+    @param      WorkerDir   The top directory of the AthenaMP workers
+    
+    @return     True if all input files have been claimed or the serial job succeeded
+    """
+    in_files = ReadListFromFile("XAMPP_MP_inputs.txt") if os.path.isfile("XAMPP_MP_inputs.txt") else []
+    claimed = []
+    if os.path.isdir("XAMPP_MP_claims"):
+        for claim in os.listdir("XAMPP_MP_claims"):
+            name_file = "XAMPP_MP_claims/%s/file_name" % (claim)
+            if os.path.isfile(name_file): claimed += [f.rsplit("/", 1)[-1] for f in ReadListFromFile(name_file)]
+    unclaimed = [f for f in in_files if f.rsplit("/", 1)[-1] not in claimed]
+    if len(unclaimed) == 0: return True
+    ### A serial job stopped by --evtMax does not open the files behind the last event either
+    if RunOptions.evtMax > 0 or RunOptions.skipEvents > 0:
+        print("INFO: %d input files have not been opened within the processed event range" % (len(unclaimed)))
+        return True
+    print("INFO: %d input files have not been claimed by any worker. Collect their meta-data in a serial job" % (len(unclaimed)))
+    workers = [int(W.rsplit("_", 1)[-1]) for W in os.listdir(WorkerDir) if W.startswith("worker_")] if os.path.isdir(WorkerDir) else []
+    job_dir = "%s/worker_%d" % (WorkerDir, max(workers) + 1 if len(workers) > 0 else 0)
+    CreateDirectory(job_dir, False)
+    out_name = RunOptions.outFile.rsplit("/", 1)[-1]
+    ### The remaining options are the ones of the parallel job
+    Args = [A for A in AthenaArgs if not A.startswith("--filesInput") and not A.startswith("--nProcs") and not A.startswith("--outFile")]
+    Args = ["--filesInput '%s'" % (",".join([os.path.abspath(f) if os.path.exists(f) else f for f in unclaimed]))] + Args
+    Args += ["--outFile %s" % (out_name)] if "-" in Args else ["-", "--outFile %s" % (out_name)]
+    ExeCmd = "cd %s && athena.py %s %s" % (job_dir, BringToAthenaStyle(RunOptions.jobOptions), " ".join(Args))
+    print(ExeCmd)
+    return os.system(ExeCmd) == 0 and os.path.isfile("%s/%s" % (job_dir, out_name))
+
+
+def MergeParallelOutputs(RunOptions, WorkerDir="athenaMP_workers"):
+    """
+    @brief      Merge the outputs of the AthenaMP workers into the final output file.
+                The trees are written in the order of the input events and the
+                meta-data and histograms are summed in the order of the workers.
+                The directories and files of the workers are cleaned afterwards.
+    
+    @param      RunOptions  The run options
+    @param      WorkerDir   The top directory of the AthenaMP workers
+    
+    @return     True if the merging succeeded
+    """
+    out_name = RunOptions.outFile.rsplit("/", 1)[-1]
+    workers = [
+        "%s/%s/%s" % (WorkerDir, W, out_name) for W in sorted(os.listdir(WorkerDir), key=lambda x: int(x.rsplit("_", 1)[-1]))
+        if W.startswith("worker_") and os.path.isfile("%s/%s/%s" % (WorkerDir, W, out_name))
+    ] if os.path.isdir(WorkerDir) else []
+    if len(workers) == 0:
+        print("ERROR: No worker output has been found in %s" % (WorkerDir))
+        return False
+    print("INFO: Merge the outputs of %d workers into %s" % (len(workers), out_name))
+    MergeCmd = "MergeParallelOutputs --outFile %s --InList XAMPP_MP_inputs.txt %s" % (out_name, " ".join(
+        ["--inFile %s" % (W) for W in workers]))
+    if os.system(MergeCmd): return False
+    os.system("rm -rf %s XAMPP_MP_claims XAMPP_MP_inputs.txt" % (WorkerDir))
+    return True
 
 
 def applyZnunuSampleFix(RunOptionsOrFilename, AthenaArgs=None):
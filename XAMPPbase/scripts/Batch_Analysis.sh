@@ -77,6 +77,17 @@ if [ -f "${OutCfg}" ];then
     echo "OutFile=`sed -n \"${TASK_ID}{p;q;}\" ${OutCfg}`"
     OutFile=`sed -n "${TASK_ID}{p;q;}" ${OutCfg}`
 fi
+# The resource usage of the job is reported to the submission of the next jobs
+Monitor=""
+if [ -n "${ResourceReportDir}" ] && [ -f "${SampleCfg}" ];then
+    Sample=`sed -n "${TASK_ID}{p;q;}" ${SampleCfg}`
+    Monitor="python -m ClusterSubmission.ResourceReport --report ${ResourceReportDir}/${Sample}_${TASK_ID}.json --sample ${Sample} --config ${ResourceConfig} --inputList ${InFile}"
+    # The catalog of the submission knows the number of events without opening the input files again
+    if [ -n "${ResourceCatalog}" ];then
+        Monitor="${Monitor} --catalog ${ResourceCatalog}"
+    fi
+    Monitor="${Monitor} --"
+fi
 
 
 To_Process=""
@@ -87,8 +98,8 @@ done < "${InFile}"
 # Process job
 cd ${TMPDIR}
 echo "execute jobOptions..."
-echo "athena ${Execute} --filesInput  \"${To_Process}\" -  --parseFilesForPRW ${Options}"
-athena ${Execute} --filesInput  "${To_Process}" - ${Options}  --parseFilesForPRW 
+echo "${Monitor} athena ${Execute} --filesInput  \"${To_Process}\" -  --parseFilesForPRW ${Options}"
+${Monitor} athena ${Execute} --filesInput  "${To_Process}" - ${Options}  --parseFilesForPRW 
 
 
 if [ $? -eq 0 ]; then
@@ -355,6 +355,30 @@ def SetupAnalysisHelper(TreeName="XAMPPBaseTree"):
     return getattr(ToolSvc, "AnalysisHelper")
 
 
+def SetupParallelProcessing():
+    ### Configure the event-parallel mode of AthenaMP (runAthena.py --nProcs)
+    ### The workers are forked after initialize and pull event ranges from a shared queue.
+    ### runAthena.py merges their outputs afterwards using MergeParallelOutputs
+    athArgs = getAthenaArgs()
+    if getattr(athArgs, "nProcs", 0) < 2: return
+    from AthenaCommon.AppMgr import ServiceMgr
+    from AthenaCommon.Logging import logging
+    from AthenaMP.AthenaMPFlags import jobproperties as jps
+    from ClusterSubmission.Utils import WriteList
+    recoLog = logging.getLogger('XAMPP MultiProcess')
+    jps.AthenaMPFlags.Strategy = "SharedQueue"
+    jps.AthenaMPFlags.ChunkSize = athArgs.eventsPerRange
+    jps.AthenaMPFlags.EventsBeforeFork = 0
+    recoLog.info("Run with %d workers each processing ranges of %d events" % (athArgs.nProcs, athArgs.eventsPerRange))
+    ### The merging needs the order of the input files to restore the event order of a serial run
+    WriteList(ServiceMgr.EventSelector.InputCollections, "%s/XAMPP_MP_inputs.txt" % (os.getcwd()))
+    claim_dir = "%s/XAMPP_MP_claims" % (os.getcwd())
+    if os.path.exists(claim_dir): os.system("rm -rf %s" % (claim_dir))
+    os.makedirs(claim_dir)
+    SetupAnalysisHelper().MetaDataFileClaimDir = claim_dir
+    SetupAnalysisHelper().MotherProcessID = os.getpid()
+
+
 def SetupAlgorithm():
     from AthenaCommon.AlgSequence import AlgSequence
     from AthenaCommon.AppMgr import ServiceMgr
@@ -369,6 +393,13 @@ def SetupAlgorithm():
         thisAlg.AnalysisHelper = SetupAnalysisHelper()
         thisAlg.SystematicsTool = SetupSystematicsTool()
         thisAlg.nfiles = len(ServiceMgr.EventSelector.InputCollections)
+        budgets = getattr(getAthenaArgs(), "allocationBudgets", [])
+        if len(budgets) > 0:
+            thisAlg.AllocationBudgets = dict([(B.split(":")[0], int(B.split(":")[1])) for B in budgets])
+            recoLog.info("Count the allocations per event with the budgets %s" % (str(thisAlg.AllocationBudgets)))
+        thisAlg.AllocationReport = getattr(getAthenaArgs(), "allocationReport", "")
+        thisAlg.MaxAllocationGrowth = getattr(getAthenaArgs(), "maxAllocationGrowth", -1.)
+        SetupParallelProcessing()
         job += thisAlg
         recoLog.info("Created XAMPP algorithm")
     return getattr(job, "XAMPPAlgorithm")
@@ -381,6 +412,12 @@ def getDefaultGRL():
 def setupGRL(GRL=getDefaultGRL()):
     if isData():
         SetupAnalysisHelper().GoodRunsLists = GRL
+        athArgs = getAthenaArgs()
+        if getattr(athArgs, "grlLookup", False) or getattr(athArgs, "validateGRLLookup", False):
+            setupEventInfo().UseGRLLookup = True
+            setupEventInfo().ValidateGRLLookup = getattr(athArgs, "validateGRLLookup", False)
+            setupEventInfo().GoodRunsLists = GRL
+            setupEventInfo().GRLLookupCache = getattr(athArgs, "grlLookupCache", "")
 
 
 def getLumiCalcConfig(use1516Data=True, use17Data=True, use18Data=True):
@@ -472,11 +509,49 @@ def ParseBasicConfigsToHelper(STFile="SUSYTools/SUSYTools_Default.conf",
     BaseHelper.STConfigFile = STFile if not "STConfigFile" in globals() else STConfigFile
     from AthenaCommon.Logging import logging
     recoLog = logging.getLogger('XAMPP BaseToolSetup')
+    if len(getattr(athArgs, "calibrationCache", "")) > 0:
+        ### The cache file of an input is opened before the fork. The workers would all write into the same file
+        if getattr(athArgs, "nProcs", 0) > 1:
+            recoLog.warning("The calibration cache is not supported in the --nProcs mode. Calibrate all objects")
+        else:
+            recoLog.info("Cache the calibrated objects in %s" % (athArgs.calibrationCache))
+            BaseHelper.CalibrationCacheDir = athArgs.calibrationCache
+            ### The per-particle scale-factors are not part of the cache
+            BaseHelper.CalibrationCacheWeights = not SeparateSF
+    if len(getattr(athArgs, "startupSnapshot", "")) > 0:
+        recoLog.info("Use the startup snapshot %s" % (athArgs.startupSnapshot))
+        BaseHelper.StartupSnapshot = athArgs.startupSnapshot
+    if getattr(athArgs, "asyncTreeWriting", 0) > 0:
+        recoLog.info("Fill the output trees in a separate thread with a queue of %d entries" % (athArgs.asyncTreeWriting))
+        BaseHelper.AsyncTreeWriting = True
+        BaseHelper.AsyncTreeQueueSize = athArgs.asyncTreeWriting
+    if getattr(athArgs, "cachePRW", False) or getattr(athArgs, "validatePRWCache", False):
+        recoLog.info("Cache the results of the pile-up reweighting tool")
+        setupEventInfo().CachePRWResults = True
+        setupEventInfo().ValidatePRWCache = getattr(athArgs, "validatePRWCache", False)
+    ### Intermediate files profit from fast algorithms like LZ4, final outputs from ZSTD or LZMA
+    if len(getattr(athArgs, "treeCompression", "")) > 0: BaseHelper.NominalTreeCompression = athArgs.treeCompression
+    if len(getattr(athArgs, "systTreeCompression", "")) > 0: BaseHelper.SystTreeCompression = athArgs.systTreeCompression
+    if getattr(athArgs, "treeAutoFlush", 0) != 0: BaseHelper.NominalTreeAutoFlush = athArgs.treeAutoFlush
+    if getattr(athArgs, "systTreeAutoFlush", 0) != 0: BaseHelper.SystTreeAutoFlush = athArgs.systTreeAutoFlush
+    if getattr(athArgs, "deltaSystTrees", False):
+        ### The nominal entries referenced by the systematic trees are not preserved by the merge of the worker outputs
+        if getattr(athArgs, "nProcs", 0) > 1:
+            recoLog.warning("The delta encoded systematic trees are not supported in the --nProcs mode. Write the full trees")
+        else:
+            recoLog.info("The systematic trees only store the differences to nominal")
+            BaseHelper.DeltaSystTrees = True
+    if getattr(athArgs, "lheWeightsAsVector", False):
+        recoLog.info("Store the LHE weights in one vector branch")
+        BaseHelper.LHEWeightsAsVector = True
 
     if isData():
         setupGRL()
     else:
         BaseHelper.STCrossSectionDB = xSecDB
+        if len(getattr(athArgs, "xsecSnapshot", "")) > 0:
+            BaseHelper.XsecSnapshot = athArgs.xsecSnapshot
+            BaseHelper.ValidateXsecSnapshot = getattr(athArgs, "validateXsecSnapshot", False)
     #### Some people came up with the idea of assigining the same DSID twice to different
     #### Monte Carlo (Sherpa221_Znunu samples are the first victims of this idea)
     offset = 0
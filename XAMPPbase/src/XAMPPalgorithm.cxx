@@ -2,9 +2,11 @@
 #include "XAMPPalgorithm.h"
 #include <EventInfo/EventStreamInfo.h>
 #include <GaudiKernel/ServiceHandle.h>
+#include <TFile.h>
 #include <XAMPPbase/AnalysisUtils.h>
 #include <XAMPPbase/IAnalysisHelper.h>
 #include <XAMPPbase/ISystematics.h>
+#include <fstream>
 
 __attribute__((constructor)) static void initializer(void) {
     printf(
@@ -45,13 +47,27 @@ namespace XAMPP {
         m_TotSyst(0),
         m_updateTotEvents(false),
         m_TotFiles(0),
-        m_CurrentFile(0) {
+        m_CurrentFile(0),
+        m_allocBudgets(),
+        m_allocMonitors(),
+        m_trackAllocations(false),
+        m_allocReport(""),
+        m_maxAllocGrowth(-1.),
+        m_allocWarmUp(100),
+        m_liveAtWarmUp(0),
+        m_liveAllocs(0) {
         declareProperty("AnalysisHelper", m_helper);
         declareProperty("SystematicsTool", m_systematics);
         declareProperty("RunCutFlow", m_RunCutFlow);
         declareProperty("nevents", m_Events);
         declareProperty("nfiles", m_TotFiles);
         declareProperty("printInterval", m_printInterval);
+        // Stage name -> maximum number of operator new calls per event. Needs libXAMPPAllocationHook.so to be preloaded
+        declareProperty("AllocationBudgets", m_allocBudgets);
+        declareProperty("AllocationReport", m_allocReport);
+        // The live allocations are compared between the beginning of the events after the first AllocationWarmUp events
+        declareProperty("MaxAllocationGrowth", m_maxAllocGrowth);
+        declareProperty("AllocationWarmUp", m_allocWarmUp);
     }
 
     XAMPPalgorithm::~XAMPPalgorithm() {}
@@ -70,6 +86,7 @@ namespace XAMPP {
             return StatusCode::FAILURE;
         }
         m_TotSyst = m_systematics->GetKinematicSystematics().size();
+        ATH_CHECK(initAllocationMonitors());
         m_init = true;
         m_CurrentEvent = 0;
         m_updateTotEvents = (m_Events == 0);
@@ -80,6 +97,10 @@ namespace XAMPP {
     StatusCode XAMPPalgorithm::finalize() {
         ATH_MSG_INFO("Finalizing " << name() << "...");
         m_tsw.Stop();
+        PrintAllocationSummary();
+        ATH_CHECK(WriteAllocationReport());
+        ATH_CHECK(CheckAllocationGrowth());
+        m_systematics->PrintSwitchSummary();
         CHECK(m_helper->finalize());
         return StatusCode::SUCCESS;
     }
@@ -90,7 +111,9 @@ namespace XAMPP {
             return StatusCode::FAILURE;
         }
         ++m_CurrentEvent;
+        TrackAllocationGrowth();
         CHECK(ExecuteEvent());
+        CHECK(CheckAllocationBudgets());
         if (m_RunCutFlow) CHECK(CheckCutflow());
         if (m_printInterval > 0 && m_CurrentEvent % m_printInterval == 0) {
             double t2 = m_tsw.RealTime();
@@ -112,7 +135,9 @@ namespace XAMPP {
 
     StatusCode XAMPPalgorithm::ExecuteEvent() {
         ATH_MSG_DEBUG("Call beginEvent...");
+        startStage(LoadContainers);
         ATH_CHECK(m_helper->LoadContainers());
+        stopStage(LoadContainers);
         ATH_MSG_DEBUG("ExecuteEvent()....");
         if (!m_helper->AcceptEvent()) {
             ATH_MSG_DEBUG("The event is discarded by the AnalysisHelper");
@@ -134,18 +159,26 @@ namespace XAMPP {
             ATH_CHECK(m_systematics->resetSystematics());
             ATH_CHECK(m_systematics->setSystematic(current_syst));
             ATH_MSG_DEBUG("FillInitialObjects: ");
+            startStage(FillInitialObjects);
             ATH_CHECK(m_helper->FillInitialObjects(current_syst));
+            stopStage(FillInitialObjects);
             ATH_MSG_DEBUG("RemoveOverlap: ");
+            startStage(RemoveOverlap);
             ATH_CHECK(m_helper->RemoveOverlap());
+            stopStage(RemoveOverlap);
             ATH_MSG_DEBUG("FillObjects: ");
+            startStage(FillObjects);
             ATH_CHECK(m_helper->FillObjects(current_syst));
+            stopStage(FillObjects);
             ATH_MSG_DEBUG("CleanObjects?");
             if (!m_helper->CleanObjects(current_syst)) {
                 ATH_MSG_DEBUG("Found bad objects in the current systematic" << current_syst->name());
                 continue;
             }
             ATH_MSG_DEBUG("Call FillEvent");
+            startStage(FillEvent);
             ATH_CHECK(m_helper->FillEvent(current_syst));
+            stopStage(FillEvent);
         }
         return StatusCode::SUCCESS;
     }
@@ -154,6 +187,94 @@ namespace XAMPP {
         for (const auto& current_syst : m_systematics->GetKinematicSystematics()) { ATH_CHECK(m_helper->CheckCutFlow(current_syst)); }
         return StatusCode::SUCCESS;
     }
+    StatusCode XAMPPalgorithm::initAllocationMonitors() {
+        if (m_allocBudgets.empty() && m_allocReport.empty() && m_maxAllocGrowth < 0) return StatusCode::SUCCESS;
+        if (!AllocationCounter::isAvailable()) {
+            ATH_MSG_WARNING("Allocations should be counted but libXAMPPAllocationHook.so is not preloaded. Will not count the allocations");
+            return StatusCode::SUCCESS;
+        }
+        static const std::vector<std::string> stage_names{"LoadContainers", "FillInitialObjects", "RemoveOverlap", "FillObjects",
+                                                          "FillEvent"};
+        for (const auto& budget : m_allocBudgets) {
+            if (!IsInVector(budget.first, stage_names)) {
+                ATH_MSG_FATAL("Unknown stage " << budget.first << " to monitor the allocations");
+                return StatusCode::FAILURE;
+            }
+        }
+        for (const auto& stage : stage_names) {
+            std::map<std::string, int>::const_iterator itr = m_allocBudgets.find(stage);
+            m_allocMonitors.push_back(std::make_unique<AllocationMonitor>(stage, itr != m_allocBudgets.end() ? itr->second : -1));
+            ATH_MSG_INFO("Count the allocations in stage " << stage << " with a budget of " << m_allocMonitors.back()->budget()
+                                                            << " per event.");
+        }
+        m_trackAllocations = true;
+        return StatusCode::SUCCESS;
+    }
+    void XAMPPalgorithm::startStage(AllocationStage stage) {
+        if (m_trackAllocations) m_allocMonitors[stage]->start();
+    }
+    void XAMPPalgorithm::stopStage(AllocationStage stage) {
+        if (m_trackAllocations) m_allocMonitors[stage]->stop();
+    }
+    StatusCode XAMPPalgorithm::CheckAllocationBudgets() {
+        if (!m_trackAllocations) return StatusCode::SUCCESS;
+        bool pass = true;
+        for (auto& monitor : m_allocMonitors) {
+            if (monitor->endEvent()) continue;
+            ATH_MSG_ERROR("Stage " << monitor->stage() << " made " << monitor->eventAllocations() << " allocations in event "
+                                   << m_CurrentEvent << ". The budget is " << monitor->budget() << ".");
+            pass = false;
+        }
+        if (!pass) {
+            PrintAllocationSummary();
+            return StatusCode::FAILURE;
+        }
+        return StatusCode::SUCCESS;
+    }
+    void XAMPPalgorithm::PrintAllocationSummary() const {
+        if (!m_trackAllocations) return;
+        ATH_MSG_INFO("Allocations per event in the event loop:");
+        for (const auto& monitor : m_allocMonitors) {
+            ATH_MSG_INFO("  *** " << std::setw(20) << std::left << monitor->stage() << " mean: " << std::setw(10) << monitor->meanAllocations()
+                                  << " max: " << std::setw(10) << monitor->maxAllocations() << " budget: " << monitor->budget());
+        }
+    }
+    void XAMPPalgorithm::TrackAllocationGrowth() {
+        if (!m_trackAllocations) return;
+        // The objects of the previous event have been removed from the store at this point
+        m_liveAllocs = AllocationCounter::liveAllocations();
+        if (m_CurrentEvent == m_allocWarmUp + 1) m_liveAtWarmUp = m_liveAllocs;
+    }
+    StatusCode XAMPPalgorithm::CheckAllocationGrowth() const {
+        if (!m_trackAllocations || m_maxAllocGrowth < 0) return StatusCode::SUCCESS;
+        const long long int n_events = m_CurrentEvent - m_allocWarmUp - 1;
+        if (n_events <= 0) {
+            ATH_MSG_WARNING("Only " << m_CurrentEvent << " events processed. Need more than " << m_allocWarmUp + 1
+                                    << " to check the growth of the allocations.");
+            return StatusCode::SUCCESS;
+        }
+        const double growth = (double)(m_liveAllocs - m_liveAtWarmUp) / (double)n_events;
+        ATH_MSG_INFO("The live allocations changed by " << m_liveAllocs - m_liveAtWarmUp << " over " << n_events
+                                                        << " events after the warm-up, i.e. " << growth << " per event.");
+        if (growth > m_maxAllocGrowth) {
+            ATH_MSG_ERROR("The live allocations grow by " << growth << " per event. Allowed are " << m_maxAllocGrowth << ".");
+            return StatusCode::FAILURE;
+        }
+        return StatusCode::SUCCESS;
+    }
+    StatusCode XAMPPalgorithm::WriteAllocationReport() const {
+        if (!m_trackAllocations || m_allocReport.empty()) return StatusCode::SUCCESS;
+        std::ofstream report(m_allocReport, std::ios::out | std::ios::trunc);
+        // Same format as the --allocationBudgets of runAthena.py
+        for (const auto& monitor : m_allocMonitors) report << monitor->stage() << ":" << monitor->maxAllocations() << std::endl;
+        report.close();
+        if (report.fail()) {
+            ATH_MSG_ERROR("Could not write the allocation report " << m_allocReport);
+            return StatusCode::FAILURE;
+        }
+        ATH_MSG_INFO("Wrote the maximum allocations per event and stage to " << m_allocReport);
+        return StatusCode::SUCCESS;
+    }
     std::string XAMPPalgorithm::TimeHMS(float t) const {
         std::stringstream ostr;
         ostr << std::setw(2) << std::setfill('0') << (int)((t / 60. / 60.)) % 24 << ":" << std::setw(2) << std::setfill('0')
@@ -165,6 +286,7 @@ namespace XAMPP {
         ATH_CHECK(inputMetaStore()->retrieve(esi));
         if (m_updateTotEvents) m_Events += esi->getNumberOfEvents();
         ++m_CurrentFile;
+        ATH_CHECK(m_helper->beginInputFile(currentFile() ? currentFile()->GetUUID().AsString() : ""));
         return StatusCode::SUCCESS;
     }
 
@@ -5,7 +5,11 @@
 #include <AthenaBaseComps/AthAlgorithm.h>
 #include <GaudiKernel/ToolHandle.h>
 #include <TStopwatch.h>
+#include <XAMPPbase/AllocationCounter.h>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace XAMPP {
     class IAnalysisHelper;
@@ -24,6 +28,17 @@ namespace XAMPP {
         StatusCode CheckCutflow();
         StatusCode ExecuteEvent();
 
+        // Stages of the event loop for which the calls to operator new are counted
+        enum AllocationStage { LoadContainers = 0, FillInitialObjects, RemoveOverlap, FillObjects, FillEvent, nAllocationStages };
+        StatusCode initAllocationMonitors();
+        void startStage(AllocationStage stage);
+        void stopStage(AllocationStage stage);
+        StatusCode CheckAllocationBudgets();
+        void PrintAllocationSummary() const;
+        void TrackAllocationGrowth();
+        StatusCode CheckAllocationGrowth() const;
+        StatusCode WriteAllocationReport() const;
+
         ToolHandle<XAMPP::ISystematics> m_systematics;
         ToolHandle<XAMPP::IAnalysisHelper> m_helper;
 
@@ -39,6 +54,19 @@ namespace XAMPP {
         bool m_updateTotEvents;  // Update the number of total events at the beginning of each file
         unsigned int m_TotFiles;
         unsigned int m_CurrentFile;
+
+        // Budgets of allocations per event and stage. A negative budget only monitors the stage
+        std::map<std::string, int> m_allocBudgets;
+        std::vector<std::unique_ptr<AllocationMonitor>> m_allocMonitors;
+        bool m_trackAllocations;
+        // File to which the maximum allocations per event and stage are written. Used as budgets of later jobs
+        std::string m_allocReport;
+        // Maximum mean growth of the live allocations per event after the warm-up. A negative value disables the check
+        double m_maxAllocGrowth;
+        long long int m_allocWarmUp;
+        long long int m_liveAtWarmUp;
+        long long int m_liveAllocs;
+
         std::string TimeHMS(float t) const;
     };
 
@@ -0,0 +1,124 @@
+#! /usr/bin/env python
+import os, shutil, tempfile, unittest
+from array import array
+import ROOT
+
+
+def EventHash(event):
+    ### Same layout as the CommonEventHash branch of the XAMPP ntuples. The second word holds the run number
+    return (event, 1000 + event % 3)
+
+
+class FriendTreeReaderTest(unittest.TestCase):
+    """Writes a tree with a friend containing every second event in reverse order, reads the friend index
+       back from the .hashidx sidecar and checks that it is rejected for another file or another tree.
+       The friend is registered to the tree in ROOT as done by the TreeBase"""
+    def setUp(self):
+        self.tmp_dir = tempfile.mkdtemp()
+        self.file_path = "%s/ntuple.root" % (self.tmp_dir)
+        self.n_events = 100
+        out_file = ROOT.TFile.Open(self.file_path, "RECREATE")
+        for tree_name, events in [("Common", range(self.n_events)), ("Friend", range(self.n_events - 2, -1, -2))]:
+            tree = ROOT.TTree(tree_name, tree_name)
+            event_hash = array("L", [0, 0])
+            value = array("d", [0.])
+            tree.Branch("CommonEventHash", event_hash, "CommonEventHash[2]/l")
+            tree.Branch("%sValue" % (tree_name), value, "%sValue/D" % (tree_name))
+            if tree_name == "Common": tree.AddFriend("Friend")
+            for e in events:
+                event_hash[0], event_hash[1] = EventHash(e)
+                value[0] = self.value(tree_name, e)
+                tree.Fill()
+            out_file.WriteObject(tree, tree_name)
+        self.uuid = out_file.GetUUID().AsString()
+        out_file.Close()
+        self.root_file = ROOT.TFile.Open(self.file_path, "READ")
+        self.sidecar = "%s.Friend.hashidx" % (self.file_path)
+
+    def value(self, tree_name, event):
+        return event * (0.5 if tree_name == "Friend" else 1.)
+
+    def friend_entry(self, event):
+        return (self.n_events - 2 - event) // 2
+
+    def tearDown(self):
+        self.root_file.Close()
+        shutil.rmtree(self.tmp_dir)
+
+    def check_reader(self, reader):
+        self.assertTrue(reader.addFriend("Friend"))
+        self.assertTrue(reader.Init())
+        self.assertEqual(reader.GetEntries(), self.n_events)
+        for e in range(self.n_events):
+            self.assertTrue(reader.GetEntry(e))
+            self.assertEqual(reader.hasFriendEntry("Friend"), e % 2 == 0)
+
+    def test_sidecar(self):
+        self.assertFalse(os.path.exists(self.sidecar))
+        self.check_reader(ROOT.XAMPP.FriendTreeReader(self.root_file, "Common"))
+        self.assertTrue(os.path.exists(self.sidecar))
+        ### The index written by the first reader is read back
+        friend = self.root_file.Get("Friend")
+        index = ROOT.XAMPP.EventHashIndex()
+        self.assertTrue(index.load(self.sidecar, self.uuid, friend.GetEntries()))
+        self.assertEqual(index.entries(), self.n_events // 2)
+        for e in range(self.n_events):
+            h0, h1 = EventHash(e)
+            self.assertEqual(index.find(h0, h1), self.friend_entry(e) if e % 2 == 0 else -1)
+        ### The index belongs to this file and tree only
+        self.assertFalse(ROOT.XAMPP.EventHashIndex().load(self.sidecar, ROOT.TUUID().AsString(), friend.GetEntries()))
+        self.assertFalse(ROOT.XAMPP.EventHashIndex().load(self.sidecar, self.uuid, friend.GetEntries() + 1))
+        ### A second reader uses the sidecar instead of reading the friend again
+        ### A rebuilt index would be moved in place as a new file
+        inode = os.stat(self.sidecar).st_ino
+        self.check_reader(ROOT.XAMPP.FriendTreeReader(self.root_file, "Common"))
+        self.assertEqual(os.stat(self.sidecar).st_ino, inode)
+
+    def test_columns(self):
+        reader = ROOT.XAMPP.FriendTreeReader(self.root_file, "Common")
+        self.assertTrue(reader.addFriend("Friend"))
+        main_value = getattr(reader, "column<double>")("CommonValue")
+        friend_value = getattr(reader, "column<double>")("FriendValue")
+        ### The friend is no longer read by ROOT at the entry of the main tree
+        common = self.root_file.Get("Common")
+        self.assertFalse(common.GetListOfFriends() and common.GetListOfFriends().GetEntries())
+        friend = self.root_file.Get("Friend")
+        for e in range(self.n_events):
+            self.assertTrue(reader.GetEntry(e))
+            self.assertEqual(main_value[0], self.value("Common", e))
+            if e % 2 == 0:
+                self.assertTrue(reader.hasFriendEntry("Friend"))
+                self.assertEqual(friend_value[0], self.value("Friend", e))
+                self.assertEqual(friend.GetReadEntry(), self.friend_entry(e))
+            else:
+                ### The friend keeps the values of the last event it contains
+                self.assertFalse(reader.hasFriendEntry("Friend"))
+                self.assertEqual(friend_value[0], self.value("Friend", e - 1))
+                self.assertEqual(friend.GetReadEntry(), self.friend_entry(e - 1))
+
+    def test_build_and_save(self):
+        friend = self.root_file.Get("Friend")
+        index = ROOT.XAMPP.EventHashIndex()
+        self.assertTrue(index.build(friend))
+        path = "%s/friend.hashidx" % (self.tmp_dir)
+        self.assertTrue(index.save(path, self.uuid))
+        loaded = ROOT.XAMPP.EventHashIndex()
+        self.assertTrue(loaded.load(path, self.uuid, friend.GetEntries()))
+        self.assertEqual(loaded.memory(), index.memory())
+        h0, h1 = EventHash(0)
+        self.assertEqual(loaded.find(h0, h1), index.find(h0, h1))
+        ### A truncated file is rejected
+        with open(path, "rb") as in_file:
+            content = in_file.read()
+        with open(path, "wb") as out_file:
+            out_file.write(content[:len(content) // 2])
+        self.assertFalse(ROOT.XAMPP.EventHashIndex().load(path, self.uuid, friend.GetEntries()))
+        ### The index directory replaces the directory of the ROOT file
+        index_dir = "%s/indices" % (self.tmp_dir)
+        os.mkdir(index_dir)
+        self.check_reader(ROOT.XAMPP.FriendTreeReader(self.root_file, "Common", index_dir))
+        self.assertTrue(os.path.exists("%s/ntuple.root.Friend.hashidx" % (index_dir)))
+
+
+if __name__ == '__main__':
+    unittest.main()
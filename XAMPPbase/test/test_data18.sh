@@ -73,3 +73,11 @@ fi
 # Evalulate cut flows        #
 ##############################
 python ${TestArea}/XAMPPbase/python/printCutFlow.py -i ${TESTRESULT} -a MyCutFlow | tee cutflow.txt
+
+# the compiled AggregateCutFlows has to print the same cut flow as the script
+AggregateCutFlows -i ${TESTRESULT} -a MyCutFlow > cutflow_aggregated.txt
+diff cutflow.txt cutflow_aggregated.txt
+if [ $? -ne 0 ]; then
+  printf '%s\n' "The cut flow of AggregateCutFlows differs from the one of printCutFlow.py" >&2
+  exit 1
+fi
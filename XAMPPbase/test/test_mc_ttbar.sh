@@ -1,4 +1,19 @@
 #!/bin/bash
+# Usage: test_mc_ttbar.sh [nProcs | --allocations]
+# With nProcs > 1 the job runs with nProcs AthenaMP workers and its cut flow
+# is compared to the one of a serial job over the same events.
+# With --allocations the calls to operator new are counted. The job fails if a
+# stage exceeds the budget measured in the reference run (allocation_budgets.txt
+# next to this script) by more than 10% or if the live allocations grow from
+# event to event. The maxima measured by the job are written to
+# test_job/allocation_report.txt. Copy them over the reference to update it.
+ALLOCATIONS=0
+NPROCS=1
+if [ "$1" == "--allocations" ]; then
+    ALLOCATIONS=1
+elif [ -n "$1" ]; then
+    NPROCS=$1
+fi
 
 ##############################
 # Setup                      #
@@ -24,9 +39,17 @@ fi
 
 # definition of folder for storing test results
 TESTDIR=test_job/
+if [ ${NPROCS} -gt 1 ]; then
+    TESTDIR=test_job_mp/
+elif [ ${ALLOCATIONS} -eq 1 ]; then
+    TESTDIR=test_job_alloc/
+fi
 TESTFILE="root://eoshome.cern.ch//eos/user/x/xampp/ci/base/DAOD_SUSY1.15084993._000088.pool.root.1"
 LOCALCOPY=DxAOD.root
 TESTRESULT=processedNtuple.root
+SERIALRESULT=processedNtuple_serial.root
+ALLOCREFERENCE=${TestArea}/XAMPPbase/test/allocation_budgets.txt
+ALLOCREPORT=allocation_report.txt
 
 ##############################
 # Process test sample        #
@@ -52,12 +75,33 @@ if [ ! -f ${LOCALCOPY} ]; then
 fi
 
 # clean up old job result
-if [ -f ${TESTRESULT} ]; then
-    rm ${TESTRESULT} 
-fi
+for f in ${TESTRESULT} ${SERIALRESULT} ${ALLOCREPORT}; do
+    if [ -f ${f} ]; then
+        rm ${f}
+    fi
+done
 
 # run job
-python ${TestArea}/XAMPPbase/python/runAthena.py --noSyst --filesInput ${LOCALCOPY} --outFile ${TESTRESULT} --jobOptions XAMPPbase/runXAMPPbase.py --noSyst
+if [ ${NPROCS} -gt 1 ]; then
+    # the reference job runs serially over the same events
+    python ${TestArea}/XAMPPbase/python/runAthena.py --noSyst --filesInput ${LOCALCOPY} --outFile ${SERIALRESULT} --jobOptions XAMPPbase/runXAMPPbase.py --evtMax 2000
+    if [ $? -ne 0 ]; then
+      printf '%s\n' "Execution of the serial runAthena.py failed" >&2
+      exit 1
+    fi
+    python ${TestArea}/XAMPPbase/python/runAthena.py --noSyst --filesInput ${LOCALCOPY} --outFile ${TESTRESULT} --jobOptions XAMPPbase/runXAMPPbase.py --evtMax 2000 --nProcs ${NPROCS} --eventsPerRange 50
+elif [ ${ALLOCATIONS} -eq 1 ]; then
+    # the budgets are the measured maxima per event and stage plus a margin of 10%
+    if [ ! -f ${ALLOCREFERENCE} ]; then
+        printf '%s\n' "The reference allocations ${ALLOCREFERENCE} do not exist" >&2
+        exit 1
+    fi
+    BUDGETS="--allocationBudgets $(awk -F: '{printf "%s:%d ", $1, $2 * 1.1 + 1}' ${ALLOCREFERENCE})"
+    python ${TestArea}/XAMPPbase/python/runAthena.py --noSyst --filesInput ${LOCALCOPY} --outFile ${TESTRESULT} --jobOptions XAMPPbase/runXAMPPbase.py --evtMax 500 \
+        ${BUDGETS} --allocationReport ${ALLOCREPORT} --maxAllocationGrowth 0
+else
+    python ${TestArea}/XAMPPbase/python/runAthena.py --noSyst --filesInput ${LOCALCOPY} --outFile ${TESTRESULT} --jobOptions XAMPPbase/runXAMPPbase.py --noSyst
+fi
 
 
 ###################################################
@@ -67,9 +111,30 @@ if [ $? -ne 0 ]; then
   printf '%s\n' "Execution of runAthena.py failed" >&2  # write error message to stderr
   exit 1
 fi
+if [ ${ALLOCATIONS} -eq 1 ]; then
+  exit 0
+fi
 
 
 ##############################
 # Evalulate cut flows        #
 ##############################
 python ${TestArea}/XAMPPbase/python/printCutFlow.py -i ${TESTRESULT} -a MyCutFlow | tee cutflow.txt
+
+# the compiled AggregateCutFlows has to print the same raw and weighted cut flows as the script
+python ${TestArea}/XAMPPbase/python/printCutFlow.py -i ${TESTRESULT} -a MyCutFlow --weighted > cutflow_weighted.txt
+AggregateCutFlows -i ${TESTRESULT} -a MyCutFlow > cutflow_aggregated.txt
+AggregateCutFlows -i ${TESTRESULT} -a MyCutFlow --weighted > cutflow_aggregated_weighted.txt
+diff cutflow.txt cutflow_aggregated.txt && diff cutflow_weighted.txt cutflow_aggregated_weighted.txt
+if [ $? -ne 0 ]; then
+  printf '%s\n' "The cut flow of AggregateCutFlows differs from the one of printCutFlow.py" >&2
+  exit 1
+fi
+if [ ${NPROCS} -gt 1 ]; then
+  python ${TestArea}/XAMPPbase/python/printCutFlow.py -i ${SERIALRESULT} -a MyCutFlow > cutflow_serial.txt
+  diff cutflow_serial.txt cutflow.txt
+  if [ $? -ne 0 ]; then
+    printf '%s\n' "The cut flow of the parallel job differs from the serial one" >&2
+    exit 1
+  fi
+fi
@@ -0,0 +1,440 @@
+#include <TDirectory.h>
+#include <TError.h>
+#include <TFile.h>
+#include <TH1.h>
+#include <TROOT.h>
+#include <TTree.h>
+#include <XAMPPbase/AnalysisUtils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//###############################################################################
+//  Compiled counterpart of printCutFlow.py. The MetaDataTrees and the          #
+//  Histos_<analysis>_<syst>/InfoHistograms/DSID_<id>_CutFlow(_weighted)         #
+//  histograms of the input files are read in parallel threads, one file at a   #
+//  time per thread. The metadata entries are indexed by a hash of              #
+//  (DSID, process id) or the run number instead of searching the list of all   #
+//  samples for each entry. The results of the files are combined in the order  #
+//  of the input files such that the printout is the same as of the script,     #
+//  which is checked by the test jobs in XAMPPbase/test.                        #
+//  Optionally, a JSON summary of the samples and their cutflows is written.    #
+//###############################################################################
+namespace {
+    const char* const AppName = "AggregateCutFlows";
+
+    struct Sample {
+        bool isData = false;
+        unsigned int DSID = 0;
+        unsigned int procID = 0;
+        unsigned int runNumber = 0;
+        double xSec = -1.;
+        Long64_t TotalEvents = 0;
+        Long64_t ProcessedEvents = 0;
+        double SumW = 0.;
+        unsigned long long key() const {
+            if (isData) return (1ull << 63) | runNumber;
+            return (static_cast<unsigned long long>(DSID) << 32) | procID;
+        }
+        void add(const Sample& other) {
+            TotalEvents += other.TotalEvents;
+            ProcessedEvents += other.ProcessedEvents;
+            SumW += other.SumW;
+        }
+    };
+
+    struct CutFlow {
+        std::string name;
+        std::vector<std::string> labels;
+        std::vector<double> content;
+        std::vector<double> sumw2;
+        void add(const CutFlow& other) {
+            if (content.empty()) {
+                *this = other;
+                return;
+            }
+            for (size_t b = 0; b < content.size() && b < other.content.size(); ++b) {
+                content[b] += other.content[b];
+                sumw2[b] += other.sumw2[b];
+            }
+        }
+    };
+
+    // Samples in the order of their first appearance and the cutflows by their path in the file
+    class Summary {
+    public:
+        void add(const Sample& sample) {
+            std::unordered_map<unsigned long long, size_t>::const_iterator itr = m_index.find(sample.key());
+            if (itr != m_index.end()) {
+                m_samples[itr->second].add(sample);
+                return;
+            }
+            m_index.insert(std::make_pair(sample.key(), m_samples.size()));
+            m_samples.push_back(sample);
+        }
+        void add(const std::string& path, const CutFlow& cutflow) { m_cutflows[path].add(cutflow); }
+        void add(const Summary& other) {
+            for (const auto& sample : other.m_samples) add(sample);
+            for (const auto& cutflow : other.m_cutflows) add(cutflow.first, cutflow.second);
+        }
+        const std::vector<Sample>& samples() const { return m_samples; }
+        const CutFlow* cutflow(const std::string& path) const {
+            std::unordered_map<std::string, CutFlow>::const_iterator itr = m_cutflows.find(path);
+            return itr != m_cutflows.end() ? &itr->second : nullptr;
+        }
+
+    private:
+        std::vector<Sample> m_samples;
+        std::unordered_map<unsigned long long, size_t> m_index;
+        std::unordered_map<std::string, CutFlow> m_cutflows;
+    };
+
+    struct Options {
+        std::string analysis;
+        std::string systematic = "Nominal";
+        bool weighted = false;
+        bool weightedNoXSec = false;
+        bool sumUpData = false;
+        double lumi = 1.;
+    };
+
+    std::string DataCutFlowPath(const Options& opt, unsigned int run) {
+        return "Histos_" + opt.analysis + "_Nominal/InfoHistograms/DSID_" + std::to_string(run) + "_CutFlow";
+    }
+    std::string MCCutFlowPath(const Options& opt, unsigned int DSID) {
+        return "Histos_" + opt.analysis + "_" + opt.systematic + "/InfoHistograms/DSID_" + std::to_string(DSID) + "_CutFlow" +
+               (opt.weighted ? "_weighted" : "");
+    }
+
+    bool ReadFile(const std::string& file_name, const Options& opt, Summary& summary) {
+        std::unique_ptr<TFile> file(TFile::Open(file_name.c_str(), "READ"));
+        if (!file || !file->IsOpen()) {
+            Error(AppName, "Could not open %s", file_name.c_str());
+            return false;
+        }
+        TTree* tree = nullptr;
+        file->GetObject("MetaDataTree", tree);
+        if (!tree) {
+            Error(AppName, "No MetaDataTree in %s", file_name.c_str());
+            return false;
+        }
+        bool isData = false;
+        unsigned int mcChannelNumber = 0, runNumber = 0, ProcessID = 0;
+        double xSection = 0., kFactor = 0., FilterEfficiency = 0., TotalSumW = 0.;
+        Long64_t TotalEvents = 0, ProcessedEvents = 0;
+        tree->SetBranchStatus("*", 0);
+        for (const char* branch : {"isData", "mcChannelNumber", "runNumber", "ProcessID", "xSection", "kFactor", "FilterEfficiency",
+                                   "TotalSumW", "TotalEvents", "ProcessedEvents"}) {
+            if (tree->GetBranch(branch)) tree->SetBranchStatus(branch, 1);
+        }
+        tree->SetBranchAddress("isData", &isData);
+        tree->SetBranchAddress("runNumber", &runNumber);
+        tree->SetBranchAddress("TotalEvents", &TotalEvents);
+        tree->SetBranchAddress("ProcessedEvents", &ProcessedEvents);
+        // The MC branches only exist if MC has been processed
+        const bool hasMC = tree->GetBranch("mcChannelNumber") != nullptr;
+        if (hasMC) {
+            tree->SetBranchAddress("mcChannelNumber", &mcChannelNumber);
+            tree->SetBranchAddress("ProcessID", &ProcessID);
+            tree->SetBranchAddress("xSection", &xSection);
+            tree->SetBranchAddress("kFactor", &kFactor);
+            tree->SetBranchAddress("FilterEfficiency", &FilterEfficiency);
+            tree->SetBranchAddress("TotalSumW", &TotalSumW);
+        }
+        std::set<std::string> paths;
+        const Long64_t entries = tree->GetEntries();
+        for (Long64_t e = 0; e < entries; ++e) {
+            if (tree->GetEntry(e) <= 0) {
+                Error(AppName, "Could not read entry %lld of the MetaDataTree in %s", e, file_name.c_str());
+                return false;
+            }
+            // processIDs greater than 1000 correspond to LHE variations. They are not of interest for the cutflow comparison
+            if (!isData && ProcessID > 1000) continue;
+            Sample sample;
+            sample.isData = isData;
+            sample.runNumber = runNumber;
+            sample.TotalEvents = TotalEvents;
+            sample.ProcessedEvents = ProcessedEvents;
+            if (!isData) {
+                sample.DSID = mcChannelNumber;
+                sample.procID = ProcessID;
+                sample.xSec = xSection * kFactor * FilterEfficiency;
+                sample.SumW = TotalSumW;
+            }
+            summary.add(sample);
+            paths.insert(isData ? DataCutFlowPath(opt, runNumber) : MCCutFlowPath(opt, mcChannelNumber));
+        }
+        for (const auto& path : paths) {
+            // The histograms are not attached to the file and must be deleted
+            TH1* raw_histo = nullptr;
+            file->GetObject(path.c_str(), raw_histo);
+            std::unique_ptr<TH1> histo(raw_histo);
+            if (!histo) continue;
+            CutFlow cutflow;
+            cutflow.name = histo->GetName();
+            const int n_bins = histo->GetNbinsX();
+            for (int b = 1; b <= n_bins; ++b) {
+                cutflow.labels.push_back(histo->GetXaxis()->GetBinLabel(b));
+                cutflow.content.push_back(histo->GetBinContent(b));
+                cutflow.sumw2.push_back(histo->GetBinError(b) * histo->GetBinError(b));
+            }
+            summary.add(path, cutflow);
+        }
+        return true;
+    }
+
+    std::string Format(const char* format, double value) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), format, value);
+        return buffer;
+    }
+    // str() of a float in python 2, i.e. 12 significant digits and a trailing .0 for integral values
+    std::string PythonStr(double value) {
+        std::string str = Format("%.12g", value);
+        if (std::isfinite(value) && str.find_first_of(".e") == std::string::npos) str += ".0";
+        return str;
+    }
+    std::string LeftJustified(const std::string& str, size_t width) {
+        return str.size() >= width ? str : str + std::string(width - str.size(), ' ');
+    }
+    // Same layout as prettyPrint of printCutFlow.py
+    void PrettyPrint(const std::string& preamble, const std::string& data1, const std::string& data2, size_t width1, size_t width2 = 10,
+                     const std::string& separator2 = "") {
+        std::cout << LeftJustified(preamble, width1) << LeftJustified(data1, width2) << separator2 << data2 << std::endl;
+    }
+    void PrintCutFlow(const CutFlow& cutflow, double weight, bool doRaw, const std::string& systematic, double lumi) {
+        size_t width1 = 0;
+        for (const auto& label : cutflow.labels) width1 = std::max(width1, label.size() + 2);
+        PrettyPrint("CutFlowHisto", cutflow.name, "", width1);
+        PrettyPrint("Systematic variation", systematic, "", width1);
+        const std::string separator(width1 + std::max(cutflow.name.size(), systematic.size()), '#');
+        std::cout << separator << std::endl;
+        PrettyPrint("Cut", "Yields", "", width1);
+        std::cout << separator << std::endl;
+        size_t width2 = 0;
+        for (size_t b = 0; b < cutflow.content.size(); ++b) {
+            if (cutflow.content[b] == 0) break;
+            const double error = std::sqrt(cutflow.sumw2[b]);
+            std::string content, error_str;
+            if (doRaw) {
+                content = Format("%.0f ", cutflow.content[b] * weight);
+                error_str = Format(" %.2f", error * weight);
+            } else {
+                content = Format("%.8f ", cutflow.content[b] * weight * lumi);
+                error_str = Format(" %.8f", error * weight * lumi);
+            }
+            if (b == 0) width2 = content.size();
+            PrettyPrint(cutflow.labels[b], content, error_str, width1, width2, "±");
+        }
+        std::cout << separator << std::endl;
+    }
+
+    std::string JSONString(const std::string& str) {
+        std::string out = "\"";
+        for (const char c : str) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        return out + "\"";
+    }
+    void WriteCutFlow(std::ostream& out, const CutFlow* cutflow, double weight) {
+        out << "[";
+        for (size_t b = 0; cutflow && b < cutflow->content.size(); ++b) {
+            out << (b ? ", " : "") << "{\"cut\": " << JSONString(cutflow->labels[b]) << ", \"yield\": " << cutflow->content[b] * weight
+                << ", \"error\": " << std::sqrt(cutflow->sumw2[b]) * weight << "}";
+        }
+        out << "]";
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    std::vector<std::string> in_files;
+    std::string summary_file;
+    unsigned int n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--inputFile" || argument == "-i") {
+            // ROOT files and text files listing them
+            for (++a; a < argc && argv[a][0] != '-'; ++a) {
+                std::string value = argv[a];
+                if (XAMPP::IsROOTFile(value)) {
+                    in_files.push_back(value);
+                    continue;
+                }
+                std::ifstream list(value);
+                if (!list.good()) {
+                    Error(AppName, "Could not read the file list %s", value.c_str());
+                    return EXIT_FAILURE;
+                }
+                std::string line;
+                while (XAMPP::GetLine(list, line)) XAMPP::FillVectorFromString(in_files, line);
+            }
+            --a;
+        } else if (argument == "--analysis" || argument == "-a") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            opt.analysis = argv[++a];
+        } else if (argument == "--systematic" || argument == "--syst" || argument == "-s") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            opt.systematic = argv[++a];
+        } else if (argument == "--lumi" || argument == "-l") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            opt.lumi = std::atof(argv[++a]);
+        } else if (argument == "--weighted") {
+            opt.weighted = true;
+        } else if (argument == "--weightedNoXSec") {
+            opt.weightedNoXSec = true;
+        } else if (argument == "--sumUpData") {
+            opt.sumUpData = true;
+        } else if (argument == "--nThreads" || argument == "-j") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            n_threads = std::max(1, std::atoi(argv[++a]));
+        } else if (argument == "--summary") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            summary_file = argv[++a];
+        } else {
+            Error(AppName, "Unknown argument %s", argument.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (opt.analysis.empty() || in_files.empty()) {
+        Error(AppName, "Usage: %s --analysis <analysis> --inputFile <files or lists> [--systematic <syst>] [--weighted] [--weightedNoXSec]",
+              AppName);
+        Error(AppName, "       [--lumi <pb^-1>] [--sumUpData] [--nThreads <n>] [--summary <json file>]");
+        return EXIT_FAILURE;
+    }
+    // The cutflows are copied out of the histograms. The histograms do not need to be attached to any directory
+    ROOT::EnableThreadSafety();
+    TH1::AddDirectory(false);
+
+    std::vector<Summary> file_summaries(in_files.size());
+    std::atomic<size_t> next_file(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> workers;
+    n_threads = std::min<size_t>(n_threads, in_files.size());
+    for (unsigned int t = 0; t < n_threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t f = next_file++; f < in_files.size() && !failed; f = next_file++) {
+                if (!ReadFile(in_files[f], opt, file_summaries[f])) failed = true;
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    if (failed) return EXIT_FAILURE;
+
+    Summary summary;
+    for (const auto& file_summary : file_summaries) {
+        std::cout << "Extracting MetaData information..." << std::endl;
+        summary.add(file_summary);
+    }
+    const std::vector<Sample>& samples = summary.samples();
+
+    // Weight applied to the cutflow of each sample. The summary reports the same yields as the printout
+    std::vector<double> weights(samples.size(), 1.);
+    std::vector<std::string> paths(samples.size());
+    bool hasData = false, hasMC = false;
+    std::unordered_map<unsigned int, std::vector<size_t>> processes;
+    for (size_t s = 0; s < samples.size(); ++s) {
+        if (!samples[s].isData) processes[samples[s].DSID].push_back(s);
+    }
+    for (size_t s = 0; s < samples.size(); ++s) {
+        const Sample& sample = samples[s];
+        hasData = hasData || sample.isData;
+        hasMC = hasMC || !sample.isData;
+        paths[s] = sample.isData ? DataCutFlowPath(opt, sample.runNumber) : MCCutFlowPath(opt, sample.DSID);
+        if (sample.isData || !opt.weighted) continue;
+        double xSec = 0.;
+        if (sample.procID != 0) {
+            xSec = sample.xSec;
+        } else {
+            // Sum over the processes of the DSID. The inclusive process is only used if there is no other
+            const std::vector<size_t>& procs = processes[sample.DSID];
+            for (size_t p : procs) {
+                if (procs.size() == 1 || samples[p].procID != 0) xSec += samples[p].xSec;
+            }
+        }
+        // The xsection is given in pb
+        weights[s] = 1.e3 * (opt.weightedNoXSec ? 1. : xSec) / sample.SumW;
+    }
+
+    if (hasData) {
+        std::cout << "Having found CutFlow for Data, printing..." << std::endl;
+        CutFlow summed;
+        for (size_t s = 0; s < samples.size(); ++s) {
+            if (!samples[s].isData) continue;
+            const CutFlow* cutflow = summary.cutflow(paths[s]);
+            if (!opt.sumUpData) {
+                if (!cutflow) {
+                    Error(AppName, "Could not find cutflow histo %s", paths[s].c_str());
+                    return EXIT_FAILURE;
+                }
+                PrintCutFlow(*cutflow, 1., true, "", 1.);
+            } else if (cutflow) {
+                summed.add(*cutflow);
+            }
+        }
+        if (opt.sumUpData) PrintCutFlow(summed, 1., true, "", 1.);
+    }
+    if (hasMC) {
+        std::cout << "Having found CutFlow for MC, printing..." << std::endl;
+        for (size_t s = 0; s < samples.size(); ++s) {
+            if (samples[s].isData) continue;
+            const CutFlow* cutflow = summary.cutflow(paths[s]);
+            if (!cutflow) {
+                Error(AppName, "Could not find cutflow histo %s", paths[s].c_str());
+                return EXIT_FAILURE;
+            }
+            if (opt.weighted) {
+                if (!opt.weightedNoXSec)
+                    std::cout << "Printing weighted events (with xSection weight " << PythonStr(weights[s]) << ")" << std::endl;
+                else
+                    std::cout << "Printing weighted events (without xSection weight)" << std::endl;
+                PrintCutFlow(*cutflow, weights[s], false, opt.systematic, opt.lumi);
+            } else {
+                std::cout << "Printing raw events" << std::endl;
+                PrintCutFlow(*cutflow, 1., true, opt.systematic, 1.);
+            }
+        }
+    }
+
+    if (!summary_file.empty()) {
+        std::ofstream out(summary_file);
+        if (!out.good()) {
+            Error(AppName, "Could not write the summary %s", summary_file.c_str());
+            return EXIT_FAILURE;
+        }
+        out.precision(12);
+        out << "{\"analysis\": " << JSONString(opt.analysis) << ", \"systematic\": " << JSONString(opt.systematic)
+            << ", \"weighted\": " << (opt.weighted ? "true" : "false") << ", \"lumi\": " << opt.lumi << ", \"samples\": [" << std::endl;
+        for (size_t s = 0; s < samples.size(); ++s) {
+            const Sample& sample = samples[s];
+            // Weighted MC yields are given for the luminosity
+            const double weight = weights[s] * (!sample.isData && opt.weighted ? opt.lumi : 1.);
+            out << "  {\"isData\": " << (sample.isData ? "true" : "false") << ", \"runNumber\": " << sample.runNumber;
+            if (!sample.isData) {
+                out << ", \"DSID\": " << sample.DSID << ", \"ProcessID\": " << sample.procID << ", \"xSection\": " << sample.xSec
+                    << ", \"SumW\": " << sample.SumW;
+            }
+            out << ", \"TotalEvents\": " << sample.TotalEvents << ", \"ProcessedEvents\": " << sample.ProcessedEvents
+                << ", \"CutFlowHisto\": " << JSONString(paths[s]) << ", \"CutFlow\": ";
+            WriteCutFlow(out, summary.cutflow(paths[s]), weight);
+            out << "}" << (s + 1 < samples.size() ? "," : "") << std::endl;
+        }
+        out << "]}" << std::endl;
+        std::cout << "Wrote the summary of " << samples.size() << " samples to " << summary_file << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+// Replacement of the global operator new/delete counting each allocation and deallocation.
+// The library is meant to be preloaded into the job
+//      LD_PRELOAD=libXAMPPAllocationHook.so athena.py ...
+// The counters are read out by XAMPP::AllocationCounter via the XAMPP_AllocationCount
+// and XAMPP_DeallocationCount symbols
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<unsigned long long> s_allocations(0);
+    std::atomic<unsigned long long> s_deallocations(0);
+
+    void* countedMalloc(std::size_t size) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        return std::malloc(size ? size : 1);
+    }
+    void* countedNew(std::size_t size) {
+        void* ptr = countedMalloc(size);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+    void countedFree(void* ptr) {
+        // Deleting a null pointer is not a deallocation
+        if (!ptr) return;
+        s_deallocations.fetch_add(1, std::memory_order_relaxed);
+        std::free(ptr);
+    }
+#if __cpp_aligned_new
+    void* countedAlignedMalloc(std::size_t size, std::align_val_t alignment) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        // posix_memalign needs at least the alignment of a pointer. The memory is released by free
+        std::size_t align = static_cast<std::size_t>(alignment);
+        if (align < sizeof(void*)) align = sizeof(void*);
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, align, size ? size : 1) != 0) return nullptr;
+        return ptr;
+    }
+    void* countedAlignedNew(std::size_t size, std::align_val_t alignment) {
+        void* ptr = countedAlignedMalloc(size, alignment);
+        if (!ptr) throw std::bad_alloc();
+        return ptr;
+    }
+#endif
+}  // namespace
+
+extern "C" unsigned long long XAMPP_AllocationCount() { return s_allocations.load(std::memory_order_relaxed); }
+extern "C" unsigned long long XAMPP_DeallocationCount() { return s_deallocations.load(std::memory_order_relaxed); }
+
+void* operator new(std::size_t size) { return countedNew(size); }
+void* operator new[](std::size_t size) { return countedNew(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedMalloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedMalloc(size); }
+
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr); }
+
+#if __cpp_aligned_new
+// Over-aligned types (alignas larger than the one of malloc) are allocated via these overloads
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedNew(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedNew(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedMalloc(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return countedAlignedMalloc(size, alignment);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { countedFree(ptr); }
+#endif
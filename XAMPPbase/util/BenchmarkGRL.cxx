@@ -0,0 +1,128 @@
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/GoodRunsLookup.h>
+
+#include <GoodRunsLists/GoodRunsListSelectionTool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+//###########################################################################
+//  Compares the GoodRunsLookup with the GoodRunsListSelectionTool. For     #
+//  each run of the GRLs the lumi blocks 0 ... maxLB are queried with       #
+//  eventsPerLB events each, once sorted by run and lumi block like the     #
+//  data and once in random order. The time to build the lookup from the    #
+//  xml files and from the binary cache, the number of deviating decisions  #
+//  and the time per query are printed.                                     #
+//###########################################################################
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    typedef std::pair<unsigned int, unsigned int> RunLB;
+    void Benchmark(const std::string& category, const std::vector<RunLB>& queries, const GoodRunsListSelectionTool& tool,
+                   const XAMPP::GoodRunsLookup& lookup) {
+        const size_t n = queries.size();
+        std::vector<char> reference(n), decision(n);
+
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < n; ++i) reference[i] = tool.passRunLB(queries[i].first, queries[i].second);
+        double t_tool = Seconds(start);
+
+        unsigned long long hits = lookup.nLastHits();
+        start = Clock::now();
+        for (size_t i = 0; i < n; ++i) decision[i] = lookup.passRunLB(queries[i].first, queries[i].second);
+        double t_lookup = Seconds(start);
+        hits = lookup.nLastHits() - hits;
+
+        size_t n_deviations = 0, n_good = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (reference[i] != decision[i]) {
+                if (n_deviations < 10)
+                    std::cout << "BenchmarkGRL: Run " << queries[i].first << ", lumi block " << queries[i].second
+                              << " tool: " << int(reference[i]) << ", lookup: " << int(decision[i]) << std::endl;
+                ++n_deviations;
+            }
+            if (reference[i]) ++n_good;
+        }
+        std::cout << "BenchmarkGRL: " << category << " (" << n << " queries, " << n_good << " good)" << std::endl;
+        std::cout << "    Deviating decisions:  " << n_deviations << std::endl;
+        std::cout << "    Last interval hits:   " << (100. * hits / n) << "%" << std::endl;
+        std::cout << "    Time per query:       GoodRunsListSelectionTool " << 1.e9 * t_tool / n << " ns, GoodRunsLookup "
+                  << 1.e9 * t_lookup / n << " ns" << std::endl;
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> grls;
+    std::string cache_file;
+    unsigned int max_lb = 2000;
+    unsigned int events_per_lb = 10;
+    unsigned int seed = 4357;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--grl") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            grls.push_back(argv[a + 1]);
+            ++a;
+        } else if (argument == "--cache") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            cache_file = argv[a + 1];
+            ++a;
+        } else if (argument == "--maxLB") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            max_lb = std::atoi(argv[a + 1]);
+            ++a;
+        } else if (argument == "--eventsPerLB") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            events_per_lb = std::atoi(argv[a + 1]);
+            ++a;
+        } else if (argument == "--seed") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            seed = std::atoi(argv[a + 1]);
+            ++a;
+        }
+    }
+    if (grls.empty() || events_per_lb == 0) {
+        std::cout << "BenchmarkGRL: Please give at least one GRL via --grl <xml>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    grls = XAMPP::GetPathResolvedFileList(grls);
+
+    Clock::time_point start = Clock::now();
+    GoodRunsListSelectionTool tool("GoodRunsListSelectionTool");
+    if (!tool.setProperty("GoodRunsListVec", grls).isSuccess() || !tool.setProperty("PassThrough", false).isSuccess() ||
+        !tool.initialize().isSuccess())
+        return EXIT_FAILURE;
+    double t_tool = Seconds(start);
+
+    XAMPP::GoodRunsLookup lookup;
+    start = Clock::now();
+    if (!lookup.load(grls)) return EXIT_FAILURE;
+    double t_xml = Seconds(start);
+    std::cout << "BenchmarkGRL: Setup of the GoodRunsListSelectionTool " << 1.e3 * t_tool << " ms, lookup from the xml files "
+              << 1.e3 * t_xml << " ms" << std::endl;
+    if (!cache_file.empty()) {
+        // The first call creates the cache if it does not exist yet
+        if (!lookup.load(grls, cache_file)) return EXIT_FAILURE;
+        start = Clock::now();
+        if (!lookup.load(grls, cache_file)) return EXIT_FAILURE;
+        std::cout << "BenchmarkGRL: Lookup from the cache " << 1.e3 * Seconds(start) << " ms" << std::endl;
+    }
+
+    std::vector<RunLB> queries;
+    for (const auto& run : lookup.runs()) {
+        for (unsigned int lb = 0; lb <= max_lb; ++lb) queries.insert(queries.end(), events_per_lb, RunLB(run, lb));
+    }
+    Benchmark("sorted", queries, tool, lookup);
+    std::shuffle(queries.begin(), queries.end(), std::mt19937(seed));
+    Benchmark("random order", queries, tool, lookup);
+    return EXIT_SUCCESS;
+}
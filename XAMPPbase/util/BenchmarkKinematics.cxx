@@ -0,0 +1,246 @@
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/ParticleKinematics.h>
+
+#include <xAODEgamma/ElectronAuxContainer.h>
+#include <xAODJet/JetAuxContainer.h>
+#include <xAODMissingET/MissingET.h>
+#include <xAODMuon/MuonAuxContainer.h>
+#include <xAODRootAccess/Init.h>
+
+#include <TRandom3.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+//###########################################################################
+//  Compares the ParticleKinematics with the IParticle based helpers of     #
+//  AnalysisUtils on synthetic events with 2-6 electrons and muons and 0-7  #
+//  jets. The reference implementations of the Z veto and of the low mass   #
+//  removal are the former per-particle ones based on TLorentzVector. For   #
+//  each helper the number of events with a different result and the time  #
+//  per event are printed. The kinematics are filled once per event and     #
+//  this time is included in the ones of the Z veto and of the dPhi(jet,met)#
+//###########################################################################
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    struct Event {
+        xAOD::ElectronContainer electrons;
+        xAOD::ElectronAuxContainer electrons_aux;
+        xAOD::MuonContainer muons;
+        xAOD::MuonAuxContainer muons_aux;
+        xAOD::JetContainer jets;
+        xAOD::JetAuxContainer jets_aux;
+        xAOD::IParticleContainer leptons{SG::VIEW_ELEMENTS};
+        std::unique_ptr<xAOD::MissingET> met;
+    };
+    std::vector<std::unique_ptr<Event>> Generate(TRandom3& rnd, unsigned int n) {
+        static XAMPP::CharDecorator dec_passOR("passOR");
+        std::vector<std::unique_ptr<Event>> events;
+        events.reserve(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            std::unique_ptr<Event> E = std::make_unique<Event>();
+            E->electrons.setStore(&E->electrons_aux);
+            E->muons.setStore(&E->muons_aux);
+            E->jets.setStore(&E->jets_aux);
+            const unsigned int n_lep = 2 + rnd.Integer(5);
+            for (unsigned int l = 0; l < n_lep; ++l) {
+                const double pt = 10.e3 + rnd.Exp(30.e3), eta = rnd.Uniform(-2.5, 2.5), phi = rnd.Uniform(-M_PI, M_PI);
+                const float charge = rnd.Rndm() < 0.5 ? -1. : 1.;
+                if (rnd.Rndm() < 0.5) {
+                    xAOD::Electron* el = new xAOD::Electron();
+                    E->electrons.push_back(el);
+                    el->setP4(pt, eta, phi, 0.511);
+                    el->setCharge(charge);
+                    dec_passOR(*el) = rnd.Rndm() < 0.9;
+                    E->leptons.push_back(el);
+                } else {
+                    xAOD::Muon* mu = new xAOD::Muon();
+                    E->muons.push_back(mu);
+                    mu->setP4(pt, eta, phi);
+                    mu->setCharge(charge);
+                    dec_passOR(*mu) = rnd.Rndm() < 0.9;
+                    E->leptons.push_back(mu);
+                }
+            }
+            const unsigned int n_jets = rnd.Integer(8);
+            for (unsigned int j = 0; j < n_jets; ++j) {
+                xAOD::Jet* jet = new xAOD::Jet();
+                E->jets.push_back(jet);
+                jet->setJetP4(xAOD::JetFourMom_t(20.e3 + rnd.Exp(50.e3), rnd.Uniform(-2.8, 2.8), rnd.Uniform(-M_PI, M_PI), rnd.Exp(10.e3)));
+            }
+            E->met = std::make_unique<xAOD::MissingET>(rnd.Gaus(0., 50.e3), rnd.Gaus(0., 50.e3), 500.e3);
+            events.push_back(std::move(E));
+        }
+        return events;
+    }
+
+    // The former implementations of AnalysisUtils
+    int ReferenceZVeto(const xAOD::IParticleContainer& Particles, float Z_Window) {
+        using namespace XAMPP;
+        unsigned int Veto = ZVeto::Pass;
+        for (auto L = Particles.begin(); L != Particles.end(); ++L) {
+            for (auto L1 = L + 1; L1 != Particles.end(); ++L1) {
+                bool TwoLep = IsSFOS(*L, *L1);
+                if (TwoLep && fabs(InvariantMass(*L, *L1) - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail2Lep; }
+                for (auto L2 = L1 + 1; L2 != Particles.end(); ++L2) {
+                    bool ThreeLep = (TwoLep || IsSFOS(*L1, *L2) || IsSFOS(*L, *L2));
+                    if (ThreeLep && fabs(InvariantMass(*L, *L1, *L2) - Z_MASS) < Z_Window) {
+                        if (TypeToPdgId(*L) == 22 || TypeToPdgId(*L1) == 22 || TypeToPdgId(*L2) == 22) {
+                            Veto = Veto | ZVeto::Fail2LepPhot;
+                        } else {
+                            Veto = Veto | ZVeto::Fail3Lep;
+                        }
+                    }
+                    for (auto L3 = L2 + 1; L3 != Particles.end(); ++L3) {
+                        bool SFOSSFOS = (IsSFOS(*L, *L1) && IsSFOS(*L2, *L3)) || (IsSFOS(*L, *L2) && IsSFOS(*L1, *L3)) ||
+                                        (IsSFOS(*L, *L3) && IsSFOS(*L2, *L1));
+                        if (SFOSSFOS && fabs(InvariantMass(*L, *L1, *L2, *L3) - Z_MASS) < Z_Window) { Veto = Veto | ZVeto::Fail4Lep; }
+                    }
+                }
+            }
+        }
+        return Veto;
+    }
+    void ReferenceLowMassRemoval(const xAOD::IParticleContainer& Leptons, float Upper_Mll, float Lower_Mll) {
+        static XAMPP::CharDecorator dec_passLMR("passLMR");
+        static XAMPP::CharAccessor acc_passOR("passOR");
+        for (auto L = Leptons.begin(); L != Leptons.end(); ++L) {
+            if (!acc_passOR(**L)) continue;
+            for (auto L1 = Leptons.begin(); L1 != L; ++L1) {
+                if (!acc_passOR(**L1) || XAMPP::IsSame(*L, *L1) || !XAMPP::IsSFOS(*L, *L1)) continue;
+                float M = XAMPP::InvariantMass(*L, *L1);
+                if (M > Lower_Mll && M < Upper_Mll) {
+                    dec_passLMR(**L1) = false;
+                    dec_passLMR(**L) = false;
+                }
+            }
+        }
+    }
+    // Encodes the passLMR decorations of the event as bit pattern and resets them
+    unsigned int LowMassPattern(const xAOD::IParticleContainer& Leptons) {
+        static XAMPP::CharDecorator dec_passLMR("passLMR");
+        unsigned int pattern = 0;
+        for (size_t l = 0; l < Leptons.size(); ++l) {
+            if (!dec_passLMR(*Leptons[l])) pattern |= 1 << l;
+            dec_passLMR(*Leptons[l]) = true;
+        }
+        return pattern;
+    }
+
+    struct Comparison {
+        std::string name;
+        double t_reference;
+        double t_kinematics;
+        unsigned int n_differences;
+    };
+    void Print(const std::vector<Comparison>& comparisons, size_t n_events) {
+        std::cout << "BenchmarkKinematics: " << n_events << " events" << std::endl;
+        for (const auto& C : comparisons) {
+            std::cout << "    " << C.name << ": differences " << C.n_differences << ", time per event AnalysisUtils "
+                      << 1.e9 * C.t_reference / n_events << " ns, ParticleKinematics " << 1.e9 * C.t_kinematics / n_events << " ns"
+                      << std::endl;
+        }
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int n_events = 100000;
+    unsigned int seed = 4357;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--nEvents" || argument == "-n") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            n_events = std::atoi(argv[a + 1]);
+            ++a;
+        } else if (argument == "--seed") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            seed = std::atoi(argv[a + 1]);
+            ++a;
+        }
+    }
+    if (n_events == 0) return EXIT_FAILURE;
+    if (!xAOD::Init("BenchmarkKinematics").isSuccess()) return EXIT_FAILURE;
+    TRandom3 rnd(seed);
+    std::vector<std::unique_ptr<Event>> events = Generate(rnd, n_events);
+    const float Z_Window = 10.e3, Upper_Mll = 12.e3, Lower_Mll = 0.;
+
+    std::vector<int> ref_veto(n_events), ref_lmr(n_events);
+    std::vector<float> ref_mtmin(n_events), ref_mtmax(n_events), ref_dphi(n_events), ref_ht(n_events);
+    std::vector<Comparison> comparisons{{"GetZVeto", 0., 0., 0},   {"RemoveLowMassLeptons", 0., 0., 0}, {"ComputeMtMin", 0., 0., 0},
+                                        {"ComputeMtMax", 0., 0., 0}, {"ComputeDPhiMin", 0., 0., 0},       {"CalculateHt", 0., 0., 0}};
+    for (unsigned int i = 0; i < n_events; ++i) LowMassPattern(events[i]->leptons);
+
+    // Per-particle implementations
+    Clock::time_point start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ref_veto[i] = ReferenceZVeto(events[i]->leptons, Z_Window);
+    comparisons[0].t_reference = Seconds(start);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ReferenceLowMassRemoval(events[i]->leptons, Upper_Mll, Lower_Mll);
+    comparisons[1].t_reference = Seconds(start);
+    for (unsigned int i = 0; i < n_events; ++i) ref_lmr[i] = LowMassPattern(events[i]->leptons);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ref_mtmin[i] = XAMPP::ComputeMtMin(&events[i]->leptons, events[i]->met.get());
+    comparisons[2].t_reference = Seconds(start);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ref_mtmax[i] = XAMPP::ComputeMtMax(&events[i]->leptons, events[i]->met.get());
+    comparisons[3].t_reference = Seconds(start);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ref_dphi[i] = XAMPP::ComputeDPhiMin(&events[i]->jets, events[i]->met.get(), 2);
+    comparisons[4].t_reference = Seconds(start);
+    start = Clock::now();
+    for (unsigned int i = 0; i < n_events; ++i) ref_ht[i] = XAMPP::CalculateHt(&events[i]->leptons);
+    comparisons[5].t_reference = Seconds(start);
+
+    // Structure of arrays filled once per event
+    XAMPP::ParticleKinematics kinematics, jet_kinematics;
+    std::vector<double> t_kinematics(comparisons.size(), 0.);
+    for (unsigned int i = 0; i < n_events; ++i) {
+        const Event& E = *events[i];
+        Clock::time_point begin = Clock::now();
+        kinematics.fill(&E.leptons);
+        const int veto = kinematics.GetZVeto(Z_Window);
+        Clock::time_point step = Clock::now();
+        t_kinematics[0] += std::chrono::duration<double>(step - begin).count();
+
+        kinematics.RemoveLowMassLeptons(XAMPP::IsSFOS, Upper_Mll, Lower_Mll);
+        begin = Clock::now();
+        t_kinematics[1] += std::chrono::duration<double>(begin - step).count();
+        const unsigned int lmr = LowMassPattern(E.leptons);
+
+        begin = Clock::now();
+        const float mtmin = kinematics.ComputeMtMin(E.met.get());
+        step = Clock::now();
+        t_kinematics[2] += std::chrono::duration<double>(step - begin).count();
+        const float mtmax = kinematics.ComputeMtMax(E.met.get());
+        begin = Clock::now();
+        t_kinematics[3] += std::chrono::duration<double>(begin - step).count();
+        jet_kinematics.fill(&E.jets);
+        const float dphi = jet_kinematics.ComputeDPhiMin(E.met.get(), 2);
+        step = Clock::now();
+        t_kinematics[4] += std::chrono::duration<double>(step - begin).count();
+        const float ht = kinematics.CalculateHt();
+        t_kinematics[5] += Seconds(step);
+
+        if (veto != ref_veto[i]) ++comparisons[0].n_differences;
+        if (lmr != (unsigned int)ref_lmr[i]) ++comparisons[1].n_differences;
+        if (mtmin != ref_mtmin[i]) ++comparisons[2].n_differences;
+        if (mtmax != ref_mtmax[i]) ++comparisons[3].n_differences;
+        if (dphi != ref_dphi[i]) ++comparisons[4].n_differences;
+        if (ht != ref_ht[i]) ++comparisons[5].n_differences;
+    }
+    for (size_t c = 0; c < comparisons.size(); ++c) comparisons[c].t_kinematics = t_kinematics[c];
+    Print(comparisons, n_events);
+    for (const auto& C : comparisons) {
+        if (C.n_differences) return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,197 @@
+#include <TFile.h>
+#include <TError.h>
+
+#include <AthContainers/AuxElement.h>
+#include <xAODEventInfo/EventInfo.h>
+#include <xAODRootAccess/Init.h>
+#include <xAODRootAccess/TEvent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+//###########################################################################
+//  Compares the two ways of storing the LHE weights of the                 #
+//  SUSYAnalysisHelper on the events of an xAOD:                            #
+//   - per variation: Each weight is read via its index, checked for        #
+//     being an outlier, added to the sum of weights of its process id      #
+//     found in the map and decorated as GenWeight_LHE_<1000 + idx>.        #
+//     The outlier check is repeated afterwards like in AcceptEvent.        #
+//   - vector: The weights are read in one loop with the outlier            #
+//     correction, added to the sums of weights resolved once and           #
+//     decorated as one vector.                                             #
+//  The sums of weights of both schemes must agree. Their time per event    #
+//  is printed.                                                             #
+//###########################################################################
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    struct SumOfWeights {
+        double SumW = 0.;
+        double SumW2 = 0.;
+    };
+    enum OutlierWeightStrategy { doNothing = 0, ignoreEvent = 1, resetWeight = 2 };
+
+    class PerVariation {
+    public:
+        PerVariation(int strategy, double threshold) : m_strategy(strategy), m_threshold(threshold), m_decorators(), m_sums() {}
+        void fill(const xAOD::EventInfo* info) {
+            m_info = info;
+            const size_t n = info->mcEventWeights().size();
+            for (size_t idx = 1; idx < n; ++idx) {
+                std::unique_ptr<SG::AuxElement::Decorator<double>>& dec = m_decorators[idx];
+                if (!dec) dec = std::make_unique<SG::AuxElement::Decorator<double>>("GenWeight_LHE_" + std::to_string(idx + 1000));
+                if (dec->isAvailable(*info)) continue;
+                const double w = GetGenWeight(idx);
+                SumOfWeights& sum = m_sums[idx + 1000];
+                sum.SumW = sum.SumW + w;
+                sum.SumW2 = sum.SumW2 + w * w;
+                (*dec)(*info) = w;
+                m_outliers += isOutlier(GetRawGenWeight(idx));
+            }
+            for (size_t idx = 1; idx < n; ++idx) m_outliers += isOutlier(GetRawGenWeight(idx));
+        }
+        const std::map<unsigned int, SumOfWeights>& sums() const { return m_sums; }
+        unsigned long long outliers() const { return m_outliers; }
+
+    private:
+        bool isOutlier(double w) const { return m_strategy != doNothing && std::fabs(w) > m_threshold; }
+        double GetRawGenWeight(unsigned int idx) const {
+            if (m_info->mcEventWeights().size() > idx) return *(m_info->mcEventWeights().begin() + idx);
+            return 1.;
+        }
+        double GetGenWeight(unsigned int idx) const {
+            double w = GetRawGenWeight(idx);
+            if (isOutlier(w)) {
+                if (m_strategy == ignoreEvent) return 0;
+                if (m_strategy == resetWeight) return w / std::fabs(w);
+            }
+            return w;
+        }
+        int m_strategy;
+        double m_threshold;
+        const xAOD::EventInfo* m_info = nullptr;
+        std::map<unsigned int, std::unique_ptr<SG::AuxElement::Decorator<double>>> m_decorators;
+        std::map<unsigned int, SumOfWeights> m_sums;
+        unsigned long long m_outliers = 0;
+    };
+
+    class Vectorized {
+    public:
+        Vectorized(int strategy, double threshold) : m_strategy(strategy), m_threshold(threshold), m_decorator("GenWeight_LHE") {}
+        void fill(const xAOD::EventInfo* info) {
+            if (m_decorator.isAvailable(*info)) return;
+            const std::vector<float>& raw = info->mcEventWeights();
+            const size_t n = raw.size();
+            m_weights.resize(n);
+            const bool check = m_strategy != doNothing;
+            unsigned int n_outliers = 0;
+            for (size_t i = 0; i < n; ++i) {
+                const double w = raw[i];
+                const bool outlier = check && std::fabs(w) > m_threshold;
+                n_outliers += outlier;
+                m_weights[i] = !outlier ? w : (m_strategy == ignoreEvent ? 0. : w / std::fabs(w));
+            }
+            if (m_sums.size() < n) m_sums.resize(n);
+            for (size_t i = 1; i < n; ++i) {
+                m_sums[i].SumW = m_sums[i].SumW + m_weights[i];
+                m_sums[i].SumW2 = m_sums[i].SumW2 + m_weights[i] * m_weights[i];
+            }
+            m_decorator(*info) = m_weights;
+            // The nominal weight is not part of the LHE loops of the other scheme
+            if (n_outliers > 0) n_outliers -= check && std::fabs(raw[0]) > m_threshold;
+            m_outliers += 2 * n_outliers;
+        }
+        const std::vector<SumOfWeights>& sums() const { return m_sums; }
+        unsigned long long outliers() const { return m_outliers; }
+
+    private:
+        int m_strategy;
+        double m_threshold;
+        SG::AuxElement::Decorator<std::vector<double>> m_decorator;
+        std::vector<double> m_weights;
+        std::vector<SumOfWeights> m_sums;
+        unsigned long long m_outliers = 0;
+    };
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> in_files;
+    long long max_events = -1;
+    int strategy = resetWeight;
+    double threshold = 100.;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--inFile" || argument == "-i") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            in_files.push_back(argv[a + 1]);
+            ++a;
+        } else if (argument == "--nEvents" || argument == "-n") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            max_events = std::atoll(argv[a + 1]);
+            ++a;
+        } else if (argument == "--outlierStrategy") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            strategy = std::atoi(argv[a + 1]);
+            ++a;
+        } else if (argument == "--outlierThreshold") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            threshold = std::atof(argv[a + 1]);
+            ++a;
+        }
+    }
+    if (in_files.empty()) {
+        Error("BenchmarkLHEWeights", "Please give at least one xAOD via --inFile <file>");
+        return EXIT_FAILURE;
+    }
+    if (!xAOD::Init("BenchmarkLHEWeights").isSuccess()) return EXIT_FAILURE;
+    xAOD::TEvent event(xAOD::TEvent::kClassAccess);
+
+    PerVariation per_variation(strategy, threshold);
+    Vectorized vectorized(strategy, threshold);
+    double t_per_variation = 0., t_vectorized = 0.;
+    long long n_events = 0;
+    size_t n_weights = 0;
+    for (const auto& in_file : in_files) {
+        std::unique_ptr<TFile> File(TFile::Open(in_file.c_str(), "READ"));
+        if (!File || !File->IsOpen() || !event.readFrom(File.get()).isSuccess()) {
+            Error("BenchmarkLHEWeights", "Could not read %s", in_file.c_str());
+            return EXIT_FAILURE;
+        }
+        for (long long entry = 0; entry < event.getEntries() && (max_events < 0 || n_events < max_events); ++entry, ++n_events) {
+            if (event.getEntry(entry) < 0) return EXIT_FAILURE;
+            const xAOD::EventInfo* info = nullptr;
+            if (!event.retrieve(info, "EventInfo").isSuccess()) return EXIT_FAILURE;
+            n_weights = std::max(n_weights, info->mcEventWeights().size());
+
+            Clock::time_point start = Clock::now();
+            per_variation.fill(info);
+            t_per_variation += Seconds(start);
+            start = Clock::now();
+            vectorized.fill(info);
+            t_vectorized += Seconds(start);
+        }
+    }
+    if (n_events == 0) return EXIT_FAILURE;
+
+    size_t n_deviations = 0;
+    for (const auto& sum : per_variation.sums()) {
+        const SumOfWeights& other = vectorized.sums().at(sum.first - 1000);
+        if (sum.second.SumW != other.SumW || sum.second.SumW2 != other.SumW2) ++n_deviations;
+    }
+    if (per_variation.outliers() != vectorized.outliers()) ++n_deviations;
+    std::cout << "BenchmarkLHEWeights: " << n_events << " events with up to " << n_weights << " weights" << std::endl;
+    std::cout << "    Deviating sums of weights: " << n_deviations << std::endl;
+    std::cout << "    Time per event:            per variation " << 1.e6 * t_per_variation / n_events << " us, vector "
+              << 1.e6 * t_vectorized / n_events << " us" << std::endl;
+    return n_deviations ? EXIT_FAILURE : EXIT_SUCCESS;
+}
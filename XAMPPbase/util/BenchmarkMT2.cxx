@@ -0,0 +1,140 @@
+#include <XAMPPbase/MT2Solver.h>
+
+#include <CalcGenericMT2/MT2_ROOT.h>
+
+#include <TLorentzVector.h>
+#include <TRandom3.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//###########################################################################
+//  Compares the MT2Solver with the ComputeMT2 implementation of            #
+//  CalcGenericMT2. Random configurations are thrown in three categories    #
+//      - massless:  Massless visible and invisible particles               #
+//      - massive:   Massive visible particles, massless invisible ones     #
+//      - general:   Massive visible and (asymmetric) invisible particles   #
+//  For each category the maximum and mean relative deviation as well as    #
+//  the time per configuration of the single and batched interface are      #
+//  printed. The benchmark fails if the maximum relative deviation exceeds  #
+//  --tolerance (default 1e-4). ComputeMT2 is only kept as reference for    #
+//  this comparison, CalculateAMT2 uses the MT2Solver.                      #
+//###########################################################################
+namespace {
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    struct Configuration {
+        TLorentzVector visa, visb, met;
+        double mInvA, mInvB;
+    };
+    TLorentzVector RandomParticle(TRandom3& rnd, double mass) {
+        TLorentzVector V;
+        V.SetPtEtaPhiM(rnd.Exp(50.e3), rnd.Uniform(-2.5, 2.5), rnd.Uniform(-M_PI, M_PI), mass);
+        return V;
+    }
+    std::vector<Configuration> Generate(TRandom3& rnd, unsigned int n, bool massive_vis, bool massive_inv) {
+        std::vector<Configuration> configs;
+        configs.reserve(n);
+        for (unsigned int i = 0; i < n; ++i) {
+            Configuration C;
+            C.visa = RandomParticle(rnd, massive_vis ? rnd.Uniform(0., 100.e3) : 0.);
+            C.visb = RandomParticle(rnd, massive_vis ? rnd.Uniform(0., 100.e3) : 0.);
+            C.met.SetPtEtaPhiM(rnd.Exp(80.e3), 0., rnd.Uniform(-M_PI, M_PI), 0.);
+            C.mInvA = massive_inv ? rnd.Uniform(0., 200.e3) : 0.;
+            C.mInvB = massive_inv ? rnd.Uniform(0., 200.e3) : 0.;
+            configs.push_back(C);
+        }
+        return configs;
+    }
+    bool Benchmark(const std::string& category, const std::vector<Configuration>& configs, const XAMPP::MT2Solver& solver,
+                   double tolerance) {
+        const size_t n = configs.size();
+        std::vector<double> reference(n), single(n), batched;
+
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            const Configuration& C = configs[i];
+            reference[i] = ComputeMT2(C.visa, C.visb, C.met, C.mInvA, C.mInvB).Compute();
+        }
+        double t_reference = Seconds(start);
+
+        start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            const Configuration& C = configs[i];
+            single[i] = solver.compute(C.visa.M(), C.visa.Px(), C.visa.Py(), C.visb.M(), C.visb.Px(), C.visb.Py(), C.met.Px(), C.met.Py(),
+                                       C.mInvA, C.mInvB);
+        }
+        double t_single = Seconds(start);
+
+        XAMPP::MT2Batch batch;
+        batch.reserve(n);
+        for (const auto& C : configs) {
+            batch.add(C.visa.M(), C.visa.Px(), C.visa.Py(), C.visb.M(), C.visb.Px(), C.visb.Py(), C.met.Px(), C.met.Py(), C.mInvA, C.mInvB);
+        }
+        XAMPP::MT2Solver::Scratch scratch;
+        start = Clock::now();
+        solver.compute(batch, batched, scratch);
+        double t_batched = Seconds(start);
+
+        double max_dev = 0., mean_dev = 0., max_batch_dev = 0.;
+        for (size_t i = 0; i < n; ++i) {
+            double dev = std::fabs(single[i] - reference[i]) / std::max(reference[i], 1.);
+            double batch_dev = std::fabs(batched[i] - single[i]) / std::max(single[i], 1.);
+            mean_dev += dev;
+            if (dev > max_dev) max_dev = dev;
+            if (batch_dev > max_batch_dev) max_batch_dev = batch_dev;
+        }
+        mean_dev /= n;
+        std::cout << "BenchmarkMT2: " << category << " (" << n << " configurations)" << std::endl;
+        std::cout << "    Deviation to ComputeMT2:  max " << max_dev << ", mean " << mean_dev << std::endl;
+        std::cout << "    Deviation batch / single: max " << max_batch_dev << std::endl;
+        std::cout << "    Time per configuration:   ComputeMT2 " << 1.e9 * t_reference / n << " ns, MT2Solver " << 1.e9 * t_single / n
+                  << " ns, batched " << 1.e9 * t_batched / n << " ns" << std::endl;
+        if (max_dev > tolerance || max_batch_dev > tolerance) {
+            std::cout << "    FAILED: The deviation exceeds the tolerance of " << tolerance << std::endl;
+            return false;
+        }
+        return true;
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    unsigned int n_configs = 100000;
+    double precision = 1.e-7;
+    unsigned int seed = 4357;
+    double tolerance = 1.e-4;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--nConfigs" || argument == "-n") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            n_configs = std::atoi(argv[a + 1]);
+            ++a;
+        } else if (argument == "--precision") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            precision = std::atof(argv[a + 1]);
+            ++a;
+        } else if (argument == "--tolerance") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            tolerance = std::atof(argv[a + 1]);
+            ++a;
+        } else if (argument == "--seed") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            seed = std::atoi(argv[a + 1]);
+            ++a;
+        }
+    }
+    if (n_configs == 0) return EXIT_FAILURE;
+    TRandom3 rnd(seed);
+    XAMPP::MT2Solver solver(precision);
+    bool agrees = Benchmark("massless", Generate(rnd, n_configs, false, false), solver, tolerance);
+    agrees &= Benchmark("massive", Generate(rnd, n_configs, true, false), solver, tolerance);
+    agrees &= Benchmark("general", Generate(rnd, n_configs, true, true), solver, tolerance);
+    return agrees ? EXIT_SUCCESS : EXIT_FAILURE;
+}
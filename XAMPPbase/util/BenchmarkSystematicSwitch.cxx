@@ -0,0 +1,216 @@
+#include <TError.h>
+#include <TFile.h>
+
+#include <PATInterfaces/SystematicSet.h>
+#include <PATInterfaces/SystematicVariation.h>
+#include <xAODCore/ShallowCopy.h>
+#include <xAODEventInfo/EventInfo.h>
+#include <xAODRootAccess/Init.h>
+#include <xAODRootAccess/TEvent.h>
+#include <xAODRootAccess/TStore.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//###########################################################################
+//  Compares the two ways of the XAMPP::EventInfo to switch between the     #
+//  EventInfo copies of the kinematic systematics on the events of an xAOD: #
+//   - store lookup: Each switch scans the list of kinematic systematics,   #
+//     assembles the store key from the name of the set and retrieves the   #
+//     copy from the store. The copy is made at the first switch to the set #
+//     in the event.                                                        #
+//   - ordinal: The copies of all kinematic systematics are made when the   #
+//     event is loaded with store keys assembled once per job. Each switch  #
+//     is a lookup of the ordinal of the set and an index into the copies.  #
+//  --nSystematics synthetic kinematic systematics (default 200, i.e. the   #
+//  size of a full SUSYTools configuration) are activated --nSwitches       #
+//  times per event each. Both schemes must return copies of the current    #
+//  event, one per systematic. The time per event is printed.               #
+//###########################################################################
+namespace {
+    const char* const AppName = "BenchmarkSystematicSwitch";
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    typedef std::vector<const CP::SystematicSet*> SystematicList;
+
+    bool MakeCopy(const xAOD::EventInfo& original, xAOD::TStore& store, const std::string& key, xAOD::EventInfo*& copy) {
+        std::pair<xAOD::EventInfo*, xAOD::ShallowAuxInfo*> shallow = xAOD::shallowCopyObject(original);
+        if (!shallow.first || !store.record(shallow.first, key).isSuccess() || !store.record(shallow.second, key + "Aux.").isSuccess())
+            return false;
+        copy = shallow.first;
+        return true;
+    }
+
+    // Scheme of EventInfo::SetSystematic before the copies were indexed by their ordinal
+    class StoreLookup {
+    public:
+        StoreLookup(const std::string& tool_name, const SystematicList& kinematics) :
+            m_name(tool_name), m_kinematics(kinematics), m_store(), m_original(nullptr) {}
+        void load(const xAOD::EventInfo* original) {
+            m_store.clear();
+            m_original = original;
+        }
+        xAOD::EventInfo* get(const CP::SystematicSet* set) {
+            bool kinematic = false;
+            for (const auto s : m_kinematics) {
+                if (s == set) {
+                    kinematic = true;
+                    break;
+                }
+            }
+            const CP::SystematicSet* use = kinematic ? set : m_kinematics.front();
+            const std::string storeName = m_name + "EvI" + use->name();
+            xAOD::EventInfo* info = nullptr;
+            if (m_store.contains<xAOD::EventInfo>(storeName)) {
+                if (!m_store.retrieve(info, storeName).isSuccess()) return nullptr;
+                return info;
+            }
+            if (!MakeCopy(*m_original, m_store, storeName, info)) return nullptr;
+            return info;
+        }
+
+    private:
+        std::string m_name;
+        SystematicList m_kinematics;
+        xAOD::TStore m_store;
+        const xAOD::EventInfo* m_original;
+    };
+
+    // Scheme of EventInfo::CreateInfoSlots and GetInfoSlot
+    class OrdinalSlots {
+    public:
+        OrdinalSlots(const std::string& tool_name, const SystematicList& kinematics) : m_ordinal(), m_names(), m_slots(), m_store() {
+            for (size_t k = 0; k < kinematics.size(); ++k) {
+                m_ordinal[kinematics[k]] = k;
+                m_names.push_back(tool_name + "EvI" + kinematics[k]->name());
+            }
+        }
+        bool load(const xAOD::EventInfo* original) {
+            m_store.clear();
+            m_slots.assign(m_names.size(), nullptr);
+            for (size_t s = 0; s < m_names.size(); ++s) {
+                if (!MakeCopy(*original, m_store, m_names[s], m_slots[s])) return false;
+            }
+            return true;
+        }
+        xAOD::EventInfo* get(const CP::SystematicSet* set) const {
+            std::unordered_map<const CP::SystematicSet*, int>::const_iterator itr = m_ordinal.find(set);
+            return m_slots[itr != m_ordinal.end() ? itr->second : 0];
+        }
+
+    private:
+        std::unordered_map<const CP::SystematicSet*, int> m_ordinal;
+        std::vector<std::string> m_names;
+        std::vector<xAOD::EventInfo*> m_slots;
+        xAOD::TStore m_store;
+    };
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> in_files;
+    long long max_events = 1000;
+    unsigned int n_systematics = 200;
+    unsigned int n_switches = 1;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--inFile" || argument == "-i") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            in_files.push_back(argv[++a]);
+        } else if (argument == "--nEvents" || argument == "-n") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            max_events = std::atoll(argv[++a]);
+        } else if (argument == "--nSystematics") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            n_systematics = std::atoi(argv[++a]);
+        } else if (argument == "--nSwitches") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            n_switches = std::atoi(argv[++a]);
+        } else {
+            Error(AppName, "Unknown argument %s", argument.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (in_files.empty()) {
+        Error(AppName, "Please give at least one xAOD via --inFile <file>");
+        return EXIT_FAILURE;
+    }
+    if (!xAOD::Init(AppName).isSuccess()) return EXIT_FAILURE;
+    xAOD::TEvent event(xAOD::TEvent::kClassAccess);
+
+    // The nominal set is the first kinematic systematic like in the SUSYSystematics
+    std::vector<std::unique_ptr<CP::SystematicSet>> sets;
+    sets.push_back(std::make_unique<CP::SystematicSet>());
+    for (unsigned int s = 1; s < n_systematics; ++s) {
+        sets.push_back(std::make_unique<CP::SystematicSet>());
+        sets.back()->insert(CP::SystematicVariation("SYST_KINEMATIC_" + std::to_string(s / 2), s % 2 ? 1 : -1));
+    }
+    SystematicList kinematics;
+    for (const auto& set : sets) kinematics.push_back(set.get());
+
+    StoreLookup store_lookup("EventInfoHandler", kinematics);
+    OrdinalSlots ordinal_slots("EventInfoHandler", kinematics);
+    double t_store = 0., t_ordinal = 0.;
+    long long n_events = 0;
+    size_t n_deviations = 0;
+    std::set<const xAOD::EventInfo*> copies;
+    for (const auto& in_file : in_files) {
+        std::unique_ptr<TFile> File(TFile::Open(in_file.c_str(), "READ"));
+        if (!File || !File->IsOpen() || !event.readFrom(File.get()).isSuccess()) {
+            Error(AppName, "Could not read %s", in_file.c_str());
+            return EXIT_FAILURE;
+        }
+        for (long long entry = 0; entry < event.getEntries() && (max_events < 0 || n_events < max_events); ++entry, ++n_events) {
+            if (event.getEntry(entry) < 0) return EXIT_FAILURE;
+            const xAOD::EventInfo* info = nullptr;
+            if (!event.retrieve(info, "EventInfo").isSuccess()) return EXIT_FAILURE;
+
+            Clock::time_point start = Clock::now();
+            store_lookup.load(info);
+            for (unsigned int n = 0; n < n_switches; ++n) {
+                for (const auto& set : kinematics) {
+                    const xAOD::EventInfo* copy = store_lookup.get(set);
+                    if (!copy || copy->eventNumber() != info->eventNumber()) ++n_deviations;
+                }
+            }
+            t_store += Seconds(start);
+
+            start = Clock::now();
+            if (!ordinal_slots.load(info)) return EXIT_FAILURE;
+            for (unsigned int n = 0; n < n_switches; ++n) {
+                for (const auto& set : kinematics) {
+                    const xAOD::EventInfo* copy = ordinal_slots.get(set);
+                    if (!copy || copy->eventNumber() != info->eventNumber()) ++n_deviations;
+                }
+            }
+            t_ordinal += Seconds(start);
+
+            // Each systematic has a copy of its own in both schemes
+            copies.clear();
+            for (const auto& set : kinematics) {
+                copies.insert(store_lookup.get(set));
+                copies.insert(ordinal_slots.get(set));
+            }
+            if (copies.size() != 2 * kinematics.size()) ++n_deviations;
+        }
+    }
+    if (n_events == 0) return EXIT_FAILURE;
+
+    const double n_activations = double(n_events) * n_switches * kinematics.size();
+    std::cout << AppName << ": " << n_events << " events with " << kinematics.size() << " kinematic systematics activated " << n_switches
+              << " times each" << std::endl;
+    std::cout << "    Deviating copies: " << n_deviations << std::endl;
+    std::cout << "    Time per event:   store lookup " << 1.e6 * t_store / n_events << " us, ordinal " << 1.e6 * t_ordinal / n_events
+              << " us (including the copies)" << std::endl;
+    std::cout << "    Time per switch:  store lookup " << 1.e9 * t_store / n_activations << " ns, ordinal "
+              << 1.e9 * t_ordinal / n_activations << " ns" << std::endl;
+    return n_deviations ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include <PathResolver/PathResolver.h>
+#include <SUSYTools/SUSYCrossSection.h>
+#include <TError.h>
+#include <XAMPPbase/AnalysisUtils.h>
+#include <XAMPPbase/CrossSectionTable.h>
+#include <XAMPPbase/MetaDataTree.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+//###############################################################################
+//  Compiles the cross-section text files of SUSYTools into the binary table    #
+//  read by the SUSYAnalysisHelper (property XsecSnapshot). The text files are  #
+//  loaded by the SUSY::CrossSectionDB itself and the table stores its answers  #
+//  for each DSID listed in the files and each final state, i.e. 0 and the      #
+//  SUSY process IDs. Final state 0 is always stored. The other final states    #
+//  are stored if the database answers differently than for an unknown          #
+//  process, which is stored as well. The table is therefore complete and a     #
+//  missing process never requires parsing the text files.                      #
+//  Afterwards, the time to parse the text files is compared to the time to     #
+//  map the table and all entries are checked against the database. The time   #
+//  of the table includes the hash over the text files which has to be read in #
+//  full to verify that the table matches them.                                 #
+//###############################################################################
+namespace {
+    const char* const AppName = "CompileCrossSections";
+    typedef std::chrono::steady_clock Clock;
+    double Seconds(const Clock::time_point& since) { return std::chrono::duration<double>(Clock::now() - since).count(); }
+
+    // Only the first column (the DSID) of the text files is needed here
+    bool ReadDSIDs(const std::string& txt_file, std::set<unsigned int>& dsids) {
+        std::ifstream in(txt_file);
+        if (!in.good()) {
+            Error(AppName, "Could not read %s", txt_file.c_str());
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            const size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') continue;
+            char* end = nullptr;
+            const unsigned long dsid = std::strtoul(line.c_str() + first, &end, 10);
+            if (end != line.c_str() + first) dsids.insert(dsid);
+        }
+        return true;
+    }
+    XAMPP::CrossSectionTable::Entry Query(const SUSY::CrossSectionDB& db, unsigned int dsid, unsigned int finalState) {
+        XAMPP::CrossSectionTable::Entry entry;
+        entry.dsid = dsid;
+        entry.finalState = finalState;
+        entry.xsect = db.rawxsect(dsid, finalState);
+        entry.kfactor = db.kfactor(dsid, finalState);
+        entry.efficiency = db.efficiency(dsid, finalState);
+        entry.relunc = db.rel_uncertainty(dsid, finalState);
+        entry.xsectTimesEff = db.xsectTimesEff(dsid, finalState);
+        return entry;
+    }
+    bool SameAnswer(const XAMPP::CrossSectionTable::Entry& a, const XAMPP::CrossSectionTable::Entry& b) {
+        return a.xsect == b.xsect && a.kfactor == b.kfactor && a.efficiency == b.efficiency && a.relunc == b.relunc &&
+               a.xsectTimesEff == b.xsectTimesEff;
+    }
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string xsec_dir = "SUSYTools/mc15_13TeV/";
+    std::string out_file;
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--xsecDir" || argument == "-d") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            xsec_dir = argv[++a];
+        } else if (argument == "--outFile" || argument == "-o") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            out_file = argv[++a];
+        } else {
+            Error(AppName, "Unknown argument %s", argument.c_str());
+            return EXIT_FAILURE;
+        }
+    }
+    if (out_file.empty()) {
+        Error(AppName, "Please give the output file via --outFile <file>");
+        return EXIT_FAILURE;
+    }
+    // Same selection of the files as in the SUSYAnalysisHelper
+    const std::vector<std::string> xsec_files = XAMPP::ListDirectory(PathResolverFindCalibDirectory(xsec_dir), "", "(.*\\.txt)");
+    if (xsec_files.empty()) {
+        Error(AppName, "No cross-section files found in %s", xsec_dir.c_str());
+        return EXIT_FAILURE;
+    }
+    std::set<unsigned int> dsids;
+    for (const auto& xsec_file : xsec_files) {
+        if (!ReadDSIDs(xsec_file, dsids)) return EXIT_FAILURE;
+    }
+
+    Clock::time_point start = Clock::now();
+    SUSY::CrossSectionDB db("", false, false, false);
+    for (const auto& xsec_file : xsec_files) db.loadFile(xsec_file);
+    const double t_text = Seconds(start);
+
+    const XAMPP::CrossSectionTable::Entry unknown =
+        Query(db, XAMPP::CrossSectionTable::UnknownProcess, XAMPP::CrossSectionTable::UnknownProcess);
+    std::vector<XAMPP::CrossSectionTable::Entry> entries{unknown};
+    const std::vector<unsigned int> final_states = XAMPP::SUSYprocessIDs();
+    for (const auto& dsid : dsids) {
+        entries.push_back(Query(db, dsid, 0));
+        for (const auto& fs : final_states) {
+            const XAMPP::CrossSectionTable::Entry entry = Query(db, dsid, fs);
+            if (!SameAnswer(entry, unknown)) entries.push_back(entry);
+        }
+    }
+    const unsigned long long source_hash = XAMPP::CrossSectionTable::SourceHash(xsec_files);
+    if (!XAMPP::CrossSectionTable::write(out_file, entries, source_hash)) return EXIT_FAILURE;
+
+    // The hash of the text files is part of the startup of the helper as well
+    start = Clock::now();
+    const unsigned long long current_hash = XAMPP::CrossSectionTable::SourceHash(xsec_files);
+    const double t_hash = Seconds(start);
+    XAMPP::CrossSectionTable table;
+    if (!table.load(out_file, current_hash)) return EXIT_FAILURE;
+    const double t_table = Seconds(start);
+
+    size_t n_deviations = 0;
+    for (const auto& entry : entries) {
+        const XAMPP::CrossSectionTable::Entry* stored = table.find(entry.dsid, entry.finalState);
+        if (!stored || !SameAnswer(*stored, entry)) ++n_deviations;
+    }
+    // Processes which are not stored must be unknown to the database
+    for (const auto& dsid : dsids) {
+        for (const auto& fs : final_states) {
+            if (!SameAnswer(*table.lookup(dsid, fs), Query(db, dsid, fs))) ++n_deviations;
+        }
+    }
+    std::cout << AppName << ": " << table.size() << " processes of " << dsids.size() << " DSIDs from " << xsec_files.size()
+              << " text files" << std::endl;
+    std::cout << "    Deviating entries: " << n_deviations << std::endl;
+    std::cout << "    Startup time:      text files " << 1.e3 * t_text << " ms, table " << 1.e3 * t_table << " ms (of which "
+              << 1.e3 * t_hash << " ms to read and hash the text files)" << std::endl;
+    return n_deviations ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,559 @@
+#include <TClass.h>
+#include <TDirectory.h>
+#include <TFile.h>
+#include <TFriendElement.h>
+#include <TH1.h>
+#include <TKey.h>
+#include <TLeaf.h>
+#include <TProfile.h>
+#include <TProfile2D.h>
+#include <TProfile3D.h>
+#include <TTree.h>
+#include <XAMPPbase/AnalysisUtils.h>
+
+#include <xAODEventInfo/EventInfo.h>
+#include "xAODRootAccess/Init.h"
+#include "xAODRootAccess/TEvent.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//###############################################################################
+//  Merges the outputs of the workers of a runAthena --nProcs job into one file #
+//  with the same entry order as the output of a serial job over the same       #
+//  input files:                                                                #
+//    * The event trees are sorted by the position of the event in the input    #
+//      files. The position is looked up from the eventNumber/runNumber or the   #
+//      CommonEventHash of the entry. Trees without any event key reuse the      #
+//      permutation of a sibling tree with the same per-worker entries.          #
+//    * The MetaDataTree entries of the same sample are summed                  #
+//    * Histograms are summed bin-by-bin                                        #
+//  The workers are merged in the order given by --inFile and the floating      #
+//  point sums are compensated (Neumaier). The merged sums are therefore        #
+//  reproducible and carry only the rounding of the final value, while the      #
+//  naive running sum of a serial job accumulates its own rounding errors. The  #
+//  two agree to that precision, but not necessarily bit by bit.                #
+//###############################################################################
+namespace {
+    const char* const AppName = "MergeParallelOutputs";
+
+    // Neumaier summation. The error of the sum does not grow with the number of terms
+    class CompensatedSum {
+    public:
+        CompensatedSum() : m_sum(0.), m_compensation(0.) {}
+        void add(double value) {
+            const double sum = m_sum + value;
+            if (std::fabs(m_sum) >= std::fabs(value))
+                m_compensation += (m_sum - sum) + value;
+            else
+                m_compensation += (value - sum) + m_sum;
+            m_sum = sum;
+        }
+        double value() const { return m_sum + m_compensation; }
+
+    private:
+        double m_sum;
+        double m_compensation;
+    };
+
+    // (eventNumber, runNumber) -> global position of the event in the input files
+    class InputOrder {
+    public:
+        bool load(const std::vector<std::string>& files) {
+            xAOD::TEvent event(xAOD::TEvent::kBranchAccess);
+            Long64_t position = 0;
+            for (const auto& file_name : files) {
+                std::unique_ptr<TFile> file(TFile::Open(file_name.c_str(), "READ"));
+                if (!file || !file->IsOpen()) {
+                    Error(AppName, "Could not open input file %s", file_name.c_str());
+                    return false;
+                }
+                if (!event.readFrom(file.get()).isSuccess()) {
+                    Error(AppName, "Could not read the events of %s", file_name.c_str());
+                    return false;
+                }
+                const Long64_t entries = event.getEntries();
+                for (Long64_t e = 0; e < entries; ++e) {
+                    const xAOD::EventInfo* info = nullptr;
+                    if (event.getEntry(e) < 0 || !event.retrieve(info, "EventInfo").isSuccess()) {
+                        Error(AppName, "Could not retrieve the EventInfo of entry %lld in %s", e, file_name.c_str());
+                        return false;
+                    }
+                    m_positions[info->eventNumber()].push_back(std::make_pair(info->runNumber(), position));
+                    ++position;
+                }
+            }
+            Info(AppName, "Read the order of %lld events from %lu input files", position, files.size());
+            return true;
+        }
+        // Returns -1 if the event is unknown. run_hash is either the runNumber or the second
+        // word of the CommonEventHash which carries the runNumber / 100 for MC
+        Long64_t find(ULong64_t event_number, Long64_t run, bool run_is_hash) const {
+            static const unsigned max_period_bit = XAMPP::max_bit(9999);
+            static const ULong64_t period_mask = (1ull << max_period_bit) - 1;
+            std::unordered_map<ULong64_t, std::vector<std::pair<unsigned int, Long64_t>>>::const_iterator itr = m_positions.find(event_number);
+            if (itr == m_positions.end()) return -1;
+            if (itr->second.size() == 1 || run < 0) return itr->second.front().second;
+            for (const auto& cand : itr->second) {
+                if (cand.first == run) return cand.second;
+                if (run_is_hash && (ULong64_t(run) & period_mask) == cand.first / 100) return cand.second;
+            }
+            return itr->second.front().second;
+        }
+
+    private:
+        std::unordered_map<ULong64_t, std::vector<std::pair<unsigned int, Long64_t>>> m_positions;
+    };
+
+    // Position in the output of the entry of the worker tree
+    struct EntryRef {
+        Long64_t key;
+        size_t worker;
+        Long64_t entry;
+        bool operator<(const EntryRef& other) const {
+            if (key != other.key) return key < other.key;
+            if (worker != other.worker) return worker < other.worker;
+            return entry < other.entry;
+        }
+    };
+    typedef std::vector<EntryRef> Permutation;
+
+    std::vector<Long64_t> EntriesPerWorker(const std::vector<TTree*>& trees) {
+        std::vector<Long64_t> entries;
+        for (const auto& tree : trees) entries.push_back(tree ? tree->GetEntries() : 0);
+        return entries;
+    }
+    bool BuildPermutation(const std::vector<TTree*>& trees, const std::string& name, const InputOrder& order, Permutation& perm) {
+        perm.clear();
+        Long64_t unknown = 0;
+        for (size_t w = 0; w < trees.size(); ++w) {
+            TTree* tree = trees[w];
+            if (!tree) continue;
+            TLeaf* hash_leaf = tree->GetLeaf("CommonEventHash");
+            TLeaf* event_leaf = tree->GetLeaf("eventNumber");
+            TLeaf* run_leaf = tree->GetLeaf("runNumber");
+            if (!hash_leaf && !event_leaf) return false;
+            for (Long64_t e = 0; e < tree->GetEntries(); ++e) {
+                ULong64_t event_number = 0;
+                Long64_t run = -1;
+                if (hash_leaf) {
+                    hash_leaf->GetBranch()->GetEntry(e);
+                    event_number = hash_leaf->GetValueLong64(0);
+                    run = hash_leaf->GetValueLong64(1);
+                } else {
+                    event_leaf->GetBranch()->GetEntry(e);
+                    event_number = event_leaf->GetValueLong64();
+                    if (run_leaf) {
+                        run_leaf->GetBranch()->GetEntry(e);
+                        run = run_leaf->GetValueLong64();
+                    }
+                }
+                Long64_t key = order.find(event_number, run, hash_leaf != nullptr);
+                // Unknown events are appended after all known ones keeping the worker order
+                if (key < 0) {
+                    key = std::numeric_limits<Long64_t>::max();
+                    ++unknown;
+                }
+                perm.push_back(EntryRef{key, w, e});
+            }
+        }
+        std::sort(perm.begin(), perm.end());
+        if (unknown > 0) Warning(AppName, "%lld entries of %s could not be found in the input files", unknown, name.c_str());
+        return true;
+    }
+
+    void ClearFriends(TTree* tree) {
+        if (!tree->GetListOfFriends()) return;
+        std::vector<TTree*> friends;
+        for (auto obj : *tree->GetListOfFriends()) {
+            TFriendElement* fe = dynamic_cast<TFriendElement*>(obj);
+            if (fe && fe->GetTree()) friends.push_back(fe->GetTree());
+        }
+        for (auto fr : friends) tree->RemoveFriend(fr);
+    }
+
+    bool CopyEntries(const std::vector<TTree*>& trees, const Permutation& perm, TTree* out) {
+        size_t current = trees.size();
+        for (const auto& ref : perm) {
+            if (ref.worker != current) {
+                current = ref.worker;
+                trees[current]->CopyAddresses(out);
+            }
+            if (trees[current]->GetEntry(ref.entry) < 0) {
+                Error(AppName, "Failed to read entry %lld of %s", ref.entry, out->GetName());
+                return false;
+            }
+            out->Fill();
+        }
+        return true;
+    }
+
+    TTree* FirstTree(const std::vector<TTree*>& trees) {
+        for (const auto& tree : trees) {
+            if (tree) return tree;
+        }
+        return nullptr;
+    }
+
+    class Merger {
+    public:
+        Merger(const InputOrder& order) : m_order(order), m_known_perms(), m_merged_trees() {}
+
+        bool mergeDirectory(const std::vector<TDirectory*>& in_dirs, TDirectory* out_dir) {
+            // Collect the object names in the order of their first appearance
+            std::vector<std::string> names;
+            std::map<std::string, std::string> class_names;
+            for (const auto& dir : in_dirs) {
+                if (!dir) continue;
+                for (auto obj : *dir->GetListOfKeys()) {
+                    TKey* key = dynamic_cast<TKey*>(obj);
+                    if (!key || class_names.find(key->GetName()) != class_names.end()) continue;
+                    names.push_back(key->GetName());
+                    class_names[key->GetName()] = key->GetClassName();
+                }
+            }
+            std::vector<std::string> trees_with_friends;
+            for (const auto& name : names) {
+                TClass* cl = TClass::GetClass(class_names[name].c_str());
+                if (!cl) {
+                    Warning(AppName, "Unknown class %s of %s. Skip it", class_names[name].c_str(), name.c_str());
+                    continue;
+                }
+                if (cl->InheritsFrom(TDirectory::Class())) {
+                    std::vector<TDirectory*> in_sub_dirs;
+                    for (const auto& dir : in_dirs) in_sub_dirs.push_back(dir ? dir->GetDirectory(name.c_str()) : nullptr);
+                    TDirectory* out_sub_dir = out_dir->mkdir(name.c_str());
+                    if (!out_sub_dir || !mergeDirectory(in_sub_dirs, out_sub_dir)) return false;
+                } else if (cl->InheritsFrom(TTree::Class())) {
+                    std::vector<TTree*> trees = Get<TTree>(in_dirs, name);
+                    TTree* first = FirstTree(trees);
+                    // Trees with friends are merged after their friends have been merged
+                    if (first && first->GetListOfFriends() && first->GetListOfFriends()->GetEntries() > 0) {
+                        trees_with_friends.push_back(name);
+                        continue;
+                    }
+                    if (!mergeTree(trees, out_dir, name)) return false;
+                } else if (cl->InheritsFrom(TH1::Class())) {
+                    if (!mergeHisto(Get<TH1>(in_dirs, name), out_dir, name)) return false;
+                } else {
+                    for (const auto& dir : in_dirs) {
+                        TObject* obj = dir ? dir->Get(name.c_str()) : nullptr;
+                        if (!obj) continue;
+                        out_dir->WriteTObject(obj, name.c_str());
+                        break;
+                    }
+                }
+            }
+            for (const auto& name : trees_with_friends) {
+                if (!mergeTree(Get<TTree>(in_dirs, name), out_dir, name)) return false;
+            }
+            return true;
+        }
+
+    private:
+        template <class T> std::vector<T*> Get(const std::vector<TDirectory*>& in_dirs, const std::string& name) const {
+            std::vector<T*> objs;
+            for (const auto& dir : in_dirs) {
+                T* obj = nullptr;
+                if (dir) dir->GetObject(name.c_str(), obj);
+                objs.push_back(obj);
+            }
+            return objs;
+        }
+
+        bool mergeHisto(const std::vector<TH1*>& histos, TDirectory* out_dir, const std::string& name) {
+            std::vector<TH1*> present;
+            for (const auto& h : histos) {
+                if (h) present.push_back(h);
+            }
+            if (present.empty()) return true;
+            TH1* merged = dynamic_cast<TH1*>(present.front()->Clone(name.c_str()));
+            merged->SetDirectory(out_dir);
+            if (present.size() == 1) return true;
+            // Profiles keep additional sums per bin. They and histograms with different axes are left to ROOT
+            bool bin_by_bin = !IsProfile(merged);
+            for (const auto& h : present) bin_by_bin &= SameBinning(merged, h);
+            if (!bin_by_bin) {
+                for (size_t w = 1; w < present.size(); ++w) {
+                    if (!merged->Add(present[w])) {
+                        Error(AppName, "Failed to add histogram %s", name.c_str());
+                        return false;
+                    }
+                }
+                return true;
+            }
+            const bool has_sumw2 = merged->GetSumw2N() > 0;
+            for (Int_t cell = 0; cell < merged->GetNcells(); ++cell) {
+                CompensatedSum content, sumw2;
+                for (const auto& h : present) {
+                    content.add(h->GetBinContent(cell));
+                    if (has_sumw2) sumw2.add(h->GetSumw2N() > 0 ? h->GetSumw2()->At(cell) : h->GetBinContent(cell));
+                }
+                merged->SetBinContent(cell, content.value());
+                if (has_sumw2) (*merged->GetSumw2())[cell] = sumw2.value();
+            }
+            // SetBinContent has reset the statistics. They are summed like the bin contents
+            std::vector<CompensatedSum> stats(TH1::kNstat);
+            CompensatedSum entries;
+            for (const auto& h : present) {
+                Double_t h_stats[TH1::kNstat] = {0};
+                h->GetStats(h_stats);
+                for (int s = 0; s < TH1::kNstat; ++s) stats[s].add(h_stats[s]);
+                entries.add(h->GetEntries());
+            }
+            Double_t merged_stats[TH1::kNstat] = {0};
+            for (int s = 0; s < TH1::kNstat; ++s) merged_stats[s] = stats[s].value();
+            merged->PutStats(merged_stats);
+            merged->SetEntries(entries.value());
+            return true;
+        }
+        static bool IsProfile(const TH1* h) {
+            return h->InheritsFrom(TProfile::Class()) || h->InheritsFrom(TProfile2D::Class()) || h->InheritsFrom(TProfile3D::Class());
+        }
+        static bool SameAxis(const TAxis* a, const TAxis* b) {
+            if (a->GetNbins() != b->GetNbins() || a->GetXmin() != b->GetXmin() || a->GetXmax() != b->GetXmax()) return false;
+            for (Int_t bin = 1; bin <= a->GetNbins(); ++bin) {
+                if (a->GetBinLowEdge(bin) != b->GetBinLowEdge(bin)) return false;
+            }
+            return true;
+        }
+        static bool SameBinning(const TH1* a, const TH1* b) {
+            return a->GetDimension() == b->GetDimension() && a->GetNcells() == b->GetNcells() && SameAxis(a->GetXaxis(), b->GetXaxis()) &&
+                   SameAxis(a->GetYaxis(), b->GetYaxis()) && SameAxis(a->GetZaxis(), b->GetZaxis());
+        }
+
+        bool mergeTree(const std::vector<TTree*>& trees, TDirectory* out_dir, const std::string& name) {
+            TTree* first = FirstTree(trees);
+            if (!first) return true;
+            out_dir->cd();
+            if (name == "MetaDataTree") return mergeMetaData(trees, out_dir);
+
+            Permutation perm;
+            const std::vector<Long64_t> entries = EntriesPerWorker(trees);
+            if (BuildPermutation(trees, name, m_order, perm)) {
+                m_known_perms.push_back(std::make_pair(entries, perm));
+            } else {
+                // Friend trees do not carry the event number themselves but are filled
+                // entry-by-entry together with the tree they are befriended with
+                std::vector<std::pair<std::vector<Long64_t>, Permutation>>::const_iterator itr =
+                    std::find_if(m_known_perms.begin(), m_known_perms.end(),
+                                 [&entries](const std::pair<std::vector<Long64_t>, Permutation>& known) { return known.first == entries; });
+                if (itr != m_known_perms.end()) {
+                    perm = itr->second;
+                } else {
+                    Warning(AppName, "No event key found for tree %s. Concatenate the workers' entries", name.c_str());
+                    for (size_t w = 0; w < trees.size(); ++w) {
+                        for (Long64_t e = 0; e < entries[w]; ++e) perm.push_back(EntryRef{0, w, e});
+                    }
+                }
+            }
+            TTree* out = first->CloneTree(0);
+            if (!out) {
+                Error(AppName, "Failed to clone tree %s", name.c_str());
+                return false;
+            }
+            ClearFriends(out);
+            out->SetDirectory(out_dir);
+            if (!CopyEntries(trees, perm, out)) return false;
+            if (first->GetListOfFriends()) {
+                for (auto obj : *first->GetListOfFriends()) {
+                    TFriendElement* fe = dynamic_cast<TFriendElement*>(obj);
+                    if (!fe) continue;
+                    std::map<std::string, TTree*>::const_iterator fr = m_merged_trees.find(std::string(out_dir->GetPath()) + "/" + fe->GetTreeName());
+                    if (fr == m_merged_trees.end() || out->AddFriend(fr->second) == nullptr) {
+                        Error(AppName, "Could not restore the friend %s of tree %s", fe->GetTreeName(), name.c_str());
+                        return false;
+                    }
+                }
+            }
+            m_merged_trees[std::string(out_dir->GetPath()) + "/" + name] = out;
+            Info(AppName, "Merged %lld entries of tree %s", out->GetEntries(), name.c_str());
+            return true;
+        }
+
+        // The MetaDataTree has one entry per sample and worker. The entries are grouped by
+        // the sample keys. The event counters are summed in the worker order and the lumi blocks unified
+        bool mergeMetaData(const std::vector<TTree*>& trees, TDirectory* out_dir) {
+            static const std::vector<std::string> key_names{"mcChannelNumber", "runNumber", "ProcessID"};
+            static const std::vector<std::string> sum_names{"TotalEvents", "TotalSumW", "TotalSumW2", "ProcessedEvents"};
+            static const std::vector<std::string> set_names{"ProcessedLumiBlocks", "TotalLumiBlocks"};
+
+            // Take the tree with the most branches as template. Workers without events only have the isData branch
+            TTree* templ = nullptr;
+            for (const auto& tree : trees) {
+                if (tree && (!templ || tree->GetListOfBranches()->GetEntries() > templ->GetListOfBranches()->GetEntries())) templ = tree;
+            }
+            std::vector<std::string> keys;
+            for (const auto& key : key_names) {
+                if (templ->GetLeaf(key.c_str())) keys.push_back(key);
+            }
+            // Attach the lumi block sets before the addresses are copied to the output
+            std::vector<std::vector<std::set<unsigned int>*>> sets(trees.size(), std::vector<std::set<unsigned int>*>(set_names.size(), nullptr));
+            std::map<std::vector<Long64_t>, std::vector<std::pair<size_t, Long64_t>>> groups;
+            for (size_t w = 0; w < trees.size(); ++w) {
+                TTree* tree = trees[w];
+                if (!tree) continue;
+                for (size_t s = 0; s < set_names.size(); ++s) {
+                    if (tree->GetBranch(set_names[s].c_str())) tree->SetBranchAddress(set_names[s].c_str(), &sets[w][s]);
+                }
+                std::vector<TLeaf*> key_leaves;
+                for (const auto& key : keys) key_leaves.push_back(tree->GetLeaf(key.c_str()));
+                if (keys.empty() || std::find(key_leaves.begin(), key_leaves.end(), nullptr) != key_leaves.end()) continue;
+                for (Long64_t e = 0; e < tree->GetEntries(); ++e) {
+                    std::vector<Long64_t> values;
+                    for (const auto& leaf : key_leaves) {
+                        leaf->GetBranch()->GetEntry(e);
+                        values.push_back(leaf->GetValueLong64());
+                    }
+                    groups[values].push_back(std::make_pair(w, e));
+                }
+            }
+            TTree* out = templ->CloneTree(0);
+            if (!out) return false;
+            out->SetDirectory(out_dir);
+            if (groups.empty()) {
+                // No sample information at all, just keep the template
+                return CopyEntries(trees, Permutation{}, out);
+            }
+            size_t current = trees.size();
+            for (const auto& group : groups) {
+                std::vector<Long64_t> int_sums(sum_names.size(), 0);
+                std::vector<CompensatedSum> dbl_sums(sum_names.size());
+                std::vector<std::set<unsigned int>> set_union(set_names.size());
+                for (const auto& member : group.second) {
+                    TTree* tree = trees[member.first];
+                    for (size_t s = 0; s < sum_names.size(); ++s) {
+                        TLeaf* leaf = tree->GetLeaf(sum_names[s].c_str());
+                        if (!leaf) continue;
+                        leaf->GetBranch()->GetEntry(member.second);
+                        int_sums[s] += leaf->GetValueLong64();
+                        dbl_sums[s].add(leaf->GetValue());
+                    }
+                    for (size_t s = 0; s < set_names.size(); ++s) {
+                        TBranch* br = tree->GetBranch(set_names[s].c_str());
+                        if (!br || !sets[member.first][s]) continue;
+                        br->GetEntry(member.second);
+                        set_union[s].insert(sets[member.first][s]->begin(), sets[member.first][s]->end());
+                    }
+                }
+                // The first entry of the group provides all remaining information
+                const std::pair<size_t, Long64_t>& front = group.second.front();
+                TTree* tree = trees[front.first];
+                if (front.first != current) {
+                    current = front.first;
+                    tree->CopyAddresses(out);
+                }
+                tree->GetEntry(front.second);
+                for (size_t s = 0; s < sum_names.size(); ++s) {
+                    TLeaf* leaf = tree->GetLeaf(sum_names[s].c_str());
+                    if (leaf) SetLeafValue(leaf, int_sums[s], dbl_sums[s].value());
+                }
+                for (size_t s = 0; s < set_names.size(); ++s) {
+                    if (sets[front.first][s]) *sets[front.first][s] = set_union[s];
+                }
+                out->Fill();
+            }
+            for (size_t w = 0; w < trees.size(); ++w) {
+                if (trees[w]) trees[w]->ResetBranchAddresses();
+                for (auto& set : sets[w]) delete set;
+            }
+            Info(AppName, "Merged %lu metadata entries", groups.size());
+            return true;
+        }
+
+        static void SetLeafValue(TLeaf* leaf, Long64_t int_value, double dbl_value) {
+            void* ptr = leaf->GetValuePointer();
+            const std::string type = leaf->GetTypeName();
+            if (type == "Double_t")
+                *static_cast<Double_t*>(ptr) = dbl_value;
+            else if (type == "Float_t")
+                *static_cast<Float_t*>(ptr) = dbl_value;
+            else if (type == "Long64_t")
+                *static_cast<Long64_t*>(ptr) = int_value;
+            else if (type == "ULong64_t")
+                *static_cast<ULong64_t*>(ptr) = int_value;
+            else if (type == "Int_t")
+                *static_cast<Int_t*>(ptr) = int_value;
+            else if (type == "UInt_t")
+                *static_cast<UInt_t*>(ptr) = int_value;
+            else
+                Warning(AppName, "Cannot sum the leaf %s of type %s", leaf->GetName(), type.c_str());
+        }
+
+        const InputOrder& m_order;
+        std::vector<std::pair<std::vector<Long64_t>, Permutation>> m_known_perms;
+        std::map<std::string, TTree*> m_merged_trees;
+    };
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> inFiles;
+    std::vector<std::string> orderFiles;
+    std::string outFile = "";
+
+    // Reading the Arguments parsed to the executable
+    for (int a = 1; a < argc; ++a) {
+        std::string argument = argv[a];
+        if (argument == "--inFile" || argument == "-i") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            std::string value = argv[a + 1];
+            if (!XAMPP::IsInVector(value, inFiles)) inFiles.push_back(value);
+            ++a;
+        } else if (argument == "--outFile" || argument == "-o") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            outFile = argv[a + 1];
+            ++a;
+        } else if (argument == "--InList") {
+            if (a + 1 == argc) return EXIT_FAILURE;
+            std::ifstream ifst(argv[a + 1]);
+            if (!ifst.good()) return EXIT_FAILURE;
+            std::string line;
+            while (XAMPP::GetLine(ifst, line)) XAMPP::FillVectorFromString(orderFiles, line);
+            ++a;
+        }
+    }
+    if (outFile.empty() || inFiles.empty() || orderFiles.empty()) {
+        Error(AppName, "Usage: %s --outFile <out> --InList <input list of the job> --inFile <worker output> [--inFile ...]", AppName);
+        return EXIT_FAILURE;
+    }
+    if (!xAOD::Init(AppName).isSuccess()) {
+        Error(AppName, "Could not setup xAOD");
+        return EXIT_FAILURE;
+    }
+    InputOrder order;
+    if (!order.load(orderFiles)) return EXIT_FAILURE;
+
+    std::vector<std::shared_ptr<TFile>> workers;
+    std::vector<TDirectory*> in_dirs;
+    for (const auto& in : inFiles) {
+        std::shared_ptr<TFile> file(TFile::Open(in.c_str(), "READ"));
+        if (!file || !file->IsOpen()) {
+            Error(AppName, "Could not open worker output %s", in.c_str());
+            return EXIT_FAILURE;
+        }
+        workers.push_back(file);
+        in_dirs.push_back(file.get());
+    }
+    std::shared_ptr<TFile> out_ROOTFile(TFile::Open(outFile.c_str(), "RECREATE"));
+    if (!out_ROOTFile || !out_ROOTFile->IsOpen()) return EXIT_FAILURE;
+    Merger merger(order);
+    if (!merger.mergeDirectory(in_dirs, out_ROOTFile.get())) {
+        Error(AppName, "Merging of the worker outputs failed");
+        return EXIT_FAILURE;
+    }
+    out_ROOTFile->cd();
+    out_ROOTFile->Write("", TObject::kOverwrite);
+    out_ROOTFile->Close();
+    for (auto& file : workers) file->Close();
+    Info(AppName, "Merged %lu worker outputs into %s", inFiles.size(), outFile.c_str());
+    return EXIT_SUCCESS;
+}